@@ -0,0 +1,71 @@
+/***************************************************************************
+  qgscompactgraph.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+
+#include <algorithm>
+#include <limits>
+
+QgsCompactGraph::QgsCompactGraph( const QgsGraph &graph )
+{
+  const int vertexCount = graph.vertexCount();
+  const int edgeCount = graph.edgeCount();
+
+  int strategyCount = 0;
+  for ( int i = 0; i < edgeCount; ++i )
+    strategyCount = std::max( strategyCount, graph.edge( i ).strategies().size() );
+
+  mPoints.reserve( vertexCount );
+  mOffsets.reserve( vertexCount + 1 );
+  mToVertices.reserve( edgeCount );
+  mEdgeIds.reserve( edgeCount );
+  mCosts.resize( strategyCount );
+  for ( QVector< double > &costs : mCosts )
+    costs.reserve( edgeCount );
+  mMinimumCostPerDistance.fill( std::numeric_limits< double >::max(), strategyCount );
+
+  mOffsets.append( 0 );
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    const QgsGraphVertex &vertex = graph.vertex( i );
+    mPoints.append( vertex.point() );
+
+    const QgsGraphEdgeIds outgoingEdges = vertex.outgoingEdges();
+    for ( int edgeId : outgoingEdges )
+    {
+      const QgsGraphEdge &edge = graph.edge( edgeId );
+      mToVertices.append( edge.toVertex() );
+      mEdgeIds.append( edgeId );
+
+      const QVector< QVariant > strategies = edge.strategies();
+      const double distance = vertex.point().distance( graph.vertex( edge.toVertex() ).point() );
+      for ( int strategy = 0; strategy < strategyCount; ++strategy )
+      {
+        const double cost = strategies.value( strategy ).toDouble();
+        mCosts[ strategy ].append( cost );
+        if ( distance > 0 )
+          mMinimumCostPerDistance[ strategy ] = std::min( mMinimumCostPerDistance[ strategy ], cost / distance );
+      }
+    }
+    mOffsets.append( mToVertices.size() );
+  }
+
+  for ( double &minimum : mMinimumCostPerDistance )
+  {
+    // no usable edge, or negative costs: no heuristic
+    if ( minimum == std::numeric_limits< double >::max() || minimum < 0 )
+      minimum = 0;
+  }
+}
@@ -0,0 +1,122 @@
+/***************************************************************************
+  qgscompactgraph.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCOMPACTGRAPH_H
+#define QGSCOMPACTGRAPH_H
+
+#include <QVector>
+
+#include "qgspointxy.h"
+#include "qgis_analysis.h"
+
+class QgsGraph;
+
+/**
+ * \ingroup analysis
+ * \class QgsCompactGraph
+ * \brief A frozen, compact representation of a QgsGraph, optimized for routing.
+ *
+ * The outgoing edges of all vertices are stored contiguously, in compressed sparse
+ * row form, and the edge costs are stored as typed arrays, one per strategy. Edges
+ * keep the order and the indices they have in the source graph, so that results
+ * computed on the compact graph can be used with the source graph.
+ *
+ * Compact graphs cannot be modified once built.
+ *
+ * \see QgsGraphAnalyzer
+ * \since QGIS 3.18
+ */
+class ANALYSIS_EXPORT QgsCompactGraph
+{
+  public:
+
+    /**
+     * Builds a compact graph from a source \a graph.
+     *
+     * Edge costs are converted to doubles. Missing costs, or costs which cannot be converted, are set to 0.
+     */
+    explicit QgsCompactGraph( const QgsGraph &graph );
+
+    /**
+     * Returns the number of vertices.
+     */
+    int vertexCount() const { return mPoints.size(); }
+
+    /**
+     * Returns the number of edges.
+     */
+    int edgeCount() const { return mToVertices.size(); }
+
+    /**
+     * Returns the number of strategies, i.e. the number of costs per edge.
+     */
+    int strategyCount() const { return mCosts.size(); }
+
+    /**
+     * Returns the point of the vertex at index \a vertex.
+     */
+    QgsPointXY vertexPoint( int vertex ) const { return mPoints.at( vertex ); }
+
+    /**
+     * Returns the position of the first outgoing edge of a \a vertex.
+     *
+     * The outgoing edges of the vertex are at positions outgoingEdgesBegin() to outgoingEdgesEnd() - 1.
+     *
+     * \see outgoingEdgesEnd()
+     */
+    int outgoingEdgesBegin( int vertex ) const { return mOffsets.at( vertex ); }
+
+    /**
+     * Returns the position after the last outgoing edge of a \a vertex.
+     *
+     * \see outgoingEdgesBegin()
+     */
+    int outgoingEdgesEnd( int vertex ) const { return mOffsets.at( vertex + 1 ); }
+
+    /**
+     * Returns the index of the vertex the edge at \a position leads to.
+     */
+    int edgeToVertex( int position ) const { return mToVertices.at( position ); }
+
+    /**
+     * Returns the index in the source graph of the edge at \a position.
+     */
+    int edgeId( int position ) const { return mEdgeIds.at( position ); }
+
+    /**
+     * Returns the cost of the edge at \a position for the strategy at index \a strategy.
+     */
+    double edgeCost( int strategy, int position ) const { return mCosts.at( strategy ).at( position ); }
+
+    /**
+     * Returns the minimum ratio between the cost of an edge for the strategy at
+     * index \a strategy and the straight line distance between its vertices.
+     *
+     * The straight line distance between two vertices multiplied by this ratio is
+     * a lower bound of the cost of any path between these vertices, which is used as
+     * the heuristic of the A* search.
+     */
+    double minimumCostPerDistance( int strategy ) const { return mMinimumCostPerDistance.at( strategy ); }
+
+  private:
+
+    QVector< QgsPointXY > mPoints;
+    QVector< int > mOffsets;
+    QVector< int > mToVertices;
+    QVector< int > mEdgeIds;
+    QVector< QVector< double > > mCosts;
+    QVector< double > mMinimumCostPerDistance;
+};
+
+#endif // QGSCOMPACTGRAPH_H
@@ -0,0 +1,719 @@
+/***************************************************************************
+  qgscontractionhierarchy.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgscontractionhierarchy.h"
+#include "qgsgraph.h"
+#include "qgsfeedback.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+///@cond PRIVATE
+
+//! Identifies contraction hierarchy files ("QGCH")
+static const quint32 FILE_MAGIC = 0x51474348;
+
+//! Version of the contraction hierarchy file format
+static const quint32 FILE_VERSION = 2;
+
+//! Maximum number of vertices settled by a witness search
+static const int WITNESS_SEARCH_LIMIT = 500;
+
+//! Number of rows of a cost matrix computed by each batch of parallel searches
+static const int COST_MATRIX_BATCH_SIZE = 256;
+
+//! Maximum number of costs of a matrix, below the maximum size of a QVector
+static const int MAX_COST_MATRIX_SIZE = ( std::numeric_limits< int >::max() - 1024 ) / static_cast< int >( sizeof( double ) );
+
+typedef std::pair< double, int > QgsQueuedHierarchyVertex;
+typedef std::priority_queue< QgsQueuedHierarchyVertex, std::vector< QgsQueuedHierarchyVertex >, std::greater< QgsQueuedHierarchyVertex > > QgsHierarchyQueue;
+
+//! A vertex reached by a search of the hierarchy
+struct QgsHierarchyLabel
+{
+  double cost;
+  //! Vertex the search reached this vertex from, or -1 for the start vertex
+  int previous;
+  //! Contracted vertex bypassed by the edge from the previous vertex
+  int middle;
+};
+
+/**
+ * Contracts the vertices of a graph, from the least to the most important.
+ *
+ * The importance of a vertex is estimated from the number of shortcuts its contraction
+ * would add, its number of edges and its number of already contracted neighbors, and
+ * updated lazily when the vertex is about to be contracted.
+ */
+class QgsHierarchyContractor
+{
+  public:
+
+    struct Arc
+    {
+      int vertex;
+      double cost;
+      int middle;
+    };
+
+    explicit QgsHierarchyContractor( int vertexCount )
+      : mOut( vertexCount )
+      , mIn( vertexCount )
+      , mContracted( vertexCount, false )
+      , mContractedNeighbors( vertexCount, 0 )
+      , mWitnessCosts( vertexCount, std::numeric_limits<double>::infinity() )
+    {}
+
+    //! Adds an edge, or lowers the cost of the existing edge between the same vertices
+    void addArc( int from, int to, double cost, int middle )
+    {
+      if ( from == to )
+        return;
+
+      for ( Arc &arc : mOut[ from ] )
+      {
+        if ( arc.vertex != to )
+          continue;
+
+        if ( cost < arc.cost )
+        {
+          arc.cost = cost;
+          arc.middle = middle;
+          for ( Arc &inArc : mIn[ to ] )
+          {
+            if ( inArc.vertex == from )
+            {
+              inArc.cost = cost;
+              inArc.middle = middle;
+              break;
+            }
+          }
+        }
+        return;
+      }
+
+      mOut[ from ].push_back( { to, cost, middle } );
+      mIn[ to ].push_back( { from, cost, middle } );
+    }
+
+    /**
+     * Contracts all the vertices, storing their contraction order into \a ranks.
+     * Returns FALSE if the contraction was canceled.
+     */
+    bool contractAll( QVector< int > &ranks, QgsFeedback *feedback )
+    {
+      const int vertexCount = mOut.size();
+      ranks.fill( -1, vertexCount );
+
+      std::priority_queue< std::pair< int, int >, std::vector< std::pair< int, int > >, std::greater< std::pair< int, int > > > queue;
+      for ( int vertex = 0; vertex < vertexCount; ++vertex )
+      {
+        if ( feedback && feedback->isCanceled() )
+          return false;
+        queue.push( std::make_pair( priority( vertex ), vertex ) );
+      }
+
+      int rank = 0;
+      while ( !queue.empty() )
+      {
+        const int vertex = queue.top().second;
+        queue.pop();
+
+        // lazy update: the priority may have grown since the vertex was queued
+        const int currentPriority = priority( vertex );
+        if ( !queue.empty() && currentPriority > queue.top().first )
+        {
+          queue.push( std::make_pair( currentPriority, vertex ) );
+          continue;
+        }
+
+        mShortcutCount += contract( vertex, false );
+        mContracted[ vertex ] = true;
+        ranks[ vertex ] = rank++;
+
+        for ( const Arc &arc : mOut[ vertex ] )
+          mContractedNeighbors[ arc.vertex ]++;
+        for ( const Arc &arc : mIn[ vertex ] )
+          mContractedNeighbors[ arc.vertex ]++;
+
+        if ( feedback && rank % 100 == 0 )
+        {
+          if ( feedback->isCanceled() )
+            return false;
+          feedback->setProgress( 100.0 * rank / vertexCount );
+        }
+      }
+      return true;
+    }
+
+    const std::vector< Arc > &outgoingArcs( int vertex ) const { return mOut[ vertex ]; }
+
+    int shortcutCount() const { return mShortcutCount; }
+
+  private:
+
+    int priority( int vertex )
+    {
+      const int shortcuts = contract( vertex, true );
+      int degree = 0;
+      for ( const Arc &arc : mOut[ vertex ] )
+      {
+        if ( !mContracted[ arc.vertex ] )
+          degree++;
+      }
+      for ( const Arc &arc : mIn[ vertex ] )
+      {
+        if ( !mContracted[ arc.vertex ] )
+          degree++;
+      }
+      return 2 * shortcuts - degree + mContractedNeighbors[ vertex ];
+    }
+
+    /**
+     * Adds the shortcuts needed to contract a \a vertex, unless \a simulate is TRUE.
+     * Returns the number of shortcuts.
+     */
+    int contract( int vertex, bool simulate )
+    {
+      int shortcuts = 0;
+      const std::vector< Arc > &outArcs = mOut[ vertex ];
+      for ( const Arc &inArc : mIn[ vertex ] )
+      {
+        if ( mContracted[ inArc.vertex ] )
+          continue;
+
+        double maxCost = -1;
+        for ( const Arc &outArc : outArcs )
+        {
+          if ( !mContracted[ outArc.vertex ] && outArc.vertex != inArc.vertex )
+            maxCost = std::max( maxCost, inArc.cost + outArc.cost );
+        }
+        if ( maxCost < 0 )
+          continue;
+
+        witnessSearch( inArc.vertex, vertex, maxCost );
+        for ( const Arc &outArc : outArcs )
+        {
+          if ( mContracted[ outArc.vertex ] || outArc.vertex == inArc.vertex )
+            continue;
+
+          // no path avoiding the vertex is as cheap as the path through it
+          const double cost = inArc.cost + outArc.cost;
+          if ( mWitnessCosts[ outArc.vertex ] > cost )
+          {
+            shortcuts++;
+            if ( !simulate )
+              addArc( inArc.vertex, outArc.vertex, cost, vertex );
+          }
+        }
+
+        for ( int touched : mTouched )
+          mWitnessCosts[ touched ] = std::numeric_limits<double>::infinity();
+        mTouched.clear();
+      }
+      return shortcuts;
+    }
+
+    /**
+     * Searches the paths from a \a source vertex avoiding the \a excluded vertex, up to \a maxCost.
+     *
+     * The search is limited, so it may miss paths: it then only causes unneeded shortcuts.
+     */
+    void witnessSearch( int source, int excluded, double maxCost )
+    {
+      QgsHierarchyQueue queue;
+      mWitnessCosts[ source ] = 0;
+      mTouched.push_back( source );
+      queue.push( std::make_pair( 0.0, source ) );
+
+      int settled = 0;
+      while ( !queue.empty() )
+      {
+        const QgsQueuedHierarchyVertex current = queue.top();
+        queue.pop();
+        if ( current.first > mWitnessCosts[ current.second ] )
+          continue;
+        if ( current.first > maxCost || ++settled > WITNESS_SEARCH_LIMIT )
+          break;
+
+        for ( const Arc &arc : mOut[ current.second ] )
+        {
+          if ( arc.vertex == excluded || mContracted[ arc.vertex ] )
+            continue;
+
+          const double cost = current.first + arc.cost;
+          if ( cost < mWitnessCosts[ arc.vertex ] )
+          {
+            if ( std::isinf( mWitnessCosts[ arc.vertex ] ) )
+              mTouched.push_back( arc.vertex );
+            mWitnessCosts[ arc.vertex ] = cost;
+            queue.push( std::make_pair( cost, arc.vertex ) );
+          }
+        }
+      }
+    }
+
+    std::vector< std::vector< Arc > > mOut;
+    std::vector< std::vector< Arc > > mIn;
+    std::vector< bool > mContracted;
+    std::vector< int > mContractedNeighbors;
+    std::vector< double > mWitnessCosts;
+    std::vector< int > mTouched;
+    int mShortcutCount = 0;
+};
+
+///@endcond
+
+QgsContractionHierarchy::QgsContractionHierarchy( const QgsGraph &graph, int criterionNum, QgsFeedback *feedback )
+{
+  const int vertexCount = graph.vertexCount();
+
+  QgsHierarchyContractor contractor( vertexCount );
+  for ( int i = 0; i < graph.edgeCount(); ++i )
+  {
+    const QgsGraphEdge &edge = graph.edge( i );
+    contractor.addArc( edge.fromVertex(), edge.toVertex(), edge.cost( criterionNum ).toDouble(), -1 );
+  }
+
+  QVector< int > ranks;
+  if ( !contractor.contractAll( ranks, feedback ) )
+    return;
+
+  // split the edges into the ones going up the hierarchy from their start vertex,
+  // and the ones going up the hierarchy from their end vertex
+  mForward.offsets.fill( 0, vertexCount + 1 );
+  mBackward.offsets.fill( 0, vertexCount + 1 );
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+  {
+    for ( const QgsHierarchyContractor::Arc &arc : contractor.outgoingArcs( vertex ) )
+    {
+      if ( ranks.at( vertex ) < ranks.at( arc.vertex ) )
+        mForward.offsets[ vertex + 1 ]++;
+      else
+        mBackward.offsets[ arc.vertex + 1 ]++;
+    }
+  }
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+  {
+    mForward.offsets[ vertex + 1 ] += mForward.offsets.at( vertex );
+    mBackward.offsets[ vertex + 1 ] += mBackward.offsets.at( vertex );
+  }
+
+  for ( Arcs *arcs : { &mForward, &mBackward } )
+  {
+    const int arcCount = arcs->offsets.last();
+    arcs->targets.resize( arcCount );
+    arcs->costs.resize( arcCount );
+    arcs->middles.resize( arcCount );
+  }
+
+  QVector< int > forwardPositions = mForward.offsets;
+  QVector< int > backwardPositions = mBackward.offsets;
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+  {
+    for ( const QgsHierarchyContractor::Arc &arc : contractor.outgoingArcs( vertex ) )
+    {
+      if ( ranks.at( vertex ) < ranks.at( arc.vertex ) )
+      {
+        const int position = forwardPositions[ vertex ]++;
+        mForward.targets[ position ] = arc.vertex;
+        mForward.costs[ position ] = arc.cost;
+        mForward.middles[ position ] = arc.middle;
+      }
+      else
+      {
+        const int position = backwardPositions[ arc.vertex ]++;
+        mBackward.targets[ position ] = vertex;
+        mBackward.costs[ position ] = arc.cost;
+        mBackward.middles[ position ] = arc.middle;
+      }
+    }
+  }
+
+  mPoints.reserve( vertexCount );
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+    mPoints.append( graph.vertex( vertex ).point() );
+
+  mRanks = ranks;
+  mShortcutCount = contractor.shortcutCount();
+  mValid = true;
+}
+
+double QgsContractionHierarchy::cost( int fromVertex, int toVertex ) const
+{
+  return bidirectionalSearch( fromVertex, toVertex, nullptr );
+}
+
+QVector<int> QgsContractionHierarchy::shortestPath( int fromVertex, int toVertex, double *cost ) const
+{
+  QVector<int> path;
+  const double pathCost = bidirectionalSearch( fromVertex, toVertex, &path );
+  if ( cost )
+    *cost = pathCost;
+  return path;
+}
+
+QVector<double> QgsContractionHierarchy::costMatrix( const QVector<int> &fromVertices, const QVector<int> &toVertices, QgsFeedback *feedback ) const
+{
+  const int columnCount = toVertices.size();
+  const qint64 size = static_cast< qint64 >( fromVertices.size() ) * columnCount;
+  if ( size == 0 || size > MAX_COST_MATRIX_SIZE )
+    return QVector<double>();
+
+  QVector<double> matrix( static_cast< int >( size ), std::numeric_limits<double>::infinity() );
+
+  // every shortest path goes up the hierarchy from both of its ends, and meets at its most
+  // important vertex. The backward searches from the end vertices leave their costs in buckets
+  // at the vertices they reach, which are then scanned by the forward searches
+  QHash< int, QVector< QPair< int, double > > > buckets;
+  QVector< QPair< int, double > > settled;
+  for ( int column = 0; column < columnCount; ++column )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return matrix;
+
+    const int toVertex = toVertices.at( column );
+    if ( toVertex < 0 || toVertex >= mPoints.size() )
+      continue;
+
+    upwardSearch( mBackward, toVertex, settled );
+    for ( const QPair< int, double > &vertex : qgis::as_const( settled ) )
+      buckets[ vertex.first ].append( qMakePair( column, vertex.second ) );
+
+    if ( feedback )
+      feedback->setProgress( 50.0 * column / columnCount );
+  }
+
+  double *costs = matrix.data();
+  auto computeRow = [this, &fromVertices, &buckets, costs, columnCount, feedback]( int row )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    const int fromVertex = fromVertices.at( row );
+    if ( fromVertex < 0 || fromVertex >= mPoints.size() )
+      return;
+
+    QVector< QPair< int, double > > reached;
+    upwardSearch( mForward, fromVertex, reached );
+
+    double *rowCosts = costs + static_cast< std::size_t >( row ) * columnCount;
+    for ( const QPair< int, double > &vertex : qgis::as_const( reached ) )
+    {
+      const auto bucket = buckets.constFind( vertex.first );
+      if ( bucket == buckets.constEnd() )
+        continue;
+
+      for ( const QPair< int, double > &entry : bucket.value() )
+      {
+        const double cost = vertex.second + entry.second;
+        if ( cost < rowCosts[ entry.first ] )
+          rowCosts[ entry.first ] = cost;
+      }
+    }
+  };
+
+  // rows are independent, compute them in parallel
+  const int rowCount = fromVertices.size();
+  QVector< int > rows;
+  for ( int batchStart = 0; batchStart < rowCount; batchStart += COST_MATRIX_BATCH_SIZE )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    rows.clear();
+    const int batchEnd = std::min( rowCount, batchStart + COST_MATRIX_BATCH_SIZE );
+    for ( int row = batchStart; row < batchEnd; ++row )
+      rows.append( row );
+    QtConcurrent::blockingMap( rows, computeRow );
+
+    if ( feedback )
+      feedback->setProgress( 50.0 + 50.0 * batchEnd / rowCount );
+  }
+
+  return matrix;
+}
+
+int QgsContractionHierarchy::maximumCostMatrixSize()
+{
+  return MAX_COST_MATRIX_SIZE;
+}
+
+double QgsContractionHierarchy::bidirectionalSearch( int fromVertex, int toVertex, QVector<int> *path ) const
+{
+  const double infinity = std::numeric_limits<double>::infinity();
+  const int vertexCount = mPoints.size();
+  if ( fromVertex < 0 || fromVertex >= vertexCount || toVertex < 0 || toVertex >= vertexCount )
+    return infinity;
+
+  QHash< int, QgsHierarchyLabel > forwardLabels;
+  QHash< int, QgsHierarchyLabel > backwardLabels;
+  QgsHierarchyQueue forwardQueue;
+  QgsHierarchyQueue backwardQueue;
+  forwardLabels.insert( fromVertex, { 0.0, -1, -1 } );
+  forwardQueue.push( std::make_pair( 0.0, fromVertex ) );
+  backwardLabels.insert( toVertex, { 0.0, -1, -1 } );
+  backwardQueue.push( std::make_pair( 0.0, toVertex ) );
+
+  double best = infinity;
+  int meeting = -1;
+  while ( true )
+  {
+    const double forwardMin = forwardQueue.empty() ? infinity : forwardQueue.top().first;
+    const double backwardMin = backwardQueue.empty() ? infinity : backwardQueue.top().first;
+    // neither search can find a cheaper path anymore
+    if ( std::min( forwardMin, backwardMin ) >= best )
+      break;
+
+    const bool forward = forwardMin <= backwardMin;
+    QgsHierarchyQueue &queue = forward ? forwardQueue : backwardQueue;
+    QHash< int, QgsHierarchyLabel > &labels = forward ? forwardLabels : backwardLabels;
+    const QHash< int, QgsHierarchyLabel > &otherLabels = forward ? backwardLabels : forwardLabels;
+    const Arcs &arcs = forward ? mForward : mBackward;
+
+    const QgsQueuedHierarchyVertex current = queue.top();
+    queue.pop();
+    if ( current.first > labels.value( current.second ).cost )
+      continue;
+
+    const auto other = otherLabels.constFind( current.second );
+    if ( other != otherLabels.constEnd() && current.first + other->cost < best )
+    {
+      best = current.first + other->cost;
+      meeting = current.second;
+    }
+
+    const int end = arcs.offsets.at( current.second + 1 );
+    for ( int position = arcs.offsets.at( current.second ); position < end; ++position )
+    {
+      const int target = arcs.targets.at( position );
+      const double cost = current.first + arcs.costs.at( position );
+      auto label = labels.find( target );
+      if ( label == labels.end() )
+      {
+        labels.insert( target, { cost, current.second, arcs.middles.at( position ) } );
+        queue.push( std::make_pair( cost, target ) );
+      }
+      else if ( cost < label->cost )
+      {
+        *label = { cost, current.second, arcs.middles.at( position ) };
+        queue.push( std::make_pair( cost, target ) );
+      }
+    }
+  }
+
+  if ( meeting < 0 || !path )
+    return best;
+
+  // edges from the start vertex up to the meeting vertex
+  QVector< QgsHierarchyLabel > forwardEdges;
+  QVector< int > forwardEdgeEnds;
+  for ( int vertex = meeting; vertex != fromVertex; )
+  {
+    const QgsHierarchyLabel &label = forwardLabels[ vertex ];
+    forwardEdges.append( label );
+    forwardEdgeEnds.append( vertex );
+    vertex = label.previous;
+  }
+
+  path->clear();
+  path->append( fromVertex );
+  for ( int i = forwardEdges.size() - 1; i >= 0; --i )
+    unpackEdge( forwardEdges.at( i ).previous, forwardEdgeEnds.at( i ), forwardEdges.at( i ).middle, *path );
+
+  // edges from the meeting vertex down to the end vertex
+  for ( int vertex = meeting; vertex != toVertex; )
+  {
+    const QgsHierarchyLabel &label = backwardLabels[ vertex ];
+    unpackEdge( vertex, label.previous, label.middle, *path );
+    vertex = label.previous;
+  }
+
+  return best;
+}
+
+void QgsContractionHierarchy::upwardSearch( const Arcs &arcs, int start, QVector< QPair< int, double > > &settled ) const
+{
+  settled.clear();
+
+  QHash< int, double > costs;
+  QgsHierarchyQueue queue;
+  costs.insert( start, 0.0 );
+  queue.push( std::make_pair( 0.0, start ) );
+
+  while ( !queue.empty() )
+  {
+    const QgsQueuedHierarchyVertex current = queue.top();
+    queue.pop();
+    if ( current.first > costs.value( current.second ) )
+      continue;
+
+    settled.append( qMakePair( current.second, current.first ) );
+
+    const int end = arcs.offsets.at( current.second + 1 );
+    for ( int position = arcs.offsets.at( current.second ); position < end; ++position )
+    {
+      const int target = arcs.targets.at( position );
+      const double cost = current.first + arcs.costs.at( position );
+      auto it = costs.find( target );
+      if ( it == costs.end() || cost < it.value() )
+      {
+        costs.insert( target, cost );
+        queue.push( std::make_pair( cost, target ) );
+      }
+    }
+  }
+}
+
+void QgsContractionHierarchy::unpackEdge( int from, int to, int middle, QVector<int> &path ) const
+{
+  if ( middle < 0 )
+  {
+    path.append( to );
+    return;
+  }
+
+  // the bypassed vertex was contracted before both ends of the shortcut, so the edge
+  // reaching it is stored as a backward edge, and the edge leaving it as a forward edge
+  unpackEdge( from, middle, edgeMiddle( mBackward, middle, from ), path );
+  unpackEdge( middle, to, edgeMiddle( mForward, middle, to ), path );
+}
+
+int QgsContractionHierarchy::edgeMiddle( const Arcs &arcs, int from, int to ) const
+{
+  const int end = arcs.offsets.at( from + 1 );
+  for ( int position = arcs.offsets.at( from ); position < end; ++position )
+  {
+    if ( arcs.targets.at( position ) == to )
+      return arcs.middles.at( position );
+  }
+  return -1;
+}
+
+bool QgsContractionHierarchy::writeToFile( const QString &path ) const
+{
+  if ( !mValid )
+    return false;
+
+  QFile file( path );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << FILE_MAGIC << FILE_VERSION << mFingerprint << mShortcutCount << mPoints.size();
+  for ( const QgsPointXY &point : mPoints )
+    stream << point.x() << point.y();
+  stream << mRanks;
+  for ( const Arcs *arcs : { &mForward, &mBackward } )
+    stream << arcs->offsets << arcs->targets << arcs->costs << arcs->middles;
+
+  return stream.status() == QDataStream::Ok && file.flush();
+}
+
+QgsContractionHierarchy QgsContractionHierarchy::readFromFile( const QString &path )
+{
+  QgsContractionHierarchy hierarchy;
+
+  QFile file( path );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return hierarchy;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+
+  quint32 magic = 0;
+  quint32 version = 0;
+  int vertexCount = 0;
+  stream >> magic >> version;
+  if ( magic != FILE_MAGIC || version != FILE_VERSION )
+    return hierarchy;
+
+  stream >> hierarchy.mFingerprint >> hierarchy.mShortcutCount >> vertexCount;
+  if ( stream.status() != QDataStream::Ok || vertexCount < 0 )
+    return hierarchy;
+
+  hierarchy.mPoints.reserve( vertexCount );
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    double x = 0;
+    double y = 0;
+    stream >> x >> y;
+    hierarchy.mPoints.append( QgsPointXY( x, y ) );
+  }
+
+  // ranks must be a permutation of the vertices
+  stream >> hierarchy.mRanks;
+  if ( stream.status() != QDataStream::Ok || hierarchy.mRanks.size() != vertexCount )
+    return QgsContractionHierarchy();
+  const QVector< int > &ranks = hierarchy.mRanks;
+  QVector< bool > rankUsed( vertexCount, false );
+  for ( int rank : ranks )
+  {
+    if ( rank < 0 || rank >= vertexCount || rankUsed.at( rank ) )
+      return QgsContractionHierarchy();
+    rankUsed[ rank ] = true;
+  }
+
+  for ( Arcs *arcs : { &hierarchy.mForward, &hierarchy.mBackward } )
+  {
+    stream >> arcs->offsets >> arcs->targets >> arcs->costs >> arcs->middles;
+    if ( stream.status() != QDataStream::Ok || arcs->offsets.size() != vertexCount + 1 )
+      return QgsContractionHierarchy();
+
+    // reject inconsistent files rather than crash on them
+    const int arcCount = arcs->targets.size();
+    if ( arcs->offsets.first() != 0 || arcs->offsets.last() != arcCount || arcs->costs.size() != arcCount || arcs->middles.size() != arcCount )
+      return QgsContractionHierarchy();
+    for ( int i = 0; i < vertexCount; ++i )
+    {
+      if ( arcs->offsets.at( i ) > arcs->offsets.at( i + 1 ) )
+        return QgsContractionHierarchy();
+    }
+    for ( int i = 0; i < arcCount; ++i )
+    {
+      if ( arcs->targets.at( i ) < 0 || arcs->targets.at( i ) >= vertexCount || arcs->middles.at( i ) < -1 || arcs->middles.at( i ) >= vertexCount )
+        return QgsContractionHierarchy();
+    }
+
+    // edges go up the hierarchy, and shortcuts bypass a vertex below both of their ends,
+    // which bounds the recursion of unpackEdge()
+    for ( int vertex = 0; vertex < vertexCount; ++vertex )
+    {
+      const int end = arcs->offsets.at( vertex + 1 );
+      for ( int position = arcs->offsets.at( vertex ); position < end; ++position )
+      {
+        const int target = arcs->targets.at( position );
+        const int middle = arcs->middles.at( position );
+        if ( ranks.at( target ) <= ranks.at( vertex ) )
+          return QgsContractionHierarchy();
+        if ( middle >= 0 && ranks.at( middle ) >= ranks.at( vertex ) )
+          return QgsContractionHierarchy();
+      }
+    }
+  }
+
+  hierarchy.mValid = true;
+  return hierarchy;
+}
@@ -0,0 +1,188 @@
+/***************************************************************************
+  qgscontractionhierarchy.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCONTRACTIONHIERARCHY_H
+#define QGSCONTRACTIONHIERARCHY_H
+
+#include <QVector>
+#include <QPair>
+
+#include "qgspointxy.h"
+#include "qgis_analysis.h"
+#include "qgis_sip.h"
+
+class QgsGraph;
+class QgsFeedback;
+
+/**
+ * \ingroup analysis
+ * \class QgsContractionHierarchy
+ * \brief A contraction hierarchy index of a QgsGraph, for fast repeated shortest path queries.
+ *
+ * Building the hierarchy contracts the vertices of the graph one after the other, from
+ * the least to the most important, adding shortcut edges which preserve the costs of
+ * the shortest paths between the remaining vertices. Queries then only need to search
+ * upward in the hierarchy from both ends of the path, which visits a tiny fraction of
+ * the vertices a Dijkstra search would visit.
+ *
+ * Building a hierarchy is expensive, but it can be written to a file and read back
+ * to answer queries on the same graph later on. Vertices keep the indices they have
+ * in the source graph.
+ *
+ * Edge costs must not be negative.
+ *
+ * \see QgsGraphAnalyzer
+ * \since QGIS 3.18
+ */
+class ANALYSIS_EXPORT QgsContractionHierarchy
+{
+  public:
+
+    /**
+     * Constructor for an invalid, empty hierarchy.
+     */
+    QgsContractionHierarchy() = default;
+
+    /**
+     * Builds the hierarchy of a \a graph, using the costs of the strategy at index \a criterionNum.
+     *
+     * An optional \a feedback can be used to report progress and to cancel the build,
+     * in which case the hierarchy is invalid.
+     */
+    explicit QgsContractionHierarchy( const QgsGraph &graph, int criterionNum = 0, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns TRUE if the hierarchy is valid, i.e. it was built or read successfully.
+     */
+    bool isValid() const { return mValid; }
+
+    /**
+     * Returns the number of vertices.
+     */
+    int vertexCount() const { return mPoints.size(); }
+
+    /**
+     * Returns the number of shortcut edges added by the contraction.
+     */
+    int shortcutCount() const { return mShortcutCount; }
+
+    /**
+     * Returns the point of the vertex at index \a vertex.
+     */
+    QgsPointXY vertexPoint( int vertex ) const { return mPoints.at( vertex ); }
+
+    /**
+     * Returns the cost of the shortest path from the vertex at index \a fromVertex to the
+     * vertex at index \a toVertex, or infinity if there is no such path.
+     */
+    double cost( int fromVertex, int toVertex ) const;
+
+    /**
+     * Returns the shortest path from the vertex at index \a fromVertex to the vertex at index \a toVertex.
+     *
+     * \param fromVertex index of the start vertex
+     * \param toVertex index of the end vertex
+     * \param cost will be set to the cost of the path, or to infinity if the end vertex is not reachable
+     * \returns the indices of the vertices of the path from the start vertex to the end vertex, or an empty list if the end vertex is not reachable
+     */
+    QVector<int> shortestPath( int fromVertex, int toVertex, double *cost SIP_OUT = nullptr ) const;
+
+    /**
+     * Returns the costs of the shortest paths from each of the \a fromVertices to each of the \a toVertices.
+     *
+     * The matrix is returned row by row: the cost from fromVertices[i] to toVertices[j] is
+     * at index i * toVertices.size() + j. Costs of unreachable or invalid vertices are infinite.
+     *
+     * An empty matrix is returned if it would have more than maximumCostMatrixSize() costs. Larger
+     * matrices can be computed by parts of \a fromVertices.
+     *
+     * An optional \a feedback can be used to report progress and to cancel the computation.
+     */
+    QVector<double> costMatrix( const QVector<int> &fromVertices, const QVector<int> &toVertices, QgsFeedback *feedback = nullptr ) const;
+
+    /**
+     * Returns the maximum number of costs of a matrix returned by costMatrix().
+     */
+    static int maximumCostMatrixSize();
+
+    /**
+     * Returns the fingerprint of the network and settings the hierarchy was built from.
+     * \see setFingerprint()
+     */
+    QString fingerprint() const { return mFingerprint; }
+
+    /**
+     * Sets the \a fingerprint of the network and settings the hierarchy was built from,
+     * e.g. its CRS, features and cost criterion. The fingerprint is stored in the hierarchy
+     * files, so that readers can check that a file matches the network they use.
+     * \see fingerprint()
+     */
+    void setFingerprint( const QString &fingerprint ) { mFingerprint = fingerprint; }
+
+    /**
+     * Writes the hierarchy to the file at \a path.
+     *
+     * Returns TRUE if the file was successfully written.
+     *
+     * \see readFromFile()
+     */
+    bool writeToFile( const QString &path ) const;
+
+    /**
+     * Reads a hierarchy from the file at \a path, which was written by writeToFile().
+     *
+     * Returns an invalid hierarchy if the file could not be read, or if it is not a consistent hierarchy.
+     */
+    static QgsContractionHierarchy readFromFile( const QString &path );
+
+  private:
+
+    //! Upward edges of the vertices, in compressed sparse row form
+    struct Arcs
+    {
+      QVector< int > offsets;
+      QVector< int > targets;
+      QVector< double > costs;
+      //! Contracted vertex a shortcut bypasses, or -1 for the edges of the source graph
+      QVector< int > middles;
+    };
+
+    //! Returns the cost of the shortest path between two vertices, and appends its vertices to \a path if set
+    double bidirectionalSearch( int fromVertex, int toVertex, QVector<int> *path ) const;
+
+    //! Settles all the vertices reachable from \a start using the upward \a arcs
+    void upwardSearch( const Arcs &arcs, int start, QVector< QPair< int, double > > &settled ) const;
+
+    //! Appends the vertices of the edge from \a from to \a to to a \a path, unpacking shortcuts
+    void unpackEdge( int from, int to, int middle, QVector<int> &path ) const;
+
+    //! Returns the contracted vertex bypassed by the edge at \a from to \a to in \a arcs
+    int edgeMiddle( const Arcs &arcs, int from, int to ) const;
+
+    bool mValid = false;
+    int mShortcutCount = 0;
+    QVector< QgsPointXY > mPoints;
+    QString mFingerprint;
+
+    //! Contraction order of the vertices
+    QVector< int > mRanks;
+
+    //! Edges toward more important vertices
+    Arcs mForward;
+
+    //! Reversed edges from more important vertices
+    Arcs mBackward;
+};
+
+#endif // QGSCONTRACTIONHIERARCHY_H
@@ -13,79 +13,207 @@
 *                                                                          *
 ***************************************************************************/
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <queue>
+#include <vector>
 
-#include <QMap>
 #include <QVector>
-#include <QPair>
 
 #include "qgsgraph.h"
+#include "qgscompactgraph.h"
 #include "qgsgraphanalyzer.h"
 
-void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+///@cond PRIVATE
+
+/**
+ * A vertex queued by a search, with the cost of the path reaching it.
+ *
+ * Vertices queued with the same cost are popped from the most recently queued one,
+ * which is the order the searches have always used, so that the shortest path trees
+ * do not change for paths of equal costs.
+ */
+struct QgsQueuedVertex
 {
-  if ( startPointIdx < 0 || startPointIdx >= source->vertexCount() )
+  double cost;
+  double priority;
+  quint64 order;
+  int vertex;
+
+  bool operator<( const QgsQueuedVertex &other ) const
   {
-    // invalid start point
-    return;
+    // std::priority_queue pops the greatest element first
+    return priority > other.priority || ( priority == other.priority && order < other.order );
   }
+};
 
-  QVector< double > *result = nullptr;
-  if ( resultCost )
+//! Outgoing edges of the vertices of a QgsGraph
+struct QgsGraphOutgoingEdges
+{
+  const QgsGraph *graph;
+  int criterionNum;
+
+  template <typename Relax>
+  void forEach( int vertex, Relax &relax ) const
   {
-    result = resultCost;
+    // edge index list
+    const QgsGraphEdgeIds &outgoingEdges = graph->vertex( vertex ).outgoingEdges();
+    for ( int edgeId : outgoingEdges )
+    {
+      const QgsGraphEdge &arc = graph->edge( edgeId );
+      relax( edgeId, arc.toVertex(), arc.cost( criterionNum ).toDouble() );
+    }
   }
-  else
+};
+
+//! Outgoing edges of the vertices of a QgsCompactGraph
+struct QgsCompactGraphOutgoingEdges
+{
+  const QgsCompactGraph *graph;
+  int criterionNum;
+
+  template <typename Relax>
+  void forEach( int vertex, Relax &relax ) const
   {
-    result = new QVector<double>();
+    const int end = graph->outgoingEdgesEnd( vertex );
+    for ( int position = graph->outgoingEdgesBegin( vertex ); position < end; ++position )
+    {
+      relax( graph->edgeId( position ), graph->edgeToVertex( position ), graph->edgeCost( criterionNum, position ) );
+    }
   }
+};
+
+/**
+ * Runs Dijkstra algorithm from \a startVertexIdx over the \a outgoingEdges of the vertices.
+ */
+template <typename OutgoingEdges>
+static void runDijkstra( int vertexCount, int startVertexIdx, const OutgoingEdges &outgoingEdges, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  QVector< double > costs( vertexCount, std::numeric_limits<double>::infinity() );
+  costs[ startVertexIdx ] = 0.0;
+
+  QVector< int > tree;
+  if ( resultTree )
+    tree.fill( -1, vertexCount );
+
+  quint64 order = 0;
+  std::priority_queue< QgsQueuedVertex > queue;
+  queue.push( { 0.0, 0.0, order++, startVertexIdx } );
+
+  QgsQueuedVertex current;
+  auto relax = [&]( int edgeId, int toVertex, double edgeCost )
+  {
+    const double cost = current.cost + edgeCost;
+    if ( cost < costs.at( toVertex ) )
+    {
+      costs[ toVertex ] = cost;
+      if ( resultTree )
+        tree[ toVertex ] = edgeId;
+      queue.push( { cost, cost, order++, toVertex } );
+    }
+  };
+
+  while ( !queue.empty() )
+  {
+    current = queue.top();
+    queue.pop();
+
+    // skip the vertices queued again since, with a lower cost
+    if ( current.cost > costs.at( current.vertex ) )
+      continue;
 
-  result->clear();
-  result->insert( result->begin(), source->vertexCount(), std::numeric_limits<double>::infinity() );
-  ( *result )[ startPointIdx ] = 0.0;
+    outgoingEdges.forEach( current.vertex, relax );
+  }
 
+  if ( resultCost )
+    *resultCost = costs;
   if ( resultTree )
+    *resultTree = tree;
+}
+
+///@endcond
+
+void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  if ( startPointIdx < 0 || startPointIdx >= source->vertexCount() )
+  {
+    // invalid start point
+    return;
+  }
+
+  runDijkstra( source->vertexCount(), startPointIdx, QgsGraphOutgoingEdges{ source, criterionNum }, resultTree, resultCost );
+}
+
+void QgsGraphAnalyzer::dijkstra( const QgsCompactGraph *source, int startVertexIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  if ( startVertexIdx < 0 || startVertexIdx >= source->vertexCount() )
   {
-    resultTree->clear();
-    resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
+    // invalid start point
+    return;
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
+  runDijkstra( source->vertexCount(), startVertexIdx, QgsCompactGraphOutgoingEdges{ source, criterionNum }, resultTree, resultCost );
+}
+
+QVector<int> QgsGraphAnalyzer::shortestPath( const QgsCompactGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, double *cost )
+{
+  if ( cost )
+    *cost = std::numeric_limits<double>::infinity();
+
+  const int vertexCount = source->vertexCount();
+  if ( startVertexIdx < 0 || startVertexIdx >= vertexCount || endVertexIdx < 0 || endVertexIdx >= vertexCount )
+    return QVector<int>();
 
-  not_begin.insert( 0.0, startPointIdx );
+  const QgsPointXY endPoint = source->vertexPoint( endVertexIdx );
+  const double costPerDistance = source->minimumCostPerDistance( criterionNum );
 
-  while ( !not_begin.empty() )
+  QVector< double > costs( vertexCount, std::numeric_limits<double>::infinity() );
+  QVector< int > previous( vertexCount, -1 );
+  costs[ startVertexIdx ] = 0.0;
+
+  quint64 order = 0;
+  std::priority_queue< QgsQueuedVertex > queue;
+  queue.push( { 0.0, costPerDistance * source->vertexPoint( startVertexIdx ).distance( endPoint ), order++, startVertexIdx } );
+
+  while ( !queue.empty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
+    const QgsQueuedVertex current = queue.top();
+    queue.pop();
 
-    // edge index list
-    const QgsGraphEdgeIds &outgoingEdges = source->vertex( curVertex ).outgoingEdges();
-    for ( int edgeId : outgoingEdges )
-    {
-      const QgsGraphEdge &arc = source->edge( edgeId );
-      double cost = arc.cost( criterionNum ).toDouble() + curCost;
+    if ( current.cost > costs.at( current.vertex ) )
+      continue;
+
+    // the heuristic is consistent, the cost of the end vertex is final when it is popped
+    if ( current.vertex == endVertexIdx )
+      break;
 
-      if ( cost < ( *result )[ arc.toVertex()] )
+    const int end = source->outgoingEdgesEnd( current.vertex );
+    for ( int position = source->outgoingEdgesBegin( current.vertex ); position < end; ++position )
+    {
+      const int toVertex = source->edgeToVertex( position );
+      const double toCost = current.cost + source->edgeCost( criterionNum, position );
+      if ( toCost < costs.at( toVertex ) )
       {
-        ( *result )[ arc.toVertex()] = cost;
-        if ( resultTree )
-        {
-          ( *resultTree )[ arc.toVertex()] = edgeId;
-        }
-        not_begin.insert( cost, arc.toVertex() );
+        costs[ toVertex ] = toCost;
+        previous[ toVertex ] = current.vertex;
+        queue.push( { toCost, toCost + costPerDistance * source->vertexPoint( toVertex ).distance( endPoint ), order++, toVertex } );
       }
     }
   }
-  if ( !resultCost )
-  {
-    delete result;
-  }
+
+  if ( std::isinf( costs.at( endVertexIdx ) ) )
+    return QVector<int>();
+
+  QVector<int> path;
+  for ( int vertex = endVertexIdx; vertex != startVertexIdx; vertex = previous.at( vertex ) )
+    path.append( vertex );
+  path.append( startVertexIdx );
+  std::reverse( path.begin(), path.end() );
+
+  if ( cost )
+    *cost = costs.at( endVertexIdx );
+  return path;
 }
 
 QgsGraph *QgsGraphAnalyzer::shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum )
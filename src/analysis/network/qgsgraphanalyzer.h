@@ -22,11 +22,15 @@
 #include "qgis_analysis.h"
 
 class QgsGraph;
+class QgsCompactGraph;
 
 /**
  * \ingroup analysis
  *  This class performs graph analysis, e.g. calculates shortest path between two
  * points using different strategies with Dijkstra algorithm
+ *
+ * Graphs which are searched many times should be converted to a QgsCompactGraph,
+ * whose typed edge costs and contiguous adjacency lists are much faster to search.
  */
 
 class ANALYSIS_EXPORT QgsGraphAnalyzer
@@ -75,6 +79,70 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
     % End
 #endif
 
+    /**
+     * Solve shortest path problem on a compact graph using Dijkstra algorithm.
+     *
+     * The results are identical to the ones of the search on the source graph of the compact graph.
+     *
+     * \param source source compact graph
+     * \param startVertexIdx index of the start vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultTree array that represents shortest path tree. resultTree[ vertexIndex ] == inboundingArcIndex if vertex reachable, otherwise resultTree[ vertexIndex ] == -1.
+     * Arc indices are the indices of the edges in the source graph.
+     * Note that the startVertexIdx will also have a value of -1 and may need special handling by callers.
+     * \param resultCost array of the paths costs
+     * \since QGIS 3.18
+     */
+    static void SIP_PYALTERNATIVETYPE( SIP_PYLIST ) dijkstra( const QgsCompactGraph *source, int startVertexIdx, int criterionNum, QVector<int> *resultTree = nullptr, QVector<double> *resultCost = nullptr );
+
+#ifdef SIP_RUN
+    % MethodCode
+    QVector< int > treeResult;
+    QVector< double > costResult;
+    QgsGraphAnalyzer::dijkstra( a0, a1, a2, &treeResult, &costResult );
+
+    PyObject *l1 = PyList_New( treeResult.size() );
+    if ( l1 == NULL )
+    {
+      return NULL;
+    }
+    PyObject *l2 = PyList_New( costResult.size() );
+    if ( l2 == NULL )
+    {
+      return NULL;
+    }
+    int i;
+    for ( i = 0; i < costResult.size(); ++i )
+    {
+      PyObject *Int = PyLong_FromLong( treeResult[i] );
+      PyList_SET_ITEM( l1, i, Int );
+      PyObject *Float = PyFloat_FromDouble( costResult[i] );
+      PyList_SET_ITEM( l2, i, Float );
+    }
+
+    sipRes = PyTuple_New( 2 );
+    PyTuple_SET_ITEM( sipRes, 0, l1 );
+    PyTuple_SET_ITEM( sipRes, 1, l2 );
+    % End
+#endif
+
+    /**
+     * Returns the shortest path between two vertices of a compact graph, using the A* algorithm.
+     *
+     * The search is guided toward the end vertex by the straight line distance to the
+     * end vertex, scaled by QgsCompactGraph::minimumCostPerDistance(), and stops as
+     * soon as the end vertex is reached.
+     *
+     * \param source source compact graph
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param cost will be set to the cost of the path, or to infinity if the end vertex is not reachable
+     * \returns the indices of the vertices of the path from the start vertex to the end vertex, or an empty list if the end vertex is not reachable
+     * \since QGIS 3.18
+     */
+    static QVector<int> shortestPath( const QgsCompactGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, double *cost SIP_OUT = nullptr );
+
     /**
      * Returns shortest path tree with root-node in startVertexIdx
      * \param source source graph
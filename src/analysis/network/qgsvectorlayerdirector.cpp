@@ -28,32 +28,275 @@
 #include "qgsgeometry.h"
 #include "qgsdistancearea.h"
 #include "qgswkbtypes.h"
+#include "qgsexception.h"
 
 #include <QString>
 #include <QtAlgorithms>
+#include <QtConcurrentMap>
 
-#include <spatialindex/SpatialIndex.h>
+#include <cmath>
 
-using namespace SpatialIndex;
+///@cond PRIVATE
+
+//! Number of network features read and prepared together
+static const int FEATURE_BATCH_SIZE = 1000;
+
+//! Maximum number of grid cells spanned in each direction by the segments stored in cells
+static const int MAX_SEGMENT_CELLS = 16;
+
+//! A segment of a network line, between two graph vertices
+struct QgsNetworkSegment
+{
+  int from;
+  int to;
+};
+
+//! An edge to add to the graph
+struct QgsNetworkArc
+{
+  int from;
+  int to;
+  double distance;
+};
+
+//! A network feature, with its lines and the edges built from them
+struct QgsNetworkFeature
+{
+  QgsFeature feature;
+  //! Transformed lines of the feature
+  QgsMultiPolylineXY lines;
+  QString transformError;
+  //! Range of the segments of the feature
+  int firstSegment = 0;
+  int endSegment = 0;
+  QVector< QgsNetworkArc > arcs;
+};
 
 struct TiePointInfo
 {
-  TiePointInfo() = default;
-  TiePointInfo( int additionalPointId, QgsFeatureId featureId, const QgsPointXY &start, const QgsPointXY &end )
-    : additionalPointId( additionalPointId )
-    , mNetworkFeatureId( featureId )
-    , mFirstPoint( start )
-    , mLastPoint( end )
-  {}
-
-  int additionalPointId = -1;
+  //! Closest network segment, or -1
+  int segment = -1;
+  //! Graph vertex of the tied point
+  int vertex = -1;
   QgsPointXY mTiedPoint;
   double mLength = std::numeric_limits<double>::max();
-  QgsFeatureId mNetworkFeatureId = -1;
-  QgsPointXY mFirstPoint;
-  QgsPointXY mLastPoint;
 };
 
+/**
+ * Indexes the graph vertices in a grid of cells as large as the topology tolerance, so that
+ * the vertices within tolerance of a point are always in the cells around the point.
+ */
+class QgsNetworkVertexGrid
+{
+  public:
+
+    explicit QgsNetworkVertexGrid( double tolerance )
+      : mTolerance( tolerance )
+      , mCellSize( std::max( tolerance, 1e-7 ) )
+    {}
+
+    /**
+     * Returns the first of the \a vertices within tolerance of a \a point, or -1.
+     */
+    int find( const QgsPointXY &point, const QVector< QgsPointXY > &vertices ) const
+    {
+      const qint64 column = cell( point.x() );
+      const qint64 row = cell( point.y() );
+      int result = -1;
+      for ( qint64 y = row - 1; y <= row + 1; ++y )
+      {
+        for ( qint64 x = column - 1; x <= column + 1; ++x )
+        {
+          const auto it = mCells.constFind( qMakePair( x, y ) );
+          if ( it == mCells.constEnd() )
+            continue;
+
+          for ( int index : it.value() )
+          {
+            const QgsPointXY &vertex = vertices.at( index );
+            if ( ( result == -1 || index < result ) && std::fabs( vertex.x() - point.x() ) <= mTolerance && std::fabs( vertex.y() - point.y() ) <= mTolerance )
+              result = index;
+          }
+        }
+      }
+      return result;
+    }
+
+    void insert( const QgsPointXY &point, int index )
+    {
+      mCells[ qMakePair( cell( point.x() ), cell( point.y() ) ) ].append( index );
+    }
+
+  private:
+
+    qint64 cell( double value ) const { return static_cast< qint64 >( std::floor( value / mCellSize ) ); }
+
+    double mTolerance = 0;
+    double mCellSize = 0;
+    QHash< QPair< qint64, qint64 >, QVector< int > > mCells;
+};
+
+/**
+ * Indexes the network segments in a grid, to find the segments closest to points.
+ */
+class QgsNetworkSegmentGrid
+{
+  public:
+
+    QgsNetworkSegmentGrid( const QVector< QgsNetworkSegment > &segments, const QVector< QgsPointXY > &vertices )
+      : mSegments( segments )
+      , mVertices( vertices )
+    {
+      QgsRectangle extent;
+      extent.setMinimal();
+      for ( const QgsPointXY &vertex : vertices )
+        extent.combineExtentWith( vertex.x(), vertex.y() );
+
+      // aim for about one segment per cell
+      const double area = extent.width() * extent.height();
+      mCellSize = std::max( std::sqrt( area / segments.size() ), std::max( extent.width(), extent.height() ) / segments.size() );
+      if ( !( mCellSize > 0 ) )
+        mCellSize = 1;
+
+      mOriginX = extent.xMinimum();
+      mOriginY = extent.yMinimum();
+      mColumns = static_cast< int >( extent.width() / mCellSize ) + 1;
+      mRows = static_cast< int >( extent.height() / mCellSize ) + 1;
+
+      for ( int i = 0; i < segments.size(); ++i )
+      {
+        const QgsPointXY &from = vertices.at( segments.at( i ).from );
+        const QgsPointXY &to = vertices.at( segments.at( i ).to );
+        const int x0 = column( std::min( from.x(), to.x() ) );
+        const int x1 = column( std::max( from.x(), to.x() ) );
+        const int y0 = row( std::min( from.y(), to.y() ) );
+        const int y1 = row( std::max( from.y(), to.y() ) );
+        if ( x1 - x0 > MAX_SEGMENT_CELLS || y1 - y0 > MAX_SEGMENT_CELLS )
+        {
+          // rare long segments are checked for every point instead
+          mLargeSegments.append( i );
+          continue;
+        }
+
+        for ( int y = y0; y <= y1; ++y )
+        {
+          for ( int x = x0; x <= x1; ++x )
+            mCells[ qMakePair( x, y ) ].append( i );
+        }
+      }
+    }
+
+    /**
+     * Returns the segment closest to a \a point, or -1 if there are no segments. The
+     * closest point of the segment is stored in \a snappedPoint, and its squared distance
+     * to the point in \a sqrDist.
+     *
+     * Among equally distant segments, the first one is returned.
+     */
+    int closestSegment( const QgsPointXY &point, QgsPointXY &snappedPoint, double &sqrDist ) const
+    {
+      int result = -1;
+      sqrDist = std::numeric_limits<double>::max();
+      auto visit = [&]( int segment )
+      {
+        QgsPointXY segmentPoint;
+        const double distance = segmentSqrDist( segment, point, segmentPoint );
+        if ( distance < sqrDist || ( distance == sqrDist && segment < result ) )
+        {
+          sqrDist = distance;
+          snappedPoint = segmentPoint;
+          result = segment;
+        }
+      };
+
+      for ( int segment : mLargeSegments )
+        visit( segment );
+
+      const double x = std::floor( ( point.x() - mOriginX ) / mCellSize );
+      const double y = std::floor( ( point.y() - mOriginY ) / mCellSize );
+      const double outsideX = x < 0 ? -x : std::max( 0.0, x - ( mColumns - 1 ) );
+      const double outsideY = y < 0 ? -y : std::max( 0.0, y - ( mRows - 1 ) );
+      if ( std::max( outsideX, outsideY ) > mColumns + mRows )
+      {
+        // far away from the network, just check every segment
+        for ( int segment = 0; segment < mSegments.size(); ++segment )
+          visit( segment );
+        return result;
+      }
+
+      // search rings of cells around the point, until no closer segment can be found
+      const int cx = static_cast< int >( x );
+      const int cy = static_cast< int >( y );
+      const int firstRing = static_cast< int >( std::max( outsideX, outsideY ) );
+      const int lastRing = std::max( std::max( std::abs( cx ), std::abs( cx - mColumns + 1 ) ), std::max( std::abs( cy ), std::abs( cy - mRows + 1 ) ) );
+      auto visitCell = [&]( int cellX, int cellY )
+      {
+        if ( cellX < 0 || cellX >= mColumns || cellY < 0 || cellY >= mRows )
+          return;
+        const auto it = mCells.constFind( qMakePair( cellX, cellY ) );
+        if ( it == mCells.constEnd() )
+          return;
+        for ( int segment : it.value() )
+          visit( segment );
+      };
+
+      for ( int ring = firstRing; ring <= lastRing; ++ring )
+      {
+        if ( ring == 0 )
+        {
+          visitCell( cx, cy );
+        }
+        else
+        {
+          for ( int cellX = std::max( cx - ring, 0 ); cellX <= std::min( cx + ring, mColumns - 1 ); ++cellX )
+          {
+            visitCell( cellX, cy - ring );
+            visitCell( cellX, cy + ring );
+          }
+          for ( int cellY = std::max( cy - ring + 1, 0 ); cellY <= std::min( cy + ring - 1, mRows - 1 ); ++cellY )
+          {
+            visitCell( cx - ring, cellY );
+            visitCell( cx + ring, cellY );
+          }
+        }
+
+        // cells of the next rings are at least ring cells away from the point
+        if ( result != -1 && std::sqrt( sqrDist ) < ring * mCellSize )
+          break;
+      }
+      return result;
+    }
+
+  private:
+
+    int column( double x ) const { return static_cast< int >( ( x - mOriginX ) / mCellSize ); }
+    int row( double y ) const { return static_cast< int >( ( y - mOriginY ) / mCellSize ); }
+
+    double segmentSqrDist( int segment, const QgsPointXY &point, QgsPointXY &segmentPoint ) const
+    {
+      const QgsPointXY &pt1 = mVertices.at( mSegments.at( segment ).from );
+      const QgsPointXY &pt2 = mVertices.at( mSegments.at( segment ).to );
+      if ( pt1 == pt2 )
+      {
+        segmentPoint = pt1;
+        return point.sqrDist( pt1 );
+      }
+      return point.sqrDistToSegment( pt1.x(), pt1.y(), pt2.x(), pt2.y(), segmentPoint, 0 );
+    }
+
+    const QVector< QgsNetworkSegment > &mSegments;
+    const QVector< QgsPointXY > &mVertices;
+    double mCellSize = 1;
+    double mOriginX = 0;
+    double mOriginY = 0;
+    int mColumns = 1;
+    int mRows = 1;
+    QHash< QPair< int, int >, QVector< int > > mCells;
+    QVector< int > mLargeSegments;
+};
+
+///@endcond
+
 QgsVectorLayerDirector::QgsVectorLayerDirector( QgsFeatureSource *source,
     int directionFieldId,
     const QString &directDirectionValue,
@@ -112,60 +355,6 @@ QgsVectorLayerDirector::Direction QgsVectorLayerDirector::directionForFeature( c
   }
 }
 
-///@cond PRIVATE
-class QgsNetworkVisitor : public SpatialIndex::IVisitor
-{
-  public:
-    explicit QgsNetworkVisitor( QVector< int > &pointIndexes )
-      : mPoints( pointIndexes ) {}
-
-    void visitNode( const INode &n ) override
-    { Q_UNUSED( n ) }
-
-    void visitData( const IData &d ) override
-    {
-      mPoints.append( d.getIdentifier() );
-    }
-
-    void visitData( std::vector<const IData *> &v ) override
-    { Q_UNUSED( v ) }
-
-  private:
-    QVector< int > &mPoints;
-};
-
-///@endcond
-
-std::unique_ptr< SpatialIndex::ISpatialIndex > createVertexSpatialIndex( SpatialIndex::IStorageManager &storageManager )
-{
-  // R-Tree parameters
-  double fillFactor = 0.7;
-  unsigned long indexCapacity = 10;
-  unsigned long leafCapacity = 10;
-  unsigned long dimension = 2;
-  RTree::RTreeVariant variant = RTree::RV_RSTAR;
-
-  // create R-tree
-  SpatialIndex::id_type indexId;
-  std::unique_ptr< SpatialIndex::ISpatialIndex > iRTree( RTree::createNewRTree( storageManager, fillFactor, indexCapacity,
-      leafCapacity, dimension, variant, indexId ) );
-  return iRTree;
-}
-
-int findClosestVertex( const QgsPointXY &point, SpatialIndex::ISpatialIndex *index, double tolerance )
-{
-  QVector< int > matching;
-  QgsNetworkVisitor visitor( matching );
-
-  double pt1[2] = { point.x() - tolerance, point.y() - tolerance },
-                  pt2[2] = { point.x() + tolerance, point.y() + tolerance };
-  SpatialIndex::Region searchRegion( pt1, pt2, 2 );
-
-  index->intersectsWithQuery( searchRegion, visitor );
-
-  return matching.empty() ? -1 : matching.at( 0 );
-}
-
 void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const QVector< QgsPointXY > &additionalPoints,
                                         QVector< QgsPointXY > &snappedPoints, QgsFeedback *feedback ) const
 {
@@ -188,130 +377,136 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
   QVector< QgsPointXY > graphVertices;
 
   // spatial index for graph vertices
-  std::unique_ptr< SpatialIndex::IStorageManager > iStorage( StorageManager::createNewMemoryStorageManager() );
-  std::unique_ptr< SpatialIndex::ISpatialIndex > iRTree = createVertexSpatialIndex( *iStorage );
-
   double tolerance = std::max( builder->topologyTolerance(), 1e-10 );
-  auto findPointWithinTolerance = [&iRTree, tolerance]( const QgsPointXY & point )->int
+  QgsNetworkVertexGrid vertexGrid( tolerance );
+  auto findOrAddVertex = [&vertexGrid, &graphVertices]( const QgsPointXY & point )->int
   {
-    return findClosestVertex( point, iRTree.get(), tolerance );
+    int index = vertexGrid.find( point, graphVertices );
+    if ( index == -1 )
+    {
+      // no vertex already exists within tolerance - add to points, and index
+      index = graphVertices.count();
+      vertexGrid.insert( point, index );
+      graphVertices.push_back( point );
+    }
+    return index;
   };
-  auto addPointToIndex = [&iRTree]( const QgsPointXY & point, int index )
+
+  // lines are extracted and transformed in parallel, batch after batch
+  auto prepareFeature = [&ct]( QgsNetworkFeature & networkFeature )
   {
-    double coords[] = {point.x(), point.y()};
-    iRTree->insertData( 0, nullptr, SpatialIndex::Point( coords, 2 ), index );
+    const QgsGeometry geometry = networkFeature.feature.geometry();
+    if ( QgsWkbTypes::flatType( geometry.wkbType() ) == QgsWkbTypes::MultiLineString )
+      networkFeature.lines = geometry.asMultiPolyline();
+    else if ( QgsWkbTypes::flatType( geometry.wkbType() ) == QgsWkbTypes::LineString )
+      networkFeature.lines.push_back( geometry.asPolyline() );
+    networkFeature.feature.clearGeometry();
+
+    const QgsCoordinateTransform transform = ct;
+    try
+    {
+      for ( QgsPolylineXY &line : networkFeature.lines )
+      {
+        for ( QgsPointXY &point : line )
+          point = transform.transform( point );
+      }
+    }
+    catch ( QgsCsException &e )
+    {
+      networkFeature.transformError = e.what();
+    }
   };
 
-  // first iteration - get all nodes from network, and snap additional points to network
-  QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setNoAttributes() );
+  // first iteration - get all nodes and segments from network
+  QVector< QgsNetworkFeature > features;
+  QVector< QgsNetworkSegment > segments;
+  QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( requiredAttributes() ) );
   QgsFeature feature;
-  while ( fit.nextFeature( feature ) )
+  bool finished = false;
+  while ( !finished )
   {
     if ( feedback && feedback->isCanceled() )
       return;
 
-    QgsMultiPolylineXY mpl;
-    if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::MultiLineString )
-      mpl = feature.geometry().asMultiPolyline();
-    else if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::LineString )
-      mpl.push_back( feature.geometry().asPolyline() );
-
-    for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+    const int batchStart = features.size();
+    while ( features.size() - batchStart < FEATURE_BATCH_SIZE )
     {
-      QgsPointXY pt1, pt2;
-      bool isFirstPoint = true;
-      for ( const QgsPointXY &point : line )
+      if ( !fit.nextFeature( feature ) )
       {
-        pt2 = ct.transform( point );
+        finished = true;
+        break;
+      }
+      QgsNetworkFeature networkFeature;
+      networkFeature.feature = feature;
+      features.append( networkFeature );
+    }
 
-        int pt2Idx = findPointWithinTolerance( pt2 ) ;
-        if ( pt2Idx == -1 )
-        {
-          // no vertex already exists within tolerance - add to points, and index
-          addPointToIndex( pt2, graphVertices.count() );
-          graphVertices.push_back( pt2 );
-        }
-        else
-        {
-          // vertex already exists within tolerance - use that
-          pt2 = graphVertices.at( pt2Idx );
-        }
+    QtConcurrent::blockingMap( features.begin() + batchStart, features.end(), prepareFeature );
 
-        if ( !isFirstPoint )
-        {
-          // check if this line segment is a candidate for being closest to each additional point
-          int i = 0;
-          for ( const QgsPointXY &additionalPoint : additionalPoints )
-          {
+    for ( int i = batchStart; i < features.size(); ++i )
+    {
+      QgsNetworkFeature &networkFeature = features[ i ];
+      if ( !networkFeature.transformError.isEmpty() )
+        throw QgsCsException( networkFeature.transformError );
 
-            QgsPointXY snappedPoint;
-            double thisSegmentClosestDist = std::numeric_limits<double>::max();
-            if ( pt1 == pt2 )
-            {
-              thisSegmentClosestDist = additionalPoint.sqrDist( pt1 );
-              snappedPoint = pt1;
-            }
-            else
-            {
-              thisSegmentClosestDist = additionalPoint.sqrDistToSegment( pt1.x(), pt1.y(),
-                                       pt2.x(), pt2.y(), snappedPoint, 0 );
-            }
-
-            if ( thisSegmentClosestDist < additionalTiePoints[ i ].mLength )
-            {
-              // found a closer segment for this additional point
-              TiePointInfo info( i, feature.id(), pt1, pt2 );
-              info.mLength = thisSegmentClosestDist;
-              info.mTiedPoint = snappedPoint;
-
-              additionalTiePoints[ i ] = info;
-              snappedPoints[ i ] = info.mTiedPoint;
-            }
-            i++;
-          }
+      networkFeature.firstSegment = segments.size();
+      for ( const QgsPolylineXY &line : qgis::as_const( networkFeature.lines ) )
+      {
+        int pt1Idx = -1;
+        for ( const QgsPointXY &point : line )
+        {
+          const int pt2Idx = findOrAddVertex( point );
+          if ( pt1Idx != -1 )
+            segments.append( { pt1Idx, pt2Idx } );
+          pt1Idx = pt2Idx;
         }
-        pt1 = pt2;
-        isFirstPoint = false;
       }
-    }
-    if ( feedback )
-      feedback->setProgress( 100.0 * static_cast< double >( ++step ) / featureCount );
-  }
+      networkFeature.endSegment = segments.size();
+      networkFeature.lines.clear();
 
-  // build a hash of feature ids to tie points which depend on this feature
-  QHash< QgsFeatureId, QList< int > > tiePointNetworkFeatures;
-  int i = 0;
-  for ( TiePointInfo &info : additionalTiePoints )
-  {
-    tiePointNetworkFeatures[ info.mNetworkFeatureId ] << i;
-    i++;
+      if ( feedback )
+        feedback->setProgress( 100.0 * static_cast< double >( ++step ) / featureCount );
+    }
   }
 
-  // add tied point to graph
-  for ( int i = 0; i < snappedPoints.size(); ++i )
+  // snap additional points to the closest network segments, in parallel
+  if ( !additionalPoints.isEmpty() && !segments.isEmpty() )
   {
-    // check index to see if vertex exists within tolerance of tie point
-    const QgsPointXY point = snappedPoints.at( i );
-    int ptIdx = findPointWithinTolerance( point );
-    if ( ptIdx == -1 )
+    const QgsNetworkSegmentGrid segmentGrid( segments, graphVertices );
+    TiePointInfo *tiePoints = additionalTiePoints.data();
+    QVector< int > pointIndices;
+    pointIndices.reserve( additionalPoints.size() );
+    for ( int i = 0; i < additionalPoints.size(); ++i )
+      pointIndices << i;
+
+    QtConcurrent::blockingMap( pointIndices, [&segmentGrid, &additionalPoints, tiePoints]( int i )
     {
-      // no vertex already within tolerance, add to index and network vertices
-      addPointToIndex( point, graphVertices.count() );
-      graphVertices.push_back( point );
-    }
-    else
+      TiePointInfo &info = tiePoints[ i ];
+      info.segment = segmentGrid.closestSegment( additionalPoints.at( i ), info.mTiedPoint, info.mLength );
+    } );
+
+    for ( int i = 0; i < additionalTiePoints.size(); ++i )
     {
-      // otherwise snap tie point to vertex
-      snappedPoints[ i ] = graphVertices.at( ptIdx );
+      if ( additionalTiePoints.at( i ).segment != -1 )
+        snappedPoints[ i ] = additionalTiePoints.at( i ).mTiedPoint;
     }
   }
-  // also need to update tie points - they need to be matched for snapped points
-  for ( int i = 0; i < additionalTiePoints.count(); ++i )
+
+  // add tied point to graph, and build a hash of segments to tie points which depend on this segment
+  QHash< int, QVector< int > > segmentTiePoints;
+  for ( int i = 0; i < snappedPoints.size(); ++i )
   {
-    additionalTiePoints[ i ].mTiedPoint = snappedPoints.at( additionalTiePoints.at( i ).additionalPointId );
+    // snap tie point to an existing vertex within tolerance, or add it to the network vertices
+    const int ptIdx = findOrAddVertex( snappedPoints.at( i ) );
+    snappedPoints[ i ] = graphVertices.at( ptIdx );
+
+    TiePointInfo &info = additionalTiePoints[ i ];
+    info.vertex = ptIdx;
+    info.mTiedPoint = snappedPoints.at( i );
+    if ( info.segment != -1 )
+      segmentTiePoints[ info.segment ] << i;
   }
 
-
   // begin graph construction
 
   // add vertices to graph
@@ -324,96 +519,81 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
     }
   }
 
-  fit = mSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( requiredAttributes() ) );
-  while ( fit.nextFeature( feature ) )
+  // split the segments at their tie points, and measure the resulting arcs in parallel
+  const QgsDistanceArea *distanceArea = builder->distanceArea();
+  auto buildArcs = [&segments, &graphVertices, &segmentTiePoints, &additionalTiePoints, distanceArea, feedback]( QgsNetworkFeature & networkFeature )
   {
     if ( feedback && feedback->isCanceled() )
       return;
 
-    Direction direction = directionForFeature( feature );
-
-    // begin features segments and add arc to the Graph;
-    QgsMultiPolylineXY mpl;
-    if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::MultiLineString )
-      mpl = feature.geometry().asMultiPolyline();
-    else if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::LineString )
-      mpl.push_back( feature.geometry().asPolyline() );
-
-    for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+    const QgsDistanceArea da = *distanceArea;
+    for ( int segment = networkFeature.firstSegment; segment < networkFeature.endSegment; ++segment )
     {
-      QgsPointXY pt1, pt2;
+      const int pt1Idx = segments.at( segment ).from;
+      const int pt2Idx = segments.at( segment ).to;
+      const QgsPointXY &pt1 = graphVertices.at( pt1Idx );
 
-      bool isFirstPoint = true;
-      for ( const QgsPointXY &point : line )
+      QMap< double, int > pointsOnArc;
+      pointsOnArc[ 0.0 ] = pt1Idx;
+      pointsOnArc[ pt1.sqrDist( graphVertices.at( pt2Idx ) )] = pt2Idx;
+
+      const auto tiePointsForSegment = segmentTiePoints.constFind( segment );
+      if ( tiePointsForSegment != segmentTiePoints.constEnd() )
       {
-        pt2 = ct.transform( point );
-        int pPt2idx = findPointWithinTolerance( pt2 );
-        Q_ASSERT_X( pPt2idx >= 0, "QgsVectorLayerDirectory::makeGraph", "encountered a vertex which was not present in graph" );
-        pt2 = graphVertices.at( pPt2idx );
+        for ( int tiePointIdx : tiePointsForSegment.value() )
+        {
+          const TiePointInfo &t = additionalTiePoints.at( tiePointIdx );
+          pointsOnArc[ pt1.sqrDist( t.mTiedPoint )] = t.vertex;
+        }
+      }
 
-        if ( !isFirstPoint )
+      int arcPt1Idx = -1;
+      for ( auto arcPointIt = pointsOnArc.constBegin(); arcPointIt != pointsOnArc.constEnd(); ++arcPointIt )
+      {
+        const int arcPt2Idx = arcPointIt.value();
+        if ( arcPt1Idx != -1 && arcPt1Idx != arcPt2Idx )
         {
-          QMap< double, QgsPointXY > pointsOnArc;
-          pointsOnArc[ 0.0 ] = pt1;
-          pointsOnArc[ pt1.sqrDist( pt2 )] = pt2;
+          const double distance = da.measureLine( graphVertices.at( arcPt1Idx ), graphVertices.at( arcPt2Idx ) );
+          networkFeature.arcs.append( { arcPt1Idx, arcPt2Idx, distance } );
+        }
+        arcPt1Idx = arcPt2Idx;
+      }
+    }
+  };
+  QtConcurrent::blockingMap( features, buildArcs );
 
-          const QList< int > tiePointsForCurrentFeature = tiePointNetworkFeatures.value( feature.id() );
-          for ( int tiePointIdx : tiePointsForCurrentFeature )
-          {
-            const TiePointInfo &t = additionalTiePoints.at( tiePointIdx );
-            if ( t.mFirstPoint == pt1 && t.mLastPoint == pt2 )
-            {
-              pointsOnArc[ pt1.sqrDist( t.mTiedPoint )] = t.mTiedPoint;
-            }
-          }
+  // add the arcs in the order of the features, as strategies may not be thread safe
+  for ( const QgsNetworkFeature &networkFeature : qgis::as_const( features ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
 
-          QgsPointXY arcPt1;
-          QgsPointXY arcPt2;
-          int pt1idx = -1;
-          int pt2idx = -1;
-          bool isFirstPoint = true;
-          for ( auto arcPointIt = pointsOnArc.constBegin(); arcPointIt != pointsOnArc.constEnd(); ++arcPointIt )
-          {
-            arcPt2 = arcPointIt.value();
-
-            pt2idx = findPointWithinTolerance( arcPt2 );
-            Q_ASSERT_X( pt2idx >= 0, "QgsVectorLayerDirectory::makeGraph", "encountered a vertex which was not present in graph" );
-            arcPt2 = graphVertices.at( pt2idx );
-
-            if ( !isFirstPoint && arcPt1 != arcPt2 )
-            {
-              double distance = builder->distanceArea()->measureLine( arcPt1, arcPt2 );
-              QVector< QVariant > prop;
-              prop.reserve( mStrategies.size() );
-              for ( QgsNetworkStrategy *strategy : mStrategies )
-              {
-                prop.push_back( strategy->cost( distance, feature ) );
-              }
-
-              if ( direction == Direction::DirectionForward ||
-                   direction == Direction::DirectionBoth )
-              {
-                builder->addEdge( pt1idx, arcPt1, pt2idx, arcPt2, prop );
-              }
-              if ( direction == Direction::DirectionBackward ||
-                   direction == Direction::DirectionBoth )
-              {
-                builder->addEdge( pt2idx, arcPt2, pt1idx, arcPt1, prop );
-              }
-            }
-            pt1idx = pt2idx;
-            arcPt1 = arcPt2;
-            isFirstPoint = false;
-          }
-        }
-        pt1 = pt2;
-        isFirstPoint = false;
+    Direction direction = directionForFeature( networkFeature.feature );
+
+    for ( const QgsNetworkArc &arc : networkFeature.arcs )
+    {
+      QVector< QVariant > prop;
+      prop.reserve( mStrategies.size() );
+      for ( QgsNetworkStrategy *strategy : mStrategies )
+      {
+        prop.push_back( strategy->cost( arc.distance, networkFeature.feature ) );
+      }
+
+      if ( direction == Direction::DirectionForward ||
+           direction == Direction::DirectionBoth )
+      {
+        builder->addEdge( arc.from, graphVertices.at( arc.from ), arc.to, graphVertices.at( arc.to ), prop );
+      }
+      if ( direction == Direction::DirectionBackward ||
+           direction == Direction::DirectionBoth )
+      {
+        builder->addEdge( arc.to, graphVertices.at( arc.to ), arc.from, graphVertices.at( arc.from ), prop );
       }
     }
+
     if ( feedback )
     {
       feedback->setProgress( 100.0 * static_cast< double >( ++step ) / featureCount );
     }
-
   }
 }
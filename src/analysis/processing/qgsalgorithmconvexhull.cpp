@@ -56,6 +56,11 @@ QString QgsConvexHullAlgorithm::shortHelpString() const
          QObject::tr( "See the 'Minimum bounding geometry' algorithm for a convex hull calculation which covers the whole layer or grouped subsets of features." );
 }
 
+QgsProcessingAlgorithm::Flags QgsConvexHullAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatureProcessing;
+}
+
 QgsConvexHullAlgorithm *QgsConvexHullAlgorithm::createInstance() const
 {
   return new QgsConvexHullAlgorithm();
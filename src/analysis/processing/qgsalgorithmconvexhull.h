@@ -44,6 +44,7 @@ class QgsConvexHullAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override;
     QString groupId() const override;
     QString shortHelpString() const override;
+    QgsProcessingAlgorithm::Flags flags() const override;
     QgsConvexHullAlgorithm *createInstance() const override SIP_FACTORY;
 
   protected:
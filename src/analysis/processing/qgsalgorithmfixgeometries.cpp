@@ -68,6 +68,11 @@ QString QgsFixGeometriesAlgorithm::shortHelpString() const
                       "NOTE: M values will be dropped from the output." );
 }
 
+QgsProcessingAlgorithm::Flags QgsFixGeometriesAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatureProcessing;
+}
+
 QgsFixGeometriesAlgorithm *QgsFixGeometriesAlgorithm::createInstance() const
 {
   return new QgsFixGeometriesAlgorithm();
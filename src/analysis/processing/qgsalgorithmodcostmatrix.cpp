@@ -0,0 +1,258 @@
+/***************************************************************************
+                         qgsalgorithmodcostmatrix.cpp
+                         ---------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsalgorithmodcostmatrix.h"
+
+#include "qgscontractionhierarchy.h"
+#include "qgsspatialindex.h"
+#include "qgsprocessingfeedback.h"
+#include "qgsfeatureiterator.h"
+#include "qgsunittypes.h"
+
+#include <QCryptographicHash>
+
+#include <cmath>
+
+///@cond PRIVATE
+
+//! Maximum number of costs of the blocks of rows of the matrix computed at once
+static const int MAX_COST_MATRIX_BLOCK_SIZE = 1 << 22;
+
+QString QgsOdCostMatrixAlgorithm::name() const
+{
+  return QStringLiteral( "odcostmatrix" );
+}
+
+QString QgsOdCostMatrixAlgorithm::displayName() const
+{
+  return QObject::tr( "Origin-destination cost matrix" );
+}
+
+QStringList QgsOdCostMatrixAlgorithm::tags() const
+{
+  return QObject::tr( "network,path,shortest,fastest,od,origin,destination,matrix,contraction,hierarchy" ).split( ',' );
+}
+
+QString QgsOdCostMatrixAlgorithm::shortHelpString() const
+{
+  return QObject::tr( "This algorithm computes the cost of the optimal (shortest or fastest) routes from every start point "
+                      "to every end point, and outputs them as a table.\n\n"
+                      "Points are snapped to the nearest vertex of the network. The routes are computed with a contraction "
+                      "hierarchy of the network, which can be saved to a file and loaded by later runs on the same network "
+                      "with the same path type, direction and speed settings, to skip the costly preparation of the network. "
+                      "A saved hierarchy is only loaded for the network and settings it was built with." );
+}
+
+QgsOdCostMatrixAlgorithm *QgsOdCostMatrixAlgorithm::createInstance() const
+{
+  return new QgsOdCostMatrixAlgorithm();
+}
+
+void QgsOdCostMatrixAlgorithm::initAlgorithm( const QVariantMap & )
+{
+  addCommonParams();
+  addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "START_POINTS" ), QObject::tr( "Vector layer with start points" ), QList< int >() << QgsProcessing::TypeVectorPoint ) );
+  addParameter( new QgsProcessingParameterField( QStringLiteral( "START_ID_FIELD" ), QObject::tr( "Start point ID field" ), QVariant(), QStringLiteral( "START_POINTS" ), QgsProcessingParameterField::Any, false, true ) );
+  addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "END_POINTS" ), QObject::tr( "Vector layer with end points" ), QList< int >() << QgsProcessing::TypeVectorPoint ) );
+  addParameter( new QgsProcessingParameterField( QStringLiteral( "END_ID_FIELD" ), QObject::tr( "End point ID field" ), QVariant(), QStringLiteral( "END_POINTS" ), QgsProcessingParameterField::Any, false, true ) );
+
+  addParameter( new QgsProcessingParameterFile( QStringLiteral( "HIERARCHY" ), QObject::tr( "Contraction hierarchy file" ), QgsProcessingParameterFile::File, QStringLiteral( "qgsch" ), QVariant(), true ) );
+
+  addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Cost matrix" ), QgsProcessing::TypeVector ) );
+  addParameter( new QgsProcessingParameterFileDestination( QStringLiteral( "OUTPUT_HIERARCHY" ), QObject::tr( "Contraction hierarchy" ),
+                QObject::tr( "Contraction hierarchy files" ) + QStringLiteral( " (*.qgsch)" ), QVariant(), true, false ) );
+}
+
+QVariantMap QgsOdCostMatrixAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  loadCommonParams( parameters, context, feedback );
+
+  std::unique_ptr< QgsFeatureSource > startPoints( parameterAsSource( parameters, QStringLiteral( "START_POINTS" ), context ) );
+  if ( !startPoints )
+    throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "START_POINTS" ) ) );
+
+  std::unique_ptr< QgsFeatureSource > endPoints( parameterAsSource( parameters, QStringLiteral( "END_POINTS" ), context ) );
+  if ( !endPoints )
+    throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "END_POINTS" ) ) );
+
+  const int startIdField = startPoints->fields().lookupField( parameterAsString( parameters, QStringLiteral( "START_ID_FIELD" ), context ) );
+  const int endIdField = endPoints->fields().lookupField( parameterAsString( parameters, QStringLiteral( "END_ID_FIELD" ), context ) );
+
+  QgsFields fields;
+  QgsField startField = startIdField >= 0 ? startPoints->fields().at( startIdField ) : QgsField( QString(), QVariant::Int );
+  startField.setName( QStringLiteral( "start_id" ) );
+  fields.append( startField );
+  QgsField endField = endIdField >= 0 ? endPoints->fields().at( endIdField ) : QgsField( QString(), QVariant::Int );
+  endField.setName( QStringLiteral( "end_id" ) );
+  fields.append( endField );
+  fields.append( QgsField( QStringLiteral( "cost" ), QVariant::Double ) );
+
+  QString dest;
+  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( parameters, QStringLiteral( "OUTPUT" ), context, dest, fields, QgsWkbTypes::NoGeometry, QgsCoordinateReferenceSystem() ) );
+  if ( !sink )
+    throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT" ) ) );
+
+  QVector< QgsPointXY > startPointsXY;
+  QHash< int, QgsAttributes > startAttributes;
+  loadPoints( startPoints.get(), startPointsXY, startAttributes, context, feedback );
+  QVector< QgsPointXY > endPointsXY;
+  QHash< int, QgsAttributes > endAttributes;
+  loadPoints( endPoints.get(), endPointsXY, endAttributes, context, feedback );
+
+  // the hierarchy is built without tying the points to the network, so that it only
+  // depends on the network and can be reused with other points
+  QgsContractionHierarchy hierarchy;
+  const QString hierarchyPath = parameterAsFile( parameters, QStringLiteral( "HIERARCHY" ), context );
+  const QString outputHierarchyPath = parameterAsFileOutput( parameters, QStringLiteral( "OUTPUT_HIERARCHY" ), context );
+  const QString fingerprint = !hierarchyPath.isEmpty() || !outputHierarchyPath.isEmpty() ? networkFingerprint( parameters, context, feedback ) : QString();
+  if ( feedback->isCanceled() )
+    return QVariantMap();
+  if ( !hierarchyPath.isEmpty() )
+  {
+    feedback->pushInfo( QObject::tr( "Loading contraction hierarchy…" ) );
+    hierarchy = QgsContractionHierarchy::readFromFile( hierarchyPath );
+    if ( !hierarchy.isValid() )
+      throw QgsProcessingException( QObject::tr( "Could not load contraction hierarchy from %1" ).arg( hierarchyPath ) );
+    if ( hierarchy.fingerprint() != fingerprint )
+      throw QgsProcessingException( QObject::tr( "Contraction hierarchy %1 was built from another network, or with other path type, direction or speed settings" ).arg( hierarchyPath ) );
+  }
+  else
+  {
+    feedback->pushInfo( QObject::tr( "Building graph…" ) );
+    QVector< QgsPointXY > snappedPoints;
+    mDirector->makeGraph( mBuilder.get(), QVector< QgsPointXY >(), snappedPoints, feedback );
+    std::unique_ptr< QgsGraph > graph( mBuilder->graph() );
+
+    feedback->pushInfo( QObject::tr( "Building contraction hierarchy…" ) );
+    hierarchy = QgsContractionHierarchy( *graph, 0, feedback );
+    if ( feedback->isCanceled() )
+      return QVariantMap();
+    hierarchy.setFingerprint( fingerprint );
+  }
+
+  QVariantMap outputs;
+  if ( !outputHierarchyPath.isEmpty() )
+  {
+    if ( !hierarchy.writeToFile( outputHierarchyPath ) )
+      throw QgsProcessingException( QObject::tr( "Could not write contraction hierarchy to %1" ).arg( outputHierarchyPath ) );
+    outputs.insert( QStringLiteral( "OUTPUT_HIERARCHY" ), outputHierarchyPath );
+  }
+
+  feedback->pushInfo( QObject::tr( "Snapping points to network…" ) );
+  QgsSpatialIndex index;
+  for ( int vertex = 0; vertex < hierarchy.vertexCount(); ++vertex )
+  {
+    const QgsPointXY point = hierarchy.vertexPoint( vertex );
+    index.addFeature( vertex, QgsRectangle( point, point ) );
+  }
+
+  auto snap = [&index]( const QVector< QgsPointXY > &points )
+  {
+    QVector< int > vertices;
+    vertices.reserve( points.size() );
+    for ( const QgsPointXY &point : points )
+    {
+      const QList< QgsFeatureId > nearest = index.nearestNeighbor( point, 1 );
+      vertices.append( nearest.isEmpty() ? -1 : static_cast< int >( nearest.first() ) );
+    }
+    return vertices;
+  };
+  const QVector< int > startVertices = snap( startPointsXY );
+  const QVector< int > endVertices = snap( endPointsXY );
+
+  // the matrix is computed and written by blocks of rows, so that large matrices do not have to fit in memory
+  const int columnCount = endVertices.size();
+  if ( columnCount > QgsContractionHierarchy::maximumCostMatrixSize() )
+    throw QgsProcessingException( QObject::tr( "Too many end points (%1), at most %2 end points are supported" ).arg( columnCount ).arg( QgsContractionHierarchy::maximumCostMatrixSize() ) );
+  const int blockRowCount = columnCount > 0 ? std::max( 1, MAX_COST_MATRIX_BLOCK_SIZE / columnCount ) : startVertices.size();
+  const int blockCount = startVertices.isEmpty() ? 0 : ( startVertices.size() - 1 ) / blockRowCount + 1;
+
+  feedback->pushInfo( QObject::tr( "Calculating cost matrix…" ) );
+  QgsProcessingMultiStepFeedback multiStepFeedback( std::max( 1, blockCount ), feedback );
+
+  QgsFeature feat;
+  feat.setFields( fields );
+  QgsAttributes attributes;
+  for ( int block = 0; block < blockCount && !feedback->isCanceled(); ++block )
+  {
+    multiStepFeedback.setCurrentStep( block );
+    const int blockStart = block * blockRowCount;
+    const int rowCount = std::min( blockRowCount, startVertices.size() - blockStart );
+    const QVector< double > costs = hierarchy.costMatrix( startVertices.mid( blockStart, rowCount ), endVertices, &multiStepFeedback );
+
+    for ( int row = 0; row < rowCount; ++row )
+    {
+      if ( feedback->isCanceled() )
+        break;
+
+      // point ids are 1-based
+      const int i = blockStart + row;
+      const QVariant startId = startIdField >= 0 ? startAttributes.value( i + 1 ).value( startIdField ) : QVariant( i + 1 );
+      for ( int j = 0; j < columnCount; ++j )
+      {
+        const QVariant endId = endIdField >= 0 ? endAttributes.value( j + 1 ).value( endIdField ) : QVariant( j + 1 );
+        const double cost = costs.at( row * columnCount + j );
+
+        attributes.clear();
+        attributes << startId << endId << ( std::isinf( cost ) ? QVariant() : QVariant( cost / mMultiplier ) );
+        feat.setAttributes( attributes );
+        sink->addFeature( feat, QgsFeatureSink::FastInsert );
+      }
+    }
+  }
+
+  outputs.insert( QStringLiteral( "OUTPUT" ), dest );
+  return outputs;
+}
+
+QString QgsOdCostMatrixAlgorithm::networkFingerprint( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) const
+{
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+  // settings the graph and its costs depend on, including the units of the project which scale the speeds
+  hash.addData( mNetwork->sourceCrs().toWkt().toUtf8() );
+  hash.addData( QgsUnitTypes::encodeUnit( context.project()->crs().mapUnits() ).toUtf8() );
+  const QStringList settings { QStringLiteral( "STRATEGY" ), QStringLiteral( "DIRECTION_FIELD" ), QStringLiteral( "VALUE_FORWARD" ),
+                               QStringLiteral( "VALUE_BACKWARD" ), QStringLiteral( "VALUE_BOTH" ), QStringLiteral( "DEFAULT_DIRECTION" ),
+                               QStringLiteral( "SPEED_FIELD" ), QStringLiteral( "DEFAULT_SPEED" ), QStringLiteral( "TOLERANCE" ) };
+  for ( const QString &setting : settings )
+    hash.addData( QStringLiteral( "%1=%2\n" ).arg( setting, parameterAsString( parameters, setting, context ) ).toUtf8() );
+
+  // geometries and direction and speed values of the network
+  QgsAttributeList attributes;
+  for ( const QString &field : { parameterAsString( parameters, QStringLiteral( "DIRECTION_FIELD" ), context ), parameterAsString( parameters, QStringLiteral( "SPEED_FIELD" ), context ) } )
+  {
+    const int index = field.isEmpty() ? -1 : mNetwork->fields().lookupField( field );
+    if ( index >= 0 )
+      attributes << index;
+  }
+
+  QgsFeatureIterator it = mNetwork->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( attributes ) );
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( feedback->isCanceled() )
+      break;
+
+    hash.addData( feature.geometry().asWkb() );
+    for ( int attribute : qgis::as_const( attributes ) )
+      hash.addData( feature.attribute( attribute ).toString().toUtf8() + '\n' );
+  }
+
+  return QString::fromLatin1( hash.result().toHex() );
+}
+
+///@endcond
@@ -17,9 +17,13 @@
 
 #include "qgsalgorithmrasterzonalstats.h"
 #include "qgsstringutils.h"
-#include "qgsstatisticalsummary.h"
 #include "qgsrasterprojector.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <limits>
+
 ///@cond PRIVATE
 
 QString QgsRasterLayerZonalStatsAlgorithm::name() const
@@ -189,11 +193,30 @@ QVariantMap QgsRasterLayerZonalStatsAlgorithm::processAlgorithm( const QVariantM
       throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT_TABLE" ) ) );
   }
 
+  // only calculate cheap stats-- we cannot calculate stats which require holding values in memory -- because otherwise we'll end
+  // up trying to store EVERY pixel value from the input in memory
   struct StatCalculator
   {
-    // only calculate cheap stats-- we cannot calculate stats which require holding values in memory -- because otherwise we'll end
-    // up trying to store EVERY pixel value from the input in memory
-    QgsStatisticalSummary s{ QgsStatisticalSummary::Count | QgsStatisticalSummary::Sum | QgsStatisticalSummary::Min | QgsStatisticalSummary::Max | QgsStatisticalSummary::Mean };
+    qgssize count = 0;
+    double sum = 0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    void addValue( double value )
+    {
+      ++count;
+      sum += value;
+      min = std::min( min, value );
+      max = std::max( max, value );
+    }
+
+    void addStats( const StatCalculator &other )
+    {
+      count += other.count;
+      sum += other.sum;
+      min = std::min( min, other.min );
+      max = std::max( max, other.max );
+    }
   };
   QHash<double, StatCalculator > zoneStats;
   qgssize noDataCount = 0;
@@ -205,63 +228,135 @@ QVariantMap QgsRasterLayerZonalStatsAlgorithm::processAlgorithm( const QVariantM
   int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
   int nbBlocks = nbBlocksWidth * nbBlocksHeight;
 
-  QgsRasterIterator iter = mRefLayer == Source ? QgsRasterIterator( mSourceInterface )
-                           : QgsRasterIterator( mZonesInterface );
-  iter.startRasterRead( mRefLayer == Source ? mBand : mZonesBand, mLayerWidth, mLayerHeight, mExtent );
-
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  std::unique_ptr< QgsRasterBlock > zonesRasterBlock;
-  bool isNoData = false;
-  while ( true )
+  // each concurrent tile reads the rasters through its own clones, as raster interfaces are not thread safe
+  struct TileReaders
   {
-    if ( mRefLayer == Source )
-    {
-      if ( !iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop, &blockExtent ) )
-        break;
+    std::unique_ptr< QgsRasterInterface > sourceDataProvider;
+    std::unique_ptr< QgsRasterInterface > zonesDataProvider;
+    std::unique_ptr< QgsRasterProjector > projector;
+    QgsRasterInterface *sourceInterface = nullptr;
+    QgsRasterInterface *zonesInterface = nullptr;
+  };
+  std::vector< TileReaders > readers( 1 );
+  readers.front().sourceInterface = mSourceInterface;
+  readers.front().zonesInterface = mZonesInterface;
+  const int concurrentTiles = std::max( 1, std::min( nbBlocks, QThreadPool::globalInstance()->maxThreadCount() ) );
+  while ( static_cast< int >( readers.size() ) < concurrentTiles )
+  {
+    TileReaders tileReaders;
+    tileReaders.sourceDataProvider.reset( mSourceDataProvider->clone() );
+    tileReaders.zonesDataProvider.reset( mZonesDataProvider->clone() );
+    if ( !tileReaders.sourceDataProvider || !tileReaders.zonesDataProvider )
+      break;
 
-      zonesRasterBlock.reset( mZonesInterface->block( mZonesBand, blockExtent, iterCols, iterRows ) );
-    }
-    else
+    tileReaders.sourceInterface = tileReaders.sourceDataProvider.get();
+    tileReaders.zonesInterface = tileReaders.zonesDataProvider.get();
+    if ( mProjector )
     {
-      if ( !iter.readNextRasterPart( mZonesBand, iterCols, iterRows, zonesRasterBlock, iterLeft, iterTop, &blockExtent ) )
-        break;
-
-      rasterBlock.reset( mSourceInterface->block( mBand, blockExtent, iterCols, iterRows ) );
+      tileReaders.projector.reset( mProjector->clone() );
+      if ( mRefLayer == Source )
+      {
+        tileReaders.projector->setInput( tileReaders.zonesDataProvider.get() );
+        tileReaders.zonesInterface = tileReaders.projector.get();
+      }
+      else
+      {
+        tileReaders.projector->setInput( tileReaders.sourceDataProvider.get() );
+        tileReaders.sourceInterface = tileReaders.projector.get();
+      }
     }
+    readers.emplace_back( std::move( tileReaders ) );
+  }
+
+  struct Tile
+  {
+    int left = 0;
+    int top = 0;
+    const TileReaders *readers = nullptr;
+    QHash<double, StatCalculator > zoneStats;
+    qgssize noDataCount = 0;
+  };
+
+  auto readTile = [&]( Tile & tile )
+  {
+    if ( feedback->isCanceled() )
+      return;
+
+    // same blocks as the ones of a raster iterator
+    const int cols = std::min( maxWidth, mLayerWidth - tile.left );
+    const int rows = std::min( maxHeight, mLayerHeight - tile.top );
+    const double xMin = mExtent.xMinimum() + tile.left / static_cast< double >( mLayerWidth ) * mExtent.width();
+    const double xMax = tile.left + cols == mLayerWidth ? mExtent.xMaximum() :
+                        mExtent.xMinimum() + ( tile.left + cols ) / static_cast< double >( mLayerWidth ) * mExtent.width();
+    const double yMin = tile.top + rows == mLayerHeight ? mExtent.yMinimum() :
+                        mExtent.yMaximum() - ( tile.top + rows ) / static_cast< double >( mLayerHeight ) * mExtent.height();
+    const double yMax = mExtent.yMaximum() - tile.top / static_cast< double >( mLayerHeight ) * mExtent.height();
+    const QgsRectangle blockExtent( xMin, yMin, xMax, yMax );
+
+    std::unique_ptr< QgsRasterBlock > rasterBlock( tile.readers->sourceInterface->block( mBand, blockExtent, cols, rows ) );
+    std::unique_ptr< QgsRasterBlock > zonesRasterBlock( tile.readers->zonesInterface->block( mZonesBand, blockExtent, cols, rows ) );
     if ( !zonesRasterBlock || !rasterBlock )
-      continue;
+      return;
 
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
     if ( !rasterBlock->isValid() || rasterBlock->isEmpty() || !zonesRasterBlock->isValid() || zonesRasterBlock->isEmpty() )
-      continue;
+      return;
 
-    for ( int row = 0; row < iterRows; row++ )
+    bool isNoData = false;
+    for ( int row = 0; row < rows; row++ )
     {
       if ( feedback->isCanceled() )
         break;
 
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < cols; column++ )
       {
         double value = rasterBlock->valueAndNoData( row, column, isNoData );
         if ( mHasNoDataValue && isNoData )
         {
-          noDataCount += 1;
+          tile.noDataCount += 1;
           continue;
         }
         double zone = zonesRasterBlock->valueAndNoData( row, column, isNoData );
         if ( mZonesHasNoDataValue && isNoData )
         {
-          noDataCount += 1;
+          tile.noDataCount += 1;
           continue;
         }
-        zoneStats[ zone ].s.addValue( value );
+        tile.zoneStats[ zone ].addValue( value );
       }
     }
+  };
+
+  // read a wave of tiles in parallel, then merge their statistics in order
+  std::vector< Tile > tiles;
+  for ( int firstBlock = 0; firstBlock < nbBlocks; firstBlock += static_cast< int >( readers.size() ) )
+  {
+    if ( feedback->isCanceled() )
+      break;
+
+    feedback->setProgress( 100.0 * firstBlock / nbBlocks );
+
+    const int waveTiles = std::min( static_cast< int >( readers.size() ), nbBlocks - firstBlock );
+    tiles.clear();
+    tiles.resize( static_cast< std::size_t >( waveTiles ) );
+    for ( int i = 0; i < waveTiles; ++i )
+    {
+      Tile &tile = tiles[ static_cast< std::size_t >( i ) ];
+      tile.left = ( ( firstBlock + i ) % nbBlocksWidth ) * maxWidth;
+      tile.top = ( ( firstBlock + i ) / nbBlocksWidth ) * maxHeight;
+      tile.readers = &readers[ static_cast< std::size_t >( i ) ];
+    }
+
+    if ( waveTiles > 1 )
+      QtConcurrent::blockingMap( tiles, readTile );
+    else
+      readTile( tiles.front() );
+
+    for ( const Tile &tile : tiles )
+    {
+      noDataCount += tile.noDataCount;
+      for ( auto it = tile.zoneStats.constBegin(); it != tile.zoneStats.constEnd(); ++it )
+        zoneStats[ it.key() ].addStats( it.value() );
+    }
   }
 
   QVariantMap outputs;
@@ -277,9 +372,8 @@ QVariantMap QgsRasterLayerZonalStatsAlgorithm::processAlgorithm( const QVariantM
   for ( auto it = zoneStats.begin(); it != zoneStats.end(); ++it )
   {
     QgsFeature f;
-    it->s.finalize();
-    f.setAttributes( QgsAttributes() << it.key() << it->s.count() * pixelArea << it->s.sum() << it->s.count() <<
-                     it->s.min() << it->s.max() << it->s.mean() );
+    f.setAttributes( QgsAttributes() << it.key() << it->count * pixelArea << it->sum << it->count <<
+                     it->min << it->max << it->sum / it->count );
     sink->addFeature( f, QgsFeatureSink::FastInsert );
   }
   outputs.insert( QStringLiteral( "OUTPUT_TABLE" ), tableDest );
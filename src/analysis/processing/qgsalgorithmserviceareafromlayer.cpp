@@ -19,6 +19,7 @@
 
 #include "qgsgeometryutils.h"
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
 
 ///@cond PRIVATE
 
@@ -110,6 +111,7 @@ QVariantMap QgsServiceAreaFromLayerAlgorithm::processAlgorithm( const QVariantMa
 
   feedback->pushInfo( QObject::tr( "Calculating service areas…" ) );
   QgsGraph *graph = mBuilder->graph();
+  const QgsCompactGraph compactGraph( *graph );
 
   QgsFields fields = startPoints->fields();
   fields.append( QgsField( QStringLiteral( "type" ), QVariant::String ) );
@@ -147,7 +149,7 @@ QVariantMap QgsServiceAreaFromLayerAlgorithm::processAlgorithm( const QVariantMa
     idxStart = graph->findVertex( snappedPoints.at( i ) );
     origPoint = points.at( i ).toString();
 
-    QgsGraphAnalyzer::dijkstra( graph, idxStart, 0, &tree, &costs );
+    QgsGraphAnalyzer::dijkstra( &compactGraph, idxStart, 0, &tree, &costs );
 
     QgsMultiPointXY areaPoints;
     QgsMultiPolylineXY lines;
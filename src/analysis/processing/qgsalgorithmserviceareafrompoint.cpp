@@ -19,6 +19,7 @@
 
 #include "qgsgeometryutils.h"
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
 
 ///@cond PRIVATE
 
@@ -104,11 +105,12 @@ QVariantMap QgsServiceAreaFromPointAlgorithm::processAlgorithm( const QVariantMa
 
   feedback->pushInfo( QObject::tr( "Calculating service area…" ) );
   QgsGraph *graph = mBuilder->graph();
+  const QgsCompactGraph compactGraph( *graph );
   int idxStart = graph->findVertex( snappedPoints[0] );
 
   QVector< int > tree;
   QVector< double > costs;
-  QgsGraphAnalyzer::dijkstra( graph, idxStart, 0, &tree, &costs );
+  QgsGraphAnalyzer::dijkstra( &compactGraph, idxStart, 0, &tree, &costs );
 
   QgsMultiPointXY points;
   QgsMultiPolylineXY lines;
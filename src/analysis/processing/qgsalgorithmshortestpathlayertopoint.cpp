@@ -18,6 +18,7 @@
 #include "qgsalgorithmshortestpathlayertopoint.h"
 
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
 
 #include "qgsmessagelog.h"
 
@@ -88,6 +89,7 @@ QVariantMap QgsShortestPathLayerToPointAlgorithm::processAlgorithm( const QVaria
 
   feedback->pushInfo( QObject::tr( "Calculating shortest paths…" ) );
   QgsGraph *graph = mBuilder->graph();
+  const QgsCompactGraph compactGraph( *graph );
   int idxEnd = graph->findVertex( snappedPoints[0] );
   int idxStart;
   int currentIdx;
@@ -111,7 +113,7 @@ QVariantMap QgsShortestPathLayerToPointAlgorithm::processAlgorithm( const QVaria
     }
 
     idxStart = graph->findVertex( snappedPoints[i] );
-    QgsGraphAnalyzer::dijkstra( graph, idxStart, 0, &tree, &costs );
+    QgsGraphAnalyzer::dijkstra( &compactGraph, idxStart, 0, &tree, &costs );
 
     if ( tree.at( idxEnd ) == -1 )
     {
@@ -18,6 +18,7 @@
 #include "qgsalgorithmshortestpathpointtolayer.h"
 
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
 
 #include "qgsmessagelog.h"
 
@@ -88,12 +89,13 @@ QVariantMap QgsShortestPathPointToLayerAlgorithm::processAlgorithm( const QVaria
 
   feedback->pushInfo( QObject::tr( "Calculating shortest paths…" ) );
   QgsGraph *graph = mBuilder->graph();
+  const QgsCompactGraph compactGraph( *graph );
   int idxStart = graph->findVertex( snappedPoints[0] );
   int idxEnd;
 
   QVector< int > tree;
   QVector< double > costs;
-  QgsGraphAnalyzer::dijkstra( graph, idxStart, 0, &tree, &costs );
+  QgsGraphAnalyzer::dijkstra( &compactGraph, idxStart, 0, &tree, &costs );
 
   QVector<QgsPointXY> route;
   double cost;
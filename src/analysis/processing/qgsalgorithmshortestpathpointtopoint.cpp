@@ -18,6 +18,7 @@
 #include "qgsalgorithmshortestpathpointtopoint.h"
 
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
 
 ///@cond PRIVATE
 
@@ -84,22 +85,20 @@ QVariantMap QgsShortestPathPointToPointAlgorithm::processAlgorithm( const QVaria
   int idxStart = graph->findVertex( snappedPoints[0] );
   int idxEnd = graph->findVertex( snappedPoints[1] );
 
-  QVector< int > tree;
-  QVector< double > costs;
-  QgsGraphAnalyzer::dijkstra( graph, idxStart, 0, &tree, &costs );
+  const QgsCompactGraph compactGraph( *graph );
+  double cost = 0;
+  const QVector< int > path = QgsGraphAnalyzer::shortestPath( &compactGraph, idxStart, idxEnd, 0, &cost );
 
-  if ( tree.at( idxEnd ) == -1 )
+  if ( path.size() < 2 )
   {
     throw QgsProcessingException( QObject::tr( "There is no route from start point to end point." ) );
   }
 
   QVector<QgsPointXY> route;
-  route.push_front( graph->vertex( idxEnd ).point() );
-  double cost = costs.at( idxEnd );
-  while ( idxEnd != idxStart )
+  route.reserve( path.size() );
+  for ( int vertex : path )
   {
-    idxEnd = graph->edge( tree.at( idxEnd ) ).fromVertex();
-    route.push_front( graph->vertex( idxEnd ).point() );
+    route.append( compactGraph.vertexPoint( vertex ) );
   }
 
   feedback->pushInfo( QObject::tr( "Writing results…" ) );
@@ -56,6 +56,11 @@ QString QgsSwapXYAlgorithm::shortHelpString() const
                       "which have accidentally had their latitude and longitude values reversed." );
 }
 
+QgsProcessingAlgorithm::Flags QgsSwapXYAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatureProcessing;
+}
+
 QgsSwapXYAlgorithm *QgsSwapXYAlgorithm::createInstance() const
 {
   return new QgsSwapXYAlgorithm();
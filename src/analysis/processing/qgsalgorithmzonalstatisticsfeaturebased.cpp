@@ -19,6 +19,9 @@
 
 ///@cond PRIVATE
 
+//! Number of features whose statistics are calculated together
+static const int FEATURE_BATCH_SIZE = 10000;
+
 const std::vector< QgsZonalStatistics::Statistic > STATS
 {
   QgsZonalStatistics::Count,
@@ -160,10 +163,93 @@ QgsFeatureList QgsZonalStatisticsFeatureBasedAlgorithm::processFeature( const Qg
 {
   Q_UNUSED( context )
   Q_UNUSED( feedback )
+  QMap<QgsZonalStatistics::Statistic, QVariant> results = QgsZonalStatistics::calculateStatistics( mRaster.get(), feature.geometry(), mPixelSizeX, mPixelSizeY, mBand, mStats );
+  return QgsFeatureList { resultFeature( feature, results ) };
+}
+
+QVariantMap QgsZonalStatisticsFeatureBasedAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  std::unique_ptr< QgsProcessingFeatureSource > source( parameterAsSource( parameters, inputParameterName(), context ) );
+  if ( !source )
+    throw QgsProcessingException( invalidSourceError( parameters, inputParameterName() ) );
+
+  QString dest;
+  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( parameters, QStringLiteral( "OUTPUT" ), context, dest,
+                                          outputFields( source->fields() ),
+                                          outputWkbType( source->wkbType() ),
+                                          outputCrs( source->sourceCrs() ),
+                                          sinkFlags() ) );
+  if ( !sink )
+    throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT" ) ) );
+
+  const long count = source->featureCount();
+  const double step = count > 0 ? 100.0 / count : 1;
+  int current = 0;
+
+  // features are processed in batches, so that the raster is read once for all the features of a batch
+  QgsFeatureList batchFeatures;
+  QVector< QgsGeometry > batchGeometries;
+  auto processBatch = [&]
+  {
+    const QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > results = QgsZonalStatistics::calculateStatistics( mRaster.get(), batchGeometries, mPixelSizeX, mPixelSizeY, mBand, mStats, feedback );
+    for ( int i = 0; i < batchFeatures.size() && !feedback->isCanceled(); ++i )
+    {
+      context.expressionContext().setFeature( batchFeatures.at( i ) );
+      QgsFeature feature = resultFeature( batchFeatures.at( i ), results.at( i ) );
+      sink->addFeature( feature, QgsFeatureSink::FastInsert );
+    }
+    batchFeatures.clear();
+    batchGeometries.clear();
+  };
+
+  auto processFeatures = [&]( QgsFeatureIterator it )
+  {
+    QgsFeature f;
+    while ( it.nextFeature( f ) )
+    {
+      if ( feedback->isCanceled() )
+        break;
+
+      batchFeatures << f;
+      batchGeometries << f.geometry();
+      if ( batchFeatures.size() >= FEATURE_BATCH_SIZE )
+        processBatch();
+
+      feedback->setProgress( current * step );
+      current++;
+    }
+
+    if ( !batchFeatures.isEmpty() && !feedback->isCanceled() )
+      processBatch();
+  };
+
+  if ( count >= 0 && count <= FEATURE_BATCH_SIZE )
+  {
+    processFeatures( source->getFeatures( request(), sourceFlags() ) );
+  }
+  else
+  {
+    // batches taken in the order of the source would each read most of the raster
+    const QList< QgsFeatureIds > batches = QgsZonalStatistics::featureBatches( source.get(), request(), mRaster->extent(), mPixelSizeX, mPixelSizeY, FEATURE_BATCH_SIZE, feedback );
+    for ( const QgsFeatureIds &batch : batches )
+    {
+      if ( feedback->isCanceled() )
+        break;
+
+      processFeatures( source->getFeatures( QgsFeatureRequest( request() ).setFilterFids( batch ), sourceFlags() ) );
+    }
+  }
+
+  QVariantMap outputs;
+  outputs.insert( QStringLiteral( "OUTPUT" ), dest );
+  return outputs;
+}
+
+QgsFeature QgsZonalStatisticsFeatureBasedAlgorithm::resultFeature( const QgsFeature &feature, const QMap<QgsZonalStatistics::Statistic, QVariant> &results ) const
+{
   QgsAttributes attributes = feature.attributes();
   attributes.resize( mOutputFields.size() );
 
-  QMap<QgsZonalStatistics::Statistic, QVariant> results = QgsZonalStatistics::calculateStatistics( mRaster.get(), feature.geometry(), mPixelSizeX, mPixelSizeY, mBand, mStats );
   for ( auto result = results.constBegin(); result != results.constEnd(); ++result )
   {
     attributes.replace( mStatFieldsMapping.value( result.key() ), result.value() );
@@ -171,8 +257,7 @@ QgsFeatureList QgsZonalStatisticsFeatureBasedAlgorithm::processFeature( const Qg
 
   QgsFeature resultFeature = feature;
   resultFeature.setAttributes( attributes );
-
-  return QgsFeatureList { resultFeature };
+  return resultFeature;
 }
 
 bool QgsZonalStatisticsFeatureBasedAlgorithm::supportInPlaceEdit( const QgsMapLayer *layer ) const
@@ -54,9 +54,14 @@ class QgsZonalStatisticsFeatureBasedAlgorithm : public QgsProcessingFeatureBased
 
     bool prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
     QgsFeatureList processFeature( const QgsFeature &feature,  QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    QVariantMap processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
     bool supportInPlaceEdit( const QgsMapLayer *layer ) const override;
 
   private:
+
+    //! Returns a copy of \a feature with the \a results of its statistics
+    QgsFeature resultFeature( const QgsFeature &feature, const QMap<QgsZonalStatistics::Statistic, QVariant> &results ) const;
+
     std::unique_ptr< QgsRasterInterface > mRaster;
     int mBand;
     QString mPrefix;
@@ -20,6 +20,10 @@
 #include "qgsrasteriterator.h"
 #include "qgsgeos.h"
 #include "qgsprocessingparameters.h"
+#include "qgscurvepolygon.h"
+#include "qgsgeometrycollection.h"
+#include "qgslinestring.h"
+#include <algorithm>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
@@ -59,18 +63,187 @@ void QgsRasterAnalysisUtils::cellInfoForBBox( const QgsRectangle &rasterBBox, co
                                     rasterBBox.yMaximum() - ( nCellsY + offsetY ) * cellSizeY );
 }
 
-void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double )> &addValue, bool skipNodata )
+/**
+ * Edge of a polygon ring crossed by the center lines of the rows of a grid, or horizontal
+ * edge lying on the center line of a row.
+ */
+struct ScanlineEdge
 {
-  std::unique_ptr< QgsGeometryEngine > polyEngine( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
-  if ( !polyEngine )
+  double x1;
+  double y1;
+  double x2;
+  double y2;
+  int firstRow;
+  int lastRow;
+};
+
+//! Returns the row or column \a index, clamped to the \a count rows or columns of the grid
+static int scanlineIndex( double index, int count )
+{
+  return static_cast< int >( std::max( 0.0, std::min( static_cast< double >( count - 1 ), index ) ) );
+}
+
+//! Adds the edges of a ring to \a edges, returns FALSE if the ring is not a line string
+static bool addScanlineEdges( const QgsCurve *ring, double gridTop, int nCellsY, double cellSizeY, std::vector< ScanlineEdge > &edges )
+{
+  const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( ring );
+  if ( !line )
+    return false;
+
+  const double *x = line->xData();
+  const double *y = line->yData();
+  const int count = line->numPoints();
+  for ( int i = 0; i + 1 < count; ++i )
   {
-    return;
+    // horizontal edges are never crossed by a center line, but the centers lying on them are on the boundary
+    if ( y[i] == y[i + 1] )
+    {
+      const int row = static_cast< int >( std::round( ( gridTop - y[i] ) / cellSizeY - 0.5 ) );
+      if ( row >= 0 && row < nCellsY && gridTop - ( row + 0.5 ) * cellSizeY == y[i] )
+        edges.push_back( ScanlineEdge{ x[i], y[i], x[i + 1], y[i + 1], row, row } );
+      continue;
+    }
+
+    // rows whose center line may cross the edge, exactly tested for each row
+    const double yMin = std::min( y[i], y[i + 1] );
+    const double yMax = std::max( y[i], y[i + 1] );
+    const int firstRow = scanlineIndex( std::floor( ( gridTop - yMax ) / cellSizeY - 0.5 ), nCellsY );
+    const int lastRow = scanlineIndex( std::ceil( ( gridTop - yMin ) / cellSizeY - 0.5 ), nCellsY );
+    if ( firstRow > lastRow )
+      continue;
+
+    edges.push_back( ScanlineEdge{ x[i], y[i], x[i + 1], y[i + 1], firstRow, lastRow } );
   }
-  polyEngine->prepareGeometry();
+  return true;
+}
+
+static bool addScanlineEdges( const QgsCurvePolygon *polygon, double gridTop, int nCellsY, double cellSizeY, std::vector< ScanlineEdge > &edges )
+{
+  if ( !polygon->exteriorRing() || !addScanlineEdges( polygon->exteriorRing(), gridTop, nCellsY, cellSizeY, edges ) )
+    return false;
+
+  for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+  {
+    if ( !addScanlineEdges( polygon->interiorRing( i ), gridTop, nCellsY, cellSizeY, edges ) )
+      return false;
+  }
+  return true;
+}
+
+bool QgsRasterAnalysisUtils::middlePointCells( const QgsGeometry &poly, const QgsRectangle &gridExtent, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY,
+    const std::function<void( int, int, int )> &addCells )
+{
+  QgsGeometry polygon = poly;
+  if ( QgsWkbTypes::isCurvedType( polygon.wkbType() ) )
+    polygon.convertToStraightSegment();
+
+  const double gridLeft = gridExtent.xMinimum();
+  const double gridTop = gridExtent.yMaximum();
+
+  std::vector< ScanlineEdge > edges;
+  const QgsAbstractGeometry *geometry = polygon.constGet();
+  if ( const QgsCurvePolygon *curvePolygon = qgsgeometry_cast< const QgsCurvePolygon * >( geometry ) )
+  {
+    if ( !addScanlineEdges( curvePolygon, gridTop, nCellsY, cellSizeY, edges ) )
+      return false;
+  }
+  else if ( const QgsGeometryCollection *collection = qgsgeometry_cast< const QgsGeometryCollection * >( geometry ) )
+  {
+    for ( int i = 0; i < collection->numGeometries(); ++i )
+    {
+      const QgsCurvePolygon *part = qgsgeometry_cast< const QgsCurvePolygon * >( collection->geometryN( i ) );
+      if ( !part || !addScanlineEdges( part, gridTop, nCellsY, cellSizeY, edges ) )
+        return false;
+    }
+  }
+  else
+  {
+    return false;
+  }
+
+  if ( edges.empty() || nCellsX <= 0 || nCellsY <= 0 )
+    return true;
+
+  // edges become active from their first row, and are dropped after their last row
+  std::sort( edges.begin(), edges.end(), []( const ScanlineEdge & a, const ScanlineEdge & b ) { return a.firstRow < b.firstRow; } );
+  int lastRow = 0;
+  for ( const ScanlineEdge &edge : edges )
+    lastRow = std::max( lastRow, edge.lastRow );
+
+  auto centerX = [gridLeft, cellSizeX]( int column ) { return gridLeft + ( column + 0.5 ) * cellSizeX; };
+
+  // cells of a run of a row, except the ones whose center lies on a horizontal edge
+  std::vector< std::pair< double, double > > horizontalEdges;
+  auto addRowCells = [&]( int row, int firstColumn, int lastColumn )
+  {
+    for ( const std::pair< double, double > &edge : horizontalEdges )
+    {
+      int edgeFirstColumn = scanlineIndex( std::floor( ( edge.first - gridLeft ) / cellSizeX - 0.5 ), nCellsX );
+      while ( edgeFirstColumn < nCellsX && centerX( edgeFirstColumn ) < edge.first )
+        ++edgeFirstColumn;
+      int edgeLastColumn = scanlineIndex( std::ceil( ( edge.second - gridLeft ) / cellSizeX - 0.5 ), nCellsX );
+      while ( edgeLastColumn >= 0 && centerX( edgeLastColumn ) > edge.second )
+        --edgeLastColumn;
+      if ( edgeFirstColumn > edgeLastColumn || edgeLastColumn < firstColumn || edgeFirstColumn > lastColumn )
+        continue;
+
+      if ( edgeFirstColumn > firstColumn )
+        addCells( row, firstColumn, edgeFirstColumn - 1 );
+      firstColumn = edgeLastColumn + 1;
+      if ( firstColumn > lastColumn )
+        return;
+    }
+    addCells( row, firstColumn, lastColumn );
+  };
+
+  std::vector< const ScanlineEdge * > active;
+  std::vector< double > crossings;
+  std::size_t nextEdge = 0;
+  for ( int row = edges.front().firstRow; row <= lastRow; ++row )
+  {
+    while ( nextEdge < edges.size() && edges[ nextEdge ].firstRow <= row )
+      active.push_back( &edges[ nextEdge++ ] );
+    active.erase( std::remove_if( active.begin(), active.end(), [row]( const ScanlineEdge * edge ) { return edge->lastRow < row; } ), active.end() );
+
+    // each edge is crossed by the center line if it is between its end points, including the lower one only
+    const double y = gridTop - ( row + 0.5 ) * cellSizeY;
+    crossings.clear();
+    horizontalEdges.clear();
+    for ( const ScanlineEdge *edge : active )
+    {
+      if ( edge->y1 == edge->y2 )
+        horizontalEdges.emplace_back( std::min( edge->x1, edge->x2 ), std::max( edge->x1, edge->x2 ) );
+      else if ( ( edge->y1 > y ) != ( edge->y2 > y ) )
+        crossings.push_back( edge->x1 + ( y - edge->y1 ) * ( edge->x2 - edge->x1 ) / ( edge->y2 - edge->y1 ) );
+    }
+    std::sort( crossings.begin(), crossings.end() );
+    std::sort( horizontalEdges.begin(), horizontalEdges.end() );
 
+    // even-odd rule: centers strictly between pairs of crossings are within the polygon
+    for ( std::size_t i = 0; i + 1 < crossings.size(); i += 2 )
+    {
+      const double left = crossings[i];
+      const double right = crossings[i + 1];
+      int firstColumn = scanlineIndex( std::floor( ( left - gridLeft ) / cellSizeX - 0.5 ), nCellsX );
+      while ( firstColumn < nCellsX && centerX( firstColumn ) <= left )
+        ++firstColumn;
+      int lastColumn = scanlineIndex( std::ceil( ( right - gridLeft ) / cellSizeX - 0.5 ), nCellsX );
+      while ( lastColumn >= 0 && centerX( lastColumn ) >= right )
+        --lastColumn;
+
+      if ( firstColumn <= lastColumn )
+        addRowCells( row, firstColumn, lastColumn );
+    }
+  }
+  return true;
+}
+
+void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double )> &addValue, bool skipNodata )
+{
   QgsRasterIterator iter( rasterInterface );
   iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
 
+  std::unique_ptr< QgsGeometryEngine > polyEngine;
   std::unique_ptr< QgsRasterBlock > block;
   int iterLeft = 0;
   int iterTop = 0;
@@ -80,6 +253,29 @@ void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *
   bool isNoData = false;
   while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop, &blockExtent ) )
   {
+    const bool filled = !polyEngine && middlePointCells( poly, blockExtent, iterCols, iterRows, cellSizeX, cellSizeY, [&]( int row, int firstColumn, int lastColumn )
+    {
+      for ( int col = firstColumn; col <= lastColumn; ++col )
+      {
+        const double pixelValue = block->valueAndNoData( row, col, isNoData );
+        if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
+          addValue( pixelValue );
+      }
+    } );
+    if ( filled )
+      continue;
+
+    // geometries which cannot be filled are tested cell by cell
+    if ( !polyEngine )
+    {
+      polyEngine.reset( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
+      if ( !polyEngine )
+      {
+        return;
+      }
+      polyEngine->prepareGeometry();
+    }
+
     double cellCenterY = blockExtent.yMaximum() - 0.5 * cellSizeY;
 
     for ( int row = 0; row < iterRows; ++row )
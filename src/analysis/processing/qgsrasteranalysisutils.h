@@ -46,6 +46,22 @@ namespace QgsRasterAnalysisUtils
                         int rasterWidth, int rasterHeight,
                         QgsRectangle &rasterBlockExtent );
 
+  /**
+   * Finds the cells of a grid whose center point is within the polygon \a poly, with a scanline fill of the polygon.
+   *
+   * The grid has \a nCellsX by \a nCellsY cells of \a cellSizeX by \a cellSizeY map units, starting from the top left
+   * corner of \a gridExtent. The cells are passed to \a addCells as runs of consecutive cells of a row, given by the
+   * row and the first and last columns of the run.
+   *
+   * Like the GEOS contains test, cell centers on the boundary of the polygon are not within it.
+   *
+   * Returns FALSE without finding any cell if \a poly is not a (multi)polygon.
+   *
+   * \since QGIS 3.18
+   */
+  bool middlePointCells( const QgsGeometry &poly, const QgsRectangle &gridExtent, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY,
+                         const std::function<void( int row, int firstColumn, int lastColumn )> &addCells );
+
   //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
   void statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY,
                                       double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const std::function<void( double )> &addValue, bool skipNodata = true );
@@ -27,6 +27,8 @@
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
@@ -36,6 +38,9 @@
 #include "qgsgdalutils.h"
 #endif
 
+//! Approximate number of pixels of the strips of rows calculated at once
+static const int STRIP_PIXELS = 1 << 18;
+
 QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QString &outputFile, const QString &outputFormat, const QgsRectangle &outputExtent, int nOutputColumns, int nOutputRows, const QVector<QgsRasterCalculatorEntry> &rasterEntries, const QgsCoordinateTransformContext &transformContext )
   : mFormulaString( formulaString )
   , mOutputFile( outputFile )
@@ -160,92 +165,165 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
 
-  // Take the fast route (process one line at a time) if we can
+  // Take the fast route (process one strip of rows at a time, in parallel) if we can
   if ( ! requiresMatrix )
   {
-    // Map of raster names -> blocks
-    std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
+    // Map of raster names -> entries
     std::map<QString, QgsRasterCalculatorEntry> uniqueRasterEntries;
     const QList<const QgsRasterCalcNode *> rasterRefNodes = calcNode->findNodes( QgsRasterCalcNode::Type::tRasterRef );
     for ( const QgsRasterCalcNode *r : rasterRefNodes )
     {
       QString layerRef( r->toString().remove( 0, 1 ) );
       layerRef.chop( 1 );
-      if ( ! inputBlocks.count( layerRef ) )
+      if ( ! uniqueRasterEntries.count( layerRef ) )
       {
         for ( const QgsRasterCalculatorEntry &ref : qgis::as_const( mRasterEntries ) )
         {
           if ( ref.ref == layerRef )
           {
             uniqueRasterEntries[layerRef] = ref;
-            inputBlocks[layerRef ] = qgis::make_unique<QgsRasterBlock>();
           }
         }
       }
     }
 
-    //read / write line by line
-    QMap<QString, QgsRasterBlock * > _rasterData;
-    // Cast to float
-    std::vector<float> castedResult( static_cast<size_t>( mNumOutputColumns ), 0 );
-    auto rowHeight = mOutputRectangle.height() / mNumOutputRows;
-    for ( size_t row = 0; row < static_cast<size_t>( mNumOutputRows ); ++row )
+    // strips span whole rows of input and output blocks, so that each block is read and written once
+    int blockRows = 1;
+    int outputBlockColumns = 0;
+    int outputBlockRows = 0;
+    GDALGetBlockSize( outputRasterBand, &outputBlockColumns, &outputBlockRows );
+    blockRows = std::max( blockRows, outputBlockRows );
+    for ( const auto &entry : uniqueRasterEntries )
     {
-      if ( feedback )
+      blockRows = std::max( blockRows, entry.second.raster->dataProvider()->yBlockSize() );
+    }
+    if ( static_cast< qint64 >( blockRows ) * mNumOutputColumns > 16 * static_cast< qint64 >( STRIP_PIXELS ) )
+    {
+      // huge blocks, e.g. single block images, are not worth the memory
+      blockRows = 1;
+    }
+    int stripRows = std::max( 1, STRIP_PIXELS / std::max( 1, mNumOutputColumns ) );
+    stripRows = std::max( 1, std::min( mNumOutputRows, ( ( stripRows + blockRows - 1 ) / blockRows ) * blockRows ) );
+    const int stripCount = ( mNumOutputRows + stripRows - 1 ) / stripRows;
+
+    // each concurrent strip reads its inputs through its own providers, as providers are not thread safe
+    const int concurrentStrips = std::max( 1, std::min( stripCount, QThreadPool::globalInstance()->maxThreadCount() ) );
+    std::vector< std::map<QString, std::unique_ptr<QgsRasterDataProvider>> > providers( concurrentStrips );
+    for ( auto &stripProviders : providers )
+    {
+      for ( const auto &entry : uniqueRasterEntries )
       {
-        feedback->setProgress( 100.0 * static_cast< double >( row ) / mNumOutputRows );
+        stripProviders[entry.first].reset( entry.second.raster->dataProvider()->clone() );
       }
+    }
 
+    struct Strip
+    {
+      int firstRow = 0;
+      int rows = 0;
+      int providers = 0;
+      bool ok = true;
+      std::vector<float> values;
+    };
+
+    const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+    const QgsRasterCalcNode *node = calcNode.get();
+    auto calculateStrip = [&]( Strip & strip )
+    {
       if ( feedback && feedback->isCanceled() )
-      {
-        break;
-      }
+        return;
 
-      // Calculates the rect for a single row read
+      // Calculates the rect for the strip
       QgsRectangle rect( mOutputRectangle );
-      rect.setYMaximum( rect.yMaximum() - rowHeight * row );
-      rect.setYMinimum( rect.yMaximum() - rowHeight );
+      rect.setYMaximum( rect.yMaximum() - rowHeight * strip.firstRow );
+      rect.setYMinimum( rect.yMaximum() - rowHeight * strip.rows );
 
-      // Read rows into input blocks
-      for ( auto &layerRef : inputBlocks )
+      // Read strip into input blocks
+      std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
+      QMap<QString, QgsRasterBlock * > rasterData;
+      for ( auto &provider : providers[ strip.providers ] )
       {
-        QgsRasterCalculatorEntry ref = uniqueRasterEntries[layerRef.first];
+        const QgsRasterCalculatorEntry &ref = uniqueRasterEntries.at( provider.first );
+        std::unique_ptr<QgsRasterBlock> block;
         if ( ref.raster->crs() != mOutputCrs )
         {
           QgsRasterProjector proj;
           proj.setCrs( ref.raster->crs(), mOutputCrs, mTransformContext );
-          proj.setInput( ref.raster->dataProvider() );
+          proj.setInput( provider.second.get() );
           proj.setPrecision( QgsRasterProjector::Exact );
-          layerRef.second.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          block.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, strip.rows ) );
         }
         else
         {
-          layerRef.second.reset( ref.raster->dataProvider()->block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          block.reset( provider.second->block( ref.bandNumber, rect, mNumOutputColumns, strip.rows ) );
         }
+        rasterData.insert( provider.first, block.get() );
+        inputBlocks[provider.first] = std::move( block );
       }
 
-      // 1 row X mNumOutputColumns matrix
-      QgsRasterMatrix resultMatrix( mNumOutputColumns, 1, nullptr, outputNodataValue );
+      // strip.rows X mNumOutputColumns matrix
+      QgsRasterMatrix resultMatrix( mNumOutputColumns, strip.rows, nullptr, outputNodataValue );
+      strip.ok = node->calculate( rasterData, resultMatrix, -1 );
+      if ( !strip.ok )
+        return;
+
+      // Cast to float
+      const size_t count = static_cast<size_t>( mNumOutputColumns ) * static_cast<size_t>( strip.rows );
+      if ( resultMatrix.isNumber() )
+        strip.values.assign( count, static_cast< float >( resultMatrix.number() ) );
+      else
+        strip.values.assign( resultMatrix.data(), resultMatrix.data() + count );
+    };
 
-      _rasterData.clear();
-      for ( const auto &layerRef : inputBlocks )
+    // calculate a wave of strips in parallel, then write them in order
+    std::vector<Strip> strips( static_cast<size_t>( concurrentStrips ) );
+    for ( int firstStrip = 0; firstStrip < stripCount; firstStrip += concurrentStrips )
+    {
+      if ( feedback )
       {
-        _rasterData.insert( layerRef.first, layerRef.second.get() );
+        feedback->setProgress( 100.0 * static_cast< double >( firstStrip ) / stripCount );
       }
 
-      if ( calcNode->calculate( _rasterData, resultMatrix, 0 ) )
+      if ( feedback && feedback->isCanceled() )
       {
-        std::copy( resultMatrix.data(), resultMatrix.data() + mNumOutputColumns, castedResult.begin() );
-        if ( GDALRasterIO( outputRasterBand, GF_Write, 0, row, mNumOutputColumns, 1, castedResult.data(), mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
-        {
-          QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
-        }
+        break;
+      }
+
+      const int waveStrips = std::min( concurrentStrips, stripCount - firstStrip );
+      strips.resize( static_cast<size_t>( waveStrips ) );
+      for ( int i = 0; i < waveStrips; ++i )
+      {
+        Strip &strip = strips[ static_cast<size_t>( i ) ];
+        strip.firstRow = ( firstStrip + i ) * stripRows;
+        strip.rows = std::min( stripRows, mNumOutputRows - strip.firstRow );
+        strip.providers = i;
+        strip.ok = true;
+        strip.values.clear();
       }
+
+      if ( waveStrips > 1 )
+        QtConcurrent::blockingMap( strips, calculateStrip );
       else
+        calculateStrip( strips.front() );
+
+      for ( Strip &strip : strips )
       {
-        //delete the dataset without closing (because it is faster)
-        gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
-        return CalculationError;
+        if ( !strip.ok )
+        {
+          //delete the dataset without closing (because it is faster)
+          gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
+          return CalculationError;
+        }
+        if ( strip.values.empty() )
+        {
+          // canceled
+          continue;
+        }
+
+        if ( GDALRasterIO( outputRasterBand, GF_Write, 0, strip.firstRow, mNumOutputColumns, strip.rows, strip.values.data(), mNumOutputColumns, strip.rows, GDT_Float32, 0, 0 ) != CE_None )
+        {
+          QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
+        }
       }
     }
 
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsrastermatrix.h"
+#include "qgsrastermatrixkernels_p.h"
 #include <cstring>
 #include <cmath>
 #include <algorithm>
@@ -352,7 +353,8 @@ bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMa
     int nEntries = mColumns * mRows;
     double value1, value2;
 
-    for ( int i = 0; i < nEntries; ++i )
+    const int calculated = QgsRasterMatrixKernels::twoArgumentOperation( op, mData, false, mNodataValue, matrix, false, other.mNodataValue, mData, mNodataValue, nEntries );
+    for ( int i = calculated; i < nEntries; ++i )
     {
       value1 = mData[i];
       value2 = matrix[i];
@@ -389,7 +391,8 @@ bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMa
       return true;
     }
 
-    for ( int i = 0; i < nEntries; ++i )
+    const int calculated = QgsRasterMatrixKernels::twoArgumentOperation( op, &value, true, mNodataValue, matrix, false, other.mNodataValue, mData, mNodataValue, nEntries );
+    for ( int i = calculated; i < nEntries; ++i )
     {
       if ( matrix[i] == other.mNodataValue )
       {
@@ -415,7 +418,8 @@ bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMa
       return true;
     }
 
-    for ( int i = 0; i < nEntries; ++i )
+    const int calculated = QgsRasterMatrixKernels::twoArgumentOperation( op, mData, false, mNodataValue, &value, true, other.mNodataValue, mData, mNodataValue, nEntries );
+    for ( int i = calculated; i < nEntries; ++i )
     {
       if ( mData[i] == mNodataValue )
       {
@@ -0,0 +1,132 @@
+/***************************************************************************
+  qgsrastermatrixkernels.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgsrastermatrixkernels_p.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define QGS_RASTER_MATRIX_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+///@cond PRIVATE
+
+#ifdef QGS_RASTER_MATRIX_SSE2
+
+#include "qgsrastermatrixkernelsimpl_p.h"
+
+namespace
+{
+  struct Sse2Lanes
+  {
+    typedef __m128d Type;
+    typedef __m128d Mask;
+    static const int SIZE = 2;
+
+    static Type load( const double *p ) { return _mm_loadu_pd( p ); }
+    static void store( double *p, Type v ) { _mm_storeu_pd( p, v ); }
+    static Type set( double v ) { return _mm_set1_pd( v ); }
+    static Type add( Type a, Type b ) { return _mm_add_pd( a, b ); }
+    static Type subtract( Type a, Type b ) { return _mm_sub_pd( a, b ); }
+    static Type multiply( Type a, Type b ) { return _mm_mul_pd( a, b ); }
+    static Type divide( Type a, Type b ) { return _mm_div_pd( a, b ); }
+    static Mask equal( Type a, Type b ) { return _mm_cmpeq_pd( a, b ); }
+    static Mask notEqual( Type a, Type b ) { return _mm_cmpneq_pd( a, b ); }
+    static Mask lessThan( Type a, Type b ) { return _mm_cmplt_pd( a, b ); }
+    static Mask lessEqual( Type a, Type b ) { return _mm_cmple_pd( a, b ); }
+    static Mask maskAnd( Mask a, Mask b ) { return _mm_and_pd( a, b ); }
+    static Mask maskOr( Mask a, Mask b ) { return _mm_or_pd( a, b ); }
+    static Type select( Mask mask, Type ifTrue, Type ifFalse ) { return _mm_or_pd( _mm_and_pd( mask, ifTrue ), _mm_andnot_pd( mask, ifFalse ) ); }
+  };
+}
+
+#endif
+
+static bool cpuSupportsAvx()
+{
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+  int info[4];
+  __cpuid( info, 1 );
+  const bool osUsesXsave = info[2] & ( 1 << 27 );
+  const bool avx = info[2] & ( 1 << 28 );
+  // the OS must also save the AVX registers
+  return osUsesXsave && avx && ( _xgetbv( 0 ) & 6 ) == 6;
+#elif defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+  return __builtin_cpu_supports( "avx" );
+#else
+  return false;
+#endif
+}
+
+static std::atomic< int > sInstructionSet( -1 );
+
+QgsRasterMatrixKernels::InstructionSet QgsRasterMatrixKernels::supportedInstructionSet()
+{
+  static const InstructionSet sSupported = []
+  {
+    if ( avxBuilt() && cpuSupportsAvx() )
+      return Avx;
+#ifdef QGS_RASTER_MATRIX_SSE2
+    return Sse2;
+#else
+    return Scalar;
+#endif
+  }();
+  return sSupported;
+}
+
+QgsRasterMatrixKernels::InstructionSet QgsRasterMatrixKernels::instructionSet()
+{
+  const int set = sInstructionSet.load( std::memory_order_relaxed );
+  if ( set < 0 )
+    return supportedInstructionSet();
+  return static_cast< InstructionSet >( set );
+}
+
+void QgsRasterMatrixKernels::setInstructionSet( InstructionSet set )
+{
+  sInstructionSet.store( std::min( set, supportedInstructionSet() ), std::memory_order_relaxed );
+}
+
+int QgsRasterMatrixKernels::twoArgumentOperation( QgsRasterMatrix::TwoArgOperator op,
+    const double *left, bool leftIsNumber, double leftNodata,
+    const double *right, bool rightIsNumber, double rightNodata,
+    double *result, double resultNodata, int size )
+{
+  switch ( instructionSet() )
+  {
+    case Avx:
+      return twoArgumentOperationAvx( op, left, leftIsNumber, leftNodata, right, rightIsNumber, rightNodata, result, resultNodata, size );
+
+    case Sse2:
+#ifdef QGS_RASTER_MATRIX_SSE2
+      return QgsRasterMatrixKernel< Sse2Lanes >::twoArgumentOperation( op, left, leftIsNumber, leftNodata, right, rightIsNumber, rightNodata, result, resultNodata, size );
+#else
+      break;
+#endif
+
+    case Scalar:
+      break;
+  }
+  return 0;
+}
+
+///@endcond
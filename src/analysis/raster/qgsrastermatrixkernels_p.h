@@ -0,0 +1,107 @@
+/***************************************************************************
+  qgsrastermatrixkernels_p.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSRASTERMATRIXKERNELS_P_H
+#define QGSRASTERMATRIXKERNELS_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_analysis.h"
+#include "qgsrastermatrix.h"
+
+/**
+ * \ingroup analysis
+ * \brief Vectorized kernels for the operations of QgsRasterMatrix.
+ *
+ * Kernels use the widest instruction set supported both by the build and by the
+ * CPU, selected at runtime. They handle the arithmetic, comparison, logical and
+ * min/max operators, and replace the per entry nodata tests of the scalar loops
+ * by masks computed and blended for a whole vector of entries at once.
+ *
+ * \since QGIS 3.18
+ */
+class ANALYSIS_EXPORT QgsRasterMatrixKernels
+{
+  public:
+
+    //! Instruction sets of the kernels, from the narrowest to the widest
+    enum InstructionSet
+    {
+      Scalar, //!< No kernel, matrices are calculated entry by entry
+      Sse2, //!< SSE2 kernels, two entries at a time
+      Avx, //!< AVX kernels, four entries at a time
+    };
+
+    /**
+     * Returns the widest instruction set supported both by the build and by the CPU.
+     */
+    static InstructionSet supportedInstructionSet();
+
+    /**
+     * Returns the instruction set of the kernels in use.
+     *
+     * \see setInstructionSet()
+     */
+    static InstructionSet instructionSet();
+
+    /**
+     * Sets the instruction \a set of the kernels to use, limited to the supported instruction set.
+     *
+     * This is meant for tests and benchmarks.
+     *
+     * \see instructionSet()
+     */
+    static void setInstructionSet( InstructionSet set );
+
+    /**
+     * Calculates the operation \a op on the first \a size entries of the \a left and \a right
+     * operands, and stores the values in \a result, which may be the \a left operand.
+     *
+     * An operand which is a number only has one entry, which must not be nodata. The entries of the
+     * other operands which equal their nodata value give \a resultNodata, as do divisions by zero.
+     *
+     * Returns the number of leading entries calculated, the remaining entries must be calculated
+     * by the caller. This is 0 for operators which have no kernel or when kernels are disabled.
+     */
+    static int twoArgumentOperation( QgsRasterMatrix::TwoArgOperator op,
+                                     const double *left, bool leftIsNumber, double leftNodata,
+                                     const double *right, bool rightIsNumber, double rightNodata,
+                                     double *result, double resultNodata, int size );
+
+  private:
+
+    //! Returns TRUE if the AVX kernels were built
+    static bool avxBuilt();
+
+    //! AVX version of twoArgumentOperation(), built in a separate translation unit
+    static int twoArgumentOperationAvx( QgsRasterMatrix::TwoArgOperator op,
+                                        const double *left, bool leftIsNumber, double leftNodata,
+                                        const double *right, bool rightIsNumber, double rightNodata,
+                                        double *result, double resultNodata, int size );
+};
+
+/// @endcond
+
+#endif // QGSRASTERMATRIXKERNELS_P_H
@@ -0,0 +1,91 @@
+/***************************************************************************
+  qgsrastermatrixkernelsavx.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+// This file is built with AVX enabled when the compiler targets x86. Its code must
+// only run once the CPU was checked for AVX support, and it must not define nor
+// use inline functions shared with other translation units.
+
+#include "qgsrastermatrixkernels_p.h"
+
+#ifdef __AVX__
+
+#include <immintrin.h>
+
+#include "qgsrastermatrixkernelsimpl_p.h"
+
+///@cond PRIVATE
+
+namespace
+{
+  struct AvxLanes
+  {
+    typedef __m256d Type;
+    typedef __m256d Mask;
+    static const int SIZE = 4;
+
+    static Type load( const double *p ) { return _mm256_loadu_pd( p ); }
+    static void store( double *p, Type v ) { _mm256_storeu_pd( p, v ); }
+    static Type set( double v ) { return _mm256_set1_pd( v ); }
+    static Type add( Type a, Type b ) { return _mm256_add_pd( a, b ); }
+    static Type subtract( Type a, Type b ) { return _mm256_sub_pd( a, b ); }
+    static Type multiply( Type a, Type b ) { return _mm256_mul_pd( a, b ); }
+    static Type divide( Type a, Type b ) { return _mm256_div_pd( a, b ); }
+    static Mask equal( Type a, Type b ) { return _mm256_cmp_pd( a, b, _CMP_EQ_OQ ); }
+    static Mask notEqual( Type a, Type b ) { return _mm256_cmp_pd( a, b, _CMP_NEQ_UQ ); }
+    static Mask lessThan( Type a, Type b ) { return _mm256_cmp_pd( a, b, _CMP_LT_OQ ); }
+    static Mask lessEqual( Type a, Type b ) { return _mm256_cmp_pd( a, b, _CMP_LE_OQ ); }
+    static Mask maskAnd( Mask a, Mask b ) { return _mm256_and_pd( a, b ); }
+    static Mask maskOr( Mask a, Mask b ) { return _mm256_or_pd( a, b ); }
+    static Type select( Mask mask, Type ifTrue, Type ifFalse ) { return _mm256_or_pd( _mm256_and_pd( mask, ifTrue ), _mm256_andnot_pd( mask, ifFalse ) ); }
+  };
+}
+
+bool QgsRasterMatrixKernels::avxBuilt()
+{
+  return true;
+}
+
+int QgsRasterMatrixKernels::twoArgumentOperationAvx( QgsRasterMatrix::TwoArgOperator op,
+    const double *left, bool leftIsNumber, double leftNodata,
+    const double *right, bool rightIsNumber, double rightNodata,
+    double *result, double resultNodata, int size )
+{
+  const int calculated = QgsRasterMatrixKernel< AvxLanes >::twoArgumentOperation( op, left, leftIsNumber, leftNodata, right, rightIsNumber, rightNodata, result, resultNodata, size );
+  // avoid the penalty of mixing AVX and legacy SSE code afterwards
+  _mm256_zeroupper();
+  return calculated;
+}
+
+///@endcond
+
+#else
+
+///@cond PRIVATE
+
+bool QgsRasterMatrixKernels::avxBuilt()
+{
+  return false;
+}
+
+int QgsRasterMatrixKernels::twoArgumentOperationAvx( QgsRasterMatrix::TwoArgOperator,
+    const double *, bool, double,
+    const double *, bool, double,
+    double *, double, int )
+{
+  return 0;
+}
+
+///@endcond
+
+#endif
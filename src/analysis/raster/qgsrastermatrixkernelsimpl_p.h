@@ -0,0 +1,196 @@
+/***************************************************************************
+  qgsrastermatrixkernelsimpl_p.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSRASTERMATRIXKERNELSIMPL_P_H
+#define QGSRASTERMATRIXKERNELSIMPL_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsrastermatrix.h"
+
+// The kernels are included by translation units built with different instruction
+// sets, so they are kept out of any shared symbol: the linker must never pick
+// code built for a wider instruction set than the one the CPU was checked for.
+namespace
+{
+
+  /**
+   * Kernels for the two argument operations of QgsRasterMatrix, for the vectors of entries
+   * described by \a Lanes.
+   *
+   * Lanes provides the vector \c Type and its \c Mask, the number of entries \c SIZE of a vector,
+   * and the load, store, set, arithmetic, comparison and blending (select) functions.
+   *
+   * Comparisons follow the ones of the scalar operators: they are false when an entry is NaN, except
+   * the not equal comparison, and NaN entries are true for the logical operators.
+   */
+  template <class Lanes>
+  struct QgsRasterMatrixKernel
+  {
+    typedef typename Lanes::Type Type;
+    typedef typename Lanes::Mask Mask;
+
+    static Type fromMask( Mask mask, Type one, Type zero )
+    {
+      return Lanes::select( mask, one, zero );
+    }
+
+    template <int OP>
+    static Type apply( Type a, Type b, Type nodata, Type one, Type zero )
+    {
+      switch ( OP )
+      {
+        case QgsRasterMatrix::opPLUS:
+          return Lanes::add( a, b );
+        case QgsRasterMatrix::opMINUS:
+          return Lanes::subtract( a, b );
+        case QgsRasterMatrix::opMUL:
+          return Lanes::multiply( a, b );
+        case QgsRasterMatrix::opDIV:
+          return Lanes::select( Lanes::equal( b, zero ), nodata, Lanes::divide( a, b ) );
+        case QgsRasterMatrix::opEQ:
+          return fromMask( Lanes::equal( a, b ), one, zero );
+        case QgsRasterMatrix::opNE:
+          return fromMask( Lanes::notEqual( a, b ), one, zero );
+        case QgsRasterMatrix::opGT:
+          return fromMask( Lanes::lessThan( b, a ), one, zero );
+        case QgsRasterMatrix::opLT:
+          return fromMask( Lanes::lessThan( a, b ), one, zero );
+        case QgsRasterMatrix::opGE:
+          return fromMask( Lanes::lessEqual( b, a ), one, zero );
+        case QgsRasterMatrix::opLE:
+          return fromMask( Lanes::lessEqual( a, b ), one, zero );
+        case QgsRasterMatrix::opAND:
+          return fromMask( Lanes::maskAnd( Lanes::notEqual( a, zero ), Lanes::notEqual( b, zero ) ), one, zero );
+        case QgsRasterMatrix::opOR:
+          return fromMask( Lanes::maskOr( Lanes::notEqual( a, zero ), Lanes::notEqual( b, zero ) ), one, zero );
+        case QgsRasterMatrix::opMAX:
+          // same as std::max, including for NaN and signed zeros
+          return Lanes::select( Lanes::lessThan( a, b ), b, a );
+        case QgsRasterMatrix::opMIN:
+          // same as std::min
+          return Lanes::select( Lanes::lessThan( b, a ), b, a );
+      }
+      return nodata;
+    }
+
+    template <int OP, bool LEFT_IS_NUMBER, bool RIGHT_IS_NUMBER>
+    static int calculate( const double *left, double leftNodata, const double *right, double rightNodata,
+                          double *result, double resultNodata, int size )
+    {
+      const Type leftNumber = Lanes::set( left[0] );
+      const Type rightNumber = Lanes::set( right[0] );
+      const Type leftNodataLanes = Lanes::set( leftNodata );
+      const Type rightNodataLanes = Lanes::set( rightNodata );
+      const Type nodata = Lanes::set( resultNodata );
+      const Type one = Lanes::set( 1.0 );
+      const Type zero = Lanes::set( 0.0 );
+
+      int i = 0;
+      for ( ; i + Lanes::SIZE <= size; i += Lanes::SIZE )
+      {
+        const Type a = LEFT_IS_NUMBER ? leftNumber : Lanes::load( left + i );
+        const Type b = RIGHT_IS_NUMBER ? rightNumber : Lanes::load( right + i );
+        const Type value = apply<OP>( a, b, nodata, one, zero );
+
+        // operations with nodata values always generate nodata
+        Mask isNodata;
+        if ( LEFT_IS_NUMBER )
+          isNodata = Lanes::equal( b, rightNodataLanes );
+        else if ( RIGHT_IS_NUMBER )
+          isNodata = Lanes::equal( a, leftNodataLanes );
+        else
+          isNodata = Lanes::maskOr( Lanes::equal( a, leftNodataLanes ), Lanes::equal( b, rightNodataLanes ) );
+
+        Lanes::store( result + i, Lanes::select( isNodata, nodata, value ) );
+      }
+      return i;
+    }
+
+    template <int OP>
+    static int calculate( const double *left, bool leftIsNumber, double leftNodata,
+                          const double *right, bool rightIsNumber, double rightNodata,
+                          double *result, double resultNodata, int size )
+    {
+      if ( leftIsNumber && rightIsNumber )
+        return 0;
+      else if ( leftIsNumber )
+        return calculate<OP, true, false>( left, leftNodata, right, rightNodata, result, resultNodata, size );
+      else if ( rightIsNumber )
+        return calculate<OP, false, true>( left, leftNodata, right, rightNodata, result, resultNodata, size );
+      else
+        return calculate<OP, false, false>( left, leftNodata, right, rightNodata, result, resultNodata, size );
+    }
+
+    static int twoArgumentOperation( QgsRasterMatrix::TwoArgOperator op,
+                                     const double *left, bool leftIsNumber, double leftNodata,
+                                     const double *right, bool rightIsNumber, double rightNodata,
+                                     double *result, double resultNodata, int size )
+    {
+#define CALCULATE(OP) calculate<QgsRasterMatrix::OP>( left, leftIsNumber, leftNodata, right, rightIsNumber, rightNodata, result, resultNodata, size )
+      switch ( op )
+      {
+        case QgsRasterMatrix::opPLUS:
+          return CALCULATE( opPLUS );
+        case QgsRasterMatrix::opMINUS:
+          return CALCULATE( opMINUS );
+        case QgsRasterMatrix::opMUL:
+          return CALCULATE( opMUL );
+        case QgsRasterMatrix::opDIV:
+          return CALCULATE( opDIV );
+        case QgsRasterMatrix::opEQ:
+          return CALCULATE( opEQ );
+        case QgsRasterMatrix::opNE:
+          return CALCULATE( opNE );
+        case QgsRasterMatrix::opGT:
+          return CALCULATE( opGT );
+        case QgsRasterMatrix::opLT:
+          return CALCULATE( opLT );
+        case QgsRasterMatrix::opGE:
+          return CALCULATE( opGE );
+        case QgsRasterMatrix::opLE:
+          return CALCULATE( opLE );
+        case QgsRasterMatrix::opAND:
+          return CALCULATE( opAND );
+        case QgsRasterMatrix::opOR:
+          return CALCULATE( opOR );
+        case QgsRasterMatrix::opMIN:
+          return CALCULATE( opMIN );
+        case QgsRasterMatrix::opMAX:
+          return CALCULATE( opMAX );
+        case QgsRasterMatrix::opPOW:
+          // no vectorized pow, left to the scalar loop
+          break;
+      }
+#undef CALCULATE
+      return 0;
+    }
+  };
+
+}
+
+/// @endcond
+
+#endif // QGSRASTERMATRIXKERNELSIMPL_P_H
@@ -18,17 +18,36 @@
 #include "qgszonalstatistics.h"
 
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturesource.h"
 #include "qgsfeedback.h"
 #include "qgsgeometry.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
 #include "processing/qgsrasteranalysisutils.h"
+#include "qgsrasterblock.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgslogger.h"
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+
+//! Number of features whose statistics are calculated together
+static const int FEATURE_BATCH_SIZE = 10000;
+
+//! Width and height in pixels of the tiles of the raster read for the statistics of several features
+static const int RASTER_TILE_SIZE = 1024;
+
+//! Number of consecutive tiles read by a thread in each wave of tiles
+static const int TILES_PER_THREAD = 4;
+
+//! Minimum percentage of the cells of the tiles covered by the bounding boxes of the features, below which each feature reads its own window of the raster
+static const int MINIMUM_TILE_OCCUPANCY_PERCENT = 25;
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : QgsZonalStatistics( polygonLayer,
@@ -116,39 +135,76 @@ QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback
   request.setNoAttributes();
 
   request.setDestinationCrs( mRasterCrs, QgsProject::instance()->transformContext() );
-  QgsFeatureIterator fi = vectorProvider->getFeatures( request );
   QgsFeature feature;
 
   int featureCounter = 0;
 
   QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( feature ) )
+
+  // features are gathered in batches, so that the raster is read once for all the features of a batch
+  QVector< QgsFeatureId > batchIds;
+  QVector< QgsGeometry > batchGeometries;
+  auto calculateBatch = [&]
   {
-    ++featureCounter;
-    if ( feedback && feedback->isCanceled() )
+    const QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > batchResults = calculateStatistics( mRasterInterface, batchGeometries, mCellSizeX, mCellSizeY, mRasterBand, mStatistics, feedback );
+    for ( int i = 0; i < batchResults.size(); ++i )
     {
-      break;
+      const QMap<QgsZonalStatistics::Statistic, QVariant> &results = batchResults.at( i );
+      if ( results.empty() )
+        continue;
+
+      QgsAttributeMap changeAttributeMap;
+      for ( auto result = results.constBegin(); result != results.constEnd(); ++result )
+      {
+        changeAttributeMap.insert( statFieldIndexes.value( result.key() ), result.value() );
+      }
+
+      changeMap.insert( batchIds.at( i ), changeAttributeMap );
     }
+    batchIds.clear();
+    batchGeometries.clear();
+  };
 
-    if ( feedback )
+  auto calculateFeatures = [&]( QgsFeatureIterator fi )
+  {
+    while ( fi.nextFeature( feature ) )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
-    }
+      ++featureCounter;
+      if ( feedback && feedback->isCanceled() )
+      {
+        break;
+      }
 
-    QgsGeometry featureGeometry = feature.geometry();
+      if ( feedback )
+      {
+        feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
+      }
 
-    QMap<QgsZonalStatistics::Statistic, QVariant> results = calculateStatistics( mRasterInterface, featureGeometry, mCellSizeX, mCellSizeY, mRasterBand, mStatistics );
+      batchIds << feature.id();
+      batchGeometries << feature.geometry();
+      if ( batchGeometries.size() >= FEATURE_BATCH_SIZE )
+        calculateBatch();
+    }
 
-    if ( results.empty() )
-      continue;
+    if ( !batchGeometries.isEmpty() && !( feedback && feedback->isCanceled() ) )
+      calculateBatch();
+  };
 
-    QgsAttributeMap changeAttributeMap;
-    for ( const auto &result : results.toStdMap() )
+  if ( featureCount >= 0 && featureCount <= FEATURE_BATCH_SIZE )
+  {
+    calculateFeatures( vectorProvider->getFeatures( request ) );
+  }
+  else
+  {
+    // batches taken in the order of the layer would each read most of the raster
+    const QList< QgsFeatureIds > batches = featureBatches( vectorProvider, request, mRasterInterface->extent(), mCellSizeX, mCellSizeY, FEATURE_BATCH_SIZE, feedback );
+    for ( const QgsFeatureIds &batch : batches )
     {
-      changeAttributeMap.insert( statFieldIndexes.value( result.first ), result.second );
-    }
+      if ( feedback && feedback->isCanceled() )
+        break;
 
-    changeMap.insert( feature.id(), changeAttributeMap );
+      calculateFeatures( vectorProvider->getFeatures( QgsFeatureRequest( request ).setFilterFids( batch ) ) );
+    }
   }
 
   vectorProvider->changeAttributeValues( changeMap );
@@ -326,8 +382,12 @@ QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::calculateStati
     QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( rasterInterface, rasterBand, geometry, nCellsX, nCellsY, cellSizeX, cellSizeY, rasterBlockExtent, [ &featureStats ]( double value, double weight ) { featureStats.addValue( value, weight ); } );
   }
 
-  // calculate the statistics
-  QgsAttributeMap changeAttributeMap;
+  return statisticsFromValues( featureStats, statistics );
+}
+
+QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::statisticsFromValues( FeatureStats &featureStats, QgsZonalStatistics::Statistics statistics )
+{
+  QMap<QgsZonalStatistics::Statistic, QVariant> results;
   if ( statistics & QgsZonalStatistics::Count )
     results.insert( QgsZonalStatistics::Count, QVariant( featureStats.count ) );
   if ( statistics & QgsZonalStatistics::Sum )
@@ -397,3 +457,253 @@ QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::calculateStati
 
   return results;
 }
+
+QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > QgsZonalStatistics::calculateStatistics( QgsRasterInterface *rasterInterface, const QVector< QgsGeometry > &geometries, double cellSizeX, double cellSizeY, int rasterBand, QgsZonalStatistics::Statistics statistics, QgsFeedback *feedback )
+{
+  QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > results( geometries.size() );
+  if ( !rasterInterface || geometries.isEmpty() )
+    return results;
+
+  const QgsRectangle rasterBBox = rasterInterface->extent();
+  const int rasterWidth = rasterInterface->xSize();
+  const int rasterHeight = rasterInterface->ySize();
+  const int tileColumns = ( rasterWidth + RASTER_TILE_SIZE - 1 ) / RASTER_TILE_SIZE;
+
+  const bool statsStoreValues = ( statistics & QgsZonalStatistics::Median ) ||
+                                ( statistics & QgsZonalStatistics::StDev ) ||
+                                ( statistics & QgsZonalStatistics::Variance );
+  const bool statsStoreValueCount = ( statistics & QgsZonalStatistics::Minority ) ||
+                                    ( statistics & QgsZonalStatistics::Majority );
+
+  // pairs of tile and geometry, sorted by tile so that the geometries are grouped by the tiles they intersect
+  std::vector< std::pair< int, int > > tileGeometries;
+  std::vector< int > remainingTiles( static_cast< std::size_t >( geometries.size() ), 0 );
+  double windowCells = 0;
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const QgsGeometry &geometry = geometries.at( i );
+    if ( geometry.isEmpty() )
+      continue;
+
+    const QgsRectangle featureRect = geometry.boundingBox().intersect( rasterBBox );
+    if ( featureRect.isEmpty() )
+      continue;
+
+    int nCellsX, nCellsY;
+    QgsRectangle rasterBlockExtent;
+    QgsRasterAnalysisUtils::cellInfoForBBox( rasterBBox, featureRect, cellSizeX, cellSizeY, nCellsX, nCellsY, rasterWidth, rasterHeight, rasterBlockExtent );
+    if ( nCellsX <= 0 || nCellsY <= 0 )
+    {
+      // no cell to read, but the statistics still have their empty values
+      results[i] = calculateStatistics( rasterInterface, geometry, cellSizeX, cellSizeY, rasterBand, statistics );
+      continue;
+    }
+
+    windowCells += static_cast< double >( nCellsX ) * nCellsY;
+    const int offsetX = static_cast< int >( std::round( ( rasterBlockExtent.xMinimum() - rasterBBox.xMinimum() ) / cellSizeX ) );
+    const int offsetY = static_cast< int >( std::round( ( rasterBBox.yMaximum() - rasterBlockExtent.yMaximum() ) / cellSizeY ) );
+    for ( int tileRow = offsetY / RASTER_TILE_SIZE; tileRow <= ( offsetY + nCellsY - 1 ) / RASTER_TILE_SIZE; ++tileRow )
+    {
+      for ( int tileColumn = offsetX / RASTER_TILE_SIZE; tileColumn <= ( offsetX + nCellsX - 1 ) / RASTER_TILE_SIZE; ++tileColumn )
+      {
+        tileGeometries.emplace_back( tileRow * tileColumns + tileColumn, i );
+        ++remainingTiles[ static_cast< std::size_t >( i ) ];
+      }
+    }
+  }
+  std::sort( tileGeometries.begin(), tileGeometries.end() );
+
+  struct Tile
+  {
+    int index = 0;
+    std::size_t firstGeometry = 0;
+    std::size_t lastGeometry = 0;
+  };
+  std::vector< Tile > tiles;
+  for ( std::size_t i = 0; i < tileGeometries.size(); ++i )
+  {
+    if ( tiles.empty() || tiles.back().index != tileGeometries[i].first )
+      tiles.push_back( Tile{ tileGeometries[i].first, i, i } );
+    tiles.back().lastGeometry = i;
+  }
+  if ( tiles.empty() )
+    return results;
+
+  // when the geometries are scattered, reading whole tiles would read much more of the raster than
+  // the windows around each geometry
+  if ( windowCells * 100 < static_cast< double >( tiles.size() ) * RASTER_TILE_SIZE * RASTER_TILE_SIZE * MINIMUM_TILE_OCCUPANCY_PERCENT )
+  {
+    for ( int i = 0; i < geometries.size(); ++i )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return QVector< QMap<QgsZonalStatistics::Statistic, QVariant> >( geometries.size() );
+
+      if ( remainingTiles[ static_cast< std::size_t >( i ) ] > 0 )
+        results[i] = calculateStatistics( rasterInterface, geometries.at( i ), cellSizeX, cellSizeY, rasterBand, statistics );
+    }
+    return results;
+  }
+
+  // each thread reads its tiles through its own clone of the raster, as interfaces are not thread safe
+  const int threadCount = std::min( static_cast< int >( tiles.size() ), QThreadPool::globalInstance()->maxThreadCount() );
+  std::vector< std::unique_ptr< QgsRasterInterface > > clones;
+  for ( int i = 0; i < threadCount && threadCount > 1; ++i )
+  {
+    std::unique_ptr< QgsRasterInterface > clone( rasterInterface->clone() );
+    if ( !clone )
+      break;
+    clones.emplace_back( std::move( clone ) );
+  }
+
+  struct GeometryStats
+  {
+    int geometry;
+    bool filled;
+    FeatureStats stats;
+  };
+  struct TileRun
+  {
+    QgsRasterInterface *interface = nullptr;
+    std::size_t firstTile = 0;
+    std::size_t lastTile = 0;
+    std::vector< GeometryStats > stats;
+  };
+
+  auto readTiles = [&]( TileRun & run )
+  {
+    for ( std::size_t t = run.firstTile; t <= run.lastTile; ++t )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return;
+
+      const Tile &tile = tiles[t];
+      const int left = ( tile.index % tileColumns ) * RASTER_TILE_SIZE;
+      const int top = ( tile.index / tileColumns ) * RASTER_TILE_SIZE;
+      const int width = std::min( RASTER_TILE_SIZE, rasterWidth - left );
+      const int height = std::min( RASTER_TILE_SIZE, rasterHeight - top );
+      const QgsRectangle tileExtent( rasterBBox.xMinimum() + left * cellSizeX, rasterBBox.yMaximum() - ( top + height ) * cellSizeY,
+                                     rasterBBox.xMinimum() + ( left + width ) * cellSizeX, rasterBBox.yMaximum() - top * cellSizeY );
+      std::unique_ptr< QgsRasterBlock > block( run.interface->block( rasterBand, tileExtent, width, height ) );
+      const bool blockIsValid = block && block->isValid() && !block->isEmpty();
+
+      bool isNoData = false;
+      for ( std::size_t g = tile.firstGeometry; g <= tile.lastGeometry; ++g )
+      {
+        const int geometry = tileGeometries[g].second;
+        GeometryStats geometryStats { geometry, true, FeatureStats( statsStoreValues, statsStoreValueCount ) };
+        if ( blockIsValid )
+        {
+          geometryStats.filled = QgsRasterAnalysisUtils::middlePointCells( geometries.at( geometry ), tileExtent, width, height, cellSizeX, cellSizeY, [&]( int row, int firstColumn, int lastColumn )
+          {
+            for ( int column = firstColumn; column <= lastColumn; ++column )
+            {
+              const double pixelValue = block->valueAndNoData( row, column, isNoData );
+              if ( QgsRasterAnalysisUtils::validPixel( pixelValue ) && !isNoData )
+                geometryStats.stats.addValue( pixelValue );
+            }
+          } );
+        }
+        run.stats.emplace_back( std::move( geometryStats ) );
+      }
+    }
+  };
+
+  // statistics are merged in the order of the tiles, once all the tiles of a wave were read
+  std::vector< FeatureStats > featureStats( static_cast< std::size_t >( geometries.size() ), FeatureStats( statsStoreValues, statsStoreValueCount ) );
+  std::vector< bool > notFilled( static_cast< std::size_t >( geometries.size() ), false );
+  const std::size_t runCount = std::max< std::size_t >( 1, clones.size() );
+  std::vector< TileRun > runs;
+  for ( std::size_t firstTile = 0; firstTile < tiles.size(); firstTile += runCount * TILES_PER_THREAD )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    runs.clear();
+    for ( std::size_t i = 0; i < runCount; ++i )
+    {
+      TileRun run;
+      run.interface = clones.empty() ? rasterInterface : clones[i].get();
+      run.firstTile = firstTile + i * TILES_PER_THREAD;
+      run.lastTile = std::min( run.firstTile + TILES_PER_THREAD, tiles.size() ) - 1;
+      if ( run.firstTile >= tiles.size() )
+        break;
+      runs.emplace_back( std::move( run ) );
+    }
+
+    if ( runs.size() > 1 )
+      QtConcurrent::blockingMap( runs, readTiles );
+    else
+      readTiles( runs.front() );
+
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    for ( TileRun &run : runs )
+    {
+      for ( GeometryStats &geometryStats : run.stats )
+      {
+        const std::size_t geometry = static_cast< std::size_t >( geometryStats.geometry );
+        if ( geometryStats.filled )
+          featureStats[geometry].addStats( geometryStats.stats );
+        else
+          notFilled[geometry] = true;
+
+        if ( --remainingTiles[geometry] > 0 )
+          continue;
+
+        // all the tiles of the geometry were read. Geometries which cannot be filled, and the ones smaller than
+        // cells, for which precise intersections are needed, are calculated on their own
+        if ( notFilled[geometry] || featureStats[geometry].count <= 1 )
+          results[geometryStats.geometry] = calculateStatistics( rasterInterface, geometries.at( geometryStats.geometry ), cellSizeX, cellSizeY, rasterBand, statistics );
+        else
+          results[geometryStats.geometry] = statisticsFromValues( featureStats[geometry], statistics );
+        featureStats[geometry] = FeatureStats();
+      }
+    }
+  }
+
+  if ( feedback && feedback->isCanceled() )
+    return QVector< QMap<QgsZonalStatistics::Statistic, QVariant> >( geometries.size() );
+
+  return results;
+}
+
+QList< QgsFeatureIds > QgsZonalStatistics::featureBatches( QgsFeatureSource *source, const QgsFeatureRequest &request, const QgsRectangle &rasterExtent, double cellSizeX, double cellSizeY, int batchSize, QgsFeedback *feedback )
+{
+  const double tileWidth = cellSizeX * RASTER_TILE_SIZE;
+  const double tileHeight = cellSizeY * RASTER_TILE_SIZE;
+  const int tileColumns = tileWidth > 0 ? std::max( 1, static_cast< int >( std::ceil( rasterExtent.width() / tileWidth ) ) ) : 1;
+  const int tileRows = tileHeight > 0 ? std::max( 1, static_cast< int >( std::ceil( rasterExtent.height() / tileHeight ) ) ) : 1;
+
+  // pairs of tile and feature id, features without geometry come first
+  std::vector< std::pair< qint64, QgsFeatureId > > tileFeatures;
+  QgsFeatureRequest tileRequest( request );
+  tileRequest.setNoAttributes();
+  QgsFeatureIterator it = source->getFeatures( tileRequest );
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return QList< QgsFeatureIds >();
+
+    qint64 tile = -1;
+    if ( feature.hasGeometry() )
+    {
+      const QgsPointXY center = feature.geometry().boundingBox().center();
+      const int column = tileWidth > 0 ? static_cast< int >( std::floor( ( center.x() - rasterExtent.xMinimum() ) / tileWidth ) ) : 0;
+      const int row = tileHeight > 0 ? static_cast< int >( std::floor( ( rasterExtent.yMaximum() - center.y() ) / tileHeight ) ) : 0;
+      tile = static_cast< qint64 >( std::min( std::max( row, 0 ), tileRows - 1 ) ) * tileColumns + std::min( std::max( column, 0 ), tileColumns - 1 );
+    }
+    tileFeatures.emplace_back( tile, feature.id() );
+  }
+  std::sort( tileFeatures.begin(), tileFeatures.end() );
+
+  QList< QgsFeatureIds > batches;
+  for ( const std::pair< qint64, QgsFeatureId > &tileFeature : tileFeatures )
+  {
+    if ( batches.isEmpty() || batches.last().size() >= batchSize )
+      batches << QgsFeatureIds();
+    batches.last().insert( tileFeature.second );
+  }
+  return batches;
+}
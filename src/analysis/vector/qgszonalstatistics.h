@@ -20,6 +20,7 @@
 
 #include <QString>
 #include <QMap>
+#include <QVector>
 
 #include <limits>
 #include <cfloat>
@@ -28,6 +29,7 @@
 #include "qgsfeedback.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfields.h"
+#include "qgsfeatureid.h"
 
 class QgsGeometry;
 class QgsVectorLayer;
@@ -38,6 +40,7 @@ class QgsRectangle;
 class QgsField;
 class QgsFeatureSink;
 class QgsFeatureSource;
+class QgsFeatureRequest;
 
 /**
  * \ingroup analysis
@@ -157,6 +160,38 @@ class ANALYSIS_EXPORT QgsZonalStatistics
      */
     static QMap<QgsZonalStatistics::Statistic, QVariant> calculateStatistics( QgsRasterInterface *rasterInterface, const QgsGeometry &geometry, double cellSizeX, double cellSizeY, int rasterBand, QgsZonalStatistics::Statistics statistics );
 
+    /**
+     * Calculates the specified \a statistics for the pixels of \a rasterBand
+     * in \a rasterInterface (a raster layer dataProvider() ) within each of the polygon \a geometries.
+     *
+     * The results are the same as calculating the statistics of each geometry on its own, but the raster
+     * is read in tiles, each of them read once for all the geometries it intersects, and the tiles are
+     * processed on multiple threads through clones of \a rasterInterface. The cells within the geometries
+     * are found with a scanline fill of the polygons instead of testing each cell. When the geometries only
+     * cover a small part of the tiles they intersect, each geometry reads its own window of the raster instead.
+     *
+     * Returns the maps of statistic to result value, in the order of \a geometries. The maps are empty for
+     * the geometries outside of the raster, and for all of them if the calculation was canceled through
+     * \a feedback.
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.18
+     */
+    static QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > calculateStatistics( QgsRasterInterface *rasterInterface, const QVector< QgsGeometry > &geometries, double cellSizeX, double cellSizeY, int rasterBand, QgsZonalStatistics::Statistics statistics, QgsFeedback *feedback = nullptr ) SIP_SKIP;
+
+    /**
+     * Returns the ids of the features of \a source matching \a request, in batches of up to \a batchSize
+     * features for calculateStatistics(). Features are ordered by the tile of the raster the center of
+     * their bounding box falls in, given the \a rasterExtent and cell sizes of the raster, so that the
+     * statistics of each batch only read a few tiles of the raster.
+     *
+     * Returns an empty list if the calculation was canceled through \a feedback.
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.18
+     */
+    static QList< QgsFeatureIds > featureBatches( QgsFeatureSource *source, const QgsFeatureRequest &request, const QgsRectangle &rasterExtent, double cellSizeX, double cellSizeY, int batchSize, QgsFeedback *feedback = nullptr ) SIP_SKIP;
+
   private:
     QgsZonalStatistics() = default;
 
@@ -198,6 +233,22 @@ class ANALYSIS_EXPORT QgsZonalStatistics
           if ( mStoreValues )
             values.append( value );
         }
+
+        //! Adds the values accumulated by \a other, which must store the same values
+        void addStats( const FeatureStats &other )
+        {
+          sum += other.sum;
+          count += other.count;
+          min = std::min( min, other.min );
+          max = std::max( max, other.max );
+          if ( mStoreValueCounts )
+          {
+            for ( auto it = other.valueCount.constBegin(); it != other.valueCount.constEnd(); ++it )
+              valueCount[ it.key() ] += it.value();
+          }
+          if ( mStoreValues )
+            values.append( other.values );
+        }
         double sum = 0.0;
         double count = 0.0;
         double max = std::numeric_limits<double>::lowest();
@@ -210,6 +261,9 @@ class ANALYSIS_EXPORT QgsZonalStatistics
         bool mStoreValueCounts = false;
     };
 
+    //! Returns the \a statistics of the values accumulated in \a featureStats
+    static QMap<QgsZonalStatistics::Statistic, QVariant> statisticsFromValues( FeatureStats &featureStats, QgsZonalStatistics::Statistics statistics );
+
     QString getUniqueFieldName( const QString &fieldName, const QList<QgsField> &newFields );
 
     QgsRasterInterface *mRasterInterface = nullptr;
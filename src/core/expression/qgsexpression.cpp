@@ -15,6 +15,7 @@
 
 #include "qgsexpression.h"
 #include "qgsexpressionfunction.h"
+#include "qgsfeature.h"
 #include "qgsexpressionnodeimpl.h"
 #include "qgsfeaturerequest.h"
 #include "qgscolorramp.h"
@@ -52,6 +53,7 @@ void QgsExpression::setExpression( const QString &expression )
   d->mEvalErrorString = QString();
   d->mExp = expression;
   d->mIsPrepared = false;
+  d->mProgram.reset();
 }
 
 QString QgsExpression::expression() const
@@ -340,7 +342,13 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 
   initGeomCalculator( context );
   d->mIsPrepared = true;
-  return d->mRootNode->prepare( this, context );
+  d->mProgram.reset();
+  if ( !d->mRootNode->prepare( this, context ) )
+    return false;
+
+  // lower the prepared tree to a flat instruction stream for faster evaluation
+  d->mProgram = QgsExpressionProgram::compile( d->mRootNode );
+  return true;
 }
 
 QVariant QgsExpression::evaluate()
@@ -368,9 +376,49 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
   {
     prepare( context );
   }
+  if ( d->mProgram && QgsExpressionProgram::isEnabled() )
+    return d->mProgram->run( this, context );
   return d->mRootNode->eval( this, context );
 }
 
+QVariantList QgsExpression::evaluateBlock( const QList< QgsFeature > &features, QgsExpressionContext *context )
+{
+  d->mEvalErrorString = QString();
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    return QVariantList();
+  }
+
+  QgsExpressionContext defaultContext;
+  if ( !context )
+    context = &defaultContext;
+
+  if ( ! d->mIsPrepared )
+  {
+    prepare( context );
+  }
+  if ( d->mProgram && QgsExpressionProgram::isEnabled() )
+    return d->mProgram->runBlock( this, context, features );
+
+  QVariantList results;
+  results.reserve( features.size() );
+  QString lastError;
+  for ( const QgsFeature &feature : features )
+  {
+    context->setFeature( feature );
+    d->mEvalErrorString = QString();
+    results << d->mRootNode->eval( this, context );
+    if ( hasEvalError() )
+    {
+      results.last() = QVariant();
+      lastError = d->mEvalErrorString;
+    }
+  }
+  d->mEvalErrorString = lastError;
+  return results;
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
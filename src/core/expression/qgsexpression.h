@@ -318,6 +318,25 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /**
+     * Evaluates the expression for a batch of \a features and returns the results,
+     * in the same order as the features.
+     *
+     * This is a batched version of evaluate(): the results are the same QVariant values
+     * evaluate() would return for each feature, not typed columns. It is faster than calling
+     * evaluate() for each feature, as attributes are read directly from the features and
+     * the evaluation state is set up once for the whole batch.
+     *
+     * The feature of the \a context is set to each feature in turn when parts of the
+     * expression need the whole context, and is the last feature of the block after the call.
+     * If the evaluation fails for some features, their results are NULL and evalErrorString()
+     * returns the last error.
+     *
+     * \note prepare() should be called before calling this method.
+     * \since QGIS 3.18
+     */
+    QVariantList evaluateBlock( const QList< QgsFeature > &features, QgsExpressionContext *context );
+
     //! Returns TRUE if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
@@ -330,6 +330,8 @@ class CORE_EXPORT QgsExpressionNode SIP_ABSTRACT
 
     bool mHasCachedValue = false;
     QVariant mCachedStaticValue;
+
+    friend class QgsExpressionProgram;
 };
 
 Q_DECLARE_METATYPE( QgsExpressionNode * )
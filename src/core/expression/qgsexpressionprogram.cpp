@@ -0,0 +1,840 @@
+/***************************************************************************
+                          qgsexpressionprogram.cpp
+                          ------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionutils.h"
+#include "qgsfeature.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+///@cond PRIVATE
+
+static std::atomic< bool > sProgramsEnabled( true );
+
+/**
+ * A register of a running program.
+ *
+ * Numeric values are unboxed, loaded values additionally keep their original
+ * QVariant so that they are returned unchanged.
+ */
+class QgsExpressionProgram::Value
+{
+  public:
+
+    enum Type
+    {
+      Null,
+      Int,
+      Double,
+      Tvl, //!< Result of a logical operator or comparison, boxes like TVL_True and TVL_False
+      Variant, //!< Any other value, which is handled by the tree walking interpreter
+    };
+
+    Type type = Null;
+    qlonglong i = 0;
+    double d = 0;
+    QVariant variant;
+
+    void load( const QVariant &value )
+    {
+      variant = value;
+      if ( value.isNull() )
+      {
+        type = Null;
+        return;
+      }
+
+      switch ( value.type() )
+      {
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+          type = Int;
+          i = value.toLongLong();
+          break;
+
+        case QVariant::Double:
+          type = Double;
+          d = value.toDouble();
+          break;
+
+        default:
+          type = Variant;
+          break;
+      }
+    }
+
+    void setNull()
+    {
+      type = Null;
+      variant = QVariant();
+    }
+
+    void setInt( qlonglong value )
+    {
+      type = Int;
+      i = value;
+      variant = QVariant();
+    }
+
+    void setDouble( double value )
+    {
+      type = Double;
+      d = value;
+      variant = QVariant();
+    }
+
+    void setTvl( QgsExpressionUtils::TVL value )
+    {
+      if ( value == QgsExpressionUtils::Unknown )
+      {
+        setNull();
+        return;
+      }
+      type = Tvl;
+      i = value == QgsExpressionUtils::True ? 1 : 0;
+      variant = QVariant();
+    }
+
+    bool isNumeric() const
+    {
+      return type == Int || type == Double || type == Tvl;
+    }
+
+    bool isIntSafe() const
+    {
+      return type == Int || type == Tvl;
+    }
+
+    double toDouble() const
+    {
+      return type == Double ? d : static_cast< double >( i );
+    }
+
+    QVariant toVariant() const
+    {
+      if ( type == Null || type == Variant || variant.isValid() )
+        return variant;
+
+      switch ( type )
+      {
+        case Int:
+          return QVariant( i );
+        case Double:
+          return QVariant( d );
+        case Tvl:
+          return i ? TVL_True : TVL_False;
+        case Null:
+        case Variant:
+          break;
+      }
+      return variant;
+    }
+
+    QgsExpressionUtils::TVL toTvl( QgsExpression *parent ) const
+    {
+      switch ( type )
+      {
+        case Null:
+          return QgsExpressionUtils::Unknown;
+        case Int:
+        case Tvl:
+          return i != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+        case Double:
+          return !qgsDoubleNear( d, 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+        case Variant:
+          break;
+      }
+      return QgsExpressionUtils::getTVLValue( variant, parent );
+    }
+
+    void negate( const Value &operand, QgsExpression *parent, const QgsExpressionContext *context )
+    {
+      switch ( operand.type )
+      {
+        case Int:
+        case Tvl:
+          setInt( -operand.i );
+          return;
+
+        case Double:
+          setDouble( -operand.d );
+          return;
+
+        case Null:
+        case Variant:
+          break;
+      }
+
+      QgsExpressionNodeUnaryOperator node( QgsExpressionNodeUnaryOperator::uoMinus, new QgsExpressionNodeLiteral( operand.toVariant() ) );
+      load( node.eval( parent, context ) );
+    }
+
+    void binary( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value &left, const Value &right, QgsExpression *parent, const QgsExpressionContext *context )
+    {
+      if ( computeBinary( op, left, right, parent ) )
+        return;
+
+      // same operation on values of other types, let the interpreter handle it
+      QgsExpressionNodeBinaryOperator node( op, new QgsExpressionNodeLiteral( left.toVariant() ), new QgsExpressionNodeLiteral( right.toVariant() ) );
+      load( node.eval( parent, context ) );
+    }
+
+  private:
+
+    static bool compare( QgsExpressionNodeBinaryOperator::BinaryOperator op, double diff )
+    {
+      switch ( op )
+      {
+        case QgsExpressionNodeBinaryOperator::boEQ:
+          return qgsDoubleNear( diff, 0.0 );
+        case QgsExpressionNodeBinaryOperator::boNE:
+          return !qgsDoubleNear( diff, 0.0 );
+        case QgsExpressionNodeBinaryOperator::boLT:
+          return diff < 0;
+        case QgsExpressionNodeBinaryOperator::boGT:
+          return diff > 0;
+        case QgsExpressionNodeBinaryOperator::boLE:
+          return diff <= 0;
+        case QgsExpressionNodeBinaryOperator::boGE:
+          return diff >= 0;
+        default:
+          Q_ASSERT( false );
+          return false;
+      }
+    }
+
+    /**
+     * Computes the operations on numeric and NULL values, with the same semantics
+     * as QgsExpressionNodeBinaryOperator::evalNode().
+     * Returns FALSE if the operand types are not handled.
+     */
+    bool computeBinary( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value &left, const Value &right, QgsExpression *parent )
+    {
+      const bool leftNull = left.type == Null;
+      const bool rightNull = right.type == Null;
+
+      switch ( op )
+      {
+        case QgsExpressionNodeBinaryOperator::boAnd:
+        case QgsExpressionNodeBinaryOperator::boOr:
+        {
+          const QgsExpressionUtils::TVL tvlL = left.toTvl( parent );
+          const QgsExpressionUtils::TVL tvlR = right.toTvl( parent );
+          if ( op == QgsExpressionNodeBinaryOperator::boAnd )
+            setTvl( QgsExpressionUtils::AND[tvlL][tvlR] );
+          else
+            setTvl( QgsExpressionUtils::OR[tvlL][tvlR] );
+          return true;
+        }
+
+        case QgsExpressionNodeBinaryOperator::boPlus:
+          // two NULL strings are concatenated
+          if ( leftNull && rightNull )
+            return false;
+          FALLTHROUGH
+        case QgsExpressionNodeBinaryOperator::boMinus:
+        case QgsExpressionNodeBinaryOperator::boMul:
+        case QgsExpressionNodeBinaryOperator::boDiv:
+        case QgsExpressionNodeBinaryOperator::boMod:
+        {
+          if ( ( leftNull && ( rightNull || right.isNumeric() ) ) || ( rightNull && left.isNumeric() ) )
+          {
+            setNull();
+            return true;
+          }
+          if ( !left.isNumeric() || !right.isNumeric() )
+            return false;
+
+          if ( op != QgsExpressionNodeBinaryOperator::boDiv && left.isIntSafe() && right.isIntSafe() )
+          {
+            // both are integers - let's use integer arithmetic
+            const qlonglong iL = left.i;
+            const qlonglong iR = right.i;
+            switch ( op )
+            {
+              case QgsExpressionNodeBinaryOperator::boPlus:
+                setInt( iL + iR );
+                break;
+              case QgsExpressionNodeBinaryOperator::boMinus:
+                setInt( iL - iR );
+                break;
+              case QgsExpressionNodeBinaryOperator::boMul:
+                setInt( iL * iR );
+                break;
+              default:
+                if ( iR == 0 )
+                  setNull();
+                else
+                  setInt( iL % iR );
+                break;
+            }
+            return true;
+          }
+
+          // general floating point arithmetic
+          const double fL = left.toDouble();
+          const double fR = right.toDouble();
+          switch ( op )
+          {
+            case QgsExpressionNodeBinaryOperator::boPlus:
+              setDouble( fL + fR );
+              break;
+            case QgsExpressionNodeBinaryOperator::boMinus:
+              setDouble( fL - fR );
+              break;
+            case QgsExpressionNodeBinaryOperator::boMul:
+              setDouble( fL * fR );
+              break;
+            case QgsExpressionNodeBinaryOperator::boDiv:
+              if ( fR == 0. )
+                setNull(); // silently handle division by zero and return NULL
+              else
+                setDouble( fL / fR );
+              break;
+            default:
+              if ( fR == 0. )
+                setNull();
+              else
+                setDouble( std::fmod( fL, fR ) );
+              break;
+          }
+          return true;
+        }
+
+        case QgsExpressionNodeBinaryOperator::boIntDiv:
+        {
+          if ( !left.isNumeric() || !right.isNumeric() )
+            return false;
+
+          const double fL = left.toDouble();
+          const double fR = right.toDouble();
+          if ( fR == 0. )
+            setNull(); // silently handle division by zero and return NULL
+          else
+            setInt( static_cast< qlonglong >( std::floor( fL / fR ) ) );
+          return true;
+        }
+
+        case QgsExpressionNodeBinaryOperator::boPow:
+          if ( ( leftNull && ( rightNull || right.isNumeric() ) ) || ( rightNull && left.isNumeric() ) )
+          {
+            setNull();
+            return true;
+          }
+          if ( !left.isNumeric() || !right.isNumeric() )
+            return false;
+
+          setDouble( std::pow( left.toDouble(), right.toDouble() ) );
+          return true;
+
+        case QgsExpressionNodeBinaryOperator::boEQ:
+        case QgsExpressionNodeBinaryOperator::boNE:
+        case QgsExpressionNodeBinaryOperator::boLT:
+        case QgsExpressionNodeBinaryOperator::boGT:
+        case QgsExpressionNodeBinaryOperator::boLE:
+        case QgsExpressionNodeBinaryOperator::boGE:
+          if ( ( leftNull && ( rightNull || right.isNumeric() ) ) || ( rightNull && left.isNumeric() ) )
+          {
+            setTvl( QgsExpressionUtils::Unknown );
+            return true;
+          }
+          if ( !left.isNumeric() || !right.isNumeric() )
+            return false;
+
+          setTvl( compare( op, left.toDouble() - right.toDouble() ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+          return true;
+
+        case QgsExpressionNodeBinaryOperator::boIs:
+        case QgsExpressionNodeBinaryOperator::boIsNot:
+        {
+          bool equal = false;
+          if ( leftNull || rightNull )
+          {
+            if ( ( leftNull && right.type == Variant ) || ( rightNull && left.type == Variant ) )
+              return false;
+            equal = leftNull && rightNull;
+          }
+          else if ( left.isNumeric() && right.isNumeric() )
+          {
+            equal = qgsDoubleNear( left.toDouble(), right.toDouble() );
+          }
+          else
+          {
+            return false;
+          }
+          setTvl( equal == ( op == QgsExpressionNodeBinaryOperator::boIs ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+          return true;
+        }
+
+        default:
+          break;
+      }
+      return false;
+    }
+};
+
+std::unique_ptr<QgsExpressionProgram> QgsExpressionProgram::compile( QgsExpressionNode *root )
+{
+  if ( !root )
+    return nullptr;
+
+  std::unique_ptr< QgsExpressionProgram > program( new QgsExpressionProgram() );
+  program->mResultRegister = program->compileNode( root );
+
+  if ( program->mInstructions.size() == 1 && program->mInstructions.at( 0 ).code == Evaluate )
+    return nullptr;
+
+  return program;
+}
+
+QVariant QgsExpressionProgram::run( QgsExpression *parent, const QgsExpressionContext *context ) const
+{
+  QVarLengthArray< Value, 32 > registers( mRegisterCount );
+  return execute( parent, context, nullptr, registers.data() );
+}
+
+QVariantList QgsExpressionProgram::runBlock( QgsExpression *parent, QgsExpressionContext *context, const QgsFeatureList &features ) const
+{
+  QVariantList results;
+  if ( features.isEmpty() )
+    return results;
+
+  results.reserve( features.size() );
+  QString lastError;
+
+  if ( !mHasControlFlow && !hasFallbacks() )
+  {
+    // straight program, execute it one instruction at a time over the whole block
+    const int size = features.size();
+    std::vector< Value > registers( static_cast< std::size_t >( mRegisterCount ) * size );
+    QVector< bool > failed( size, false );
+
+    auto checkError = [parent, &failed, &lastError]( int row )
+    {
+      if ( parent->hasEvalError() )
+      {
+        failed[row] = true;
+        lastError = parent->evalErrorString();
+        parent->setEvalErrorString( QString() );
+      }
+    };
+
+    for ( const Instruction &instruction : mInstructions )
+    {
+      Value *result = registers.data() + static_cast< std::size_t >( instruction.result ) * size;
+      const Value *a = instruction.a >= 0 ? registers.data() + static_cast< std::size_t >( instruction.a ) * size : nullptr;
+      const Value *b = instruction.b >= 0 ? registers.data() + static_cast< std::size_t >( instruction.b ) * size : nullptr;
+
+      switch ( instruction.code )
+      {
+        case LoadConstant:
+        {
+          Value constant;
+          constant.load( mConstants.at( instruction.a ) );
+          std::fill( result, result + size, constant );
+          break;
+        }
+
+        case LoadField:
+          for ( int row = 0; row < size; ++row )
+          {
+            const QgsFeature &feature = features.at( row );
+            if ( feature.isValid() )
+            {
+              result[row].load( feature.attribute( instruction.a ) );
+            }
+            else if ( !failed[row] )
+            {
+              context->setFeature( feature );
+              result[row].load( instruction.node->eval( parent, context ) );
+              checkError( row );
+            }
+          }
+          break;
+
+        case Move:
+          std::copy( a, a + size, result );
+          break;
+
+        case Negate:
+          for ( int row = 0; row < size; ++row )
+          {
+            if ( failed[row] )
+              continue;
+            result[row].negate( a[row], parent, context );
+            checkError( row );
+          }
+          break;
+
+        case Not:
+          for ( int row = 0; row < size; ++row )
+          {
+            if ( failed[row] )
+              continue;
+            const QgsExpressionUtils::TVL tvl = a[row].toTvl( parent );
+            result[row].setTvl( QgsExpressionUtils::NOT[tvl] );
+            checkError( row );
+          }
+          break;
+
+        case Binary:
+          for ( int row = 0; row < size; ++row )
+          {
+            if ( failed[row] )
+              continue;
+            result[row].binary( instruction.op, a[row], b[row], parent, context );
+            checkError( row );
+          }
+          break;
+
+        case Evaluate:
+        case ShortCircuit:
+        case JumpIfNotTrue:
+        case Jump:
+          Q_ASSERT( false );
+          break;
+      }
+    }
+
+    const Value *result = registers.data() + static_cast< std::size_t >( mResultRegister ) * size;
+    for ( int row = 0; row < size; ++row )
+      results << ( failed.at( row ) ? QVariant() : result[row].toVariant() );
+
+    context->setFeature( features.last() );
+  }
+  else
+  {
+    QVarLengthArray< Value, 32 > registers( mRegisterCount );
+    for ( const QgsFeature &feature : features )
+    {
+      // the tree walking interpreter needs the feature in the context
+      context->setFeature( feature );
+      results << execute( parent, context, &feature, registers.data() );
+      if ( parent->hasEvalError() )
+      {
+        lastError = parent->evalErrorString();
+        parent->setEvalErrorString( QString() );
+      }
+    }
+  }
+
+  if ( !lastError.isNull() )
+    parent->setEvalErrorString( lastError );
+  return results;
+}
+
+QVariant QgsExpressionProgram::execute( QgsExpression *parent, const QgsExpressionContext *context, const QgsFeature *feature, Value *registers ) const
+{
+  QgsFeature contextFeature;
+  if ( !feature )
+  {
+    // fetched from the context when a field is loaded
+    feature = &contextFeature;
+  }
+  bool featureFetched = feature != &contextFeature;
+
+  const int count = mInstructions.size();
+  const Instruction *instructions = mInstructions.constData();
+  int pc = 0;
+  while ( pc < count )
+  {
+    const Instruction &instruction = instructions[pc++];
+    switch ( instruction.code )
+    {
+      case LoadConstant:
+        registers[instruction.result].load( mConstants.at( instruction.a ) );
+        break;
+
+      case LoadField:
+        if ( !featureFetched )
+        {
+          if ( context )
+            contextFeature = context->feature();
+          featureFetched = true;
+        }
+        if ( feature->isValid() )
+        {
+          registers[instruction.result].load( feature->attribute( instruction.a ) );
+        }
+        else
+        {
+          // let the column reference report the error
+          registers[instruction.result].load( instruction.node->eval( parent, context ) );
+          if ( parent->hasEvalError() )
+            return QVariant();
+        }
+        break;
+
+      case Evaluate:
+        registers[instruction.result].load( instruction.node->eval( parent, context ) );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        break;
+
+      case Move:
+        registers[instruction.result] = registers[instruction.a];
+        break;
+
+      case Negate:
+        registers[instruction.result].negate( registers[instruction.a], parent, context );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        break;
+
+      case Not:
+      {
+        const QgsExpressionUtils::TVL tvl = registers[instruction.a].toTvl( parent );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        registers[instruction.result].setTvl( QgsExpressionUtils::NOT[tvl] );
+        break;
+      }
+
+      case Binary:
+        registers[instruction.result].binary( instruction.op, registers[instruction.a], registers[instruction.b], parent, context );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        break;
+
+      case ShortCircuit:
+      {
+        const QgsExpressionUtils::TVL tvl = registers[instruction.a].toTvl( parent );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        if ( instruction.op == QgsExpressionNodeBinaryOperator::boAnd && tvl == QgsExpressionUtils::False )
+        {
+          registers[instruction.result].setTvl( QgsExpressionUtils::False );
+          pc = instruction.target;
+        }
+        else if ( instruction.op == QgsExpressionNodeBinaryOperator::boOr && tvl == QgsExpressionUtils::True )
+        {
+          registers[instruction.result].setTvl( QgsExpressionUtils::True );
+          pc = instruction.target;
+        }
+        break;
+      }
+
+      case JumpIfNotTrue:
+      {
+        const QgsExpressionUtils::TVL tvl = registers[instruction.a].toTvl( parent );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        if ( tvl != QgsExpressionUtils::True )
+          pc = instruction.target;
+        break;
+      }
+
+      case Jump:
+        pc = instruction.target;
+        break;
+    }
+  }
+
+  return registers[mResultRegister].toVariant();
+}
+
+bool QgsExpressionProgram::hasFallbacks() const
+{
+  for ( const Instruction &instruction : mInstructions )
+  {
+    if ( instruction.code == Evaluate )
+      return true;
+  }
+  return false;
+}
+
+int QgsExpressionProgram::fallbackCount() const
+{
+  int count = 0;
+  for ( const Instruction &instruction : mInstructions )
+  {
+    if ( instruction.code == Evaluate )
+      count++;
+  }
+  return count;
+}
+
+void QgsExpressionProgram::setEnabled( bool enabled )
+{
+  sProgramsEnabled = enabled;
+}
+
+bool QgsExpressionProgram::isEnabled()
+{
+  return sProgramsEnabled;
+}
+
+int QgsExpressionProgram::compileNode( QgsExpressionNode *node )
+{
+  Instruction instruction;
+  instruction.node = node;
+
+  if ( node->mHasCachedValue )
+  {
+    // static value, computed during preparation
+    instruction.code = LoadConstant;
+    instruction.a = mConstants.size();
+    mConstants << node->mCachedStaticValue;
+    instruction.result = mRegisterCount++;
+    append( instruction );
+    return instruction.result;
+  }
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntLiteral:
+      instruction.code = LoadConstant;
+      instruction.a = mConstants.size();
+      mConstants << static_cast< QgsExpressionNodeLiteral * >( node )->value();
+      instruction.result = mRegisterCount++;
+      append( instruction );
+      return instruction.result;
+
+    case QgsExpressionNode::ntColumnRef:
+    {
+      const QgsExpressionNodeColumnRef *columnRef = static_cast< QgsExpressionNodeColumnRef * >( node );
+      if ( columnRef->mIndex < 0 )
+        return compileFallback( node );
+
+      instruction.code = LoadField;
+      instruction.a = columnRef->mIndex;
+      instruction.result = mRegisterCount++;
+      append( instruction );
+      return instruction.result;
+    }
+
+    case QgsExpressionNode::ntUnaryOperator:
+    {
+      const QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+      instruction.code = unary->op() == QgsExpressionNodeUnaryOperator::uoNot ? Not : Negate;
+      instruction.a = compileNode( unary->operand() );
+      instruction.result = mRegisterCount++;
+      append( instruction );
+      return instruction.result;
+    }
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      const QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+      instruction.code = Binary;
+      instruction.op = binary->op();
+      instruction.result = mRegisterCount++;
+      instruction.a = compileNode( binary->opLeft() );
+
+      int shortCircuit = -1;
+      if ( instruction.op == QgsExpressionNodeBinaryOperator::boAnd || instruction.op == QgsExpressionNodeBinaryOperator::boOr )
+      {
+        // no need to evaluate the right-hand side if the left-hand side decides the result
+        Instruction jump = instruction;
+        jump.code = ShortCircuit;
+        mHasControlFlow = true;
+        shortCircuit = append( jump );
+      }
+
+      instruction.b = compileNode( binary->opRight() );
+      append( instruction );
+
+      if ( shortCircuit >= 0 )
+        mInstructions[shortCircuit].target = mInstructions.size();
+
+      return instruction.result;
+    }
+
+    case QgsExpressionNode::ntCondition:
+    {
+      const QgsExpressionNodeCondition *condition = static_cast< QgsExpressionNodeCondition * >( node );
+      const int result = mRegisterCount++;
+      mHasControlFlow = true;
+
+      QList< int > jumpsToEnd;
+      const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+      for ( const QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+      {
+        Instruction jumpToNext;
+        jumpToNext.code = JumpIfNotTrue;
+        jumpToNext.a = compileNode( whenThen->whenExp() );
+        const int next = append( jumpToNext );
+
+        Instruction move;
+        move.code = Move;
+        move.a = compileNode( whenThen->thenExp() );
+        move.result = result;
+        append( move );
+
+        Instruction jumpToEnd;
+        jumpToEnd.code = Jump;
+        jumpsToEnd << append( jumpToEnd );
+
+        mInstructions[next].target = mInstructions.size();
+      }
+
+      if ( condition->elseExp() )
+      {
+        Instruction move;
+        move.code = Move;
+        move.a = compileNode( condition->elseExp() );
+        move.result = result;
+        append( move );
+      }
+      else
+      {
+        // NULL if no condition is matching
+        Instruction loadNull;
+        loadNull.code = LoadConstant;
+        loadNull.a = mConstants.size();
+        mConstants << QVariant();
+        loadNull.result = result;
+        append( loadNull );
+      }
+
+      for ( int jump : qgis::as_const( jumpsToEnd ) )
+        mInstructions[jump].target = mInstructions.size();
+
+      return result;
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    case QgsExpressionNode::ntFunction:
+    case QgsExpressionNode::ntIndexOperator:
+      break;
+  }
+
+  return compileFallback( node );
+}
+
+int QgsExpressionProgram::compileFallback( QgsExpressionNode *node )
+{
+  Instruction instruction;
+  instruction.code = Evaluate;
+  instruction.node = node;
+  instruction.result = mRegisterCount++;
+  append( instruction );
+  return instruction.result;
+}
+
+int QgsExpressionProgram::append( const Instruction &instruction )
+{
+  mInstructions.append( instruction );
+  return mInstructions.size() - 1;
+}
+
+///@endcond
@@ -0,0 +1,154 @@
+/***************************************************************************
+                          qgsexpressionprogram.h
+                          ----------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONPROGRAM_H
+#define QGSEXPRESSIONPROGRAM_H
+
+#define SIP_NO_FILE
+
+///@cond PRIVATE
+
+#include <QVariant>
+#include <QVector>
+
+#include <memory>
+
+#include "qgis_core.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsfeature.h"
+
+class QgsExpression;
+class QgsExpressionContext;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionProgram
+ * \brief A prepared expression tree lowered to a flat, register based instruction stream.
+ *
+ * Literals, static nodes, field references, arithmetic, comparison and logical
+ * operators and CASE conditions are executed directly on typed registers, without
+ * boxing intermediate numeric results into QVariant values. Any other node (functions,
+ * IN, LIKE, index operators, ...) is delegated to the tree walking interpreter,
+ * as are operands whose runtime types are not handled by the fast paths, so that the
+ * results are always identical to QgsExpressionNode::eval().
+ *
+ * Programs refer to the nodes of the tree they have been compiled from and must
+ * not outlive it.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsExpressionProgram
+{
+  public:
+
+    /**
+     * Compiles the prepared tree starting at \a root.
+     *
+     * Returns NULLPTR if the tree would entirely be delegated to the tree walking interpreter.
+     */
+    static std::unique_ptr< QgsExpressionProgram > compile( QgsExpressionNode *root );
+
+    /**
+     * Runs the program and returns the result of the expression. Errors are reported to the \a parent.
+     *
+     * This method is reentrant, registers are allocated on each run.
+     */
+    QVariant run( QgsExpression *parent, const QgsExpressionContext *context ) const;
+
+    /**
+     * Runs the program for a block of \a features and returns the results, in the same order.
+     *
+     * Programs without control flow nor fallback instructions are executed one
+     * instruction at a time over the whole block, others one feature at a time.
+     * The feature of the \a context is set to each feature when the tree walking
+     * interpreter may need it, and is the last feature of the block after the call.
+     */
+    QVariantList runBlock( QgsExpression *parent, QgsExpressionContext *context, const QgsFeatureList &features ) const;
+
+    //! Returns the number of instructions of the program
+    int instructionCount() const { return mInstructions.size(); }
+
+    //! Returns the number of nodes which are delegated to the tree walking interpreter
+    int fallbackCount() const;
+
+    //! Returns TRUE if some nodes are delegated to the tree walking interpreter
+    bool hasFallbacks() const;
+
+    /**
+     * Sets whether compiled programs are used by QgsExpression::evaluate().
+     *
+     * This is enabled by default and mostly useful for comparing both engines.
+     */
+    static void setEnabled( bool enabled );
+
+    //! Returns whether compiled programs are used by QgsExpression::evaluate()
+    static bool isEnabled();
+
+  private:
+
+    enum OpCode
+    {
+      LoadConstant, //!< Copies constant a into the result register
+      LoadField, //!< Loads the attribute at index a of the context feature, evaluates node if unavailable
+      Evaluate, //!< Evaluates node with the tree walking interpreter
+      Move, //!< Copies register a into the result register
+      Negate, //!< Unary minus of register a
+      Not, //!< Logical NOT of register a
+      Binary, //!< Binary operator op on registers a and b
+      ShortCircuit, //!< Sets the result register and jumps to target if register a decides the AND/OR operator op
+      JumpIfNotTrue, //!< Jumps to target if register a is not TRUE
+      Jump, //!< Jumps to target
+    };
+
+    struct Instruction
+    {
+      OpCode code = Jump;
+      int result = -1;
+      int a = -1;
+      int b = -1;
+      int target = -1;
+      QgsExpressionNodeBinaryOperator::BinaryOperator op = QgsExpressionNodeBinaryOperator::boOr;
+      QgsExpressionNode *node = nullptr;
+    };
+
+    class Value;
+
+    QgsExpressionProgram() = default;
+
+    /**
+     * Runs the program for a single feature, using \a registers.
+     * If \a feature is NULLPTR, the feature is fetched from the \a context.
+     */
+    QVariant execute( QgsExpression *parent, const QgsExpressionContext *context, const QgsFeature *feature, Value *registers ) const;
+
+    //! Emits the instructions of \a node and returns its result register
+    int compileNode( QgsExpressionNode *node );
+
+    //! Emits a fallback instruction for \a node and returns its result register
+    int compileFallback( QgsExpressionNode *node );
+
+    //! Appends an \a instruction and returns its position
+    int append( const Instruction &instruction );
+
+    QVector< Instruction > mInstructions;
+    QVector< QVariant > mConstants;
+    int mRegisterCount = 0;
+    int mResultRegister = -1;
+    bool mHasControlFlow = false;
+};
+
+///@endcond
+
+#endif // QGSEXPRESSIONPROGRAM_H
@@ -27,6 +27,7 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsgeometryeditutils.h"
 #include <limits>
 #include <cstdio>
+#include <QThreadStorage>
 
 #define DEFAULT_QUADRANT_SEGMENTS 8
 
@@ -113,7 +114,26 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-Q_GLOBAL_STATIC( GEOSInit, geosinit )
+/*
+ * GEOS forbids using a context handle from several threads at once, so
+ * a new GEOS context is created for every thread.
+ */
+#if defined(USE_THREAD_LOCAL) && !defined(Q_OS_WIN)
+static thread_local GEOSInit sGeosInit;
+#else
+static QThreadStorage< GEOSInit * > sGeosInit;
+#endif
+
+static GEOSInit *geosinit()
+{
+#if defined(USE_THREAD_LOCAL) && !defined(Q_OS_WIN)
+  return &sGeosInit;
+#else
+  if ( !sGeosInit.hasLocalData() )
+    sGeosInit.setLocalData( new GEOSInit() );
+  return sGeosInit.localData();
+#endif
+}
 
 void geos::GeosDeleter::operator()( GEOSGeometry *geom )
 {
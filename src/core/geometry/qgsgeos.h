@@ -356,6 +356,12 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static geos::unique_ptr asGeos( const QgsAbstractGeometry *geometry, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    /**
+     * Returns the GEOS context handle of the current thread.
+     *
+     * GEOS context handles must not be used from several threads at once, so every
+     * thread gets its own handle, which must not be passed on to other threads.
+     */
     static GEOSContextHandle_t getGEOSHandler();
 
 
@@ -0,0 +1,201 @@
+/***************************************************************************
+                         qgswkbgeometryview.cpp
+                         ----------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgswkbptr.h"
+#include "qgsgeometry.h"
+
+#include <limits>
+
+///@cond PRIVATE
+
+/**
+ * Extends the bounds [\a xMin, \a xMax] x [\a yMin, \a yMax] by the coordinates of a
+ * sequence of \a pointCount points of \a wkbType read from \a wkb.
+ */
+static void extendBoundsByPoints( QgsConstWkbPtr &wkb, QgsWkbTypes::Type wkbType, unsigned int pointCount,
+                                  double &xMin, double &yMin, double &xMax, double &yMax )
+{
+  const int skipZM = ( QgsWkbTypes::coordDimensions( wkbType ) - 2 ) * sizeof( double );
+  double x = 0;
+  double y = 0;
+  for ( unsigned int i = 0; i < pointCount; ++i )
+  {
+    wkb >> x >> y;
+    if ( skipZM )
+      wkb += skipZM;
+
+    // empty points are stored with NaN coordinates, which never pass these tests
+    if ( x < xMin )
+      xMin = x;
+    if ( x > xMax )
+      xMax = x;
+    if ( y < yMin )
+      yMin = y;
+    if ( y > yMax )
+      yMax = y;
+  }
+}
+
+/**
+ * Extends the bounds by the coordinates of the geometry starting at \a wkb, and moves
+ * \a wkb past it. Returns FALSE if the bounding box cannot be determined from the vertices
+ * of the geometry, i.e. if it contains curves.
+ */
+static bool extendBoundsByGeometry( QgsConstWkbPtr &wkb, double &xMin, double &yMin, double &xMax, double &yMax )
+{
+  const QgsWkbTypes::Type wkbType = wkb.readHeader();
+  switch ( QgsWkbTypes::flatType( wkbType ) )
+  {
+    case QgsWkbTypes::Point:
+      extendBoundsByPoints( wkb, wkbType, 1, xMin, yMin, xMax, yMax );
+      return true;
+
+    case QgsWkbTypes::LineString:
+    {
+      unsigned int pointCount = 0;
+      wkb >> pointCount;
+      extendBoundsByPoints( wkb, wkbType, pointCount, xMin, yMin, xMax, yMax );
+      return true;
+    }
+
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::Triangle:
+    {
+      unsigned int ringCount = 0;
+      wkb >> ringCount;
+      for ( unsigned int i = 0; i < ringCount; ++i )
+      {
+        unsigned int pointCount = 0;
+        wkb >> pointCount;
+        // like QgsCurvePolygon::boundingBox(), only the exterior ring counts
+        if ( i == 0 )
+          extendBoundsByPoints( wkb, wkbType, pointCount, xMin, yMin, xMax, yMax );
+        else
+          wkb += static_cast< int >( pointCount * QgsWkbTypes::coordDimensions( wkbType ) * sizeof( double ) );
+      }
+      return true;
+    }
+
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+    case QgsWkbTypes::GeometryCollection:
+    case QgsWkbTypes::CompoundCurve:
+    case QgsWkbTypes::CurvePolygon:
+    case QgsWkbTypes::MultiCurve:
+    case QgsWkbTypes::MultiSurface:
+    {
+      // each part has its own header
+      unsigned int partCount = 0;
+      wkb >> partCount;
+      for ( unsigned int i = 0; i < partCount; ++i )
+      {
+        if ( !extendBoundsByGeometry( wkb, xMin, yMin, xMax, yMax ) )
+          return false;
+      }
+      return true;
+    }
+
+    default:
+      // circular strings, or types unknown to QGIS
+      return false;
+  }
+}
+
+/**
+ * Calculates the \a bounds of the geometry stored in \a wkb from its vertices. Returns FALSE
+ * if they cannot be determined this way. \a empty is set to TRUE if the geometry has no vertices.
+ */
+static bool boundsFromVertices( const QByteArray &wkb, QgsRectangle &bounds, bool &empty )
+{
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = -std::numeric_limits< double >::max();
+  double yMax = -std::numeric_limits< double >::max();
+  try
+  {
+    QgsConstWkbPtr wkbPtr( wkb );
+    if ( !extendBoundsByGeometry( wkbPtr, xMin, yMin, xMax, yMax ) )
+      return false;
+  }
+  catch ( const QgsWkbException & )
+  {
+    return false;
+  }
+
+  empty = xMin > xMax || yMin > yMax;
+  if ( !empty )
+    bounds = QgsRectangle( xMin, yMin, xMax, yMax );
+  return true;
+}
+
+///@endcond
+
+QgsWkbGeometryView::QgsWkbGeometryView( const QByteArray &wkb )
+  : mWkb( wkb )
+{
+}
+
+QgsWkbTypes::Type QgsWkbGeometryView::wkbType() const
+{
+  if ( mWkb.isEmpty() )
+    return QgsWkbTypes::Unknown;
+
+  try
+  {
+    QgsConstWkbPtr wkb( mWkb );
+    return wkb.readHeader();
+  }
+  catch ( const QgsWkbException & )
+  {
+    return QgsWkbTypes::Unknown;
+  }
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox() const
+{
+  if ( mWkb.isEmpty() )
+    return QgsRectangle();
+
+  QgsRectangle bounds;
+  bool empty = false;
+  if ( !boundsFromVertices( mWkb, bounds, empty ) )
+    return geometry().boundingBox();
+
+  return empty ? QgsRectangle() : bounds;
+}
+
+bool QgsWkbGeometryView::boundingBoxIntersects( const QgsRectangle &rectangle ) const
+{
+  if ( mWkb.isEmpty() )
+    return false;
+
+  QgsRectangle bounds;
+  bool empty = false;
+  if ( !boundsFromVertices( mWkb, bounds, empty ) )
+    return geometry().boundingBoxIntersects( rectangle );
+
+  return !empty && bounds.intersects( rectangle );
+}
+
+QgsGeometry QgsWkbGeometryView::geometry() const
+{
+  QgsGeometry geometry;
+  if ( !mWkb.isEmpty() )
+    geometry.fromWkb( mWkb );
+  return geometry;
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+                         qgswkbgeometryview.h
+                         --------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgswkbtypes.h"
+#include "qgsrectangle.h"
+
+#include <QByteArray>
+
+class QgsGeometry;
+
+/**
+ * \ingroup core
+ * \class QgsWkbGeometryView
+ * \brief A lightweight read-only view of a geometry stored in its WKB representation.
+ *
+ * The view keeps the WKB buffer it was created from, which is implicitly shared
+ * and never copied. Its type and bounding box are read straight from the WKB, without
+ * creating the geometry objects. The full QgsGeometry is only created by geometry().
+ *
+ * Providers can attach a view to a feature with QgsFeature::setGeometryView(),
+ * so that consumers which only need the bounding box of features (such as bounding box
+ * filters or spatial index building) don't pay for creating their geometries.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    //! Constructor for a null QgsWkbGeometryView
+    QgsWkbGeometryView() = default;
+
+    /**
+     * Constructor for QgsWkbGeometryView, viewing the geometry stored in \a wkb.
+     */
+    explicit QgsWkbGeometryView( const QByteArray &wkb );
+
+    /**
+     * Returns TRUE if the view has no WKB.
+     */
+    bool isNull() const { return mWkb.isEmpty(); }
+
+    /**
+     * Returns the WKB the view was created from.
+     */
+    QByteArray wkb() const { return mWkb; }
+
+    /**
+     * Returns the WKB type of the geometry, or QgsWkbTypes::Unknown if the WKB is null or malformed.
+     */
+    QgsWkbTypes::Type wkbType() const;
+
+    /**
+     * Returns the bounding box of the geometry.
+     *
+     * It is read from the coordinates stored in the WKB, without creating the geometry,
+     * except for geometries containing curves (whose bounding box may extend beyond their
+     * vertices) or malformed WKB, for which the geometry is created temporarily.
+     */
+    QgsRectangle boundingBox() const;
+
+    /**
+     * Returns TRUE if the bounding box of the geometry intersects \a rectangle.
+     * \see boundingBox()
+     */
+    bool boundingBoxIntersects( const QgsRectangle &rectangle ) const;
+
+    /**
+     * Creates the geometry from the WKB.
+     */
+    QgsGeometry geometry() const;
+
+  private:
+    QByteArray mWkb;
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
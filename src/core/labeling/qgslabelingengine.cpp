@@ -23,6 +23,7 @@
 #include "layer.h"
 #include "pal.h"
 #include "problem.h"
+#include "candidatecache.h"
 #include "qgsrendercontext.h"
 #include "qgsmaplayer.h"
 #include "qgssymbol.h"
@@ -275,6 +276,10 @@ void QgsLabelingEngine::registerLabels( QgsRenderContext &context )
 
   mPal->setShowPartialLabels( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
   mPal->setPlacementVersion( settings.placementVersion() );
+  mPal->setCandidateCacheEnabled( settings.testFlag( QgsLabelingEngineSettings::CacheCandidates ) );
+
+  mCandidateCacheHits = 0;
+  mCandidateCacheMisses = 0;
 
   // for each provider: get labels and register them in PAL
   for ( QgsAbstractLabelProvider *provider : qgis::as_const( mProviders ) )
@@ -355,6 +360,9 @@ void QgsLabelingEngine::solve( QgsRenderContext &context )
     return;
   }
 
+  mCandidateCacheHits = mPal->candidateCacheHits();
+  mCandidateCacheMisses = mPal->candidateCacheMisses();
+
   if ( context.renderingStopped() )
   {
     return; // it has been canceled
@@ -526,6 +534,11 @@ void QgsLabelingEngine::cleanup()
   mPal.reset();
 }
 
+void QgsLabelingEngine::clearCandidateCache()
+{
+  pal::CandidateCache::instance()->clear();
+}
+
 QgsLabelingResults *QgsLabelingEngine::takeResults()
 {
   return mResults.release();
@@ -265,6 +265,35 @@ class CORE_EXPORT QgsLabelingEngine
     //! For internal use by the providers
     QgsLabelingResults *results() const { return mResults.get(); }
 
+    /**
+     * Returns the number of labeled feature parts whose label candidates were retrieved from
+     * the candidate cache during the last run.
+     *
+     * Candidates are cached between runs when the QgsLabelingEngineSettings::CacheCandidates
+     * flag is set, and reused for the features which are labeled at the same scale with the
+     * same geometry and settings, e.g. on consecutive renders or adjacent tiles.
+     *
+     * \see candidateCacheMisses()
+     * \since QGIS 3.18
+     */
+    int candidateCacheHits() const { return mCandidateCacheHits; }
+
+    /**
+     * Returns the number of labeled feature parts whose label candidates were generated and
+     * stored in the candidate cache during the last run.
+     *
+     * \see candidateCacheHits()
+     * \since QGIS 3.18
+     */
+    int candidateCacheMisses() const { return mCandidateCacheMisses; }
+
+    /**
+     * Removes all the label candidates from the candidate cache shared by the labeling engines.
+     *
+     * \since QGIS 3.18
+     */
+    static void clearCandidateCache();
+
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
@@ -322,6 +351,9 @@ class CORE_EXPORT QgsLabelingEngine
     QList<pal::LabelPosition *> mUnlabeled;
     QList<pal::LabelPosition *> mLabels;
 
+    int mCandidateCacheHits = 0;
+    int mCandidateCacheMisses = 0;
+
 };
 
 /**
@@ -0,0 +1,174 @@
+/***************************************************************************
+  candidatecache.cpp
+  ------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "candidatecache.h"
+#include "feature.h"
+#include "labelposition.h"
+#include "layer.h"
+#include "pal.h"
+#include "qgslabelfeature.h"
+
+#include <QDataStream>
+
+using namespace pal;
+
+//! Default maximum approximate memory used by the cached candidates, in bytes
+static const int DEFAULT_MAXIMUM_SIZE = 32 * 1024 * 1024;
+
+static uint hashPointSet( const PointSet *pointSet, uint seed )
+{
+  seed = qHash( pointSet->getGeosType(), seed ) ^ qHash( pointSet->getNumPoints(), seed );
+  seed = qHashBits( pointSet->x.data(), pointSet->x.size() * sizeof( double ), seed );
+  return qHashBits( pointSet->y.data(), pointSet->y.size() * sizeof( double ), seed );
+}
+
+//! Returns the approximate memory used by a candidate and its next parts
+static int candidateSize( const LabelPosition *candidate )
+{
+  int size = 0;
+  for ( const LabelPosition *position = candidate; position; position = position->nextPart() )
+    size += static_cast< int >( sizeof( LabelPosition ) + 2 * sizeof( double ) * static_cast< std::size_t >( position->getNumPoints() ) );
+  return size;
+}
+
+CandidateCache *CandidateCache::instance()
+{
+  // cached candidates hold no GEOS geometry, so the cache can be destroyed after the GEOS contexts
+  static CandidateCache sInstance;
+  return &sInstance;
+}
+
+CandidateCache::CandidateCache()
+{
+  mEntries.setMaxCost( DEFAULT_MAXIMUM_SIZE );
+}
+
+CandidateCache::Key CandidateCache::key( FeaturePart *part, const Pal *pal )
+{
+  QgsLabelFeature *lf = part->feature();
+  const Layer *layer = part->layer();
+
+  Key key;
+  key.layerId = layer->provider()->layerId();
+  key.providerId = layer->provider()->providerId();
+  key.featureId = lf->id();
+
+  // the geometries are only hashed, they are the expensive part of the key
+  uint geometryHash = hashPointSet( part, 0 );
+  for ( int i = 0; i < part->getNumSelfObstacles(); ++i )
+    geometryHash = hashPointSet( part->getSelfObstacle( i ), geometryHash );
+  if ( !lf->permissibleZone().isNull() )
+    geometryHash = qHash( lf->permissibleZone().asWkb(), geometryHash );
+  key.geometryHash = geometryHash;
+
+  QDataStream stream( &key.properties, QIODevice::WriteOnly );
+
+  // layer and engine settings
+  stream << static_cast< int >( layer->arrangement() ) << layer->centroidInside() << static_cast< int >( layer->upsidedownLabels() )
+         << layer->priority()
+         << static_cast< quint64 >( layer->maximumPointLabelCandidates() )
+         << static_cast< quint64 >( layer->maximumLineLabelCandidates() )
+         << static_cast< quint64 >( layer->maximumPolygonLabelCandidates() )
+         << pal->maximumLineCandidatesPerMapUnit() << pal->maximumPolygonCandidatesPerMapUnitSquared()
+         << static_cast< int >( pal->placementVersion() );
+
+  // label feature
+  const QSizeF size = lf->size();
+  const QSizeF rotatedSize = lf->size( M_PI_2 );
+  stream << lf->labelText()
+         << size.width() << size.height() << rotatedSize.width() << rotatedSize.height()
+         << lf->hasFixedPosition() << lf->fixedPosition().x() << lf->fixedPosition().y()
+         << lf->hasFixedAngle() << lf->fixedAngle()
+         << lf->hasFixedQuadrant() << lf->quadOffset()
+         << lf->positionOffset().x() << lf->positionOffset().y() << static_cast< int >( lf->offsetType() )
+         << lf->distLabel() << lf->repeatDistance() << lf->alwaysShow() << lf->priority()
+         << static_cast< int >( lf->arrangementFlags() ) << static_cast< int >( lf->polygonPlacementFlags() )
+         << lf->overrunDistance() << lf->overrunSmoothDistance()
+         << lf->lineAnchorPercent() << static_cast< int >( lf->lineAnchorType() )
+         << lf->symbolSize()
+         << lf->visualMargin().left() << lf->visualMargin().top() << lf->visualMargin().right() << lf->visualMargin().bottom();
+
+  const QVector< QgsPalLayerSettings::PredefinedPointPosition > positions = lf->predefinedPositionOrder();
+  stream << positions.size();
+  for ( QgsPalLayerSettings::PredefinedPointPosition position : positions )
+    stream << static_cast< int >( position );
+
+  if ( const LabelInfo *info = lf->curvedLabelInfo() )
+  {
+    stream << info->max_char_angle_inside << info->max_char_angle_outside << info->label_height << info->char_num;
+    for ( int i = 0; i < info->char_num; ++i )
+      stream << info->char_info[i].width;
+  }
+
+  // feature part
+  stream << part->totalRepeats() << part->getNumPoints() << part->getNumSelfObstacles();
+
+  return key;
+}
+
+bool CandidateCache::candidates( const Key &key, FeaturePart *part, std::vector<std::unique_ptr<LabelPosition> > &candidates )
+{
+  QMutexLocker locker( &mMutex );
+  const Entry *entry = mEntries.object( key );
+  if ( !entry )
+    return false;
+
+  candidates.clear();
+  candidates.reserve( entry->candidates.size() );
+  for ( const std::unique_ptr< LabelPosition > &candidate : entry->candidates )
+  {
+    candidates.emplace_back( qgis::make_unique< LabelPosition >( *candidate ) );
+    candidates.back()->setFeaturePart( part );
+  }
+  part->feature()->setAnchorPosition( entry->anchorPosition );
+  return true;
+}
+
+void CandidateCache::insert( const Key &key, FeaturePart *part, const std::vector<std::unique_ptr<LabelPosition> > &candidates )
+{
+  std::unique_ptr< Entry > entry = qgis::make_unique< Entry >();
+  entry->candidates.reserve( candidates.size() );
+  int cost = static_cast< int >( sizeof( Entry ) + sizeof( Key ) ) + key.properties.size() + 2 * ( key.layerId.size() + key.providerId.size() );
+  for ( const std::unique_ptr< LabelPosition > &candidate : candidates )
+  {
+    entry->candidates.emplace_back( qgis::make_unique< LabelPosition >( *candidate ) );
+    // the part does not outlive the labeling run, and GEOS geometries are rebuilt on demand
+    entry->candidates.back()->setFeaturePart( nullptr );
+    for ( LabelPosition *position = entry->candidates.back().get(); position; position = position->nextPart() )
+      position->invalidateGeos();
+    cost += candidateSize( candidate.get() );
+  }
+  entry->anchorPosition = part->feature()->anchorPosition();
+
+  QMutexLocker locker( &mMutex );
+  mEntries.insert( key, entry.release(), cost );
+}
+
+void CandidateCache::setMaximumSize( int bytes )
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.setMaxCost( bytes );
+}
+
+int CandidateCache::maximumSize() const
+{
+  QMutexLocker locker( &mMutex );
+  return mEntries.maxCost();
+}
+
+void CandidateCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.clear();
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+  candidatecache.h
+  ------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PAL_CANDIDATECACHE_H
+#define PAL_CANDIDATECACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgspointxy.h"
+#include "qgsfeatureid.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+
+#include <memory>
+#include <vector>
+
+namespace pal
+{
+  class FeaturePart;
+  class LabelPosition;
+  class Pal;
+
+  /**
+   * \ingroup core
+   * \brief A process wide cache of the label candidates generated for feature parts.
+   *
+   * Candidates are cached under a key made of the layer and feature id, a hash of the
+   * geometry of the part, and everything else the candidate generation depends on: the
+   * size and placement properties of the label feature and the placement settings of the
+   * layer and of the engine. These are all expressed in map units, so candidates are
+   * reused when the same features are labeled at the same scale (consecutive renders,
+   * pans leaving the clipped geometry untouched, adjacent tiles), and never otherwise.
+   *
+   * The size of the cache is bounded by the approximate memory used by the candidates.
+   *
+   * \class pal::CandidateCache
+   * \note not available in Python bindings
+   * \since QGIS 3.18
+   */
+  class CORE_EXPORT CandidateCache
+  {
+    public:
+
+      //! Key of the candidates of a feature part
+      struct Key
+      {
+        QString layerId;
+        QString providerId;
+        QgsFeatureId featureId = 0;
+        //! Hash of the geometry of the part, of its self obstacles and of the permissible zone
+        uint geometryHash = 0;
+        //! Serialized label feature and placement settings
+        QByteArray properties;
+
+        bool operator==( const Key &other ) const
+        {
+          return featureId == other.featureId && geometryHash == other.geometryHash
+                 && layerId == other.layerId && providerId == other.providerId
+                 && properties == other.properties;
+        }
+      };
+
+      //! Returns the cache instance
+      static CandidateCache *instance();
+
+      /**
+       * Returns the key of the candidates of a feature \a part labeled by \a pal.
+       */
+      static Key key( FeaturePart *part, const Pal *pal );
+
+      /**
+       * Retrieves the cached candidates for a \a key, bound to the feature \a part, into
+       * \a candidates. The anchor position of the label feature is restored to the position
+       * it had after the candidates were generated.
+       *
+       * Returns FALSE if there are no cached candidates for the key.
+       */
+      bool candidates( const Key &key, FeaturePart *part, std::vector< std::unique_ptr< LabelPosition > > &candidates );
+
+      /**
+       * Stores a copy of the \a candidates generated for a feature \a part, under a \a key.
+       */
+      void insert( const Key &key, FeaturePart *part, const std::vector< std::unique_ptr< LabelPosition > > &candidates );
+
+      /**
+       * Sets the maximum approximate memory used by the cached candidates, in bytes.
+       * \see maximumSize()
+       */
+      void setMaximumSize( int bytes );
+
+      /**
+       * Returns the maximum approximate memory used by the cached candidates, in bytes.
+       * \see setMaximumSize()
+       */
+      int maximumSize() const;
+
+      //! Removes all the cached candidates
+      void clear();
+
+    private:
+
+      CandidateCache();
+
+      struct Entry
+      {
+        std::vector< std::unique_ptr< LabelPosition > > candidates;
+        QgsPointXY anchorPosition;
+      };
+
+      mutable QMutex mMutex;
+      //! Cached entries, costs are their approximate size in bytes
+      QCache< Key, Entry > mEntries;
+  };
+
+  //! Hash of a candidate cache key, built from its cheap members only
+  inline uint qHash( const CandidateCache::Key &key, uint seed = 0 )
+  {
+    return ::qHash( key.layerId, seed ) ^ ::qHash( key.featureId, seed ) ^ key.geometryHash;
+  }
+
+} // namespace pal
+
+#endif // PAL_CANDIDATECACHE_H
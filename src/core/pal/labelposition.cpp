@@ -376,6 +376,13 @@ FeaturePart *LabelPosition::getFeaturePart() const
   return feature;
 }
 
+void LabelPosition::setFeaturePart( FeaturePart *feature )
+{
+  this->feature = feature;
+  if ( mNextPart )
+    mNextPart->setFeaturePart( feature );
+}
+
 void LabelPosition::getBoundingBox( double amin[2], double amax[2] ) const
 {
   if ( mNextPart )
@@ -173,6 +173,12 @@ namespace pal
        */
       FeaturePart *getFeaturePart() const;
 
+      /**
+       * Sets the \a feature corresponding to this labelposition and to its next parts.
+       * \since QGIS 3.18
+       */
+      void setFeaturePart( FeaturePart *feature );
+
       int getNumOverlaps() const { return nbOverlap; }
       void resetNumOverlaps() { nbOverlap = 0; } // called from problem.cpp, pal.cpp
 
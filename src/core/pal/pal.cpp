@@ -41,7 +41,11 @@
 #include "internalexception.h"
 #include "util.h"
 #include "palrtree.h"
+#include "candidatecache.h"
 #include "qgssettings.h"
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
 #include <cfloat>
 #include <list>
 
@@ -114,10 +118,6 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
   std::list< std::unique_ptr< Feats > > features;
 
-  // prepare map boundary
-  geos::unique_ptr mapBoundaryGeos( QgsGeos::asGeos( mapBoundary ) );
-  geos::prepared_unique_ptr mapBoundaryPrepared( GEOSPrepare_r( QgsGeos::getGEOSHandler(), mapBoundaryGeos.get() ) );
-
   int obstacleCount = 0;
 
   // first step : extract features from layers
@@ -156,11 +156,22 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
     QMutexLocker locker( &layer->mMutex );
 
     // generate candidates for all features
+    QVector< FeaturePart * > featureParts;
+    featureParts.reserve( layer->mFeatureParts.size() );
     for ( FeaturePart *featurePart : qgis::as_const( layer->mFeatureParts ) )
+      featureParts << featurePart;
+    std::vector< std::vector< std::unique_ptr< LabelPosition > > > partCandidates = createCandidates( featureParts, mapBoundary );
+
+    if ( isCanceled() )
+      return nullptr;
+
+    for ( int partIndex = 0; partIndex < featureParts.size(); ++partIndex )
     {
       if ( isCanceled() )
         break;
 
+      FeaturePart *featurePart = featureParts.at( partIndex );
+
       // Holes of the feature are obstacles
       for ( int i = 0; i < featurePart->getNumSelfObstacles(); i++ )
       {
@@ -174,23 +185,7 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
         }
       }
 
-      // generate candidates for the feature part
-      std::vector< std::unique_ptr< LabelPosition > > candidates = featurePart->createCandidates( this );
-
-      if ( isCanceled() )
-        break;
-
-      // purge candidates that are outside the bbox
-      candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&mapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
-      {
-        if ( showPartialLabels() )
-          return !candidate->intersects( mapBoundaryPrepared.get() );
-        else
-          return !candidate->within( mapBoundaryPrepared.get() );
-      } ), candidates.end() );
-
-      if ( isCanceled() )
-        break;
+      std::vector< std::unique_ptr< LabelPosition > > candidates = std::move( partCandidates[ partIndex ] );
 
       if ( !candidates.empty() )
       {
@@ -472,6 +467,101 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
   return prob;
 }
 
+std::vector< std::vector< std::unique_ptr< LabelPosition > > > Pal::createCandidates( const QVector< FeaturePart * > &parts, const QgsGeometry &mapBoundary )
+{
+  std::vector< std::vector< std::unique_ptr< LabelPosition > > > candidates( parts.size() );
+
+  // Parts of a label feature (e.g. parts of a multi geometry) share the label feature, which is
+  // updated during candidate generation, so they are grouped in the same task. The tasks are
+  // made of groups of consecutive parts.
+  std::vector< std::vector< int > > tasks;
+  {
+    QHash< QgsLabelFeature *, int > labelFeatureGroups;
+    std::vector< std::vector< int > > groups;
+    for ( int i = 0; i < parts.size(); ++i )
+    {
+      auto it = labelFeatureGroups.constFind( parts.at( i )->feature() );
+      if ( it == labelFeatureGroups.constEnd() )
+      {
+        it = labelFeatureGroups.insert( parts.at( i )->feature(), static_cast< int >( groups.size() ) );
+        groups.emplace_back();
+      }
+      groups[ *it ].emplace_back( i );
+    }
+
+    const std::size_t partsPerTask = 32;
+    for ( std::vector< int > &group : groups )
+    {
+      if ( tasks.empty() || tasks.back().size() >= partsPerTask )
+        tasks.emplace_back();
+      tasks.back().insert( tasks.back().end(), group.begin(), group.end() );
+    }
+  }
+
+  auto createTaskCandidates = [this, &parts, &candidates, &mapBoundary]( const std::vector< int > &task )
+  {
+    // GEOS calls of the task use the GEOS context of its thread, see QgsGeos::getGEOSHandler().
+    // Prepared geometries are not thread safe either, each task prepares its own copy of the map boundary
+    geos::unique_ptr mapBoundaryGeos( QgsGeos::asGeos( mapBoundary ) );
+    geos::prepared_unique_ptr mapBoundaryPrepared( GEOSPrepare_r( QgsGeos::getGEOSHandler(), mapBoundaryGeos.get() ) );
+
+    for ( int partIndex : task )
+    {
+      if ( isCanceled() )
+        return;
+
+      FeaturePart *part = parts.at( partIndex );
+      std::vector< std::unique_ptr< LabelPosition > > partCandidates;
+
+      CandidateCache::Key cacheKey;
+      if ( mCandidateCacheEnabled )
+        cacheKey = CandidateCache::key( part, this );
+
+      if ( mCandidateCacheEnabled && CandidateCache::instance()->candidates( cacheKey, part, partCandidates ) )
+      {
+        mCandidateCacheHits++;
+      }
+      else
+      {
+        // generate candidates for the feature part
+        partCandidates = part->createCandidates( this );
+
+        if ( isCanceled() )
+          return;
+
+        if ( mCandidateCacheEnabled )
+        {
+          CandidateCache::instance()->insert( cacheKey, part, partCandidates );
+          mCandidateCacheMisses++;
+        }
+      }
+
+      // purge candidates that are outside the bbox
+      partCandidates.erase( std::remove_if( partCandidates.begin(), partCandidates.end(), [&mapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
+      {
+        if ( showPartialLabels() )
+          return !candidate->intersects( mapBoundaryPrepared.get() );
+        else
+          return !candidate->within( mapBoundaryPrepared.get() );
+      } ), partCandidates.end() );
+
+      candidates[ partIndex ] = std::move( partCandidates );
+    }
+  };
+
+  if ( tasks.size() > 1 && QThreadPool::globalInstance()->maxThreadCount() > 1 )
+  {
+    QtConcurrent::blockingMap( tasks, createTaskCandidates );
+  }
+  else
+  {
+    for ( const std::vector< int > &task : tasks )
+      createTaskCandidates( task );
+  }
+
+  return candidates;
+}
+
 void Pal::registerCancellationCallback( Pal::FnIsCanceled fnCanceled, void *context )
 {
   fnIsCanceled = fnCanceled;
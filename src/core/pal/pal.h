@@ -43,7 +43,9 @@
 #include <ctime>
 #include <QMutex>
 #include <QStringList>
+#include <QVector>
 #include <unordered_map>
+#include <atomic>
 
 // TODO ${MAJOR} ${MINOR} etc instead of 0.2
 
@@ -56,6 +58,7 @@ namespace pal
   class PalStat;
   class Problem;
   class PointSet;
+  class FeaturePart;
 
   //! Search method to use
   enum SearchMethod
@@ -241,6 +244,39 @@ namespace pal
        */
       int globalCandidatesLimitPolygon() const { return mGlobalCandidatesLimitPolygon; }
 
+      /**
+       * Sets whether the candidates generated for the features are stored in, and
+       * retrieved from, the process wide candidate cache.
+       *
+       * \see candidateCacheEnabled()
+       * \since QGIS 3.18
+       */
+      void setCandidateCacheEnabled( bool enabled ) { mCandidateCacheEnabled = enabled; }
+
+      /**
+       * Returns whether the candidate cache is used.
+       *
+       * \see setCandidateCacheEnabled()
+       * \since QGIS 3.18
+       */
+      bool candidateCacheEnabled() const { return mCandidateCacheEnabled; }
+
+      /**
+       * Returns the number of feature parts whose candidates were retrieved from the candidate cache.
+       *
+       * \see candidateCacheMisses()
+       * \since QGIS 3.18
+       */
+      int candidateCacheHits() const { return mCandidateCacheHits; }
+
+      /**
+       * Returns the number of feature parts whose candidates were not in the candidate cache.
+       *
+       * \see candidateCacheHits()
+       * \since QGIS 3.18
+       */
+      int candidateCacheMisses() const { return mCandidateCacheMisses; }
+
     private:
 
       std::unordered_map< QgsAbstractLabelProvider *, std::unique_ptr< Layer > > mLayers;
@@ -273,6 +309,10 @@ namespace pal
 
       QgsLabelingEngineSettings::PlacementEngineVersion mPlacementVersion = QgsLabelingEngineSettings::PlacementEngineVersion2;
 
+      bool mCandidateCacheEnabled = false;
+      std::atomic< int > mCandidateCacheHits{ 0 };
+      std::atomic< int > mCandidateCacheMisses{ 0 };
+
       //! Callback that may be called from PAL to check whether the job has not been canceled in meanwhile
       FnIsCanceled fnIsCanceled = nullptr;
       //! Application-specific context for the cancellation check function
@@ -285,6 +325,15 @@ namespace pal
        */
       std::unique_ptr< Problem > extract( const QgsRectangle &extent, const QgsGeometry &mapBoundary );
 
+      /**
+       * Generates the candidates of the feature \a parts of a layer, in parallel, and discards
+       * the candidates outside the \a mapBoundary. The candidates of each part are returned
+       * at the part index.
+       *
+       * Parts sharing the same label feature are handled by the same thread.
+       */
+      std::vector< std::vector< std::unique_ptr< LabelPosition > > > createCandidates( const QVector< FeaturePart * > &parts, const QgsGeometry &mapBoundary );
+
       /**
        * \brief Choose the size of popmusic subpart's
        * \param r subpart size
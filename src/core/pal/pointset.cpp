@@ -196,19 +196,23 @@ void PointSet::invalidateGeos()
 
 PointSet::~PointSet()
 {
-  GEOSContextHandle_t geosctxt = QgsGeos::getGEOSHandler();
-
-  if ( mGeos && mOwnsGeom )
+  // point sets without GEOS geometries do not touch the GEOS context, so they can be destroyed at exit
+  if ( ( mGeos && mOwnsGeom ) || mPreparedGeom || mGeosPreparedBoundary )
   {
-    GEOSGeom_destroy_r( geosctxt, mGeos );
-    mGeos = nullptr;
-  }
-  GEOSPreparedGeom_destroy_r( geosctxt, mPreparedGeom );
+    GEOSContextHandle_t geosctxt = QgsGeos::getGEOSHandler();
 
-  if ( mGeosPreparedBoundary )
-  {
-    GEOSPreparedGeom_destroy_r( geosctxt, mGeosPreparedBoundary );
-    mGeosPreparedBoundary = nullptr;
+    if ( mGeos && mOwnsGeom )
+    {
+      GEOSGeom_destroy_r( geosctxt, mGeos );
+      mGeos = nullptr;
+    }
+    GEOSPreparedGeom_destroy_r( geosctxt, mPreparedGeom );
+
+    if ( mGeosPreparedBoundary )
+    {
+      GEOSPreparedGeom_destroy_r( geosctxt, mGeosPreparedBoundary );
+      mGeosPreparedBoundary = nullptr;
+    }
   }
 
   deleteCoords();
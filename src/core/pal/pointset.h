@@ -75,6 +75,7 @@ namespace pal
       friend class CostCalculator;
       friend class PolygonCostCalculator;
       friend class Layer;
+      friend class CandidateCache;
 
     public:
       PointSet();
@@ -39,6 +39,10 @@
 #include "internalexception.h"
 #include <cfloat>
 #include <limits> //for std::numeric_limits<int>::max()
+#include <atomic>
+
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 #include "qgslabelingengine.h"
 
@@ -564,6 +568,9 @@ void Problem::chain_search()
   if ( mFeatureCount == 0 )
     return;
 
+  if ( !mIsComponentGroup && chainSearchComponents() )
+    return;
+
   int i;
   int seed;
   bool *ok = new bool[mFeatureCount];
@@ -654,6 +661,149 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+bool Problem::chainSearchComponents()
+{
+  // below this size, the cost of splitting the problem outweighs the gain
+  const std::size_t minFeatureCount = 256;
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  if ( mFeatureCount < minFeatureCount || threadCount < 2 )
+    return false;
+
+  // find the connected components of the conflict graph
+  std::vector< int > parents( mFeatureCount );
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+    parents[i] = static_cast< int >( i );
+
+  auto findRoot = [&parents]( int feature ) -> int
+  {
+    while ( parents[feature] != feature )
+    {
+      parents[feature] = parents[ parents[feature] ];
+      feature = parents[feature];
+    }
+    return feature;
+  };
+
+  double amin[2];
+  double amax[2];
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    for ( int j = 0; j < mFeatNbLp[i]; j++ )
+    {
+      const LabelPosition *lp = mLabelPositions[ mFeatStartId[i] + j ].get();
+      lp->getBoundingBox( amin, amax );
+      mAllCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &parents, &findRoot]( const LabelPosition * lp2 ) -> bool
+      {
+        const int root1 = findRoot( lp->getProblemFeatureId() );
+        const int root2 = findRoot( lp2->getProblemFeatureId() );
+        if ( root1 != root2 && lp->isInConflict( lp2 ) )
+          parents[ std::max( root1, root2 ) ] = std::min( root1, root2 );
+        return true;
+      } );
+    }
+  }
+
+  // pack the components in groups of features, so that each thread gets a few groups
+  const std::size_t groupSize = std::max( static_cast< std::size_t >( 64 ), mFeatureCount / ( 4 * threadCount ) );
+  std::vector< std::vector< int > > components;
+  std::vector< int > componentIndex( mFeatureCount, -1 );
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    const int root = findRoot( static_cast< int >( i ) );
+    if ( componentIndex[root] < 0 )
+    {
+      componentIndex[root] = static_cast< int >( components.size() );
+      components.emplace_back();
+    }
+    components[ componentIndex[root] ].emplace_back( static_cast< int >( i ) );
+  }
+
+  std::vector< std::vector< int > > groups;
+  for ( const std::vector< int > &component : components )
+  {
+    if ( groups.empty() || groups.back().size() >= groupSize )
+      groups.emplace_back();
+    groups.back().insert( groups.back().end(), component.begin(), component.end() );
+  }
+
+  if ( groups.size() < 2 )
+    return false;
+
+  mSol.init( mFeatureCount );
+
+  const QgsRectangle extent( mMapExtentBounds[0], mMapExtentBounds[1], mMapExtentBounds[2], mMapExtentBounds[3] );
+  std::atomic< bool > empty( false );
+
+  // each group owns its candidates while it is solved, the candidates are given back to
+  // this problem afterwards, with their original ids
+  auto solveGroup = [this, &extent, &empty]( const std::vector< int > &features )
+  {
+    Problem group( extent );
+    group.pal = pal;
+    group.mDisplayAll = mDisplayAll;
+    group.mIsComponentGroup = true;
+    group.mFeatureCount = features.size();
+    group.mFeatStartId.resize( features.size() );
+    group.mFeatNbLp.resize( features.size() );
+    group.mInactiveCost.resize( features.size() );
+
+    int groupLabelId = 0;
+    for ( std::size_t k = 0; k < features.size(); k++ )
+    {
+      const int feature = features[k];
+      group.mFeatStartId[k] = groupLabelId;
+      group.mFeatNbLp[k] = mFeatNbLp[feature];
+      group.mInactiveCost[k] = mInactiveCost[feature];
+      for ( int j = 0; j < mFeatNbLp[feature]; j++ )
+      {
+        std::unique_ptr< LabelPosition > &lp = mLabelPositions[ mFeatStartId[feature] + j ];
+        lp->setProblemIds( static_cast< int >( k ), groupLabelId++ );
+        lp->insertIntoIndex( group.mAllCandidatesIndex );
+        group.mLabelPositions.emplace_back( std::move( lp ) );
+      }
+    }
+    group.mTotalCandidates = groupLabelId;
+    group.mAllNblp = groupLabelId;
+
+    try
+    {
+      group.chain_search();
+    }
+    catch ( InternalException::Empty & )
+    {
+      empty = true;
+    }
+
+    for ( std::size_t k = 0; k < features.size(); k++ )
+    {
+      const int feature = features[k];
+      for ( int j = 0; j < mFeatNbLp[feature]; j++ )
+      {
+        const int labelId = mFeatStartId[feature] + j;
+        mLabelPositions[ labelId ] = std::move( group.mLabelPositions[ group.mFeatStartId[k] + j ] );
+        mLabelPositions[ labelId ]->setProblemIds( feature, labelId );
+      }
+
+      const int groupActiveLabelId = k < group.mSol.activeLabelIds.size() ? group.mSol.activeLabelIds[k] : -1;
+      mSol.activeLabelIds[feature] = groupActiveLabelId < 0 ? -1 : mFeatStartId[feature] + groupActiveLabelId - group.mFeatStartId[k];
+    }
+  };
+
+  QtConcurrent::blockingMap( groups, solveGroup );
+
+  if ( empty )
+    throw InternalException::Empty();
+
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    if ( mSol.activeLabelIds[i] >= 0 )
+      mLabelPositions[ mSol.activeLabelIds[i] ]->insertIntoIndex( mActiveCandidatesIndex );
+  }
+
+  solution_cost();
+  return true;
+}
+
 QList<LabelPosition *> Problem::getSolution( bool returnInactive, QList<LabelPosition *> *unlabeled )
 {
   QList<LabelPosition *> finalLabelPlacements;
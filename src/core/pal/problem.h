@@ -223,7 +223,22 @@ namespace pal
 
       Pal *pal = nullptr;
 
+      /**
+       * TRUE if the problem is a group of independent components of another problem,
+       * which must not be split again
+       */
+      bool mIsComponentGroup = false;
+
       void solution_cost();
+
+      /**
+       * Splits the problem in groups of connected components of the conflict graph and
+       * runs the chain search of the groups concurrently.
+       *
+       * Returns FALSE if the problem is too small or cannot be split, in which
+       * case the problem is left untouched.
+       */
+      bool chainSearchComponents();
   };
 
 } // namespace
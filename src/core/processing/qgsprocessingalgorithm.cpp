@@ -30,6 +30,10 @@
 #include "qgsmeshlayer.h"
 #include "qgsexpressioncontextutils.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <functional>
 
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
@@ -1005,22 +1009,29 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   QgsFeature f;
   QgsFeatureIterator it = mSource->getFeatures( request(), sourceFlags() );
 
-  double step = count > 0 ? 100.0 / count : 1;
-  int current = 0;
-  while ( it.nextFeature( f ) )
+  if ( ( flags() & FlagSupportsParallelFeatureProcessing ) && QThreadPool::globalInstance()->maxThreadCount() > 1 )
   {
-    if ( feedback->isCanceled() )
+    processFeaturesInParallel( it, sink.get(), count, context, feedback );
+  }
+  else
+  {
+    double step = count > 0 ? 100.0 / count : 1;
+    int current = 0;
+    while ( it.nextFeature( f ) )
     {
-      break;
-    }
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
 
-    context.expressionContext().setFeature( f );
-    const QgsFeatureList transformed = processFeature( f, context, feedback );
-    for ( QgsFeature transformedFeature : transformed )
-      sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
+      context.expressionContext().setFeature( f );
+      const QgsFeatureList transformed = processFeature( f, context, feedback );
+      for ( QgsFeature transformedFeature : transformed )
+        sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+    }
   }
 
   mSource.reset();
@@ -1033,6 +1044,175 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   return outputs;
 }
 
+///@cond PRIVATE
+
+//! Number of features processed by a task of the thread pool
+static const int PARALLEL_FEATURE_CHUNK_SIZE = 256;
+
+//! A chunk of features processed by a task of the thread pool, with its results
+struct QgsProcessingFeatureChunk
+{
+  QgsProcessingFeatureBasedAlgorithm *algorithm = nullptr;
+  const QgsProcessingContext *context = nullptr;
+  QgsProcessingFeedback *feedback = nullptr;
+
+  QgsFeatureList features;
+  QVector< QgsFeatureList > results;
+  //! Messages pushed while processing the features, forwarded to the algorithm feedback afterwards
+  QList< std::function< void( QgsProcessingFeedback * ) > > messages;
+  bool failed = false;
+  QString error;
+};
+
+/**
+ * Feedback of a chunk of features processed in a worker thread, which stores
+ * the messages in the chunk.
+ */
+class QgsProcessingFeatureChunkFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    explicit QgsProcessingFeatureChunkFeedback( QgsProcessingFeatureChunk &chunk )
+      : mChunk( chunk )
+    {}
+
+    void setProgressText( const QString & ) override {}
+
+    void reportError( const QString &error, bool fatalError = false ) override
+    {
+      mChunk.messages << [error, fatalError]( QgsProcessingFeedback * feedback ) { feedback->reportError( error, fatalError ); };
+    }
+
+    void pushWarning( const QString &warning ) override
+    {
+      mChunk.messages << [warning]( QgsProcessingFeedback * feedback ) { feedback->pushWarning( warning ); };
+    }
+
+    void pushInfo( const QString &info ) override
+    {
+      mChunk.messages << [info]( QgsProcessingFeedback * feedback ) { feedback->pushInfo( info ); };
+    }
+
+    void pushCommandInfo( const QString &info ) override
+    {
+      mChunk.messages << [info]( QgsProcessingFeedback * feedback ) { feedback->pushCommandInfo( info ); };
+    }
+
+    void pushDebugInfo( const QString &info ) override
+    {
+      mChunk.messages << [info]( QgsProcessingFeedback * feedback ) { feedback->pushDebugInfo( info ); };
+    }
+
+    void pushConsoleInfo( const QString &info ) override
+    {
+      mChunk.messages << [info]( QgsProcessingFeedback * feedback ) { feedback->pushConsoleInfo( info ); };
+    }
+
+  private:
+
+    QgsProcessingFeatureChunk &mChunk;
+};
+
+static void processFeatureChunk( QgsProcessingFeatureChunk &chunk )
+{
+  // each task works on its own copy of the context, including the expression context
+  QgsProcessingContext context;
+  context.copyThreadSafeSettings( *chunk.context );
+  QgsProcessingFeatureChunkFeedback feedback( chunk );
+  context.setFeedback( &feedback );
+
+  chunk.results.reserve( chunk.features.size() );
+  try
+  {
+    for ( const QgsFeature &feature : qgis::as_const( chunk.features ) )
+    {
+      if ( chunk.feedback->isCanceled() )
+      {
+        feedback.cancel();
+        break;
+      }
+
+      context.expressionContext().setFeature( feature );
+      chunk.results << chunk.algorithm->processFeature( feature, context, &feedback );
+    }
+  }
+  catch ( QgsException &e )
+  {
+    chunk.failed = true;
+    chunk.error = e.what();
+  }
+}
+
+///@endcond
+
+void QgsProcessingFeatureBasedAlgorithm::processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink *sink, long count, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  const int maxChunks = 2 * QThreadPool::globalInstance()->maxThreadCount();
+  bool atEnd = false;
+
+  // features are read and written by the calling thread
+  auto readChunks = [&]
+  {
+    QVector< QgsProcessingFeatureChunk > chunks;
+    QgsFeature f;
+    while ( !atEnd && chunks.size() < maxChunks && !feedback->isCanceled() )
+    {
+      QgsProcessingFeatureChunk chunk;
+      chunk.algorithm = this;
+      chunk.context = &context;
+      chunk.feedback = feedback;
+      chunk.features.reserve( PARALLEL_FEATURE_CHUNK_SIZE );
+      while ( chunk.features.size() < PARALLEL_FEATURE_CHUNK_SIZE )
+      {
+        if ( !iterator.nextFeature( f ) )
+        {
+          atEnd = true;
+          break;
+        }
+        chunk.features << f;
+      }
+
+      if ( !chunk.features.isEmpty() )
+        chunks << chunk;
+    }
+    return chunks;
+  };
+
+  double step = count > 0 ? 100.0 / count : 1;
+  long current = 0;
+  QVector< QgsProcessingFeatureChunk > chunks = readChunks();
+  while ( !chunks.isEmpty() )
+  {
+    QFuture< void > future = QtConcurrent::map( chunks, processFeatureChunk );
+    // read the next chunks while the current ones are processed
+    QVector< QgsProcessingFeatureChunk > nextChunks = readChunks();
+    future.waitForFinished();
+
+    for ( const QgsProcessingFeatureChunk &chunk : qgis::as_const( chunks ) )
+    {
+      for ( const auto &message : chunk.messages )
+        message( feedback );
+
+      for ( const QgsFeatureList &transformed : chunk.results )
+      {
+        for ( QgsFeature transformedFeature : transformed )
+          sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
+
+        feedback->setProgress( current * step );
+        current++;
+      }
+
+      if ( chunk.failed )
+        throw QgsProcessingException( chunk.error );
+    }
+
+    if ( feedback->isCanceled() )
+      break;
+
+    chunks = nextChunks;
+  }
+}
+
 QgsFeatureRequest QgsProcessingFeatureBasedAlgorithm::request() const
 {
   return QgsFeatureRequest();
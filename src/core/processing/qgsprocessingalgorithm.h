@@ -81,6 +81,7 @@ class CORE_EXPORT QgsProcessingAlgorithm
       FlagSkipGenericModelLogging = 1 << 12, //!< When running as part of a model, the generic algorithm setup and results logging should be skipped
       FlagNotAvailableInStandaloneTool = 1 << 13, //!< Algorithm should not be available from the standalone "qgis_process" tool. Used to flag algorithms which make no sense outside of the QGIS application, such as "select by..." style algorithms.
       FlagRequiresProject = 1 << 14, //!< The algorithm requires that a valid QgsProject is available from the processing context in order to execute
+      FlagSupportsParallelFeatureProcessing = 1 << 15, //!< Feature based algorithm whose processFeature() implementation does not modify the algorithm and can be called from several threads at once. Features are then processed by a thread pool. Since QGIS 3.18
       FlagDeprecated = FlagHideFromToolbox | FlagHideFromModeler, //!< Algorithm is deprecated
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -1114,6 +1115,12 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      * prevent the algorithm execution from continuing. This can be annoying for users though as it
      * can break valid model execution - so use with extreme caution, and consider using
      * \a feedback to instead report non-fatal processing failures for features instead.
+     *
+     * If the algorithm flags() contain FlagSupportsParallelFeatureProcessing, this method is
+     * called from several threads at once, each with its own copy of the \a context (including
+     * its expression context) and its own \a feedback, whose messages are forwarded to the algorithm
+     * feedback in the order of the features. Implementations must then only read the algorithm
+     * members set in prepareAlgorithm(). This is not supported for algorithms implemented in Python.
      */
     virtual QgsFeatureList processFeature( const QgsFeature &feature, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) SIP_THROW( QgsProcessingException ) = 0 SIP_VIRTUALERRORHANDLER( processing_exception_handler );
 
@@ -1248,6 +1255,12 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
 
   private:
 
+    /**
+     * Processes the features of the \a iterator with the global thread pool, and writes
+     * the results to the \a sink in the order of the source features.
+     */
+    void processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink *sink, long count, QgsProcessingContext &context, QgsProcessingFeedback *feedback );
+
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
 
 };
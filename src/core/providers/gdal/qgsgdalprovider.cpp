@@ -258,6 +258,7 @@ QgsGdalProvider::QgsGdalProvider( const QgsGdalProvider &other )
   mHasPyramids = other.mHasPyramids;
   mGdalDataType = other.mGdalDataType;
   mExtent = other.mExtent;
+  mBlockCacheVersion = other.mBlockCacheVersion;
   mWidth = other.mWidth;
   mHeight = other.mHeight;
   mXBlockSize = other.mXBlockSize;
@@ -539,6 +540,7 @@ void QgsGdalProvider::reloadProviderData()
 {
   QMutexLocker locker( mpMutex );
   closeDataset();
+  QgsRasterBlockCache::removeSource( dataSourceUri( true ) );
 
   mHasInit = false;
   ( void )initIfNeeded();
@@ -681,12 +683,22 @@ QgsRasterBlock *QgsGdalProvider::block( int bandNo, const QgsRectangle &extent,
     QRect subRect = QgsRasterBlock::subRect( extent, width, height, mExtent );
     block->setIsNoDataExcept( subRect );
   }
-  if ( !readBlock( bandNo, extent, width, height, block->bits(), feedback ) )
+
+  // blocks of datasets opened for update are never cached, as they may be changed
+  const bool useCache = !mUpdate && !mBlockCacheVersion.isEmpty() && QgsRasterBlockCache::maximumCost() > 0;
+  const qgssize size = static_cast< qgssize >( block->dataTypeSize() ) * width * height;
+  const QgsRasterBlockCache::Key cacheKey = useCache ? blockCacheKey( bandNo, extent, width, height ) : QgsRasterBlockCache::Key();
+  if ( !useCache || !QgsRasterBlockCache::block( cacheKey, block->bits(), size ) )
   {
-    block->setError( { tr( "Error occurred while reading block." ), QStringLiteral( "GDAL" ) } );
-    block->setIsNoData();
-    block->setValid( false );
-    return block.release();
+    if ( !readBlock( bandNo, extent, width, height, block->bits(), feedback ) )
+    {
+      block->setError( { tr( "Error occurred while reading block." ), QStringLiteral( "GDAL" ) } );
+      block->setIsNoData();
+      block->setValid( false );
+      return block.release();
+    }
+    if ( useCache && !( feedback && feedback->isCanceled() ) )
+      QgsRasterBlockCache::insertBlock( cacheKey, block->bits(), size );
   }
   // apply scale and offset
   Q_ASSERT( block ); // to make cppcheck happy
@@ -695,6 +707,49 @@ QgsRasterBlock *QgsGdalProvider::block( int bandNo, const QgsRectangle &extent,
   return block.release();
 }
 
+QgsRasterBlockCache::Key QgsGdalProvider::blockCacheKey( int bandNo, const QgsRectangle &extent, int width, int height ) const
+{
+  QgsRasterBlockCache::Key key;
+  key.source = dataSourceUri( true );
+  // values depend on the resampling done by GDAL, and on the version of files changed by other processes
+  key.settings = QStringLiteral( "%1:%2:%3:%4:%5" ).arg( mProviderResamplingEnabled )
+                 .arg( static_cast< int >( mZoomedInResamplingMethod ) )
+                 .arg( static_cast< int >( mZoomedOutResamplingMethod ) )
+                 .arg( mMaxOversampling )
+                 .arg( mBlockCacheVersion );
+  key.bandNumber = bandNo;
+  key.extent = extent;
+  key.width = width;
+  key.height = height;
+  return key;
+}
+
+QString QgsGdalProvider::blockCacheVersion() const
+{
+  // Only the blocks of plain files are cached: the version of remote (/vsicurl/ etc.) and
+  // database sources, or of the sources referenced by a VRT, cannot be known. Subdatasets
+  // and URIs with options do not name an existing file either.
+  const QString source = dataSourceUri( true );
+  if ( mUpdate || mDriverName == QLatin1String( "VRT" ) || source.startsWith( QLatin1String( "/vsi" ) ) || !QFileInfo( source ).isFile() )
+    return QString();
+
+  // the dataset files include the sidecar files, such as external overviews and .aux.xml files
+  QStringList version;
+  char **files = GDALGetFileList( mGdalBaseDataset );
+  for ( char **file = files; file && *file; ++file )
+  {
+    const QFileInfo fileInfo( QString::fromUtf8( *file ) );
+    if ( !fileInfo.isFile() )
+    {
+      CSLDestroy( files );
+      return QString();
+    }
+    version << QStringLiteral( "%1:%2:%3" ).arg( fileInfo.filePath() ).arg( fileInfo.size() ).arg( fileInfo.lastModified().toMSecsSinceEpoch() );
+  }
+  CSLDestroy( files );
+  return version.join( '|' );
+}
+
 bool QgsGdalProvider::readBlock( int bandNo, int xBlock, int yBlock, void *data )
 {
   QMutexLocker locker( mpMutex );
@@ -1663,7 +1718,8 @@ QgsRasterDataProvider::ProviderCapabilities QgsGdalProvider::providerCapabilitie
 {
   return ProviderCapability::ProviderHintBenefitsFromResampling |
          ProviderCapability::ProviderHintCanPerformProviderResampling |
-         ProviderCapability::ReloadData;
+         ProviderCapability::ReloadData |
+         ProviderCapability::ConcurrentReads;
 }
 
 // This is used also by global isValidRasterFileName
@@ -2147,6 +2203,9 @@ QString QgsGdalProvider::buildPyramids( const QList<QgsRasterPyramid> &rasterPyr
 
   QgsDebugMsgLevel( QStringLiteral( "Pyramid overviews built" ), 2 );
 
+  // zoomed out blocks are now read from the new overviews
+  QgsRasterBlockCache::removeSource( dataSourceUri( true ) );
+
   // Observed problem: if a *.rrd file exists and GDALBuildOverviews() is called,
   // the *.rrd is deleted and no overviews are created, if GDALBuildOverviews()
   // is called next time, it crashes somewhere in GDAL:
@@ -2922,6 +2981,7 @@ void QgsGdalProvider::initBaseDataset()
   mDriverName = GDALGetDriverShortName( GDALGetDatasetDriver( mGdalBaseDataset ) );
   mHasInit = true;
   mValid = true;
+  mBlockCacheVersion = blockCacheVersion();
 #if 0
   for ( int i = 0; i < GDALGetRasterCount( mGdalBaseDataset ); i++ )
   {
@@ -3269,6 +3329,7 @@ bool QgsGdalProvider::write( void *data, int band, int width, int height, int xO
   {
     return false;
   }
+  QgsRasterBlockCache::removeSource( dataSourceUri( true ) );
   return gdalRasterIO( rasterBand, GF_Write, xOffset, yOffset, width, height, data, width, height, GDALGetRasterDataType( rasterBand ), 0, 0 ) == CE_None;
 }
 
@@ -3294,6 +3355,8 @@ bool QgsGdalProvider::setNoDataValue( int bandNo, double noDataValue )
   mSrcNoDataValue[bandNo - 1] = noDataValue;
   mSrcHasNoDataValue[bandNo - 1] = true;
   mUseSrcNoDataValue[bandNo - 1] = true;
+  // values resampled by GDAL depend on the nodata value
+  QgsRasterBlockCache::removeSource( dataSourceUri( true ) );
   return true;
 }
 
@@ -3316,6 +3379,7 @@ bool QgsGdalProvider::remove()
       return false;
 
     closeDataset();
+    QgsRasterBlockCache::removeSource( dataSourceUri( true ) );
 
     CPLErrorReset();
     CPLErr err = GDALDeleteDataset( driver, dataSourceUri( true ).toUtf8().constData() );
@@ -3492,6 +3556,7 @@ bool QgsGdalProvider::setEditable( bool enabled )
   }
 
   closeDataset();
+  QgsRasterBlockCache::removeSource( dataSourceUri( true ) );
 
   mUpdate = enabled;
 
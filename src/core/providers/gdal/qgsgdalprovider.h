@@ -22,6 +22,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsdataitem.h"
 #include "qgsrasterdataprovider.h"
+#include "qgsrasterblockcache.h"
 #include "qgsgdalproviderbase.h"
 #include "qgsrectangle.h"
 #include "qgscolorrampshader.h"
@@ -314,6 +315,18 @@ class QgsGdalProvider final: public QgsRasterDataProvider, QgsGdalProviderBase
     //! \brief Close data set and release related data
     void closeDataset();
 
+    //! Returns the key of a block in the shared raster block cache
+    QgsRasterBlockCache::Key blockCacheKey( int bandNo, const QgsRectangle &extent, int width, int height ) const;
+
+    //! Returns the version of the files of the dataset, or an empty string if its blocks cannot be cached
+    QString blockCacheVersion() const;
+
+    /**
+     * Version of the files of the dataset when it was opened (their sizes and modification times),
+     * empty if the blocks of the dataset are not cached
+     */
+    QString mBlockCacheVersion;
+
     //! Pair of GDAL base dataset and "real" dataset handles.
     struct DatasetPair
     {
@@ -27,6 +27,7 @@
 #include "qgssettings.h"
 #include "qgsexception.h"
 #include "qgswkbtypes.h"
+#include "qgswkbgeometryview.h"
 #include "qgsogrtransaction.h"
 
 #include <QTextCodec>
@@ -519,7 +520,16 @@ bool QgsOgrFeatureIterator::readFeature( gdal::ogr_feature_unique_ptr fet, QgsFe
   {
     OGRGeometryH geom = OGR_F_GetGeometryRef( fet.get() );
 
-    if ( geom )
+    const OGRwkbGeometryType flatGeomType = geom ? wkbFlatten( OGR_G_GetGeometryType( geom ) ) : wkbUnknown;
+    if ( geom && ( flatGeomType == wkbMultiPolygon || ( flatGeomType == wkbPolygon && !QgsWkbTypes::isMultiType( mSource->mWkbType ) ) ) )
+    {
+      // polygons have no fast conversion path, so only keep a view of their WKB
+      // and leave the geometry to be created if a consumer actually needs it
+      QByteArray wkb( OGR_G_WkbSize( geom ), Qt::Uninitialized );
+      OGR_G_ExportToWkb( geom, static_cast<OGRwkbByteOrder>( QgsApplication::endian() ), reinterpret_cast< unsigned char * >( wkb.data() ) );
+      feature.setGeometryView( QgsWkbGeometryView( wkb ) );
+    }
+    else if ( geom )
     {
       QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
 
@@ -541,7 +551,8 @@ bool QgsOgrFeatureIterator::readFeature( gdal::ogr_feature_unique_ptr fet, QgsFe
     }
     else if ( ( useIntersect && ( !feature.hasGeometry()
                                   || ( mRequest.flags() & QgsFeatureRequest::ExactIntersect && !feature.geometry().intersects( mFilterRect ) )
-                                  || ( !( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) && !feature.geometry().boundingBoxIntersects( mFilterRect ) )
+                                  || ( !( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) && !feature.geometryView().isNull() && !feature.geometryView().boundingBoxIntersects( mFilterRect ) )
+                                  || ( !( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) && feature.geometryView().isNull() && !feature.geometry().boundingBoxIntersects( mFilterRect ) )
                                 )
               )
               || ( geometryTypeFilter && ( !feature.hasGeometry() || QgsOgrProvider::ogrWkbSingleFlatten( ( OGRwkbGeometryType )feature.geometry().wkbType() ) != mSource->mOgrGeometryTypeFilter ) ) )
@@ -22,6 +22,41 @@
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
 
+//! Number of features for which expressions are evaluated at once
+static const int EXPRESSION_BLOCK_SIZE = 1024;
+
+/**
+ * Calls \a addValue with the value of the \a expression, or of the attribute \a attr if
+ * there is no expression, for each feature of \a fit. Expressions are evaluated over
+ * blocks of features.
+ */
+template< typename AddValue >
+static void iterateValues( QgsFeatureIterator &fit, int attr, QgsExpression *expression, QgsExpressionContext *context, const AddValue &addValue )
+{
+  QgsFeature f;
+  if ( !expression )
+  {
+    while ( fit.nextFeature( f ) )
+      addValue( f.attribute( attr ) );
+    return;
+  }
+
+  Q_ASSERT( context );
+  QgsFeatureList block;
+  block.reserve( EXPRESSION_BLOCK_SIZE );
+  bool hasMoreFeatures = true;
+  while ( hasMoreFeatures )
+  {
+    block.clear();
+    while ( block.size() < EXPRESSION_BLOCK_SIZE && ( hasMoreFeatures = fit.nextFeature( f ) ) )
+      block << f;
+
+    const QVariantList values = expression->evaluateBlock( block, context );
+    for ( const QVariant &v : values )
+      addValue( v );
+  }
+}
+
 
 
 QgsAggregateCalculator::QgsAggregateCalculator( const QgsVectorLayer *layer )
@@ -677,22 +712,10 @@ QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &
   Q_ASSERT( expression || attr >= 0 );
 
   QgsStatisticalSummary s( stat );
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
+  iterateValues( fit, attr, expression, context, [&s]( const QVariant & v )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
-    }
-    else
-    {
-      s.addVariant( f.attribute( attr ) );
-    }
-  }
+    s.addVariant( v );
+  } );
   s.finalize();
   double val = s.statistic( stat );
   return std::isnan( val ) ? QVariant() : val;
@@ -704,22 +727,10 @@ QVariant QgsAggregateCalculator::calculateStringAggregate( QgsFeatureIterator &f
   Q_ASSERT( expression || attr >= 0 );
 
   QgsStringStatisticalSummary s( stat );
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
+  iterateValues( fit, attr, expression, context, [&s]( const QVariant & v )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
-    }
-    else
-    {
-      s.addValue( f.attribute( attr ) );
-    }
-  }
+    s.addValue( v );
+  } );
   s.finalize();
   return s.statistic( stat );
 }
@@ -728,18 +739,14 @@ QVariant QgsAggregateCalculator::calculateGeometryAggregate( QgsFeatureIterator
 {
   Q_ASSERT( expression );
 
-  QgsFeature f;
   QVector< QgsGeometry > geometries;
-  while ( fit.nextFeature( f ) )
+  iterateValues( fit, -1, expression, context, [&geometries]( const QVariant & v )
   {
-    Q_ASSERT( context );
-    context->setFeature( f );
-    QVariant v = expression->evaluate( context );
     if ( v.canConvert<QgsGeometry>() )
     {
       geometries << v.value<QgsGeometry>();
     }
-  }
+  } );
 
   return QVariant::fromValue( QgsGeometry::collectGeometry( geometries ) );
 }
@@ -749,26 +756,13 @@ QVariant QgsAggregateCalculator::concatenateStrings( QgsFeatureIterator &fit, in
 {
   Q_ASSERT( expression || attr >= 0 );
 
-  QgsFeature f;
   QStringList results;
-  while ( fit.nextFeature( f ) )
+  iterateValues( fit, attr, expression, context, [&results, unique]( const QVariant & v )
   {
-    QString result;
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      result = v.toString();
-    }
-    else
-    {
-      result = f.attribute( attr ).toString();
-    }
-
+    const QString result = v.toString();
     if ( !unique || !results.contains( result ) )
       results << result;
-  }
+  } );
 
   return results.join( delimiter );
 }
@@ -819,22 +813,10 @@ QVariant QgsAggregateCalculator::calculateDateTimeAggregate( QgsFeatureIterator
   Q_ASSERT( expression || attr >= 0 );
 
   QgsDateTimeStatisticalSummary s( stat );
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
+  iterateValues( fit, attr, expression, context, [&s]( const QVariant & v )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
-    }
-    else
-    {
-      s.addValue( f.attribute( attr ) );
-    }
-  }
+    s.addValue( v );
+  } );
   s.finalize();
   return s.statistic( stat );
 }
@@ -844,24 +826,11 @@ QVariant QgsAggregateCalculator::calculateArrayAggregate( QgsFeatureIterator &fi
 {
   Q_ASSERT( expression || attr >= 0 );
 
-  QgsFeature f;
-
   QVariantList array;
-
-  while ( fit.nextFeature( f ) )
+  iterateValues( fit, attr, expression, context, [&array]( const QVariant & v )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      array.append( v );
-    }
-    else
-    {
-      array.append( f.attribute( attr ) );
-    }
-  }
+    array.append( v );
+  } );
   return array;
 }
 
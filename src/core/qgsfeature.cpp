@@ -68,7 +68,7 @@ bool QgsFeature::operator ==( const QgsFeature &other ) const
        && d->valid == other.d->valid
        && d->fields == other.d->fields
        && d->attributes == other.d->attributes
-       && d->geometry.equals( other.d->geometry ) )
+       && geometry().equals( other.geometry() ) )
     return true;
 
   return false;
@@ -102,9 +102,33 @@ void QgsFeature::deleteAttribute( int field )
 
 QgsGeometry QgsFeature::geometry() const
 {
+  if ( d->geometryPending.loadAcquire() )
+  {
+    // the feature may be shared with other threads, create the geometry only once
+    QMutexLocker locker( &d->geometryMutex );
+    if ( d->geometryPending.loadAcquire() )
+    {
+      d->geometry = d->geometryView.geometry();
+      d->geometryPending.storeRelease( 0 );
+    }
+  }
   return d->geometry;
 }
 
+QgsWkbGeometryView QgsFeature::geometryView() const
+{
+  return d->geometryView;
+}
+
+QgsRectangle QgsFeature::geometryBoundingBox() const
+{
+  // read straight from the WKB while the geometry has not been created yet
+  if ( d->geometryPending.loadAcquire() && !QgsWkbTypes::isCurvedType( d->geometryView.wkbType() ) )
+    return d->geometryView.boundingBox();
+
+  return geometry().boundingBox();
+}
+
 /***************************************************************************
  * This class is considered CRITICAL and any change MUST be accompanied with
  * full unit tests in testqgsfeature.cpp.
@@ -145,6 +169,8 @@ void QgsFeature::setGeometry( const QgsGeometry &geometry )
 {
   d.detach();
   d->geometry = geometry;
+  d->geometryView = QgsWkbGeometryView();
+  d->geometryPending.store( 0 );
   d->valid = true;
 }
 
@@ -152,6 +178,17 @@ void QgsFeature::setGeometry( std::unique_ptr<QgsAbstractGeometry> geometry )
 {
   d.detach();
   d->geometry = QgsGeometry( std::move( geometry ) );
+  d->geometryView = QgsWkbGeometryView();
+  d->geometryPending.store( 0 );
+  d->valid = true;
+}
+
+void QgsFeature::setGeometryView( const QgsWkbGeometryView &view )
+{
+  d.detach();
+  d->geometry = QgsGeometry();
+  d->geometryView = view;
+  d->geometryPending.store( view.isNull() ? 0 : 1 );
   d->valid = true;
 }
 
@@ -203,7 +240,7 @@ void QgsFeature::setValid( bool validity )
 
 bool QgsFeature::hasGeometry() const
 {
-  return !d->geometry.isNull();
+  return d->geometryPending.loadAcquire() || !d->geometry.isNull();
 }
 
 void QgsFeature::initAttributes( int fieldCount )
@@ -345,7 +382,7 @@ int QgsFeature::approximateMemoryUsage() const
   s += sizeof( QAtomicInt ) + sizeof( void * ); // ~ sizeof(QgsGeometryPrivate)
   // For simplicity we consider that the RAM usage is the one of the WKB
   // representation
-  s += d->geometry.wkbSize();
+  s += d->geometryPending.loadAcquire() ? d->geometryView.wkb().size() : d->geometry.wkbSize();
 
   // Fields
   s += sizeof( QgsFieldsPrivate );
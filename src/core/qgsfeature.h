@@ -37,6 +37,7 @@ class QgsField;
 class QgsGeometry;
 class QgsRectangle;
 class QgsAbstractGeometry;
+class QgsWkbGeometryView;
 
 
 /***************************************************************************
@@ -421,6 +422,41 @@ class CORE_EXPORT QgsFeature
      */
     void clearGeometry();
 
+    /**
+     * Sets the feature's geometry from a read-only \a view of its WKB representation.
+     *
+     * The geometry is only created from the WKB when geometry() is first called. Consumers
+     * which only need the bounding box of the geometry should call geometryBoundingBox() or
+     * geometryView() instead, which read the WKB directly.
+     *
+     * Calling setGeometry() or clearGeometry() discards the view.
+     *
+     * \see geometryView()
+     * \since QGIS 3.18
+     */
+    void setGeometryView( const QgsWkbGeometryView &view );
+
+    /**
+     * Returns the read-only view of the feature's geometry set by setGeometryView(), or
+     * a null view if the geometry was set by any other means.
+     *
+     * \see setGeometryView()
+     * \since QGIS 3.18
+     */
+    QgsWkbGeometryView geometryView() const;
+
+    /**
+     * Returns the bounding box of the feature's geometry, or a null rectangle if the
+     * feature has no geometry.
+     *
+     * If the geometry was set with setGeometryView() and has not been requested yet, the
+     * bounding box is read from the WKB without creating the geometry.
+     *
+     * \see geometry()
+     * \since QGIS 3.18
+     */
+    QgsRectangle geometryBoundingBox() const;
+
     /**
      * Assign a field map with the feature to allow attribute access by attribute name.
      *  \param fields The attribute fields which this feature holds
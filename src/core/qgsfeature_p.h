@@ -36,6 +36,10 @@ email                : nyall dot dawson at gmail dot com
 #include "qgsfields.h"
 
 #include "qgsgeometry.h"
+#include "qgswkbgeometryview.h"
+
+#include <QAtomicInt>
+#include <QMutex>
 
 class QgsFeaturePrivate : public QSharedData
 {
@@ -51,10 +55,13 @@ class QgsFeaturePrivate : public QSharedData
       : QSharedData( other )
       , fid( other.fid )
       , attributes( other.attributes )
-      , geometry( other.geometry )
       , valid( other.valid )
       , fields( other.fields )
     {
+      QMutexLocker locker( &other.geometryMutex );
+      geometry = other.geometry;
+      geometryView = other.geometryView;
+      geometryPending.store( other.geometryPending.load() );
     }
 
     ~QgsFeaturePrivate()
@@ -68,7 +75,16 @@ class QgsFeaturePrivate : public QSharedData
     QgsAttributes attributes;
 
     //! Geometry, may be empty if feature has no geometry
-    QgsGeometry geometry;
+    mutable QgsGeometry geometry;
+
+    //! Read-only view of the geometry's WKB, if the geometry was set from one
+    QgsWkbGeometryView geometryView;
+
+    //! Non zero while geometry still has to be created from geometryView
+    mutable QAtomicInt geometryPending = 0;
+
+    //! Guards the creation of geometry from geometryView, which may happen from const methods of shared features
+    mutable QMutex geometryMutex;
 
     //! Flag to indicate if this feature is valid
     bool valid;
@@ -17,6 +17,7 @@
 #include "qgsmaptopixel.h"
 
 #include <QPoint>
+#include <QPolygonF>
 #include <QTextStream>
 #include <QVector>
 #include <QTransform>
@@ -151,6 +152,38 @@ void QgsMapToPixel::setParameters( double mapUnitsPerPixel,
   }
 }
 
+void QgsMapToPixel::transformInPlace( QPolygonF &polygon ) const
+{
+  if ( mMatrix.type() == QTransform::TxProject )
+  {
+    // never built by QgsMapToPixel, but stay correct anyway
+    QPointF *ptr = polygon.data();
+    for ( int i = 0; i < polygon.size(); ++i, ++ptr )
+      transformInPlace( ptr->rx(), ptr->ry() );
+    return;
+  }
+
+  // affine transform: apply the same coefficients to every point, in a branch free loop
+  // which the compiler can vectorize. The expressions match the ones used by QTransform::map(),
+  // so the results are identical to transforming the points one by one.
+  const double m11 = mMatrix.m11();
+  const double m12 = mMatrix.m12();
+  const double m21 = mMatrix.m21();
+  const double m22 = mMatrix.m22();
+  const double dx = mMatrix.dx();
+  const double dy = mMatrix.dy();
+
+  const int count = polygon.size();
+  QPointF *ptr = polygon.data();
+  for ( int i = 0; i < count; ++i, ++ptr )
+  {
+    const double x = ptr->x();
+    const double y = ptr->y();
+    ptr->rx() = m11 * x + m21 * y + dx;
+    ptr->ry() = m12 * x + m22 * y + dy;
+  }
+}
+
 QString QgsMapToPixel::showParameters() const
 {
   QString rep;
@@ -44,6 +44,7 @@ class QgsMapSettings;
 class QgsRenderedFeatureHandlerInterface;
 class QgsSymbolLayer;
 class QgsMaskIdProvider;
+class QgsRenderObjectPool;
 class QgsMapClippingRegion;
 
 
@@ -85,6 +86,8 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
       ApplyScalingWorkaroundForTextRendering = 0x2000, //!< Whether a scaling workaround designed to stablise the rendering of small font sizes (or for painters scaled out by a large amount) when rendering text. Generally this is recommended, but it may incur some performance cost.
       Render3DMap              = 0x4000, //!< Render is for a 3D map
       ApplyClipAfterReprojection = 0x8000, //!< Feature geometry clipping to mapExtent() must be performed after the geometries are transformed using coordinateTransform(). Usually feature geometry clipping occurs using the extent() in the layer's CRS prior to geometry transformation, but in some cases when extent() could not be accurately calculated it is necessary to clip geometries to mapExtent() AFTER transforming them using coordinateTransform().
+      PipelinedFeatureFetching = 0x10000, //!< Fetch the features of vector layers on a separate thread while they are being drawn (since QGIS 3.18)
+      PartitionedVectorRendering = 0x20000, //!< Split the extent of each vector layer into parts which are drawn concurrently into separate images, then merged (since QGIS 3.18)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -739,6 +742,28 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
      */
     const QgsMaskIdProvider *maskIdProvider() const { return mMaskIdProvider; }
 
+    /**
+     * Attaches a \a pool of temporary objects to the context, which rendering helpers will reuse from
+     * feature to feature instead of allocating new ones. Ownership of the pool is not transferred.
+     *
+     * As pools are not thread safe, the pool is not copied along with the context.
+     *
+     * \see objectPool()
+     * \note Not available in Python bindings
+     * \since QGIS 3.18
+     */
+    void setObjectPool( QgsRenderObjectPool *pool ) SIP_SKIP { mObjectPool = pool; }
+
+    /**
+     * Returns the pool of temporary objects attached to the context, or NULLPTR if temporary objects
+     * should be allocated as usual.
+     *
+     * \see setObjectPool()
+     * \note Not available in Python bindings
+     * \since QGIS 3.18
+     */
+    QgsRenderObjectPool *objectPool() const SIP_SKIP { return mObjectPool; }
+
     /**
      * Stores a mask id as the "current" one.
      * \see currentMaskId()
@@ -894,6 +919,9 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
      */
     QgsMaskIdProvider *mMaskIdProvider = nullptr;
 
+    //! Pool of temporary objects, not owned
+    QgsRenderObjectPool *mObjectPool = nullptr;
+
     /**
      * Current mask identifier
      * \since QGIS 3.12
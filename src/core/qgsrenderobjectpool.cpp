@@ -0,0 +1,118 @@
+/***************************************************************************
+                         qgsrenderobjectpool.cpp
+                         -----------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrenderobjectpool.h"
+
+QPolygonF QgsRenderObjectPool::takePolygon( int capacity )
+{
+  if ( mPolygons.empty() )
+  {
+    mAllocationCount++;
+    QPolygonF polygon;
+    polygon.reserve( capacity );
+    return polygon;
+  }
+
+  QPolygonF polygon;
+  polygon.swap( mPolygons.back() );
+  mPolygons.pop_back();
+  if ( polygon.capacity() < capacity )
+  {
+    mAllocationCount++;
+    polygon.reserve( capacity );
+  }
+  else
+  {
+    mReuseCount++;
+  }
+  return polygon;
+}
+
+void QgsRenderObjectPool::releasePolygon( QPolygonF &&polygon )
+{
+  // a buffer still shared with another polygon would be detached (i.e. copied) when reused
+  if ( !polygon.isDetached() || polygon.capacity() == 0 || polygon.capacity() > MAX_POOLED_POLYGON_CAPACITY
+       || mPolygons.size() >= static_cast< std::size_t >( MAX_POOLED_OBJECTS ) )
+  {
+    polygon = QPolygonF();
+    return;
+  }
+
+  // since Qt 5.7 clearing a vector preserves its capacity
+  polygon.clear();
+  mPolygons.emplace_back();
+  mPolygons.back().swap( polygon );
+}
+
+QVector< QPolygonF > QgsRenderObjectPool::takePolygonList( int capacity )
+{
+  if ( mPolygonLists.empty() )
+  {
+    mAllocationCount++;
+    QVector< QPolygonF > polygons;
+    polygons.reserve( capacity );
+    return polygons;
+  }
+
+  QVector< QPolygonF > polygons;
+  polygons.swap( mPolygonLists.back() );
+  mPolygonLists.pop_back();
+  if ( polygons.capacity() < capacity )
+  {
+    mAllocationCount++;
+    polygons.reserve( capacity );
+  }
+  else
+  {
+    mReuseCount++;
+  }
+  return polygons;
+}
+
+void QgsRenderObjectPool::releasePolygonList( QVector< QPolygonF > &&polygons )
+{
+  if ( !polygons.isDetached() )
+  {
+    // the polygons are shared with the other list as well
+    polygons = QVector< QPolygonF >();
+    return;
+  }
+
+  for ( QPolygonF &polygon : polygons )
+    releasePolygon( std::move( polygon ) );
+
+  if ( polygons.capacity() == 0 || mPolygonLists.size() >= static_cast< std::size_t >( MAX_POOLED_OBJECTS ) )
+  {
+    polygons = QVector< QPolygonF >();
+    return;
+  }
+
+  polygons.clear();
+  mPolygonLists.emplace_back();
+  mPolygonLists.back().swap( polygons );
+}
+
+void QgsRenderObjectPool::clear()
+{
+  mPolygons.clear();
+  mPolygonLists.clear();
+}
+
+void QgsRenderObjectPool::resetCounters()
+{
+  mAllocationCount = 0;
+  mReuseCount = 0;
+}
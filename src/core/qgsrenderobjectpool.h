@@ -0,0 +1,126 @@
+/***************************************************************************
+                         qgsrenderobjectpool.h
+                         ---------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRENDEROBJECTPOOL_H
+#define QGSRENDEROBJECTPOOL_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QPolygonF>
+#include <QVector>
+#include <vector>
+
+/**
+ * \ingroup core
+ * \class QgsRenderObjectPool
+ *
+ * Pools of the temporary buffers created for every feature while rendering a map layer,
+ * so that they are reused from feature to feature instead of being allocated and freed
+ * for each of them.
+ *
+ * A pool is attached to a render context with QgsRenderContext::setObjectPool(). The
+ * rendering helpers which create these temporaries (such as the conversion of geometries
+ * to painter coordinates in QgsSymbol) take them from the pool of the context when it
+ * has one, and give them back once the feature has been drawn.
+ *
+ * Buffers which are still shared with other objects when given back are simply released,
+ * so that handing a buffer to a pool never affects its other users.
+ *
+ * The pool counts how many buffers it handed out were newly allocated, and how many were
+ * reused, so that the reduction of allocations can be measured.
+ *
+ * \warning Pools are not thread safe, and must only be used by the thread doing the rendering.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsRenderObjectPool
+{
+  public:
+
+    //! Maximum number of buffers of each kind kept by the pool
+    static constexpr int MAX_POOLED_OBJECTS = 64;
+
+    //! Maximum number of points of the polygon buffers kept by the pool, larger ones are freed
+    static constexpr int MAX_POOLED_POLYGON_CAPACITY = 1 << 16;
+
+    QgsRenderObjectPool() = default;
+
+    QgsRenderObjectPool( const QgsRenderObjectPool &other ) = delete;
+    QgsRenderObjectPool &operator=( const QgsRenderObjectPool &other ) = delete;
+
+    /**
+     * Returns an empty polygon, which can hold at least \a capacity points without allocating.
+     * \see releasePolygon()
+     */
+    QPolygonF takePolygon( int capacity = 0 );
+
+    /**
+     * Gives the buffer of a \a polygon which is no longer needed back to the pool.
+     * \see takePolygon()
+     */
+    void releasePolygon( QPolygonF &&polygon );
+
+    /**
+     * Returns an empty list of polygons, which can hold at least \a capacity polygons without allocating.
+     * \see releasePolygonList()
+     */
+    QVector< QPolygonF > takePolygonList( int capacity = 0 );
+
+    /**
+     * Gives the buffer of a list of \a polygons which is no longer needed back to the pool, along
+     * with the buffers of the polygons it contains.
+     * \see takePolygonList()
+     */
+    void releasePolygonList( QVector< QPolygonF > &&polygons );
+
+    /**
+     * Frees all the buffers kept by the pool.
+     */
+    void clear();
+
+    /**
+     * Returns the number of buffers handed out by the pool which had to be allocated, because
+     * no buffer large enough was available.
+     * \see reuseCount()
+     * \see resetCounters()
+     */
+    qint64 allocationCount() const { return mAllocationCount; }
+
+    /**
+     * Returns the number of buffers handed out by the pool which were reused without allocating.
+     * \see allocationCount()
+     * \see resetCounters()
+     */
+    qint64 reuseCount() const { return mReuseCount; }
+
+    /**
+     * Resets the allocation and reuse counters.
+     */
+    void resetCounters();
+
+  private:
+
+    std::vector< QPolygonF > mPolygons;
+    std::vector< QVector< QPolygonF > > mPolygonLists;
+
+    qint64 mAllocationCount = 0;
+    qint64 mReuseCount = 0;
+};
+
+#endif // QGSRENDEROBJECTPOOL_H
@@ -392,7 +392,7 @@ bool QgsSpatialIndex::featureInfo( const QgsFeature &f, QgsRectangle &rect, QgsF
     return false;
 
   id = f.id();
-  rect = f.geometry().boundingBox();
+  rect = f.geometryBoundingBox();
 
   if ( !rect.isFinite() )
     return false;
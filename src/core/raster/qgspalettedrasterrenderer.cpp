@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgspalettedrasterrenderer.h"
+#include "qgsrastercolorlookuptable_p.h"
 #include "qgsrastertransparency.h"
 #include "qgsrasterviewport.h"
 #include "qgssymbollayerutils.h"
@@ -175,6 +176,39 @@ QgsRasterBlock *QgsPalettedRasterRenderer::block( int, QgsRectangle  const &exte
   Q_ASSERT( outputBlock ); // to make cppcheck happy
   unsigned int *outputData = ( unsigned int * )( outputBlock->bits() );
 
+  // color of a value, with the opacity of the alpha band for the pixel
+  const auto valueColor = [&]( double value, double alphaBandOpacity ) -> QRgb
+  {
+    const QMap< double, QRgb >::const_iterator it = mColors.constFind( value );
+    if ( it == mColors.constEnd() )
+    {
+      return myDefaultColor;
+    }
+
+    if ( !hasTransparency )
+    {
+      return it.value();
+    }
+
+    currentOpacity = mOpacity;
+    if ( mRasterTransparency )
+    {
+      currentOpacity = mRasterTransparency->alphaValue( value, mOpacity * 255 ) / 255.0;
+    }
+    currentOpacity *= alphaBandOpacity;
+
+    QRgb c = it.value();
+    return qRgba( currentOpacity * qRed( c ), currentOpacity * qGreen( c ), currentOpacity * qBlue( c ), currentOpacity * qAlpha( c ) );
+  };
+
+  // colors only depend on values: look each distinct value up once, rather than each pixel
+  if ( mAlphaBand <= 0 &&
+       QgsRasterColorLookupTable::renderIntegerBlock( inputBlock.get(), outputData, myDefaultColor,
+           [&valueColor]( double value ) { return valueColor( value, 1.0 ); } ) )
+  {
+    return outputBlock.release();
+  }
+
   qgssize rasterSize = ( qgssize )width * height;
   bool isNoData = false;
   for ( qgssize i = 0; i < rasterSize; ++i )
@@ -185,31 +219,8 @@ QgsRasterBlock *QgsPalettedRasterRenderer::block( int, QgsRectangle  const &exte
       outputData[i] = myDefaultColor;
       continue;
     }
-    if ( !mColors.contains( value ) )
-    {
-      outputData[i] = myDefaultColor;
-      continue;
-    }
 
-    if ( !hasTransparency )
-    {
-      outputData[i] = mColors.value( value );
-    }
-    else
-    {
-      currentOpacity = mOpacity;
-      if ( mRasterTransparency )
-      {
-        currentOpacity = mRasterTransparency->alphaValue( value, mOpacity * 255 ) / 255.0;
-      }
-      if ( mAlphaBand > 0 )
-      {
-        currentOpacity *= alphaBlock->value( i ) / 255.0;
-      }
-
-      QRgb c = mColors.value( value );
-      outputData[i] = qRgba( currentOpacity * qRed( c ), currentOpacity * qGreen( c ), currentOpacity * qBlue( c ), currentOpacity * qAlpha( c ) );
-    }
+    outputData[i] = valueColor( value, mAlphaBand > 0 ? alphaBlock->value( i ) / 255.0 : 1.0 );
   }
 
   return outputBlock.release();
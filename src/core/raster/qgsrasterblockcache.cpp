@@ -0,0 +1,145 @@
+/***************************************************************************
+  qgsrasterblockcache.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrasterblockcache.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+//! Returns the initial maximum total size of the blocks, in kilobytes: the cache is disabled unless requested
+static int defaultMaximumCost()
+{
+  bool ok = false;
+  const int megabytes = qEnvironmentVariableIntValue( "QGIS_RASTER_BLOCK_CACHE_SIZE", &ok );
+  return ok ? std::max( 0, std::min( megabytes, std::numeric_limits< int >::max() / 1024 ) ) * 1024 : 0;
+}
+
+uint qHash( const QgsRasterBlockCache::Key &key, uint seed = 0 )
+{
+  uint hash = qHash( key.source, seed );
+  hash = hash * 31 + qHash( key.settings, seed );
+  hash = hash * 31 + qHash( key.bandNumber, seed );
+  hash = hash * 31 + qHash( key.width, seed );
+  hash = hash * 31 + qHash( key.height, seed );
+  hash = hash * 31 + qHash( key.extent.xMinimum(), seed );
+  hash = hash * 31 + qHash( key.extent.yMaximum(), seed );
+  return hash;
+}
+
+// the cache is created on first use, to be sure it is constructed before it is used by providers
+struct QgsRasterBlockCacheData
+{
+  QCache< QgsRasterBlockCache::Key, QByteArray > cache { defaultMaximumCost() };
+  QMutex mutex;
+  qint64 hits = 0;
+  qint64 misses = 0;
+};
+
+static QgsRasterBlockCacheData &cacheData()
+{
+  static QgsRasterBlockCacheData sData;
+  return sData;
+}
+
+//! Returns the cost of a block of \a size bytes, in kilobytes
+static int cost( qgssize size )
+{
+  return static_cast< int >( std::min< qgssize >( ( size + 1023 ) / 1024, std::numeric_limits< int >::max() ) );
+}
+
+bool QgsRasterBlockCache::block( const Key &key, void *data, qgssize size )
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  const QByteArray *bytes = d.cache.object( key );
+  if ( !bytes || static_cast< qgssize >( bytes->size() ) != size )
+  {
+    d.misses++;
+    return false;
+  }
+
+  std::memcpy( data, bytes->constData(), size );
+  d.hits++;
+  return true;
+}
+
+void QgsRasterBlockCache::insertBlock( const Key &key, const void *data, qgssize size )
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  const int blockCost = cost( size );
+  if ( blockCost > d.cache.maxCost() || size > static_cast< qgssize >( std::numeric_limits< int >::max() ) )
+    return;
+
+  d.cache.insert( key, new QByteArray( static_cast< const char * >( data ), static_cast< int >( size ) ), blockCost );
+}
+
+void QgsRasterBlockCache::removeSource( const QString &source )
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  const QList< Key > keys = d.cache.keys();
+  for ( const Key &key : keys )
+  {
+    if ( key.source == source )
+      d.cache.remove( key );
+  }
+}
+
+void QgsRasterBlockCache::clear()
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  d.cache.clear();
+}
+
+int QgsRasterBlockCache::maximumCost()
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  return d.cache.maxCost();
+}
+
+void QgsRasterBlockCache::setMaximumCost( int kilobytes )
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  d.cache.setMaxCost( std::max( 0, kilobytes ) );
+}
+
+QgsRasterBlockCache::Statistics QgsRasterBlockCache::statistics()
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  Statistics statistics;
+  statistics.hits = d.hits;
+  statistics.misses = d.misses;
+  statistics.blockCount = d.cache.count();
+  statistics.totalCost = d.cache.totalCost();
+  statistics.maximumCost = d.cache.maxCost();
+  return statistics;
+}
+
+void QgsRasterBlockCache::resetStatistics()
+{
+  QgsRasterBlockCacheData &d = cacheData();
+  QMutexLocker locker( &d.mutex );
+  d.hits = 0;
+  d.misses = 0;
+}
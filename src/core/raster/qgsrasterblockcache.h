@@ -0,0 +1,133 @@
+/***************************************************************************
+  qgsrasterblockcache.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRASTERBLOCKCACHE_H
+#define QGSRASTERBLOCKCACHE_H
+
+#include "qgis_core.h"
+#include "qgis.h"
+#include "qgsrectangle.h"
+
+#include <QString>
+
+#define SIP_NO_FILE
+
+/**
+ * A process wide cache of the decoded pixels of raster blocks, as read by data providers.
+ *
+ * Blocks are identified by their source, the settings of the provider which affect the
+ * values read, the band, and the extent and size of the window read, i.e. its resolution.
+ * Providers opened on the same source share the cached blocks, so that panning back, map
+ * tiles requested in bursts or processing steps reading the same windows do not read and
+ * decode the same data again.
+ *
+ * The cache is bounded by the total size of the blocks, the least recently used blocks are
+ * removed first.
+ *
+ * The cache is disabled by default, as it cannot detect every change of the sources done
+ * by other processes. It is enabled by setting its maximum size with setMaximumCost(), or
+ * with the QGIS_RASTER_BLOCK_CACHE_SIZE environment variable (in megabytes). Providers
+ * only cache the blocks of sources whose version they can identify, see
+ * QgsRasterBlockCache::Key::settings.
+ *
+ * The class is thread safe (its methods can be called from any thread).
+ *
+ * \note Not available in Python bindings
+ * \ingroup core
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsRasterBlockCache
+{
+  public:
+
+    //! Identifies a block in the cache
+    struct Key
+    {
+      //! Source of the block, usually the data source URI of the provider
+      QString source;
+      //! Settings of the provider which affect the values read, and version of the source
+      QString settings;
+      //! Band number of the block
+      int bandNumber = 0;
+      //! Extent of the block
+      QgsRectangle extent;
+      //! Width of the block in pixels
+      int width = 0;
+      //! Height of the block in pixels
+      int height = 0;
+
+      bool operator==( const Key &other ) const
+      {
+        return bandNumber == other.bandNumber && width == other.width && height == other.height
+               && extent == other.extent && source == other.source && settings == other.settings;
+      }
+    };
+
+    //! Statistics of the use of the cache
+    struct Statistics
+    {
+      //! Number of blocks found in the cache
+      qint64 hits = 0;
+      //! Number of blocks looked for and not found in the cache
+      qint64 misses = 0;
+      //! Number of blocks in the cache
+      int blockCount = 0;
+      //! Total size of the blocks in the cache, in kilobytes
+      int totalCost = 0;
+      //! Maximum total size of the blocks in the cache, in kilobytes
+      int maximumCost = 0;
+    };
+
+    /**
+     * Copies the \a size bytes of the block identified by \a key to \a data.
+     * \returns TRUE if the block exists in the cache with this size
+     */
+    static bool block( const Key &key, void *data, qgssize size );
+
+    /**
+     * Adds a copy of the \a size bytes of \a data as the block identified by \a key.
+     *
+     * Blocks larger than the maximum size of the cache are not added.
+     */
+    static void insertBlock( const Key &key, const void *data, qgssize size );
+
+    /**
+     * Removes the blocks of a \a source from the cache, e.g. after its data was changed.
+     */
+    static void removeSource( const QString &source );
+
+    //! Removes all blocks from the cache
+    static void clear();
+
+    /**
+     * Returns the maximum total size of the blocks in the cache, in kilobytes.
+     * \see setMaximumCost()
+     */
+    static int maximumCost();
+
+    /**
+     * Sets the maximum total size of the blocks in the cache, in \a kilobytes. Setting 0 disables the cache,
+     * which is the default unless the QGIS_RASTER_BLOCK_CACHE_SIZE environment variable is set.
+     * \see maximumCost()
+     */
+    static void setMaximumCost( int kilobytes );
+
+    //! Returns the statistics of the use of the cache
+    static Statistics statistics();
+
+    //! Resets the numbers of hits and misses of the statistics
+    static void resetStatistics();
+};
+
+#endif // QGSRASTERBLOCKCACHE_H
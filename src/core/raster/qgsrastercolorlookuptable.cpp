@@ -0,0 +1,153 @@
+/***************************************************************************
+                         qgsrastercolorlookuptable.cpp
+                         -----------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrastercolorlookuptable_p.h"
+#include "qgsrasterblock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+///@cond PRIVATE
+
+//! Maximum number of entries of the tables of integer values
+static const qgssize MAXIMUM_INTEGER_TABLE_SIZE = 1 << 20;
+
+template <typename T>
+static bool renderIntegers( QgsRasterBlock *input, QRgb *output, QRgb noDataColor, const QgsRasterColorLookupTable::ColorFunction &color )
+{
+  const qgssize count = static_cast< qgssize >( input->width() ) * input->height();
+  const T *data = reinterpret_cast< const T * >( input->bits() );
+  if ( count == 0 || !data )
+    return false;
+
+  T minimum = data[0];
+  T maximum = data[0];
+  for ( qgssize i = 1; i < count; ++i )
+  {
+    minimum = std::min( minimum, data[i] );
+    maximum = std::max( maximum, data[i] );
+  }
+
+  // building the table must not take longer than shading each pixel
+  const qint64 offset = minimum;
+  const qgssize size = static_cast< qgssize >( static_cast< qint64 >( maximum ) - offset ) + 1;
+  if ( size > std::max< qgssize >( count, 256 ) || size > MAXIMUM_INTEGER_TABLE_SIZE )
+    return false;
+
+  const bool hasNoDataValue = input->hasNoDataValue();
+  const double noDataValue = input->noDataValue();
+  std::vector< QRgb > table( size );
+  for ( qgssize i = 0; i < size; ++i )
+  {
+    const double value = static_cast< double >( offset + static_cast< qint64 >( i ) );
+    table[i] = hasNoDataValue && QgsRasterBlock::isNoDataValue( value, noDataValue ) ? noDataColor : color( value );
+  }
+
+  for ( qgssize i = 0; i < count; ++i )
+    output[i] = table[ static_cast< qint64 >( data[i] ) - offset ];
+
+  // nodata pixels from a bitmap do not depend on their value
+  if ( input->hasNoData() && !hasNoDataValue )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      if ( input->isNoData( i ) )
+        output[i] = noDataColor;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+static bool renderQuantized( QgsRasterBlock *input, QRgb *output, QRgb noDataColor, double minimum, double maximum, int resolution,
+                             const QgsRasterColorLookupTable::ColorFunction &color )
+{
+  const qgssize count = static_cast< qgssize >( input->width() ) * input->height();
+  const T *data = reinterpret_cast< const T * >( input->bits() );
+  if ( count == 0 || !data )
+    return false;
+
+  const bool hasNoDataValue = input->hasNoDataValue();
+  const bool hasNoDataBitmap = input->hasNoData() && !hasNoDataValue;
+  const double noDataValue = input->noDataValue();
+  const double scale = resolution / ( maximum - minimum );
+
+  // entries are only shaded once a value of their interval is met
+  std::vector< QRgb > table( resolution );
+  std::vector< char > shaded( resolution, 0 );
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const double value = data[i];
+    if ( ( hasNoDataValue && QgsRasterBlock::isNoDataValue( value, noDataValue ) ) || ( hasNoDataBitmap && input->isNoData( i ) ) )
+    {
+      output[i] = noDataColor;
+      continue;
+    }
+
+    if ( !( value >= minimum && value <= maximum ) )
+    {
+      output[i] = color( value );
+      continue;
+    }
+
+    const int index = std::min( static_cast< int >( ( value - minimum ) * scale ), resolution - 1 );
+    if ( !shaded[index] )
+    {
+      table[index] = color( minimum + ( index + 0.5 ) / scale );
+      shaded[index] = 1;
+    }
+    output[i] = table[index];
+  }
+  return true;
+}
+
+bool QgsRasterColorLookupTable::renderIntegerBlock( QgsRasterBlock *input, QRgb *output, QRgb noDataColor, const ColorFunction &color )
+{
+  switch ( input->dataType() )
+  {
+    case Qgis::Byte:
+      return renderIntegers< quint8 >( input, output, noDataColor, color );
+    case Qgis::UInt16:
+      return renderIntegers< quint16 >( input, output, noDataColor, color );
+    case Qgis::Int16:
+      return renderIntegers< qint16 >( input, output, noDataColor, color );
+    case Qgis::UInt32:
+      return renderIntegers< quint32 >( input, output, noDataColor, color );
+    case Qgis::Int32:
+      return renderIntegers< qint32 >( input, output, noDataColor, color );
+    default:
+      return false;
+  }
+}
+
+bool QgsRasterColorLookupTable::renderQuantizedBlock( QgsRasterBlock *input, QRgb *output, QRgb noDataColor, double minimum, double maximum, int resolution, const ColorFunction &color )
+{
+  if ( resolution <= 0 || !std::isfinite( minimum ) || !std::isfinite( maximum ) || maximum <= minimum )
+    return false;
+
+  switch ( input->dataType() )
+  {
+    case Qgis::Float32:
+      return renderQuantized< float >( input, output, noDataColor, minimum, maximum, resolution, color );
+    case Qgis::Float64:
+      return renderQuantized< double >( input, output, noDataColor, minimum, maximum, resolution, color );
+    default:
+      return false;
+  }
+}
+
+///@endcond
@@ -0,0 +1,85 @@
+/***************************************************************************
+                         qgsrastercolorlookuptable_p.h
+                         -----------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRASTERCOLORLOOKUPTABLE_P_H
+#define QGSRASTERCOLORLOOKUPTABLE_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+#include <QColor>
+#include <functional>
+
+class QgsRasterBlock;
+
+/**
+ * \ingroup core
+ * \brief Renders raster blocks to colors through lookup tables of the colors of their values.
+ *
+ * This is used by the renderers whose pixel colors only depend on the pixel values, so that
+ * each distinct value is only shaded once per block, and pixels are then colored in a tight
+ * loop over the typed block data.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsRasterColorLookupTable
+{
+  public:
+
+    //! Function returning the color of a value
+    typedef std::function< QRgb( double value ) > ColorFunction;
+
+    /**
+     * Renders the values of an \a input block of an integer data type to \a output, using a table
+     * of the colors of all the values between the minimum and maximum values of the block.
+     *
+     * Nodata pixels are set to \a noDataColor, the colors of the other values are given by \a color.
+     *
+     * Returns FALSE without rendering anything if the block is not of an integer data type, or if its
+     * values span more values than it has pixels, in which case coloring each pixel is cheaper.
+     */
+    static bool renderIntegerBlock( QgsRasterBlock *input, QRgb *output, QRgb noDataColor, const ColorFunction &color );
+
+    /**
+     * Renders the values of an \a input block of a floating point data type to \a output, using a table
+     * of \a resolution colors for equal intervals between \a minimum and \a maximum.
+     *
+     * The values of each interval get the color of the middle of the interval. Values out of the range
+     * get their exact color. Nodata pixels are set to \a noDataColor, the colors of the values are given
+     * by \a color.
+     *
+     * Returns FALSE without rendering anything if the block is not of a floating point data type or if
+     * the range or resolution is not valid.
+     */
+    static bool renderQuantizedBlock( QgsRasterBlock *input, QRgb *output, QRgb noDataColor,
+                                      double minimum, double maximum, int resolution, const ColorFunction &color );
+};
+
+/// @endcond
+
+#endif // QGSRASTERCOLORLOOKUPTABLE_P_H
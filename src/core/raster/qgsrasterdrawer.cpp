@@ -23,12 +23,22 @@
 #include "qgsrasterviewport.h"
 #include "qgsmaptopixel.h"
 #include "qgsrendercontext.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterresamplefilter.h"
+#include "qgshillshaderenderer.h"
 #include <QImage>
 #include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
 #ifndef QT_NO_PRINTER
 #include <QPrinter>
 #endif
 
+//! Minimum width and height of the tiles drawn concurrently
+static const int MINIMUM_TILE_SIZE = 256;
+
 QgsRasterDrawer::QgsRasterDrawer( QgsRasterIterator *iterator ): mIterator( iterator )
 {
 }
@@ -41,6 +51,11 @@ void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsM
     return;
   }
 
+  if ( drawTiles( p, viewPort, qgsMapToPixel, feedback ) )
+  {
+    return;
+  }
+
   // last pipe filter has only 1 band
   int bandNumber = 1;
   mIterator->startRasterRead( bandNumber, viewPort->mWidth, viewPort->mHeight, viewPort->mDrawnExtent, feedback );
@@ -66,52 +81,241 @@ void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsM
       continue;
     }
 
-    QImage img = block->image();
+    drawBlock( p, viewPort, qgsMapToPixel, feedback, block.get(), topLeftCol, topLeftRow );
 
-#ifndef QT_NO_PRINTER
-    // Because of bug in Acrobat Reader we must use "white" transparent color instead
-    // of "black" for PDF. See #9101.
-    QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
-    if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+    // OK this does not matter much anyway as the tile size quite big so most of the time
+    // there would be just one tile for the whole display area, but it won't hurt...
+    if ( feedback && feedback->isCanceled() )
+      break;
+  }
+}
+
+//! Clones the chain of interfaces ending with \a last into \a clones, and returns the clone of \a last
+static QgsRasterInterface *cloneInterfaces( const QgsRasterInterface *last, std::vector< std::unique_ptr< QgsRasterInterface > > &clones )
+{
+  QVector< const QgsRasterInterface * > interfaces;
+  for ( const QgsRasterInterface *interface = last; interface; interface = interface->input() )
+    interfaces.prepend( interface );
+
+  QgsRasterInterface *input = nullptr;
+  for ( const QgsRasterInterface *interface : qgis::as_const( interfaces ) )
+  {
+    std::unique_ptr< QgsRasterInterface > clone( interface->clone() );
+    if ( !clone )
+      return nullptr;
+
+    clone->setOn( interface->on() );
+    if ( input && !clone->setInput( input ) )
+      return nullptr;
+
+    input = clone.get();
+    clones.emplace_back( std::move( clone ) );
+  }
+  return input;
+}
+
+/**
+ * Returns the number of output pixels around each pixel which the interfaces ending with \a last read
+ * to compute it, or -1 if it is not known.
+ */
+static int neighborhoodRadius( const QgsRasterInterface *last )
+{
+  int radius = 0;
+  for ( const QgsRasterInterface *interface = last; interface; interface = interface->input() )
+  {
+    if ( dynamic_cast< const QgsHillshadeRenderer * >( interface ) )
+    {
+      // slope and aspect are computed from the 3x3 neighborhood of the pixels
+      radius = std::max( radius, 1 );
+    }
+    else if ( const QgsRasterResampleFilter *resampleFilter = dynamic_cast< const QgsRasterResampleFilter * >( interface ) )
     {
-      QgsDebugMsgLevel( QStringLiteral( "PdfFormat" ), 4 );
+      // resamplers interpolate source pixels, which span several output pixels when zooming in
+      if ( resampleFilter->zoomedInResampler() || resampleFilter->zoomedOutResampler() )
+        return -1;
+    }
+  }
+  return radius;
+}
+
+bool QgsRasterDrawer::drawTiles( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback )
+{
+  // previews need blocks to be drawn as soon as they are read
+  if ( feedback && feedback->renderPartialOutput() )
+    return false;
+
+  const QgsRasterInterface *input = mIterator->input();
+  const QgsRasterDataProvider *provider = nullptr;
+  for ( const QgsRasterInterface *interface = input; interface && !provider; interface = interface->input() )
+    provider = dynamic_cast< const QgsRasterDataProvider * >( interface );
+  if ( !provider || !( provider->providerCapabilities() & QgsRasterDataProvider::ConcurrentReads ) )
+    return false;
+
+  // tiles are read with the neighborhood of their edges shared with other tiles, and cropped,
+  // so that they are drawn exactly as a single block
+  const int radius = neighborhoodRadius( input );
+  if ( radius < 0 )
+    return false;
+
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  const double pixelCount = static_cast< double >( viewPort->mWidth ) * viewPort->mHeight;
+  if ( threadCount < 2 || pixelCount < 2.0 * MINIMUM_TILE_SIZE * MINIMUM_TILE_SIZE )
+    return false;
+
+  // about two tiles per thread, so that threads are still busy when tiles take different times
+  const int tileSize = std::max( MINIMUM_TILE_SIZE, static_cast< int >( std::ceil( std::sqrt( pixelCount / ( 2.0 * threadCount ) ) ) ) );
+
+  struct Tile
+  {
+    int columns = 0;
+    int rows = 0;
+    int topLeftColumn = 0;
+    int topLeftRow = 0;
+    QgsRectangle extent;
+    //! Part of the block within the tile, without the neighborhood read around it
+    QRect rect;
+    std::unique_ptr< QgsRasterBlock > block;
+    std::unique_ptr< QgsRasterBlockFeedback > feedback;
+  };
+  std::vector< Tile > tiles;
+
+  // tiles are the parts the iterator reads, only smaller
+  const int bandNumber = 1;
+  const int maximumTileWidth = mIterator->maximumTileWidth();
+  const int maximumTileHeight = mIterator->maximumTileHeight();
+  mIterator->setMaximumTileWidth( std::min( tileSize, maximumTileWidth ) );
+  mIterator->setMaximumTileHeight( std::min( tileSize, maximumTileHeight ) );
+  mIterator->startRasterRead( bandNumber, viewPort->mWidth, viewPort->mHeight, viewPort->mDrawnExtent, feedback );
+  Tile tile;
+  while ( mIterator->next( bandNumber, tile.columns, tile.rows, tile.topLeftColumn, tile.topLeftRow, tile.extent ) )
+    tiles.emplace_back( std::move( tile ) );
+  mIterator->stopRasterRead( bandNumber );
+  mIterator->setMaximumTileWidth( maximumTileWidth );
+  mIterator->setMaximumTileHeight( maximumTileHeight );
+
+  if ( tiles.size() < 2 )
+    return false;
+
+  for ( Tile &extendedTile : tiles )
+  {
+    const int left = extendedTile.topLeftColumn > 0 ? radius : 0;
+    const int top = extendedTile.topLeftRow > 0 ? radius : 0;
+    const int right = extendedTile.topLeftColumn + extendedTile.columns < viewPort->mWidth ? radius : 0;
+    const int bottom = extendedTile.topLeftRow + extendedTile.rows < viewPort->mHeight ? radius : 0;
+    const double xRes = extendedTile.extent.width() / extendedTile.columns;
+    const double yRes = extendedTile.extent.height() / extendedTile.rows;
+    extendedTile.rect = QRect( left, top, extendedTile.columns, extendedTile.rows );
+    extendedTile.extent = QgsRectangle( extendedTile.extent.xMinimum() - left * xRes, extendedTile.extent.yMinimum() - bottom * yRes,
+                             extendedTile.extent.xMaximum() + right * xRes, extendedTile.extent.yMaximum() + top * yRes );
+    extendedTile.columns += left + right;
+    extendedTile.rows += top + bottom;
+  }
+
+  // interfaces are not thread safe: each concurrent tile reads from its own clones
+  const int concurrentTiles = std::min( static_cast< int >( tiles.size() ), threadCount );
+  std::vector< std::vector< std::unique_ptr< QgsRasterInterface > > > clones( concurrentTiles );
+  QVector< QgsRasterInterface * > inputs;
+  for ( std::vector< std::unique_ptr< QgsRasterInterface > > &tileClones : clones )
+  {
+    QgsRasterInterface *tileInput = cloneInterfaces( input, tileClones );
+    if ( !tileInput )
+      return false;
+    inputs.append( tileInput );
+  }
 
-      img = img.convertToFormat( QImage::Format_ARGB32 );
-      QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
-      QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
-      for ( int x = 0; x < img.width(); x++ )
+  // tiles are read in waves of concurrent tiles, then drawn in order
+  for ( std::size_t first = 0; first < tiles.size(); first += concurrentTiles )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    const std::size_t last = std::min( tiles.size(), first + concurrentTiles );
+    QVector< int > waveSlots;
+    for ( std::size_t i = first; i < last; ++i )
+    {
+      Tile &waveTile = tiles[i];
+      waveTile.feedback.reset( new QgsRasterBlockFeedback() );
+      if ( feedback )
       {
-        for ( int y = 0; y < img.height(); y++ )
-        {
-          if ( img.pixel( x, y ) == transparentBlack )
-          {
-            img.setPixel( x, y, transparentWhite );
-          }
-        }
+        waveTile.feedback->setPreviewOnly( feedback->isPreviewOnly() );
+        QObject::connect( feedback, &QgsFeedback::canceled, waveTile.feedback.get(), &QgsFeedback::cancel, Qt::DirectConnection );
       }
+      waveSlots.append( static_cast< int >( i - first ) );
     }
-#endif
 
-    if ( feedback && feedback->renderPartialOutput() )
+    QtConcurrent::blockingMap( waveSlots, [&]( int slot )
+    {
+      Tile &waveTile = tiles[first + slot];
+      waveTile.block.reset( inputs.at( slot )->block( bandNumber, waveTile.extent, waveTile.columns, waveTile.rows, waveTile.feedback.get() ) );
+    } );
+
+    for ( std::size_t i = first; i < last; ++i )
     {
-      // there could have been partial preview written before
-      // so overwrite anything with the resulting image.
-      // (we are guaranteed to have a temporary image for this layer, see QgsMapRendererJob::needTemporaryImage)
-      p->setCompositionMode( QPainter::CompositionMode_Source );
+      Tile &waveTile = tiles[i];
+      if ( feedback )
+      {
+        const QStringList errors = waveTile.feedback->errors();
+        for ( const QString &error : errors )
+          feedback->appendError( error );
+      }
+
+      if ( waveTile.block )
+        drawBlock( p, viewPort, qgsMapToPixel, feedback, waveTile.block.get(), waveTile.topLeftColumn, waveTile.topLeftRow, waveTile.rect );
+      else
+        QgsDebugMsg( QStringLiteral( "Cannot get block" ) );
+
+      waveTile.block.reset();
+      waveTile.feedback.reset();
     }
+  }
+  return true;
+}
+
+void QgsRasterDrawer::drawBlock( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback,
+                                 const QgsRasterBlock *block, int topLeftCol, int topLeftRow, const QRect &blockRect ) const
+{
+  QImage img = block->image();
+  if ( !blockRect.isNull() )
+    img = img.copy( blockRect );
 
-    drawImage( p, viewPort, img, topLeftCol, topLeftRow, qgsMapToPixel );
+#ifndef QT_NO_PRINTER
+  // Because of bug in Acrobat Reader we must use "white" transparent color instead
+  // of "black" for PDF. See #9101.
+  QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
+  if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "PdfFormat" ), 4 );
 
-    if ( feedback && feedback->renderPartialOutput() )
+    img = img.convertToFormat( QImage::Format_ARGB32 );
+    QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
+    QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
+    for ( int x = 0; x < img.width(); x++ )
     {
-      // go back to the default composition mode
-      p->setCompositionMode( QPainter::CompositionMode_SourceOver );
+      for ( int y = 0; y < img.height(); y++ )
+      {
+        if ( img.pixel( x, y ) == transparentBlack )
+        {
+          img.setPixel( x, y, transparentWhite );
+        }
+      }
     }
+  }
+#endif
 
-    // OK this does not matter much anyway as the tile size quite big so most of the time
-    // there would be just one tile for the whole display area, but it won't hurt...
-    if ( feedback && feedback->isCanceled() )
-      break;
+  if ( feedback && feedback->renderPartialOutput() )
+  {
+    // there could have been partial preview written before
+    // so overwrite anything with the resulting image.
+    // (we are guaranteed to have a temporary image for this layer, see QgsMapRendererJob::needTemporaryImage)
+    p->setCompositionMode( QPainter::CompositionMode_Source );
+  }
+
+  drawImage( p, viewPort, img, topLeftCol, topLeftRow, qgsMapToPixel );
+
+  if ( feedback && feedback->renderPartialOutput() )
+  {
+    // go back to the default composition mode
+    p->setCompositionMode( QPainter::CompositionMode_SourceOver );
   }
 }
 
@@ -21,14 +21,16 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include <QMap>
+#include <QRect>
 
 class QPainter;
 class QImage;
 class QgsMapToPixel;
 class QgsRenderContext;
-struct QgsRasterViewPort;
+class QgsRasterBlock;
 class QgsRasterBlockFeedback;
 class QgsRasterIterator;
+struct QgsRasterViewPort;
 
 /**
  * \ingroup core
@@ -64,6 +66,20 @@ class CORE_EXPORT QgsRasterDrawer
 
   private:
     QgsRasterIterator *mIterator = nullptr;
+
+    /**
+     * Draws the parts of the viewport as tiles read concurrently, through clones of the input interfaces.
+     * Returns FALSE without drawing anything if the input cannot be read concurrently or if the viewport
+     * is too small to be split.
+     */
+    bool drawTiles( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback );
+
+    /**
+     * Draws the image of a \a block at \a topLeftCol and \a topLeftRow in the viewport, or only
+     * its \a blockRect part if not null.
+     */
+    void drawBlock( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback,
+                    const QgsRasterBlock *block, int topLeftCol, int topLeftRow, const QRect &blockRect = QRect() ) const;
 };
 
 #endif // QGSRASTERDRAWER_H
@@ -30,6 +30,7 @@ QgsRasterProjector::QgsRasterProjector()
 }
 Q_NOWARN_DEPRECATED_POP
 
+QgsRasterProjector::~QgsRasterProjector() = default;
 
 QgsRasterProjector *QgsRasterProjector::clone() const
 {
@@ -72,6 +73,7 @@ void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS,
 {
   mSrcCRS = srcCRS;
   mDestCRS = destCRS;
+  mProjectorData.reset();
   Q_NOWARN_DEPRECATED_PUSH
   mSrcDatumTransform = srcDatumTransform;
   mDestDatumTransform = destDatumTransform;
@@ -83,6 +85,7 @@ void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS, con
   mSrcCRS = srcCRS;
   mDestCRS = destCRS;
   mTransformContext = transformContext;
+  mProjectorData.reset();
   Q_NOWARN_DEPRECATED_PUSH
   mSrcDatumTransform = -1;
   mDestDatumTransform = -1;
@@ -219,10 +222,12 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
 #endif
 
   // init helper points
-  pHelperTop = new QgsPointXY[mDestCols];
-  pHelperBottom = new QgsPointXY[mDestCols];
-  calcHelper( 0, pHelperTop );
-  calcHelper( 1, pHelperBottom );
+  mHelperTopX.resize( mDestCols );
+  mHelperTopY.resize( mDestCols );
+  mHelperBottomX.resize( mDestCols );
+  mHelperBottomY.resize( mDestCols );
+  calcHelper( 0, mHelperTopX.data(), mHelperTopY.data() );
+  calcHelper( 1, mHelperBottomX.data(), mHelperBottomY.data() );
   mHelperTopRow = 0;
 
   // Calculate source dimensions
@@ -232,11 +237,7 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   mSrcXRes = mSrcExtent.width() / mSrcCols;
 }
 
-ProjectorData::~ProjectorData()
-{
-  delete[] pHelperTop;
-  delete[] pHelperBottom;
-}
+ProjectorData::~ProjectorData() = default;
 
 
 void ProjectorData::calcSrcExtent()
@@ -417,7 +418,7 @@ inline int ProjectorData::matrixCol( int destCol )
   return static_cast< int >( std::floor( ( destCol + 0.5 ) / mDestColsPerMatrixCol ) );
 }
 
-void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
+void ProjectorData::calcHelper( int matrixRow, double *x, double *y )
 {
   // TODO?: should we also precalc dest cell center coordinates for x and y?
   for ( int myDestCol = 0; myDestCol < mDestCols; myDestCol++ )
@@ -435,148 +436,179 @@ void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
 
     QgsPointXY &mySrcPoint0 = mCPMatrix[matrixRow][myMatrixCol];
     QgsPointXY &mySrcPoint1 = mCPMatrix[matrixRow][myMatrixCol + 1];
-    double s = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
-    double t = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
-
-    points[myDestCol].setX( s );
-    points[myDestCol].setY( t );
+    x[myDestCol] = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
+    y[myDestCol] = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
   }
 }
 
 void ProjectorData::nextHelper()
 {
-  // We just switch pHelperTop and pHelperBottom, memory is not lost
-  QgsPointXY *tmp = nullptr;
-  tmp = pHelperTop;
-  pHelperTop = pHelperBottom;
-  pHelperBottom = tmp;
-  calcHelper( mHelperTopRow + 2, pHelperBottom );
+  // We just switch top and bottom helpers, memory is not lost
+  mHelperTopX.swap( mHelperBottomX );
+  mHelperTopY.swap( mHelperBottomY );
+  calcHelper( mHelperTopRow + 2, mHelperBottomX.data(), mHelperBottomY.data() );
   mHelperTopRow++;
 }
 
-bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+void ProjectorData::srcRowCols( int destRow, int *srcRows, int *srcCols )
 {
   if ( mApproximate )
   {
-    return approximateSrcRowCol( destRow, destCol, srcRow, srcCol );
+    approximateSrcRowCols( destRow, srcRows, srcCols );
   }
   else
   {
-    return preciseSrcRowCol( destRow, destCol, srcRow, srcCol );
+    preciseSrcRowCols( destRow, srcRows, srcCols );
   }
 }
 
-bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+/**
+ * Sets the source row and column indexes of the source points \a x and \a y of a destination row.
+ * Points outside of the raster \a extent or of the source grid get a column index of -1.
+ *
+ * Indexes are selected rather than branched on, so that the loop can be vectorized.
+ */
+static void srcRowColsFromPoints( const double *x, const double *y, int count, const QgsRectangle &extent,
+                                  const QgsRectangle &srcExtent, double srcXRes, double srcYRes, int srcRows, int srcCols,
+                                  int *rows, int *cols )
 {
-#if 0 // too slow, even if we only run it on debug builds!
-  QgsDebugMsgLevel( QStringLiteral( "theDestRow = %1" ).arg( destRow ), 5 );
-  QgsDebugMsgLevel( QStringLiteral( "theDestRow = %1 mDestExtent.yMaximum() = %2 mDestYRes = %3" ).arg( destRow ).arg( mDestExtent.yMaximum() ).arg( mDestYRes ), 5 );
-#endif
-
-  // Get coordinate of center of destination cell
-  double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
-  double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-  double z = 0;
+  const double xMin = extent.xMinimum();
+  const double xMax = extent.xMaximum();
+  const double yMin = extent.yMinimum();
+  const double yMax = extent.yMaximum();
+  const double srcXMin = srcExtent.xMinimum();
+  const double srcYMax = srcExtent.yMaximum();
+  for ( int i = 0; i < count; ++i )
+  {
+    const double row = std::floor( ( srcYMax - y[i] ) / srcYRes );
+    const double col = std::floor( ( x[i] - srcXMin ) / srcXRes );
+
+    // With epsg 32661 (Polar Stereographic) it was happening that col == srcCols
+    // For now silently correct limits to avoid crashes
+    const bool inside = xMin <= x[i] && x[i] <= xMax && yMin <= y[i] && y[i] <= yMax
+                        && row >= 0 && row < srcRows && col >= 0 && col < srcCols;
+    rows[i] = inside ? static_cast< int >( row ) : 0;
+    cols[i] = inside ? static_cast< int >( col ) : -1;
+  }
+}
 
-#if 0
-  QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
+void ProjectorData::preciseSrcRowCols( int destRow, int *srcRows, int *srcCols )
+{
+  // Get coordinates of centers of destination cells
+  std::vector< double > x( mDestCols );
+  std::vector< double > y( mDestCols, mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes );
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    x[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
 
   if ( mInverseCt.isValid() )
   {
-    try
+    std::unique_ptr< bool[] > legal( new bool[mDestCols] );
+    transformPoints( mInverseCt, mDestCols, x.data(), y.data(), legal.get() );
+    for ( int destCol = 0; destCol < mDestCols; ++destCol )
     {
-      mInverseCt.transformInPlace( x, y, z );
-    }
-    catch ( QgsCsException & )
-    {
-      return false;
+      // points which could not be transformed are outside
+      if ( !legal[destCol] )
+        x[destCol] = std::numeric_limits< double >::quiet_NaN();
     }
   }
 
-#if 0
-  QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( !mExtent.contains( QgsPointXY( x, y ) ) )
-  {
-    return false;
-  }
-  // Get source row col
-  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - y ) / mSrcYRes ) );
-  *srcCol = static_cast< int >( std::floor( ( x - mSrcExtent.xMinimum() ) / mSrcXRes ) );
-#if 0
-  QgsDebugMsgLevel( QStringLiteral( "mSrcExtent.yMinimum() = %1 mSrcExtent.yMaximum() = %2 mSrcYRes = %3" ).arg( mSrcExtent.yMinimum() ).arg( mSrcExtent.yMaximum() ).arg( mSrcYRes ), 5 );
-  QgsDebugMsgLevel( QStringLiteral( "theSrcRow = %1 srcCol = %2" ).arg( *srcRow ).arg( *srcCol ), 5 );
-#endif
-
-  // With epsg 32661 (Polar Stereographic) it was happening that *srcCol == mSrcCols
-  // For now silently correct limits to avoid crashes
-  // TODO: review
-  // should not happen
-  if ( *srcRow >= mSrcRows ) return false;
-  if ( *srcRow < 0 ) return false;
-  if ( *srcCol >= mSrcCols ) return false;
-  if ( *srcCol < 0 ) return false;
-
-  return true;
+  srcRowColsFromPoints( x.data(), y.data(), mDestCols, mExtent, mSrcExtent, mSrcXRes, mSrcYRes, mSrcRows, mSrcCols, srcRows, srcCols );
 }
 
-bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+void ProjectorData::approximateSrcRowCols( int destRow, int *srcRows, int *srcCols )
 {
   int myMatrixRow = matrixRow( destRow );
-  int myMatrixCol = matrixCol( destCol );
-
-  if ( myMatrixRow > mHelperTopRow )
+  if ( myMatrixRow < mHelperTopRow )
+  {
+    // rows are read again from the top, e.g. for another band
+    calcHelper( myMatrixRow, mHelperTopX.data(), mHelperTopY.data() );
+    calcHelper( myMatrixRow + 1, mHelperBottomX.data(), mHelperBottomY.data() );
+    mHelperTopRow = myMatrixRow;
+  }
+  while ( myMatrixRow > mHelperTopRow )
   {
-    // TODO: make it more robust (for random, not sequential reading)
     nextHelper();
   }
 
   double myDestY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
 
   // See the schema in javax.media.jai.WarpGrid doc (but up side down)
-  // TODO: use some kind of cache of values which can be reused
-  double myDestXMin, myDestYMin, myDestXMax, myDestYMax;
-
-  destPointOnCPMatrix( myMatrixRow + 1, myMatrixCol, &myDestXMin, &myDestYMin );
-  destPointOnCPMatrix( myMatrixRow, myMatrixCol + 1, &myDestXMax, &myDestYMax );
+  double myDestX, myDestYMin, myDestYMax;
+  destPointOnCPMatrix( myMatrixRow + 1, 0, &myDestX, &myDestYMin );
+  destPointOnCPMatrix( myMatrixRow, 0, &myDestX, &myDestYMax );
 
-  double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
+  const double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
 
-  QgsPointXY &myTop = pHelperTop[destCol];
-  QgsPointXY &myBot = pHelperBottom[destCol];
+  // interpolate the whole row between the helpers, source points are then converted to indexes
+  std::vector< double > x( mDestCols );
+  std::vector< double > y( mDestCols );
+  const double *tx = mHelperTopX.data();
+  const double *ty = mHelperTopY.data();
+  const double *bx = mHelperBottomX.data();
+  const double *by = mHelperBottomY.data();
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    x[destCol] = bx[destCol] + ( tx[destCol] - bx[destCol] ) * yfrac;
+    y[destCol] = by[destCol] + ( ty[destCol] - by[destCol] ) * yfrac;
+  }
 
-  // Warning: this is very SLOW compared to the following code!:
-  //double mySrcX = myBot.x() + (myTop.x() - myBot.x()) * yfrac;
-  //double mySrcY = myBot.y() + (myTop.y() - myBot.y()) * yfrac;
+  srcRowColsFromPoints( x.data(), y.data(), mDestCols, mExtent, mSrcExtent, mSrcXRes, mSrcYRes, mSrcRows, mSrcCols, srcRows, srcCols );
+}
 
-  double tx = myTop.x();
-  double ty = myTop.y();
-  double bx = myBot.x();
-  double by = myBot.y();
-  double mySrcX = bx + ( tx - bx ) * yfrac;
-  double mySrcY = by + ( ty - by ) * yfrac;
+void ProjectorData::transformPoints( const QgsCoordinateTransform &ct, int count, double *x, double *y, bool *legal,
+                                     QgsCoordinateTransform::TransformDirection direction )
+{
+  if ( count <= 0 )
+    return;
 
-  if ( !mExtent.contains( QgsPointXY( mySrcX, mySrcY ) ) )
+  if ( !ct.isValid() )
   {
-    return false;
+    std::fill( legal, legal + count, false );
+    return;
   }
 
-  // TODO: check again cell selection (coor is in the middle)
-
-  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - mySrcY ) / mSrcYRes ) );
-  *srcCol = static_cast< int >( std::floor( ( mySrcX - mSrcExtent.xMinimum() ) / mSrcXRes ) );
+  // All points are transformed at once with PROJ. If some of them fail, or need a fallback
+  // operation, which the transform then uses for all points, they are transformed again
+  // one by one, so that the results are the same as transforming each point.
+  const std::vector< double > sourceX( x, x + count );
+  const std::vector< double > sourceY( y, y + count );
+  std::vector< double > z( count, 0.0 );
+  bool transformed = false;
+  try
+  {
+    ct.transformCoords( count, x, y, z.data(), direction );
+    transformed = !ct.fallbackOperationOccurred();
+    for ( int i = 0; i < count && transformed; ++i )
+      transformed = std::isfinite( x[i] ) && std::isfinite( y[i] );
+  }
+  catch ( QgsCsException & )
+  {
+    transformed = false;
+  }
 
-  // For now silently correct limits to avoid crashes
-  // TODO: review
-  // should not happen
-  if ( *srcRow >= mSrcRows ) return false;
-  if ( *srcRow < 0 ) return false;
-  if ( *srcCol >= mSrcCols ) return false;
-  if ( *srcCol < 0 ) return false;
+  if ( transformed )
+  {
+    std::fill( legal, legal + count, true );
+    return;
+  }
 
-  return true;
+  for ( int i = 0; i < count; ++i )
+  {
+    try
+    {
+      const QgsPointXY point = ct.transform( QgsPointXY( sourceX[i], sourceY[i] ), direction );
+      x[i] = point.x();
+      y[i] = point.y();
+      legal[i] = true;
+    }
+    catch ( QgsCsException & )
+    {
+      // Caught an error in transform
+      x[i] = sourceX[i];
+      y[i] = sourceY[i];
+      legal[i] = false;
+    }
+  }
 }
 
 void ProjectorData::insertRows( const QgsCoordinateTransform &ct )
@@ -621,37 +653,22 @@ void ProjectorData::insertCols( const QgsCoordinateTransform &ct )
 
 }
 
-void ProjectorData::calcCP( int row, int col, const QgsCoordinateTransform &ct )
-{
-  double myDestX, myDestY;
-  destPointOnCPMatrix( row, col, &myDestX, &myDestY );
-  QgsPointXY myDestPoint( myDestX, myDestY );
-  try
-  {
-    if ( ct.isValid() )
-    {
-      mCPMatrix[row][col] = ct.transform( myDestPoint );
-      mCPLegalMatrix[row][col] = true;
-    }
-    else
-    {
-      mCPLegalMatrix[row][col] = false;
-    }
-  }
-  catch ( QgsCsException &e )
-  {
-    Q_UNUSED( e )
-    // Caught an error in transform
-    mCPLegalMatrix[row][col] = false;
-  }
-}
-
 bool ProjectorData::calcRow( int row, const QgsCoordinateTransform &ct )
 {
   QgsDebugMsgLevel( QStringLiteral( "theRow = %1" ).arg( row ), 3 );
+  std::vector< double > x( mCPCols );
+  std::vector< double > y( mCPCols );
+  std::unique_ptr< bool[] > legal( new bool[mCPCols] );
   for ( int i = 0; i < mCPCols; i++ )
   {
-    calcCP( row, i, ct );
+    destPointOnCPMatrix( row, i, &x[i], &y[i] );
+  }
+  transformPoints( ct, mCPCols, x.data(), y.data(), legal.get() );
+  for ( int i = 0; i < mCPCols; i++ )
+  {
+    mCPLegalMatrix[row][i] = legal[i];
+    if ( legal[i] )
+      mCPMatrix[row][i] = QgsPointXY( x[i], y[i] );
   }
 
   return true;
@@ -660,9 +677,19 @@ bool ProjectorData::calcRow( int row, const QgsCoordinateTransform &ct )
 bool ProjectorData::calcCol( int col, const QgsCoordinateTransform &ct )
 {
   QgsDebugMsgLevel( QStringLiteral( "theCol = %1" ).arg( col ), 3 );
+  std::vector< double > x( mCPRows );
+  std::vector< double > y( mCPRows );
+  std::unique_ptr< bool[] > legal( new bool[mCPRows] );
   for ( int i = 0; i < mCPRows; i++ )
   {
-    calcCP( i, col, ct );
+    destPointOnCPMatrix( i, col, &x[i], &y[i] );
+  }
+  transformPoints( ct, mCPRows, x.data(), y.data(), legal.get() );
+  for ( int i = 0; i < mCPRows; i++ )
+  {
+    mCPLegalMatrix[i][col] = legal[i];
+    if ( legal[i] )
+      mCPMatrix[i][col] = QgsPointXY( x[i], y[i] );
   }
 
   return true;
@@ -675,37 +702,45 @@ bool ProjectorData::checkCols( const QgsCoordinateTransform &ct )
     return false;
   }
 
+  // approximations of the points between each pair of rows, checked all at once
+  std::vector< double > x;
+  std::vector< double > y;
+  x.reserve( static_cast< std::size_t >( mCPCols ) * ( mCPRows / 2 ) );
+  y.reserve( x.capacity() );
   for ( int c = 0; c < mCPCols; c++ )
   {
     for ( int r = 1; r < mCPRows - 1; r += 2 )
     {
-      double myDestX, myDestY;
-      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
-      QgsPointXY myDestPoint( myDestX, myDestY );
-
-      QgsPointXY mySrcPoint1 = mCPMatrix[r - 1][c];
-      QgsPointXY mySrcPoint2 = mCPMatrix[r][c];
-      QgsPointXY mySrcPoint3 = mCPMatrix[r + 1][c];
-
-      QgsPointXY mySrcApprox( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2, ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
       if ( !mCPLegalMatrix[r - 1][c] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r + 1][c] )
       {
         // There was an error earlier in transform, just abort
         return false;
       }
-      try
+      const QgsPointXY &mySrcPoint1 = mCPMatrix[r - 1][c];
+      const QgsPointXY &mySrcPoint3 = mCPMatrix[r + 1][c];
+      x.push_back( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2 );
+      y.push_back( ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
+    }
+  }
+
+  std::unique_ptr< bool[] > legal( new bool[x.size()] );
+  transformPoints( ct, static_cast< int >( x.size() ), x.data(), y.data(), legal.get(), QgsCoordinateTransform::ReverseTransform );
+
+  std::size_t i = 0;
+  for ( int c = 0; c < mCPCols; c++ )
+  {
+    for ( int r = 1; r < mCPRows - 1; r += 2, i++ )
+    {
+      if ( !legal[i] )
       {
-        QgsPointXY myDestApprox = ct.transform( mySrcApprox, QgsCoordinateTransform::ReverseTransform );
-        double mySqrDist = myDestApprox.sqrDist( myDestPoint );
-        if ( mySqrDist > mSqrTolerance )
-        {
-          return false;
-        }
+        // Caught an error in transform
+        return false;
       }
-      catch ( QgsCsException &e )
+      double myDestX, myDestY;
+      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
+      const double mySqrDist = QgsPointXY( x[i], y[i] ).sqrDist( myDestX, myDestY );
+      if ( mySqrDist > mSqrTolerance )
       {
-        Q_UNUSED( e )
-        // Caught an error in transform
         return false;
       }
     }
@@ -720,37 +755,45 @@ bool ProjectorData::checkRows( const QgsCoordinateTransform &ct )
     return false;
   }
 
+  // approximations of the points between each pair of columns, checked all at once
+  std::vector< double > x;
+  std::vector< double > y;
+  x.reserve( static_cast< std::size_t >( mCPRows ) * ( mCPCols / 2 ) );
+  y.reserve( x.capacity() );
   for ( int r = 0; r < mCPRows; r++ )
   {
     for ( int c = 1; c < mCPCols - 1; c += 2 )
     {
-      double myDestX, myDestY;
-      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
-
-      QgsPointXY myDestPoint( myDestX, myDestY );
-      QgsPointXY mySrcPoint1 = mCPMatrix[r][c - 1];
-      QgsPointXY mySrcPoint2 = mCPMatrix[r][c];
-      QgsPointXY mySrcPoint3 = mCPMatrix[r][c + 1];
-
-      QgsPointXY mySrcApprox( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2, ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
       if ( !mCPLegalMatrix[r][c - 1] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r][c + 1] )
       {
         // There was an error earlier in transform, just abort
         return false;
       }
-      try
+      const QgsPointXY &mySrcPoint1 = mCPMatrix[r][c - 1];
+      const QgsPointXY &mySrcPoint3 = mCPMatrix[r][c + 1];
+      x.push_back( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2 );
+      y.push_back( ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
+    }
+  }
+
+  std::unique_ptr< bool[] > legal( new bool[x.size()] );
+  transformPoints( ct, static_cast< int >( x.size() ), x.data(), y.data(), legal.get(), QgsCoordinateTransform::ReverseTransform );
+
+  std::size_t i = 0;
+  for ( int r = 0; r < mCPRows; r++ )
+  {
+    for ( int c = 1; c < mCPCols - 1; c += 2, i++ )
+    {
+      if ( !legal[i] )
       {
-        QgsPointXY myDestApprox = ct.transform( mySrcApprox, QgsCoordinateTransform::ReverseTransform );
-        double mySqrDist = myDestApprox.sqrDist( myDestPoint );
-        if ( mySqrDist > mSqrTolerance )
-        {
-          return false;
-        }
+        // Caught an error in transform
+        return false;
       }
-      catch ( QgsCsException &e )
+      double myDestX, myDestY;
+      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
+      const double mySqrDist = QgsPointXY( x[i], y[i] ).sqrDist( myDestX, myDestY );
+      if ( mySqrDist > mSqrTolerance )
       {
-        Q_UNUSED( e )
-        // Caught an error in transform
         return false;
       }
     }
@@ -797,10 +840,26 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
       QgsCoordinateTransform( mDestCRS, mSrcCRS, mDestDatumTransform, mSrcDatumTransform ) : QgsCoordinateTransform( mDestCRS, mSrcCRS, mTransformContext ) ;
   Q_NOWARN_DEPRECATED_POP
 
-  ProjectorData pd( extent, width, height, mInput, inverseCt, mPrecision, feedback );
+  // the grid is calculated once for all the bands of the same block
+  if ( !mProjectorData || mProjectorDataExtent != extent || mProjectorDataWidth != width || mProjectorDataHeight != height
+       || mProjectorDataPrecision != mPrecision || mProjectorDataInput != mInput )
+  {
+    mProjectorData.reset( new ProjectorData( extent, width, height, mInput, inverseCt, mPrecision, feedback ) );
+    mProjectorDataExtent = extent;
+    mProjectorDataWidth = width;
+    mProjectorDataHeight = height;
+    mProjectorDataPrecision = mPrecision;
+    mProjectorDataInput = mInput;
+  }
 
   if ( feedback && feedback->isCanceled() )
+  {
+    // the grid may be incomplete
+    mProjectorData.reset();
     return new QgsRasterBlock();
+  }
+
+  ProjectorData &pd = *mProjectorData;
 
   QgsDebugMsgLevel( QStringLiteral( "srcExtent:\n%1" ).arg( pd.srcExtent().toString() ), 4 );
   QgsDebugMsgLevel( QStringLiteral( "srcCols = %1 srcRows = %2" ).arg( pd.srcCols() ).arg( pd.srcRows() ), 4 );
@@ -849,15 +908,18 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
 
   outputBlock->setIsNoData();
 
-  int srcRow, srcCol;
+  std::vector< int > srcRows( width );
+  std::vector< int > srcCols( width );
   for ( int i = 0; i < height; ++i )
   {
     if ( feedback && feedback->isCanceled() )
       break;
+    pd.srcRowCols( i, srcRows.data(), srcCols.data() );
     for ( int j = 0; j < width; ++j )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
+      const int srcRow = srcRows[j];
+      const int srcCol = srcCols[j];
+      if ( srcCol < 0 ) continue; // we have everything set to no data
 
       qgssize srcIndex = static_cast< qgssize >( srcRow * pd.srcCols() + srcCol );
 
@@ -34,8 +34,13 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <memory>
+#include <vector>
 
 class QgsPointXY;
+#ifndef SIP_RUN
+class ProjectorData;
+#endif
 
 /**
  * \ingroup core
@@ -62,6 +67,7 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
     Q_ENUM( Precision )
 
     QgsRasterProjector();
+    ~QgsRasterProjector() override;
 
     QgsRasterProjector *clone() const override SIP_FACTORY;
 
@@ -124,6 +130,24 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
     QgsCoordinateTransformContext mTransformContext;
 
+    //! Reprojection grid of the last block, reused for the other bands of the same extent and size
+    std::unique_ptr< ProjectorData > mProjectorData;
+
+    //! Extent of the last block
+    QgsRectangle mProjectorDataExtent;
+
+    //! Width of the last block
+    int mProjectorDataWidth = 0;
+
+    //! Height of the last block
+    int mProjectorDataHeight = 0;
+
+    //! Precision of the reprojection grid of the last block
+    Precision mProjectorDataPrecision = Approximate;
+
+    //! Input of the last block
+    const QgsRasterInterface *mProjectorDataInput = nullptr;
+
 };
 
 
@@ -132,8 +156,8 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
 /**
  * Internal class for reprojection of rasters - either exact or approximate.
- * QgsRasterProjector creates it and then keeps calling srcRowCol() to get source pixel position
- * for every destination pixel position.
+ * QgsRasterProjector creates it and then keeps calling srcRowCols() to get source pixel positions
+ * for every destination row.
  */
 class ProjectorData
 {
@@ -146,11 +170,11 @@ class ProjectorData
     ProjectorData &operator=( const ProjectorData &other ) = delete;
 
     /**
-     * Returns the source row and column indexes for current source extent and resolution.
-     * If the source pixel is outside source extent srcRow and srcCol are left unchanged.
-     * \returns TRUE if inside source
+     * Calculates the source row and column indexes of the pixels of a destination row for current
+     * source extent and resolution. Pixels outside of the source get a column index of -1.
+     * Rows may be requested in any order, sequential rows are the fastest.
      */
-    bool srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    void srcRowCols( int destRow, int *srcRows, int *srcCols );
 
     QgsRectangle srcExtent() const { return mSrcExtent; }
     int srcRows() const { return mSrcRows; }
@@ -167,11 +191,18 @@ class ProjectorData
     //! Returns the matrix upper left col index for destination col.
     int matrixCol( int destCol );
 
-    //! Returns precise source row and column indexes for current source extent and resolution.
-    inline bool preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    //! Calculates precise source row and column indexes of a destination row for current source extent and resolution.
+    void preciseSrcRowCols( int destRow, int *srcRows, int *srcCols );
+
+    //! Calculates approximate source row and column indexes of a destination row for current source extent and resolution.
+    void approximateSrcRowCols( int destRow, int *srcRows, int *srcCols );
 
-    //! Returns approximate source row and column indexes for current source extent and resolution.
-    inline bool approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    /**
+     * Transforms \a count points in place with \a ct, all at once when possible, and sets in \a legal
+     * whether each point could be transformed.
+     */
+    static void transformPoints( const QgsCoordinateTransform &ct, int count, double *x, double *y, bool *legal,
+                                 QgsCoordinateTransform::TransformDirection direction = QgsCoordinateTransform::ForwardTransform );
 
     //! \brief insert rows to matrix
     void insertRows( const QgsCoordinateTransform &ct );
@@ -179,9 +210,6 @@ class ProjectorData
     //! \brief insert columns to matrix
     void insertCols( const QgsCoordinateTransform &ct );
 
-    //! Calculate single control point in current matrix
-    void calcCP( int row, int col, const QgsCoordinateTransform &ct );
-
     //! \brief calculate matrix row
     bool calcRow( int row, const QgsCoordinateTransform &ct );
 
@@ -207,7 +235,7 @@ class ProjectorData
     bool checkRows( const QgsCoordinateTransform &ct );
 
     //! Calculate array of src helper points
-    void calcHelper( int matrixRow, QgsPointXY *points );
+    void calcHelper( int matrixRow, double *x, double *y );
 
     //! Calc / switch helper
     void nextHelper();
@@ -270,13 +298,14 @@ class ProjectorData
     /* Same size as mCPMatrix */
     QList< QList<bool> > mCPLegalMatrix;
 
-    //! Array of source points for each destination column on top of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperTop = nullptr;
+    //! Coordinates of source points for each destination column on top of current CPMatrix grid row
+    /* Separate arrays of x and y, so that rows are interpolated with vector instructions */
+    std::vector< double > mHelperTopX;
+    std::vector< double > mHelperTopY;
 
-    //! Array of source points for each destination column on bottom of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperBottom = nullptr;
+    //! Coordinates of source points for each destination column on bottom of current CPMatrix grid row
+    std::vector< double > mHelperBottomX;
+    std::vector< double > mHelperBottomY;
 
     //! Current mHelperTop matrix row
     int mHelperTopRow;
@@ -18,6 +18,7 @@
 #include "qgssinglebandpseudocolorrenderer.h"
 #include "qgscolorramp.h"
 #include "qgscolorrampshader.h"
+#include "qgsrastercolorlookuptable_p.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
 #include "qgsrasterviewport.h"
@@ -77,6 +78,11 @@ void QgsSingleBandPseudoColorRenderer::setClassificationMax( double max )
   }
 }
 
+void QgsSingleBandPseudoColorRenderer::setLookupTableResolution( int resolution )
+{
+  mLookupTableResolution = std::max( 0, resolution );
+}
+
 QgsSingleBandPseudoColorRenderer *QgsSingleBandPseudoColorRenderer::clone() const
 {
   QgsRasterShader *shader = nullptr;
@@ -105,6 +111,7 @@ QgsSingleBandPseudoColorRenderer *QgsSingleBandPseudoColorRenderer::clone() cons
   }
   QgsSingleBandPseudoColorRenderer *renderer = new QgsSingleBandPseudoColorRenderer( nullptr, mBand, shader );
   renderer->copyCommonProperties( this );
+  renderer->setLookupTableResolution( mLookupTableResolution );
 
   return renderer;
 }
@@ -152,6 +159,7 @@ QgsRasterRenderer *QgsSingleBandPseudoColorRenderer::create( const QDomElement &
   // TODO: add _readXML in superclass?
   r->setClassificationMin( elem.attribute( QStringLiteral( "classificationMin" ), QStringLiteral( "NaN" ) ).toDouble() );
   r->setClassificationMax( elem.attribute( QStringLiteral( "classificationMax" ), QStringLiteral( "NaN" ) ).toDouble() );
+  r->setLookupTableResolution( elem.attribute( QStringLiteral( "lookupTableResolution" ), QStringLiteral( "0" ) ).toInt() );
 
   // Backward compatibility with serialization of QGIS 2.X era
   QString minMaxOrigin = elem.attribute( QStringLiteral( "classificationMinMaxOrigin" ) );
@@ -244,22 +252,13 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
   QRgb *outputBlockData = outputBlock->colorData();
   const QgsRasterShaderFunction *fcn = mShader->rasterShaderFunction();
 
-  qgssize count = ( qgssize )width * height;
-  bool isNoData = false;
-  for ( qgssize i = 0; i < count; i++ )
+  // color of a value, with the opacity of the alpha band for the pixel
+  const auto valueColor = [&]( double val, double alphaBandOpacity ) -> QRgb
   {
-    double val = inputBlock->valueAndNoData( i, isNoData );
-    if ( isNoData )
-    {
-      outputBlockData[i] = myDefaultColor;
-      continue;
-    }
-
     int red, green, blue, alpha;
     if ( !fcn->shade( val, &red, &green, &blue, &alpha ) )
     {
-      outputBlockData[i] = myDefaultColor;
-      continue;
+      return myDefaultColor;
     }
 
     if ( alpha < 255 )
@@ -272,23 +271,48 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
 
     if ( !hasTransparency )
     {
-      outputBlockData[i] = qRgba( red, green, blue, alpha );
+      return qRgba( red, green, blue, alpha );
     }
-    else
+
+    //opacity
+    double currentOpacity = mOpacity;
+    if ( mRasterTransparency )
     {
-      //opacity
-      double currentOpacity = mOpacity;
-      if ( mRasterTransparency )
-      {
-        currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
-      }
-      if ( mAlphaBand > 0 )
-      {
-        currentOpacity *= alphaBlock->value( i ) / 255.0;
-      }
+      currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
+    }
+    currentOpacity *= alphaBandOpacity;
+
+    return qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * alpha );
+  };
 
-      outputBlockData[i] = qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * alpha );
+  if ( mAlphaBand <= 0 )
+  {
+    // colors only depend on values: shade each distinct value once, rather than each pixel
+    const QgsRasterColorLookupTable::ColorFunction color = [&valueColor]( double val ) { return valueColor( val, 1.0 ); };
+    if ( QgsRasterColorLookupTable::renderIntegerBlock( inputBlock.get(), outputBlockData, myDefaultColor, color ) )
+    {
+      return outputBlock.release();
     }
+    if ( mLookupTableResolution > 0 &&
+         QgsRasterColorLookupTable::renderQuantizedBlock( inputBlock.get(), outputBlockData, myDefaultColor,
+             fcn->minimumValue(), fcn->maximumValue(), mLookupTableResolution, color ) )
+    {
+      return outputBlock.release();
+    }
+  }
+
+  qgssize count = ( qgssize )width * height;
+  bool isNoData = false;
+  for ( qgssize i = 0; i < count; i++ )
+  {
+    double val = inputBlock->valueAndNoData( i, isNoData );
+    if ( isNoData )
+    {
+      outputBlockData[i] = myDefaultColor;
+      continue;
+    }
+
+    outputBlockData[i] = valueColor( val, mAlphaBand > 0 ? alphaBlock->value( i ) / 255.0 : 1.0 );
   }
 
   return outputBlock.release();
@@ -310,6 +334,8 @@ void QgsSingleBandPseudoColorRenderer::writeXml( QDomDocument &doc, QDomElement
   }
   rasterRendererElem.setAttribute( QStringLiteral( "classificationMin" ), QgsRasterBlock::printValue( mClassificationMin ) );
   rasterRendererElem.setAttribute( QStringLiteral( "classificationMax" ), QgsRasterBlock::printValue( mClassificationMax ) );
+  if ( mLookupTableResolution > 0 )
+    rasterRendererElem.setAttribute( QStringLiteral( "lookupTableResolution" ), mLookupTableResolution );
 
   parentElem.appendChild( rasterRendererElem );
 }
@@ -101,6 +101,32 @@ class CORE_EXPORT QgsSingleBandPseudoColorRenderer: public QgsRasterRenderer
     void setClassificationMin( double min );
     void setClassificationMax( double max );
 
+    /**
+     * Returns the number of colors of the lookup table used to render rasters of a floating point
+     * data type, or 0 if each pixel is shaded exactly.
+     *
+     * \see setLookupTableResolution()
+     * \since QGIS 3.18
+     */
+    int lookupTableResolution() const { return mLookupTableResolution; }
+
+    /**
+     * Sets the number of colors of the lookup table used to render rasters of a floating point data type.
+     *
+     * When set, the range of the shader is divided into \a resolution equal intervals, whose values all get
+     * the color of the middle of the interval. Each interval is only shaded once per rendered block instead of
+     * shading every pixel, which is much faster for large rasters, at the cost of colors which may slightly
+     * differ from the exact colors. Values out of the range of the shader keep their exact color.
+     *
+     * Set to 0 (the default) to shade each pixel exactly.
+     *
+     * Rasters of integer data types are always rendered through a lookup table of their exact colors.
+     *
+     * \see lookupTableResolution()
+     * \since QGIS 3.18
+     */
+    void setLookupTableResolution( int resolution );
+
   private:
 #ifdef SIP_RUN
     QgsSingleBandPseudoColorRenderer( const QgsSingleBandPseudoColorRenderer & );
@@ -115,6 +141,8 @@ class CORE_EXPORT QgsSingleBandPseudoColorRenderer: public QgsRasterRenderer
     double mClassificationMin;
     double mClassificationMax;
 
+    int mLookupTableResolution = 0;
+
 };
 
 #endif // QGSSINGLEBANDPSEUDOCOLORRENDERER_H
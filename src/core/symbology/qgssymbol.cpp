@@ -52,6 +52,7 @@
 #include "qgsrenderedfeaturehandlerinterface.h"
 #include "qgslegendpatchshape.h"
 #include "qgsgeos.h"
+#include "qgsrenderobjectpool.h"
 
 QgsPropertiesDefinition QgsSymbol::sPropertyDefinitions;
 
@@ -104,6 +105,31 @@ QgsSymbol::QgsSymbol( SymbolType type, const QgsSymbolLayerList &layers )
 }
 Q_NOWARN_DEPRECATED_POP
 
+///@cond PRIVATE
+
+/**
+ * Returns the points of a \a curve, in a buffer from the object pool of the \a context if it has one.
+ */
+static QPolygonF curveToPolygon( QgsRenderContext &context, const QgsCurve &curve )
+{
+  QgsRenderObjectPool *pool = context.objectPool();
+  const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( &curve );
+  if ( !pool || !line )
+    return curve.asQPolygonF();
+
+  const int count = line->numPoints();
+  QPolygonF points = pool->takePolygon( count );
+  points.resize( count );
+  const double *x = line->xData();
+  const double *y = line->yData();
+  QPointF *dest = points.data();
+  for ( int i = 0; i < count; ++i )
+    *dest++ = QPointF( *x++, *y++ );
+  return points;
+}
+
+///@endcond
+
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const unsigned int nPoints = curve.numPoints();
@@ -123,7 +149,7 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   }
   else
   {
-    pts = curve.asQPolygonF();
+    pts = curveToPolygon( context, curve );
   }
 
   //transform the QPolygonF to screen coordinates
@@ -156,25 +182,24 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
     pts = QgsClipper::clippedLine( pts, clipRect );
   }
 
-  QPointF *ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
+  mtp.transformInPlace( pts );
 
   return pts;
 }
 
-QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve &curve, const bool clipToExtent, const bool isExteriorRing, const bool correctRingOrientation )
-{
-  const QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
-
-  QPolygonF poly = curve.asQPolygonF();
+///@cond PRIVATE
 
+/**
+ * Returns the points of a polygon ring \a curve, with corrected orientation and clipped
+ * close to the view extent if possible, still in layer coordinates.
+ */
+static QPolygonF polygonRingBeforeTransform( QgsRenderContext &context, const QgsCurve &curve, const bool clipToExtent, const bool isExteriorRing, const bool correctRingOrientation )
+{
   if ( curve.numPoints() < 1 )
     return QPolygonF();
 
+  QPolygonF poly = curveToPolygon( context, curve );
+
   if ( correctRingOrientation )
   {
     // ensure consistent polygon ring orientation
@@ -194,19 +219,70 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
     QgsClipper::trimPolygon( poly, clipRect );
   }
 
-  //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
+  return poly;
+}
+
+/**
+ * Transforms all \a rings to map coordinates with a single call to the coordinate
+ * transform of the \a context, instead of one call per ring.
+ */
+static void transformPolygonRings( const QgsRenderContext &context, QVector< QPolygonF > &rings )
+{
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  if ( !ct.isValid() || ct.isShortCircuited() )
+    return;
+
+  QgsRenderObjectPool *pool = context.objectPool();
+  QPolygonF points;
+  if ( rings.size() == 1 )
   {
-    try
-    {
-      ct.transformPolygon( poly );
-    }
-    catch ( QgsCsException & )
+    points.swap( rings[0] );
+  }
+  else
+  {
+    int pointCount = 0;
+    for ( const QPolygonF &ring : qgis::as_const( rings ) )
+      pointCount += ring.size();
+    if ( pool )
+      points = pool->takePolygon( pointCount );
+    else
+      points.reserve( pointCount );
+    for ( const QPolygonF &ring : qgis::as_const( rings ) )
+      points << ring;
+  }
+
+  try
+  {
+    ct.transformPolygon( points );
+  }
+  catch ( QgsCsException & )
+  {
+    // we don't abort the rendering here, instead we remove any invalid points and just plot those which ARE valid
+  }
+
+  if ( rings.size() == 1 )
+  {
+    points.swap( rings[0] );
+  }
+  else
+  {
+    const QPointF *src = points.constData();
+    for ( QPolygonF &ring : rings )
     {
-      // we don't abort the rendering here, instead we remove any invalid points and just plot those which ARE valid
+      std::copy( src, src + ring.size(), ring.begin() );
+      src += ring.size();
     }
+    if ( pool )
+      pool->releasePolygon( std::move( points ) );
   }
+}
 
+/**
+ * Converts a polygon ring \a poly transformed to map coordinates to device coordinates,
+ * after removing invalid points and clipping it if this was not possible before.
+ */
+static void polygonRingAfterTransform( QgsRenderContext &context, QPolygonF &poly, const bool clipToExtent )
+{
   // remove non-finite points, e.g. infinite or NaN points caused by reprojecting errors
   poly.erase( std::remove_if( poly.begin(), poly.end(),
                               []( const QPointF point )
@@ -224,31 +300,69 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
     QgsClipper::trimPolygon( poly, clipRect );
   }
 
-  QPointF *ptr = poly.data();
-  for ( int i = 0; i < poly.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
+  context.mapToPixel().transformInPlace( poly );
 
   if ( !poly.empty() && !poly.isClosed() )
     poly << poly.at( 0 );
+}
 
-  return poly;
+///@endcond
+
+QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve &curve, const bool clipToExtent, const bool isExteriorRing, const bool correctRingOrientation )
+{
+  QgsRenderObjectPool *pool = context.objectPool();
+  QVector< QPolygonF > rings = pool ? pool->takePolygonList( 1 ) : QVector< QPolygonF >();
+  rings << polygonRingBeforeTransform( context, curve, clipToExtent, isExteriorRing, correctRingOrientation );
+
+  QPolygonF ring;
+  if ( !rings.at( 0 ).isEmpty() )
+  {
+    transformPolygonRings( context, rings );
+    polygonRingAfterTransform( context, rings[0], clipToExtent );
+    ring.swap( rings[0] );
+  }
+
+  if ( pool )
+    pool->releasePolygonList( std::move( rings ) );
+  return ring;
 }
 
 void QgsSymbol::_getPolygon( QPolygonF &pts, QVector<QPolygonF> &holes, QgsRenderContext &context, const QgsPolygon &polygon, const bool clipToExtent, const bool correctRingOrientation )
 {
   holes.clear();
 
-  pts = _getPolygonRing( context, *polygon.exteriorRing(), clipToExtent, true, correctRingOrientation );
+  // the exterior ring comes first, then the interior rings
   const int ringCount = polygon.numInteriorRings();
-  holes.reserve( ringCount );
+  QgsRenderObjectPool *pool = context.objectPool();
+  QVector< QPolygonF > rings;
+  if ( pool )
+    rings = pool->takePolygonList( ringCount + 1 );
+  else
+    rings.reserve( ringCount + 1 );
+  rings << polygonRingBeforeTransform( context, *polygon.exteriorRing(), clipToExtent, true, correctRingOrientation );
   for ( int idx = 0; idx < ringCount; idx++ )
+    rings << polygonRingBeforeTransform( context, *( polygon.interiorRing( idx ) ), clipToExtent, false, correctRingOrientation );
+
+  // all the rings of the polygon are reprojected at once
+  transformPolygonRings( context, rings );
+
+  for ( QPolygonF &ring : rings )
+    polygonRingAfterTransform( context, ring, clipToExtent );
+
+  // hand the buffers over instead of sharing them, so that they can be given back to the pool
+  pts.swap( rings[0] );
+  holes.reserve( ringCount );
+  for ( int idx = 1; idx <= ringCount; idx++ )
   {
-    const QPolygonF hole = _getPolygonRing( context, *( polygon.interiorRing( idx ) ), clipToExtent, false, correctRingOrientation );
-    if ( !hole.isEmpty() )
-      holes.append( hole );
+    if ( !rings.at( idx ).isEmpty() )
+    {
+      holes.append( QPolygonF() );
+      holes.last().swap( rings[idx] );
+    }
   }
+
+  if ( pool )
+    pool->releasePolygonList( std::move( rings ) );
 }
 
 const QgsPropertiesDefinition &QgsSymbol::propertyDefinitions()
@@ -1357,6 +1471,18 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
       handler->handleRenderedFeature( feature, renderedBoundsGeom, featureContext );
   }
 
+  // give the painter coordinate buffers back for the next features
+  if ( QgsRenderObjectPool *pool = context.objectPool() )
+  {
+    for ( LineInfo &info : linesToRender )
+      pool->releasePolygon( std::move( info.renderLine ) );
+    for ( PolygonInfo &info : polygonsToRender )
+    {
+      pool->releasePolygon( std::move( info.renderExterior ) );
+      pool->releasePolygonList( std::move( info.renderRings ) );
+    }
+  }
+
   if ( drawVertexMarker )
   {
     if ( !markers.isEmpty() && !context.renderingStopped() )
@@ -0,0 +1,158 @@
+/***************************************************************************
+                         qgspipelinedfeatureiterator.cpp
+                         -------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspipelinedfeatureiterator_p.h"
+#include "qgsfeaturerequest.h"
+#include "qgsfeedback.h"
+
+///@cond PRIVATE
+
+QgsPipelinedFeatureFetchThread::QgsPipelinedFeatureFetchThread( QgsPipelinedFeatureIterator *iterator )
+  : mIterator( iterator )
+{
+}
+
+void QgsPipelinedFeatureFetchThread::run()
+{
+  mIterator->fetchFeatures();
+}
+
+
+QgsPipelinedFeatureIterator::QgsPipelinedFeatureIterator( QgsAbstractFeatureSource *source, const QgsFeatureRequest &request, QgsFeedback *interruptionChecker )
+// the base class gets an empty request: filtering, simplification and ordering
+// are all done by the iterator of the source, and must not be applied twice
+  : QgsAbstractFeatureIterator( QgsFeatureRequest() )
+  , mSource( source )
+  , mSourceRequest( request )
+  , mInterruptionChecker( interruptionChecker )
+{
+  mThread = qgis::make_unique< QgsPipelinedFeatureFetchThread >( this );
+  mThread->start();
+}
+
+QgsPipelinedFeatureIterator::~QgsPipelinedFeatureIterator()
+{
+  close();
+}
+
+bool QgsPipelinedFeatureIterator::rewind()
+{
+  return false;
+}
+
+bool QgsPipelinedFeatureIterator::close()
+{
+  if ( mClosed )
+    return false;
+
+  {
+    QMutexLocker locker( &mMutex );
+    mStopped = true;
+    mBatchTaken.wakeAll();
+  }
+  mThread->wait();
+
+  mQueue.clear();
+  mCurrentBatch.clear();
+  mCurrentIndex = 0;
+  mClosed = true;
+  return true;
+}
+
+bool QgsPipelinedFeatureIterator::isValid() const
+{
+  return mSourceValid.load() != 0;
+}
+
+bool QgsPipelinedFeatureIterator::fetchFeature( QgsFeature &f )
+{
+  if ( mClosed )
+    return false;
+
+  if ( mCurrentIndex >= mCurrentBatch.size() )
+  {
+    QMutexLocker locker( &mMutex );
+    while ( mQueue.isEmpty() && !mFinished )
+      mBatchAdded.wait( &mMutex );
+
+    if ( mQueue.isEmpty() )
+    {
+      locker.unlock();
+      close();
+      return false;
+    }
+
+    mCurrentBatch = mQueue.dequeue();
+    mCurrentIndex = 0;
+    mBatchTaken.wakeOne();
+  }
+
+  f = mCurrentBatch.at( mCurrentIndex++ );
+  return true;
+}
+
+bool QgsPipelinedFeatureIterator::pushBatch( QgsFeatureList &batch )
+{
+  QMutexLocker locker( &mMutex );
+  while ( mQueue.size() >= MAX_QUEUED_BATCHES && !mStopped )
+    mBatchTaken.wait( &mMutex );
+
+  if ( mStopped )
+    return false;
+
+  mQueue.enqueue( batch );
+  batch.clear();
+  mBatchAdded.wakeOne();
+  return true;
+}
+
+void QgsPipelinedFeatureIterator::fetchFeatures()
+{
+  QgsFeatureIterator it = mSource->getFeatures( mSourceRequest );
+  it.setInterruptionChecker( mInterruptionChecker );
+
+  QgsFeatureList batch;
+  batch.reserve( BATCH_SIZE );
+
+  bool keepGoing = true;
+  QgsFeature feature;
+  while ( keepGoing && it.nextFeature( feature ) )
+  {
+    if ( mInterruptionChecker && mInterruptionChecker->isCanceled() )
+      break;
+
+    // compute the bounding box while still on this thread, the renderer needs it for every feature
+    if ( feature.hasGeometry() )
+      feature.geometry().boundingBox();
+
+    batch << feature;
+    if ( batch.size() >= BATCH_SIZE )
+      keepGoing = pushBatch( batch );
+  }
+
+  if ( keepGoing && !batch.isEmpty() )
+    pushBatch( batch );
+
+  if ( !it.isValid() )
+    mSourceValid.store( 0 );
+  it.close();
+
+  QMutexLocker locker( &mMutex );
+  mFinished = true;
+  mBatchAdded.wakeAll();
+}
+
+///@endcond
@@ -0,0 +1,143 @@
+/***************************************************************************
+                         qgspipelinedfeatureiterator_p.h
+                         -------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPIPELINEDFEATUREITERATOR_P_H
+#define QGSPIPELINEDFEATUREITERATOR_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeature.h"
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QQueue>
+#include <memory>
+
+class QgsAbstractFeatureSource;
+class QgsFeedback;
+class QgsPipelinedFeatureIterator;
+
+/**
+ * \ingroup core
+ * Thread on which a QgsPipelinedFeatureIterator fetches its features.
+ */
+class QgsPipelinedFeatureFetchThread : public QThread
+{
+    Q_OBJECT
+
+  public:
+    QgsPipelinedFeatureFetchThread( QgsPipelinedFeatureIterator *iterator );
+
+    void run() override;
+
+  private:
+    QgsPipelinedFeatureIterator *mIterator = nullptr;
+};
+
+/**
+ * \ingroup core
+ * Feature iterator which fetches the features from a source on a separate thread
+ * while the consumer processes the previously fetched ones.
+ *
+ * The features are handed over in batches through a bounded queue, so that
+ * the fetching thread never gets too far ahead of the consumer. The iterator of
+ * the source is created, advanced and closed on the fetching thread only, so
+ * providers which tie their connections to a thread keep working.
+ *
+ * Filtering, simplification and ordering are all applied by the iterator of the
+ * source, which therefore happens on the fetching thread as well.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsPipelinedFeatureIterator : public QgsAbstractFeatureIterator
+{
+  public:
+
+    /**
+     * Constructor for QgsPipelinedFeatureIterator. Starts fetching the features
+     * of \a source matching \a request right away.
+     *
+     * The \a source and the \a interruptionChecker must stay alive until the
+     * iterator is closed.
+     */
+    QgsPipelinedFeatureIterator( QgsAbstractFeatureSource *source, const QgsFeatureRequest &request, QgsFeedback *interruptionChecker = nullptr );
+    ~QgsPipelinedFeatureIterator() override;
+
+    //! QgsPipelinedFeatureIterator cannot be copied
+    QgsPipelinedFeatureIterator( const QgsPipelinedFeatureIterator &other ) = delete;
+    //! QgsPipelinedFeatureIterator cannot be copied
+    QgsPipelinedFeatureIterator &operator=( const QgsPipelinedFeatureIterator &other ) = delete;
+
+    //! Rewinding is not supported, always returns FALSE
+    bool rewind() override;
+    bool close() override;
+    bool isValid() const override;
+
+  protected:
+    bool fetchFeature( QgsFeature &f ) override;
+
+  private:
+
+    //! Number of features handed over to the consumer at once
+    static constexpr int BATCH_SIZE = 256;
+    //! Maximum number of batches waiting for the consumer
+    static constexpr int MAX_QUEUED_BATCHES = 4;
+
+    //! Runs on the fetching thread
+    void fetchFeatures();
+
+    //! Queues a batch of features, blocks while the queue is full. Returns FALSE if fetching should stop.
+    bool pushBatch( QgsFeatureList &batch );
+
+    QgsAbstractFeatureSource *mSource = nullptr;
+    QgsFeatureRequest mSourceRequest;
+    QgsFeedback *mInterruptionChecker = nullptr;
+
+    std::unique_ptr< QgsPipelinedFeatureFetchThread > mThread;
+
+    QMutex mMutex;
+    QWaitCondition mBatchAdded;
+    QWaitCondition mBatchTaken;
+    QQueue< QgsFeatureList > mQueue;
+    bool mFinished = false;
+    bool mStopped = false;
+    QAtomicInt mSourceValid = 1;
+
+    //! Batch currently consumed, only accessed by the consumer
+    QgsFeatureList mCurrentBatch;
+    int mCurrentIndex = 0;
+
+    friend class QgsPipelinedFeatureFetchThread;
+};
+
+///@endcond
+
+#endif // QGSPIPELINEDFEATUREITERATOR_P_H
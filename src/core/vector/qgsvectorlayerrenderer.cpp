@@ -41,8 +41,91 @@
 #include "qgsvectorlayertemporalproperties.h"
 #include "qgsmapclippingutils.h"
 #include "qgsfeaturerenderergenerator.h"
+#include "qgspipelinedfeatureiterator_p.h"
+#include "qgsrenderobjectpool.h"
 
+#include <QImage>
 #include <QPicture>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <algorithm>
+
+///@cond PRIVATE
+
+/**
+ * Vertical strip of the output image whose features are fetched and drawn on their own
+ * thread into a separate image, see QgsVectorLayerRenderer::drawRendererPartitioned().
+ */
+struct QgsVectorLayerRenderPartition
+{
+  QgsAbstractFeatureSource *source = nullptr;
+  QgsFeatureRequest request;
+  //! TRUE if no feature of the layer extent can be drawn into the strip
+  bool empty = false;
+  //! Offset of the strip in device pixels of the output image
+  int x = 0;
+  //! Transform of the painter of the strip image
+  QTransform transform;
+  std::unique_ptr< QgsRenderContext > context;
+  std::unique_ptr< QgsFeatureRenderer > renderer;
+  //! Temporary objects of the thread drawing the partition, as pools are not thread safe
+  QgsRenderObjectPool objectPool;
+  QImage image;
+  //! TRUE if anything was drawn into the image since it was last cleared
+  bool drawn = false;
+  //! Features to register for labeling, in drawing order
+  QgsFeatureList labelFeatures;
+  //! Features grouped by the index of their symbol in QgsFeatureRenderer::symbols(), only used with symbol levels
+  QHash< int, QgsFeatureList > symbolFeatures;
+  bool valid = true;
+};
+
+/**
+ * Returns the symbol levels of the symbols of \a renderer.
+ */
+static QgsSymbolLevelOrder symbolLevelOrder( QgsFeatureRenderer *renderer, QgsRenderContext &context )
+{
+  QgsSymbolLevelOrder levels;
+  QgsSymbolList symbols = renderer->symbols( context );
+  for ( int i = 0; i < symbols.count(); i++ )
+  {
+    QgsSymbol *sym = symbols[i];
+    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
+    {
+      int level = sym->symbolLayer( j )->renderingPass();
+      if ( level < 0 || level >= 1000 ) // ignore invalid levels
+        continue;
+      QgsSymbolLevelItem item( sym, j );
+      while ( level >= levels.count() ) // append new empty levels
+        levels.append( QgsSymbolLevel() );
+      levels[level].append( item );
+    }
+  }
+  return levels;
+}
+
+/**
+ * Returns the maximum distance in painter units that the symbols of \a renderer
+ * can draw outside of the features.
+ */
+static double estimateMaxRendererBleed( QgsFeatureRenderer *renderer, QgsRenderContext &context )
+{
+  double maxBleed = 0;
+  const QgsSymbolList symbols = renderer->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    maxBleed = std::max( maxBleed, QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context ) );
+    if ( symbol->type() == QgsSymbol::Marker )
+    {
+      // markers are drawn around the points
+      const QRectF bounds = static_cast< QgsMarkerSymbol * >( symbol )->bounds( QPointF( 0, 0 ), context );
+      maxBleed = std::max( { maxBleed, -bounds.left(), bounds.right(), -bounds.top(), bounds.bottom() } );
+    }
+  }
+  return maxBleed;
+}
+
+///@endcond
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
   : QgsMapLayerRenderer( layer->id(), &context )
@@ -178,6 +261,19 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
     mForceRasterRender = true;
   }
 
+  // every partition drawn concurrently gets its own snapshot of the layer, which can only be
+  // created here, so only create them if one of the renderers can be partitioned
+  const bool canPartition = std::any_of( mRenderers.begin(), mRenderers.end(), [this]( const std::unique_ptr< QgsFeatureRenderer > &renderer )
+  {
+    return canRenderPartitioned( renderer.get() );
+  } );
+  if ( canPartition )
+  {
+    const int partitionCount = QThreadPool::globalInstance()->maxThreadCount();
+    for ( int i = 1; i < partitionCount; ++i )
+      mPartitionSources.emplace_back( qgis::make_unique< QgsVectorLayerFeatureSource >( layer ) );
+  }
+
   mReadyToCompose = false;
 }
 
@@ -250,6 +346,9 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
 
   // MUST be created in the thread doing the rendering
   mInterruptionChecker = qgis::make_unique< QgsVectorLayerRendererInterruptionChecker >( context );
+  if ( !mObjectPool )
+    mObjectPool = qgis::make_unique< QgsRenderObjectPool >();
+  context.setObjectPool( mObjectPool.get() );
   bool usingEffect = false;
   if ( renderer->paintEffect() && renderer->paintEffect()->enabled() )
   {
@@ -387,19 +486,41 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
     context.setVectorSimplifyMethod( vectorMethod );
   }
 
-  QgsFeatureIterator fit = mSource->getFeatures( featureRequest );
-  // Attach an interruption checker so that iterators that have potentially
-  // slow fetchFeature() implementations, such as in the WFS provider, can
-  // check it, instead of relying on just the mContext.renderingStopped() check
-  // in drawRenderer()
-  fit.setInterruptionChecker( mInterruptionChecker.get() );
-
-  if ( ( renderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && renderer->usingSymbolLevels() )
-    drawRendererLevels( renderer, fit );
+  bool sourceValid = true;
+  QgsFeatureIterator fit;
+  const int partitionCount = renderPartitionCount( renderer, requestExtent );
+  if ( partitionCount > 1 )
+  {
+    sourceValid = drawRendererPartitioned( renderer, featureRequest, requestExtent, partitionCount );
+  }
   else
-    drawRenderer( renderer, fit );
+  {
+    if ( context.testFlag( QgsRenderContext::PipelinedFeatureFetching ) )
+    {
+      // fetch (and decode/simplify) the next features on a separate thread while the
+      // current ones are being drawn. The interruption checker is handed to the
+      // iterator of the source, which is created on that thread.
+      fit = QgsFeatureIterator( new QgsPipelinedFeatureIterator( mSource.get(), featureRequest, mInterruptionChecker.get() ) );
+    }
+    else
+    {
+      fit = mSource->getFeatures( featureRequest );
+      // Attach an interruption checker so that iterators that have potentially
+      // slow fetchFeature() implementations, such as in the WFS provider, can
+      // check it, instead of relying on just the mContext.renderingStopped() check
+      // in drawRenderer()
+      fit.setInterruptionChecker( mInterruptionChecker.get() );
+    }
+
+    if ( ( renderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && renderer->usingSymbolLevels() )
+      drawRendererLevels( renderer, fit );
+    else
+      drawRenderer( renderer, fit );
 
-  if ( !fit.isValid() )
+    sourceValid = fit.isValid();
+  }
+
+  if ( !sourceValid )
   {
     mErrors.append( QStringLiteral( "Data source invalid" ) );
   }
@@ -409,7 +530,13 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
     renderer->paintEffect()->end( context );
   }
 
+  // the fetching thread of a pipelined iterator must not outlive the interruption checker
+  fit.close();
   mInterruptionChecker.reset();
+
+  QgsDebugMsgLevel( QStringLiteral( "Temporary objects for layer %1: %2 allocated, %3 reused" )
+                    .arg( layerId() ).arg( mObjectPool->allocationCount() ).arg( mObjectPool->reuseCount() ), 3 );
+  context.setObjectPool( nullptr );
   return true;
 }
 
@@ -429,6 +556,11 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
     clipEngine->prepareGeometry();
   }
 
+  // the expression context gets a copy of each feature, which is replaced by this empty
+  // feature once drawn so that the iterator can reuse the storage of the feature (and of
+  // its attributes) for the next one, instead of detaching from that copy
+  const QgsFeature drawnFeature;
+
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
   {
@@ -471,36 +603,17 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
         // new labeling engine
         if ( isMainRenderer && context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
         {
-          QgsGeometry obstacleGeometry;
-          QgsSymbolList symbols = renderer->originalSymbolsForFeature( fet, context );
-          QgsSymbol *symbol = nullptr;
-          if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
-          {
-            obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, context, symbols );
-          }
-
-          if ( !symbols.isEmpty() )
-          {
-            symbol = symbols.at( 0 );
-            QgsExpressionContextUtils::updateSymbolScope( symbol, symbolScope );
-          }
-
           if ( mApplyLabelClipGeometries )
             context.setFeatureClipGeometry( mLabelClipFeatureGeom );
 
-          if ( mLabelProvider )
-          {
-            mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
-          }
-          if ( mDiagramProvider )
-          {
-            mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
-          }
+          registerFeatureForLabeling( renderer, fet, symbolScope );
 
           if ( mApplyLabelClipGeometries )
             context.setFeatureClipGeometry( QgsGeometry() );
         }
       }
+
+      context.expressionContext().setFeature( drawnFeature );
     }
     catch ( const QgsCsException &cse )
     {
@@ -578,28 +691,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
     // new labeling engine
     if ( isMainRenderer && context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
     {
-      QgsGeometry obstacleGeometry;
-      QgsSymbolList symbols = renderer->originalSymbolsForFeature( fet, context );
-      QgsSymbol *symbol = nullptr;
-      if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
-      {
-        obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, context, symbols );
-      }
-
-      if ( !symbols.isEmpty() )
-      {
-        symbol = symbols.at( 0 );
-        QgsExpressionContextUtils::updateSymbolScope( symbol, symbolScope );
-      }
-
-      if ( mLabelProvider )
-      {
-        mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
-      }
-      if ( mDiagramProvider )
-      {
-        mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
-      }
+      registerFeatureForLabeling( renderer, fet, symbolScope );
     }
   }
 
@@ -616,22 +708,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
   }
 
   // find out the order
-  QgsSymbolLevelOrder levels;
-  QgsSymbolList symbols = renderer->symbols( context );
-  for ( int i = 0; i < symbols.count(); i++ )
-  {
-    QgsSymbol *sym = symbols[i];
-    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
-    {
-      int level = sym->symbolLayer( j )->renderingPass();
-      if ( level < 0 || level >= 1000 ) // ignore invalid levels
-        continue;
-      QgsSymbolLevelItem item( sym, j );
-      while ( level >= levels.count() ) // append new empty levels
-        levels.append( QgsSymbolLevel() );
-      levels[level].append( item );
-    }
-  }
+  QgsSymbolLevelOrder levels = symbolLevelOrder( renderer, context );
 
   if ( mApplyClipGeometries )
     context.setFeatureClipGeometry( mClipFeatureGeom );
@@ -690,6 +767,381 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
   stopRenderer( renderer, selRenderer );
 }
 
+bool QgsVectorLayerRenderer::canRenderPartitioned( QgsFeatureRenderer *renderer )
+{
+  QgsRenderContext &context = *renderContext();
+  if ( !context.testFlag( QgsRenderContext::PartitionedVectorRendering ) )
+    return false;
+
+  // only renderers drawing every feature on its own, in any order, from renderFeature()
+  static const QSet< QString > sPartitionableRenderers
+  {
+    QStringLiteral( "singleSymbol" ),
+    QStringLiteral( "categorizedSymbol" ),
+    QStringLiteral( "graduatedSymbol" ),
+  };
+  if ( !sPartitionableRenderers.contains( renderer->type() ) || renderer->orderByEnabled() )
+    return false;
+
+  // effects and blending apply to the features of the whole layer at once
+  if ( ( renderer->paintEffect() && renderer->paintEffect()->enabled() )
+       || ( context.useAdvancedEffects() && mFeatureBlendMode != QPainter::CompositionMode_SourceOver ) )
+    return false;
+
+  // rendered feature handlers and selective masking are not thread safe
+  if ( context.hasRenderedFeatureHandlers() || context.maskIdProvider() )
+    return false;
+
+  // the vertical strips of the output image must be vertical strips of the layer extent too
+  if ( !qgsDoubleNear( context.mapToPixel().mapRotation(), 0.0 )
+       || ( context.coordinateTransform().isValid() && !context.coordinateTransform().isShortCircuited() ) )
+    return false;
+
+  // the reach of the symbols outside of the features must be known beforehand
+  const QgsSymbolList symbols = renderer->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    if ( symbol->hasDataDefinedProperties() )
+      return false;
+
+    for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+    {
+      if ( symbol->symbolLayer( i )->layerType() == QLatin1String( "GeometryGenerator" ) )
+        return false;
+    }
+  }
+
+  return true;
+}
+
+int QgsVectorLayerRenderer::renderPartitionCount( QgsFeatureRenderer *renderer, const QgsRectangle &extent )
+{
+  if ( mPartitionSources.empty() || !canRenderPartitioned( renderer ) )
+    return 1;
+
+  const QgsRenderContext &context = *renderContext();
+
+  // only raster outputs can be assembled from partial images, placed at whole pixels
+  if ( !context.painter() || !context.painter()->device() || context.painter()->device()->devType() != QInternal::Image
+       || context.painter()->worldTransform().type() > QTransform::TxTranslate )
+    return 1;
+
+  if ( extent.isEmpty() || !extent.isFinite() )
+    return 1;
+
+  // every partition is at least one pixel wide
+  const QImage *targetImage = static_cast< const QImage * >( context.painter()->device() );
+  return std::max( 1, std::min( 1 + static_cast< int >( mPartitionSources.size() ), targetImage->width() ) );
+}
+
+bool QgsVectorLayerRenderer::drawRendererPartitioned( QgsFeatureRenderer *renderer, const QgsFeatureRequest &request, const QgsRectangle &extent, int partitionCount )
+{
+  const bool isMainRenderer = renderer == mRenderer;
+  const bool useSymbolLevels = ( renderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && renderer->usingSymbolLevels();
+
+  QgsRenderContext &context = *renderContext();
+  const bool registerLabels = isMainRenderer && context.labelingEngine() && ( mLabelProvider || mDiagramProvider );
+
+  const QImage *targetImage = static_cast< const QImage * >( context.painter()->device() );
+  const double devicePixelRatio = targetImage->devicePixelRatioF();
+  const QPainter::RenderHints renderHints = context.painter()->renderHints();
+  const QTransform worldTransform = context.painter()->worldTransform();
+
+  // A partition draws the features within the reach of the symbols from its strip of the
+  // output image. The bleed is doubled to account for line joins and caps, plus a pixel
+  // for antialiasing.
+  double bleed = estimateMaxRendererBleed( renderer, context );
+  if ( isMainRenderer && mDrawVertexMarkers )
+    bleed = std::max( bleed, context.convertToPainterUnits( mVertexMarkerSize, QgsUnitTypes::RenderMillimeters ) );
+  const double margin = ( 2 * bleed + 1 ) * context.mapToPixel().mapUnitsPerPixel();
+
+  auto stripMapX = [&]( int column )
+  {
+    return context.mapToPixel().toMapCoordinates( column / devicePixelRatio - worldTransform.dx(), 0.0 ).x();
+  };
+
+  std::vector< QgsVectorLayerRenderPartition > partitions( partitionCount );
+  for ( int i = 0; i < partitionCount; ++i )
+  {
+    QgsVectorLayerRenderPartition &partition = partitions[i];
+    partition.source = i == 0 ? mSource.get() : mPartitionSources[ i - 1 ].get();
+
+    // strips are whole device pixel columns, so that the images tile the output exactly
+    partition.x = static_cast< int >( std::round( static_cast< double >( i ) * targetImage->width() / partitionCount ) );
+    const int nextX = static_cast< int >( std::round( static_cast< double >( i + 1 ) * targetImage->width() / partitionCount ) );
+    partition.transform = worldTransform * QTransform::fromTranslate( -partition.x / devicePixelRatio, 0 );
+
+    // the outer strips also draw the features of the extent outside of the image, so that
+    // every feature of the extent is registered for labeling
+    const double xMin = i == 0 ? extent.xMinimum() : std::max( extent.xMinimum(), stripMapX( partition.x ) - margin );
+    const double xMax = i == partitionCount - 1 ? extent.xMaximum() : std::min( extent.xMaximum(), stripMapX( nextX ) + margin );
+    partition.empty = xMin > xMax;
+    partition.request = request;
+    partition.request.setFilterRect( QgsRectangle( xMin, extent.yMinimum(), xMax, extent.yMaximum() ) );
+
+    partition.context = qgis::make_unique< QgsRenderContext >( context );
+    partition.context->setPainter( nullptr );
+    partition.context->setObjectPool( &partition.objectPool );
+    partition.renderer.reset( renderer->clone() );
+    if ( isMainRenderer && mDrawVertexMarkers )
+      partition.renderer->setVertexMarkerAppearance( mVertexMarkerStyle, mVertexMarkerSize );
+
+    partition.image = QImage( nextX - partition.x, targetImage->height(), QImage::Format_ARGB32_Premultiplied );
+    partition.image.setDevicePixelRatio( devicePixelRatio );
+    partition.image.fill( Qt::transparent );
+  }
+
+  // 1. fetch the features of every partition, drawing them right away unless symbol levels are used
+  auto fetchPartition = [&]( QgsVectorLayerRenderPartition & partition )
+  {
+    QgsRenderContext &partitionContext = *partition.context;
+    QPainter painter( &partition.image );
+    painter.setRenderHints( renderHints );
+    painter.setWorldTransform( partition.transform );
+    partitionContext.setPainter( &painter );
+
+    partition.renderer->startRender( partitionContext, mFields );
+
+    if ( partition.empty )
+    {
+      partitionContext.setPainter( nullptr );
+      return;
+    }
+
+    QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+    QgsExpressionContextScopePopper scopePopper( partitionContext.expressionContext(), symbolScope );
+
+    std::unique_ptr< QgsGeometryEngine > clipEngine;
+    if ( mApplyClipFilter )
+    {
+      clipEngine.reset( QgsGeometry::createGeometryEngine( mClipFilterGeom.constGet() ) );
+      clipEngine->prepareGeometry();
+    }
+
+    if ( mApplyClipGeometries && !useSymbolLevels )
+      partitionContext.setFeatureClipGeometry( mClipFeatureGeom );
+
+    const QgsSymbolList symbols = useSymbolLevels ? partition.renderer->symbols( partitionContext ) : QgsSymbolList();
+
+    QgsFeatureIterator fit = partition.source->getFeatures( partition.request );
+    fit.setInterruptionChecker( mInterruptionChecker.get() );
+
+    QgsFeature fet;
+    while ( fit.nextFeature( fet ) )
+    {
+      if ( context.renderingStopped() )
+        break;
+
+      if ( !fet.hasGeometry() || fet.geometry().isEmpty() )
+        continue; // skip features without geometry
+
+      if ( clipEngine && !clipEngine->intersects( fet.geometry().constGet() ) )
+        continue; // skip features outside of clipping region
+
+      partitionContext.expressionContext().setFeature( fet );
+
+      if ( useSymbolLevels )
+      {
+        QgsSymbol *sym = partition.renderer->symbolForFeature( fet, partitionContext );
+        if ( !sym )
+          continue;
+
+        partition.symbolFeatures[ symbols.indexOf( sym ) ].append( fet );
+        if ( registerLabels )
+          partition.labelFeatures.append( fet );
+        continue;
+      }
+
+      bool sel = isMainRenderer && context.showSelection() && mSelectedFeatureIds.contains( fet.id() );
+      bool drawMarker = isMainRenderer && ( mDrawVertexMarkers && context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+      try
+      {
+        if ( partition.renderer->renderFeature( fet, partitionContext, -1, sel, drawMarker ) )
+        {
+          partition.drawn = true;
+          if ( registerLabels )
+            partition.labelFeatures.append( fet );
+        }
+      }
+      catch ( const QgsCsException &cse )
+      {
+        Q_UNUSED( cse )
+        QgsDebugMsg( QStringLiteral( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                     .arg( fet.id() ).arg( cse.what() ) );
+      }
+    }
+
+    partition.valid = fit.isValid();
+    partitionContext.setPainter( nullptr );
+  };
+
+  auto stopPartitions = [&]
+  {
+    for ( QgsVectorLayerRenderPartition &partition : partitions )
+    {
+      QPainter painter( &partition.image );
+      partition.context->setPainter( &painter );
+      partition.renderer->stopRender( *partition.context );
+      partition.context->setPainter( nullptr );
+    }
+  };
+
+  // draws the images of the partitions at their strips, and clears them for the next symbol level
+  auto mergePartitions = [&]
+  {
+    QPainter *painter = context.painter();
+    painter->save();
+    painter->setWorldTransform( QTransform() );
+    for ( QgsVectorLayerRenderPartition &partition : partitions )
+    {
+      if ( !partition.drawn )
+        continue;
+
+      painter->drawImage( QPointF( partition.x / devicePixelRatio, 0 ), partition.image );
+      partition.image.fill( Qt::transparent );
+      partition.drawn = false;
+    }
+    painter->restore();
+
+    // as soon as first features are rendered, we can start showing layer updates.
+    // but if we are blocking render updates (so that a previously cached image is being shown), we wait
+    // at most e.g. 3 seconds before we start forcing progressive updates.
+    if ( !mBlockRenderUpdates || mElapsedTimer.elapsed() > MAX_TIME_TO_USE_CACHED_PREVIEW_IMAGE )
+    {
+      mReadyToCompose = true;
+    }
+  };
+
+  QtConcurrent::blockingMap( partitions, fetchPartition );
+
+  if ( useSymbolLevels && !context.renderingStopped() )
+  {
+    // 2. draw the partitions level by level, merging each level before drawing the next one
+    const QgsSymbolList symbols = renderer->symbols( context );
+    const QgsSymbolLevelOrder levels = symbolLevelOrder( renderer, context );
+    for ( const QgsSymbolLevel &level : levels )
+    {
+      auto drawLevel = [&]( QgsVectorLayerRenderPartition & partition )
+      {
+        QgsRenderContext &partitionContext = *partition.context;
+        QPainter painter( &partition.image );
+        painter.setRenderHints( renderHints );
+        painter.setWorldTransform( partition.transform );
+        partitionContext.setPainter( &painter );
+
+        if ( mApplyClipGeometries )
+          partitionContext.setFeatureClipGeometry( mClipFeatureGeom );
+
+        for ( const QgsSymbolLevelItem &item : level )
+        {
+          auto featuresIt = partition.symbolFeatures.constFind( symbols.indexOf( item.symbol() ) );
+          if ( featuresIt == partition.symbolFeatures.constEnd() )
+            continue;
+
+          for ( const QgsFeature &fet : featuresIt.value() )
+          {
+            if ( context.renderingStopped() )
+              break;
+
+            bool sel = isMainRenderer && context.showSelection() && mSelectedFeatureIds.contains( fet.id() );
+            // maybe vertex markers should be drawn only during the last pass...
+            bool drawMarker = isMainRenderer && ( mDrawVertexMarkers && context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+            partitionContext.expressionContext().setFeature( fet );
+
+            try
+            {
+              partition.renderer->renderFeature( fet, partitionContext, item.layer(), sel, drawMarker );
+              partition.drawn = true;
+            }
+            catch ( const QgsCsException &cse )
+            {
+              Q_UNUSED( cse )
+              QgsDebugMsg( QStringLiteral( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                           .arg( fet.id() ).arg( cse.what() ) );
+            }
+          }
+        }
+
+        partitionContext.setPainter( nullptr );
+      };
+
+      QtConcurrent::blockingMap( partitions, drawLevel );
+      if ( context.renderingStopped() )
+        break;
+
+      mergePartitions();
+    }
+  }
+  else if ( !context.renderingStopped() )
+  {
+    mergePartitions();
+  }
+
+  stopPartitions();
+
+  // 3. register the features for labeling, in partition order. Features spanning several
+  // strips are drawn by each of them, but must only be registered once.
+  if ( registerLabels && !context.renderingStopped() )
+  {
+    QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+    QgsExpressionContextScopePopper scopePopper( context.expressionContext(), symbolScope );
+
+    if ( mApplyLabelClipGeometries )
+      context.setFeatureClipGeometry( mLabelClipFeatureGeom );
+
+    QgsFeatureIds registeredIds;
+    for ( QgsVectorLayerRenderPartition &partition : partitions )
+    {
+      for ( QgsFeature &fet : partition.labelFeatures )
+      {
+        if ( registeredIds.contains( fet.id() ) )
+          continue;
+
+        registeredIds.insert( fet.id() );
+        context.expressionContext().setFeature( fet );
+        registerFeatureForLabeling( renderer, fet, symbolScope );
+      }
+    }
+
+    if ( mApplyLabelClipGeometries )
+      context.setFeatureClipGeometry( QgsGeometry() );
+  }
+
+  stopRenderer( renderer, nullptr );
+
+  return std::all_of( partitions.begin(), partitions.end(), []( const QgsVectorLayerRenderPartition & partition ) { return partition.valid; } );
+}
+
+void QgsVectorLayerRenderer::registerFeatureForLabeling( QgsFeatureRenderer *renderer, QgsFeature &fet, QgsExpressionContextScope *symbolScope )
+{
+  QgsRenderContext &context = *renderContext();
+
+  QgsGeometry obstacleGeometry;
+  QgsSymbolList symbols = renderer->originalSymbolsForFeature( fet, context );
+  QgsSymbol *symbol = nullptr;
+  if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
+  {
+    obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, context, symbols );
+  }
+
+  if ( !symbols.isEmpty() )
+  {
+    symbol = symbols.at( 0 );
+    QgsExpressionContextUtils::updateSymbolScope( symbol, symbolScope );
+  }
+
+  if ( mLabelProvider )
+  {
+    mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
+  }
+  if ( mDiagramProvider )
+  {
+    mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
+  }
+}
+
 void QgsVectorLayerRenderer::stopRenderer( QgsFeatureRenderer *renderer, QgsSingleSymbolRenderer *selRenderer )
 {
   QgsRenderContext &context = *renderContext();
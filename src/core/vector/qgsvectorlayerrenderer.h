@@ -27,6 +27,8 @@ class QgsDiagramLayerSettings;
 class QgsFeatureIterator;
 class QgsSingleSymbolRenderer;
 class QgsMapClippingRegion;
+class QgsExpressionContextScope;
+class QgsRenderObjectPool;
 
 #define SIP_NO_FILE
 
@@ -112,6 +114,34 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     void drawRendererLevels( QgsFeatureRenderer *renderer, QgsFeatureIterator &fit );
 
+    /**
+     * Returns TRUE if the layer may be drawn with \a renderer by drawRendererPartitioned(),
+     * regardless of the output device and extent.
+     */
+    bool canRenderPartitioned( QgsFeatureRenderer *renderer );
+
+    /**
+     * Returns the number of parts of \a extent which can be drawn concurrently
+     * with \a renderer by drawRendererPartitioned(), or 1 if the layer must be drawn
+     * in one go.
+     */
+    int renderPartitionCount( QgsFeatureRenderer *renderer, const QgsRectangle &extent );
+
+    /**
+     * Draw layer with \a renderer, splitting the output image into \a partitionCount vertical
+     * strips. Each strip draws every feature of \a extent within the reach of its symbols,
+     * in provider order, concurrently into a separate image the size of the strip. The images
+     * are drawn at their strips (level by level when using symbol levels) before the features
+     * are registered for labeling. QgsFeatureRenderer::startRender() needs to be called before
+     * using this method.
+     *
+     * Returns FALSE if a feature source was invalid.
+     */
+    bool drawRendererPartitioned( QgsFeatureRenderer *renderer, const QgsFeatureRequest &request, const QgsRectangle &extent, int partitionCount );
+
+    //! Registers a rendered feature \a fet with the label and diagram providers
+    void registerFeatureForLabeling( QgsFeatureRenderer *renderer, QgsFeature &fet, QgsExpressionContextScope *symbolScope );
+
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsFeatureRenderer *renderer, QgsSingleSymbolRenderer *selRenderer );
 
@@ -121,6 +151,9 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     std::unique_ptr< QgsVectorLayerRendererInterruptionChecker > mInterruptionChecker;
 
+    //! Temporary objects reused between the features drawn on the rendering thread
+    std::unique_ptr< QgsRenderObjectPool > mObjectPool;
+
     //! The rendered layer
     QgsVectorLayer *mLayer = nullptr;
 
@@ -132,6 +165,9 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     std::unique_ptr< QgsVectorLayerFeatureSource > mSource;
 
+    //! Additional sources for the partitions of the extent drawn concurrently, besides mSource
+    std::vector< std::unique_ptr< QgsVectorLayerFeatureSource > > mPartitionSources;
+
     QgsFeatureRenderer *mRenderer = nullptr;
     std::vector< std::unique_ptr< QgsFeatureRenderer> > mRenderers;
 
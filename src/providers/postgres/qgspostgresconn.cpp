@@ -1437,6 +1437,18 @@ PGresult *QgsPostgresConn::PQgetResult()
   return ::PQgetResult( mConn );
 }
 
+int QgsPostgresConn::PQputCopyData( const QByteArray &buffer )
+{
+  QMutexLocker locker( &mLock );
+  return ::PQputCopyData( mConn, buffer.constData(), buffer.size() );
+}
+
+int QgsPostgresConn::PQputCopyEnd( const QString &errorMessage )
+{
+  QMutexLocker locker( &mLock );
+  return ::PQputCopyEnd( mConn, errorMessage.isNull() ? nullptr : errorMessage.toUtf8().constData() );
+}
+
 PGresult *QgsPostgresConn::PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes )
 {
   QMutexLocker locker( &mLock );
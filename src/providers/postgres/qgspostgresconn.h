@@ -280,6 +280,19 @@ class QgsPostgresConn : public QObject
      */
     PGresult *PQgetResult();
 
+    /**
+     * PQputCopyData sends data during a COPY FROM STDIN command (started with PQexec)
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    int PQputCopyData( const QByteArray &buffer );
+
+    /**
+     * PQputCopyEnd ends a COPY FROM STDIN command, the result is then available with PQgetResult.
+     * The COPY command fails if an \a errorMessage is given.
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    int PQputCopyEnd( const QString &errorMessage = QString() );
+
     bool begin();
     bool commit();
     bool rollback();
@@ -25,6 +25,10 @@
 
 #include <QElapsedTimer>
 #include <QObject>
+#include <QtEndian>
+
+#include <cstdlib>
+#include <limits>
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -253,40 +257,9 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     timer.start();
 #endif
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
-
-    QgsPostgresResult queryResult;
-    for ( ;; )
-    {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
-
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
-      mLastFetch = rows < mFeatureQueueSize;
-
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
-    }
+    if ( mPendingFetch || sendFetch() )
+      receiveFetch();
     unlock();
 
 #if 0 //disabled dynamic queue size
@@ -321,6 +294,65 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+bool QgsPostgresFeatureIterator::sendFetch()
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return false;
+  }
+
+  mPendingFetch = true;
+  return true;
+}
+
+void QgsPostgresFeatureIterator::receiveFetch()
+{
+  mPendingFetch = false;
+
+  QgsPostgresResult queryResult( mConn->PQgetResult() );
+  // consume the remaining results, so that the connection is ready for the next query
+  while ( PGresult *extraResult = mConn->PQgetResult() )
+    ::PQclear( extraResult );
+
+  if ( !queryResult.result() )
+    return;
+
+  if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return;
+  }
+
+  const int rows = queryResult.PQntuples();
+  mLastFetch = rows < mFeatureQueueSize;
+
+  // let the server prepare the next batch while this one is decoded and consumed.
+  // Transaction connections are shared with the provider, which may run other
+  // queries between two fetches, so they are only used synchronously.
+  if ( !mLastFetch && !mIsTransactionConnection )
+    sendFetch();
+
+  for ( int row = 0; row < rows; row++ )
+  {
+    mFeatureQueue.enqueue( QgsFeature() );
+    getFeature( queryResult, row, mFeatureQueue.back() );
+  } // for each row in queue
+}
+
+void QgsPostgresFeatureIterator::discardPendingFetch()
+{
+  if ( !mPendingFetch )
+    return;
+
+  while ( PGresult *result = mConn->PQgetResult() )
+    ::PQclear( result );
+  mPendingFetch = false;
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -381,6 +413,7 @@ bool QgsPostgresFeatureIterator::rewind()
 
   // move cursor to first record
 
+  discardPendingFetch();
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
   mFeatureQueue.clear();
   mFetched = 0;
@@ -394,6 +427,7 @@ bool QgsPostgresFeatureIterator::close()
   if ( !mConn )
     return false;
 
+  discardPendingFetch();
   mConn->closeCursor( mCursorName );
 
   if ( !mIsTransactionConnection )
@@ -697,6 +731,12 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
       return false;
   }
 
+  // columns with a simple binary representation are fetched and decoded
+  // without going through text
+  const char *integerDateTimes = ::PQparameterStatus( mConn->pgConnection(), "integer_datetimes" );
+  const bool hasIntegerDateTimes = integerDateTimes && qstrcmp( integerDateTimes, "on" ) == 0;
+  mBinaryFieldTypes.fill( BinaryFieldType::Text, mSource->mFields.count() );
+
   bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
   const auto constAllAttributesList = subsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
   for ( int idx : constAllAttributesList )
@@ -704,7 +744,12 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    const QgsField field = mSource->mFields.at( idx );
+    mBinaryFieldTypes[idx] = binaryFieldType( field, hasIntegerDateTimes );
+    if ( mBinaryFieldTypes[idx] != BinaryFieldType::Text )
+      query += delim + QgsPostgresConn::quotedIdentifier( field.name() );
+    else
+      query += delim + mConn->fieldExpression( field );
   }
 
   query += " FROM " + mSource->mQuery;
@@ -906,6 +951,18 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
 
   QVariant v;
 
+  const BinaryFieldType binaryType = mBinaryFieldTypes.value( idx, BinaryFieldType::Text );
+  if ( binaryType != BinaryFieldType::Text )
+  {
+    if ( ::PQgetisnull( queryResult.result(), row, col ) )
+      v = QVariant( fld.type() );
+    else
+      v = binaryValue( binaryType, fld.type(), ::PQgetvalue( queryResult.result(), row, col ), ::PQgetlength( queryResult.result(), row, col ) );
+    feature.setAttribute( idx, v );
+    col++;
+    return;
+  }
+
   switch ( fld.type() )
   {
     case QVariant::ByteArray:
@@ -955,6 +1012,134 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
   col++;
 }
 
+QgsPostgresFeatureIterator::BinaryFieldType QgsPostgresFeatureIterator::binaryFieldType( const QgsField &field, bool integerDateTimes )
+{
+  const QString typeName = field.typeName();
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+      if ( typeName == QLatin1String( "int2" ) )
+        return BinaryFieldType::Int16;
+      else if ( typeName == QLatin1String( "int4" ) )
+        return BinaryFieldType::Int32;
+      break;
+
+    case QVariant::Double:
+      // float4 is left to text, its text representation is rounded
+      if ( typeName == QLatin1String( "float8" ) || typeName == QLatin1String( "double precision" ) )
+        return BinaryFieldType::Float64;
+      break;
+
+    case QVariant::Bool:
+      if ( typeName == QLatin1String( "bool" ) )
+        return BinaryFieldType::Bool;
+      break;
+
+    case QVariant::Date:
+      if ( typeName == QLatin1String( "date" ) )
+        return BinaryFieldType::Date;
+      break;
+
+    case QVariant::Time:
+      // legacy servers may store times as floating point values
+      if ( integerDateTimes && typeName == QLatin1String( "time" ) )
+        return BinaryFieldType::Time;
+      break;
+
+    case QVariant::DateTime:
+      // timestamptz values are sent in UTC, but as text in the session time zone
+      if ( integerDateTimes && typeName == QLatin1String( "timestamp" ) )
+        return BinaryFieldType::Timestamp;
+      break;
+
+    default:
+      break;
+  }
+  return BinaryFieldType::Text;
+}
+
+QVariant QgsPostgresFeatureIterator::binaryValue( BinaryFieldType type, QVariant::Type variantType, const char *data, int length )
+{
+  const uchar *value = reinterpret_cast< const uchar * >( data );
+
+  // round microseconds to milliseconds like QTime::fromString() does for fractions of seconds
+  auto toMSecs = []( qint64 usecs )
+  {
+    qint64 msecs = usecs / 1000;
+    if ( std::abs( usecs % 1000 ) >= 500 && std::abs( msecs % 1000 ) != 999 )
+      msecs += usecs < 0 ? -1 : 1;
+    return msecs;
+  };
+
+  // all values are sent in network byte order
+  switch ( type )
+  {
+    case BinaryFieldType::Int16:
+      if ( length == 2 )
+        return static_cast< int >( qFromBigEndian<qint16>( value ) );
+      break;
+
+    case BinaryFieldType::Int32:
+      if ( length == 4 )
+        return static_cast< int >( qFromBigEndian<qint32>( value ) );
+      break;
+
+    case BinaryFieldType::Float64:
+      if ( length == 8 )
+      {
+        const quint64 bits = qFromBigEndian<quint64>( value );
+        double d;
+        memcpy( &d, &bits, sizeof( d ) );
+        return d;
+      }
+      break;
+
+    case BinaryFieldType::Bool:
+      if ( length == 1 )
+        return value[0] != 0;
+      break;
+
+    case BinaryFieldType::Date:
+      if ( length == 4 )
+      {
+        // days since 2000-01-01, infinite dates are not representable
+        const qint32 days = qFromBigEndian<qint32>( value );
+        if ( days == std::numeric_limits<qint32>::max() || days == std::numeric_limits<qint32>::min() )
+          break;
+        return QDate( 2000, 1, 1 ).addDays( days );
+      }
+      break;
+
+    case BinaryFieldType::Time:
+      if ( length == 8 )
+      {
+        // microseconds since midnight
+        const qint64 usecs = qFromBigEndian<qint64>( value );
+        return QTime::fromMSecsSinceStartOfDay( static_cast< int >( toMSecs( usecs ) ) );
+      }
+      break;
+
+    case BinaryFieldType::Timestamp:
+      if ( length == 8 )
+      {
+        // microseconds since 2000-01-01 00:00, infinite timestamps are not representable
+        const qint64 usecs = qFromBigEndian<qint64>( value );
+        if ( usecs == std::numeric_limits<qint64>::max() || usecs == std::numeric_limits<qint64>::min() )
+          break;
+
+        // compute in UTC to avoid daylight saving time shifts, timestamps
+        // without time zone are local date times
+        const QDateTime utc = QDateTime( QDate( 2000, 1, 1 ), QTime( 0, 0 ), Qt::UTC ).addMSecs( toMSecs( usecs ) );
+        return QDateTime( utc.date(), utc.time() );
+      }
+      break;
+
+    case BinaryFieldType::Text:
+      break;
+  }
+
+  return QVariant( variantType );
+}
 
 //  ------------------
 
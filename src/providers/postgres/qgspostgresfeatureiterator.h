@@ -86,6 +86,19 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
 
   private:
 
+    //! Representation of an attribute column in the binary cursor
+    enum class BinaryFieldType
+    {
+      Text, //!< Column cast to text, converted with QgsPostgresProvider::convertValue()
+      Int16,
+      Int32,
+      Float64,
+      Bool,
+      Date,
+      Time,
+      Timestamp,
+    };
+
     QgsPostgresConn *mConn = nullptr;
 
 
@@ -94,6 +107,21 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    //! Returns how the \a field is fetched from the binary cursor
+    static BinaryFieldType binaryFieldType( const QgsField &field, bool integerDateTimes );
+
+    //! Decodes a value of a column fetched in binary format
+    static QVariant binaryValue( BinaryFieldType type, QVariant::Type variantType, const char *data, int length );
+
+    //! Sends the query fetching the next batch of features
+    bool sendFetch();
+
+    //! Receives the batch of features requested by sendFetch() and appends them to the feature queue
+    void receiveFetch();
+
+    //! Discards the results of a fetch which has been sent but not received
+    void discardPendingFetch();
+
     QString mCursorName;
 
     /**
@@ -113,6 +141,12 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
 
     bool mIsTransactionConnection = false;
 
+    //! TRUE if the next batch has been requested while the current one is consumed
+    bool mPendingFetch = false;
+
+    //! How each attribute column is fetched, by field index
+    QVector<BinaryFieldType> mBinaryFieldTypes;
+
     bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const override;
 
     bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause> &orderBys ) override;
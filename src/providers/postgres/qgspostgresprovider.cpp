@@ -29,6 +29,10 @@
 
 #include <QMessageBox>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+
 #include "qgsvectorlayerexporter.h"
 #include "qgspostgresprovider.h"
 #include "qgspostgresconn.h"
@@ -54,6 +58,9 @@ const QString QgsPostgresProvider::POSTGRES_DESCRIPTION = QStringLiteral( "Postg
 
 static const QString EDITOR_WIDGET_STYLES_TABLE = QStringLiteral( "qgis_editor_widget_styles" );
 
+//! Maximum number of rows of the INSERT statements of addFeatures()
+static const int ADD_FEATURES_BATCH_SIZE = 256;
+
 inline qint64 PKINT2FID( qint32 x )
 {
   return QgsPostgresUtils::int32pk_to_fid( x );
@@ -76,6 +83,38 @@ static bool columnExists( QgsPostgresConn &conn, const QString &table, const QSt
   return res.PQgetvalue( 0, 0 ).toInt() > 0;
 }
 
+//! Appends a value escaped for the text format of COPY to the buffer
+static void appendCopyValue( const QString &value, QByteArray &buffer )
+{
+  if ( value.isNull() )
+  {
+    buffer.append( "\\N" );
+    return;
+  }
+
+  const QByteArray utf8 = value.toUtf8();
+  for ( const char c : utf8 )
+  {
+    switch ( c )
+    {
+      case '\\':
+        buffer.append( "\\\\" );
+        break;
+      case '\t':
+        buffer.append( "\\t" );
+        break;
+      case '\n':
+        buffer.append( "\\n" );
+        break;
+      case '\r':
+        buffer.append( "\\r" );
+        break;
+      default:
+        buffer.append( c );
+    }
+  }
+}
+
 QgsPostgresPrimaryKeyType
 QgsPostgresProvider::pkType( const QgsField &f ) const
 {
@@ -2295,6 +2334,7 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   conn->lock();
 
   bool returnvalue = true;
+  QStringList preparedStatements;
 
   try
   {
@@ -2302,18 +2342,31 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
 
     // Prepare the INSERT statement
     QString insert = QStringLiteral( "INSERT INTO %1(" ).arg( mQuery );
-    QString values;
     QString delim;
     int offset = 1;
 
     QStringList defaultValues;
     QList<int> fieldId;
 
+    // SQL of the inserted values, split around their parameter if any, so that
+    // the values can be rendered for several rows or for the COPY staging table
+    struct InsertValue
+    {
+      QString prefix;
+      int param = 0; // 1-based parameter number, 0 for values inlined in the statement
+      QString suffix;
+    };
+    QVector<InsertValue> insertValues;
+
     if ( !mGeometryColumn.isNull() )
     {
       insert += quotedIdentifier( mGeometryColumn );
 
-      values += geomParam( offset++ );
+      const QString geometry = geomParam( offset );
+      const QString placeholder = QStringLiteral( "$%1" ).arg( offset );
+      const int pos = geometry.indexOf( placeholder );
+      insertValues << InsertValue { geometry.left( pos ), offset, geometry.mid( pos + placeholder.size() ) };
+      offset++;
 
       delim = ',';
     }
@@ -2354,7 +2407,7 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
           if ( mIdentityFields[idx] == 'a' )
             overrideIdentity = true;
           insert += delim + quotedIdentifier( field( idx ).name() );
-          values += delim + QStringLiteral( "$%1" ).arg( defaultValues.size() + offset );
+          insertValues << InsertValue { QString(), defaultValues.size() + offset, QString() };
           delim = ',';
           fieldId << idx;
           defaultValues << defaultValueClause( idx );
@@ -2411,69 +2464,64 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
 
       if ( i == flist.size() )
       {
+        QString value;
         if ( qgsVariantEqual( v, defVal ) )
         {
           if ( defVal.isNull() )
           {
-            values += delim + "NULL";
+            value = QStringLiteral( "NULL" );
           }
           else
           {
-            values += delim + defVal;
+            value = defVal;
           }
         }
         else if ( fieldTypeName == QLatin1String( "geometry" ) )
         {
-          values += QStringLiteral( "%1%2(%3)" )
-                    .arg( delim,
-                          connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt",
-                          quotedValue( v.toString() ) );
+          value = QStringLiteral( "%1(%2)" )
+                  .arg( connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt",
+                        quotedValue( v.toString() ) );
         }
         else if ( fieldTypeName == QLatin1String( "geography" ) )
         {
-          values += QStringLiteral( "%1st_geographyfromewkt(%2)" )
-                    .arg( delim,
-                          quotedValue( v.toString() ) );
+          value = QStringLiteral( "st_geographyfromewkt(%1)" )
+                  .arg( quotedValue( v.toString() ) );
         }
         else if ( fieldTypeName == QLatin1String( "jsonb" ) )
         {
-          values += delim + quotedJsonValue( v ) + QStringLiteral( "::jsonb" );
+          value = quotedJsonValue( v ) + QStringLiteral( "::jsonb" );
         }
         else if ( fieldTypeName == QLatin1String( "json" ) )
         {
-          values += delim + quotedJsonValue( v ) + QStringLiteral( "::json" );
+          value = quotedJsonValue( v ) + QStringLiteral( "::json" );
         }
         else if ( fieldTypeName == QLatin1String( "bytea" ) )
         {
-          values += delim + quotedByteaValue( v );
+          value = quotedByteaValue( v );
         }
         //TODO: convert arrays and hstore to native types
         else
         {
-          values += delim + quotedValue( v );
+          value = quotedValue( v );
         }
+        insertValues << InsertValue { value, 0, QString() };
       }
       else
       {
         // value is not unique => add parameter
         if ( fieldTypeName == QLatin1String( "geometry" ) )
         {
-          values += QStringLiteral( "%1%2($%3)" )
-                    .arg( delim,
-                          connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt" )
-                    .arg( defaultValues.size() + offset );
+          insertValues << InsertValue { QStringLiteral( "%1(" ).arg( connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt" ),
+                                        defaultValues.size() + offset,
+                                        QStringLiteral( ")" ) };
         }
         else if ( fieldTypeName == QLatin1String( "geography" ) )
         {
-          values += QStringLiteral( "%1st_geographyfromewkt($%2)" )
-                    .arg( delim )
-                    .arg( defaultValues.size() + offset );
+          insertValues << InsertValue { QStringLiteral( "st_geographyfromewkt(" ), defaultValues.size() + offset, QStringLiteral( ")" ) };
         }
         else
         {
-          values += QStringLiteral( "%1$%2" )
-                    .arg( delim )
-                    .arg( defaultValues.size() + offset );
+          insertValues << InsertValue { QString(), defaultValues.size() + offset, QString() };
         }
         defaultValues.append( defVal );
         fieldId.append( idx );
@@ -2482,41 +2530,30 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
       delim = ',';
     }
 
-    insert += QStringLiteral( ") %1VALUES (%2)" ).arg( overrideIdentity ? "OVERRIDING SYSTEM VALUE " : "" ).arg( values );
+    const int paramCount = fieldId.size() + offset - 1;
 
-    if ( !( flags & QgsFeatureSink::FastInsert ) )
+    // renders the values of a row, replacing the parameters by the given SQL
+    auto rowValues = [&insertValues]( const std::function< QString( int param ) > &paramSql )
     {
-      if ( mPrimaryKeyType == PktFidMap || mPrimaryKeyType == PktInt || mPrimaryKeyType == PktInt64 || mPrimaryKeyType == PktUint64 )
+      QStringList values;
+      values.reserve( insertValues.size() );
+      for ( const InsertValue &value : qgis::as_const( insertValues ) )
       {
-        insert += QLatin1String( " RETURNING " );
-
-        QString delim;
-        const auto constMPrimaryKeyAttrs = mPrimaryKeyAttrs;
-        for ( int idx : constMPrimaryKeyAttrs )
-        {
-          insert += delim + quotedIdentifier( mAttributeFields.at( idx ).name() );
-          delim = ',';
-        }
+        values << ( value.param > 0 ? value.prefix + paramSql( value.param ) + value.suffix : value.prefix );
       }
-    }
-
-    QgsDebugMsgLevel( QStringLiteral( "prepare addfeatures: %1" ).arg( insert ), 2 );
-    QgsPostgresResult stmt( conn->PQprepare( QStringLiteral( "addfeatures" ), insert, fieldId.size() + offset - 1, nullptr ) );
-
-    if ( stmt.PQresultStatus() != PGRES_COMMAND_OK )
-      throw PGException( stmt );
+      return values.join( ',' );
+    };
 
-    for ( QgsFeatureList::iterator features = flist.begin(); features != flist.end(); ++features )
+    // returns the parameters of a feature, and sets the values generated by the database in the feature
+    auto featureParams = [&]( QgsFeature & feature, QStringList & params )
     {
-      QgsAttributes attrs = features->attributes();
+      QgsAttributes attrs = feature.attributes();
 
-      QStringList params;
       if ( !mGeometryColumn.isNull() )
       {
-        appendGeomParam( features->geometry(), params );
+        appendGeomParam( feature.geometry(), params );
       }
 
-      params.reserve( fieldId.size() );
       for ( int i = 0; i < fieldId.size(); i++ )
       {
         int attrIdx = fieldId[i];
@@ -2527,7 +2564,7 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
         {
           QgsField fld = field( attrIdx );
           v = paramValue( defaultValues[ i ], defaultValues[ i ] );
-          features->setAttribute( attrIdx, convertValue( fld.type(), fld.subType(), v, fld.typeName() ) );
+          feature.setAttribute( attrIdx, convertValue( fld.type(), fld.subType(), v, fld.typeName() ) );
         }
         else
         {
@@ -2554,31 +2591,210 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
           if ( v != value.toString() )
           {
             QgsField fld = field( attrIdx );
-            features->setAttribute( attrIdx, convertValue( fld.type(), fld.subType(), v, fld.typeName() ) );
+            feature.setAttribute( attrIdx, convertValue( fld.type(), fld.subType(), v, fld.typeName() ) );
           }
         }
 
         params << v;
       }
+    };
 
-      QgsPostgresResult result( conn->PQexecPrepared( QStringLiteral( "addfeatures" ), params ) );
+    const QString overriding = overrideIdentity ? QStringLiteral( "OVERRIDING SYSTEM VALUE " ) : QString();
+    insert += QStringLiteral( ") %1" ).arg( overriding );
 
-      if ( !( flags & QgsFeatureSink::FastInsert ) && result.PQresultStatus() == PGRES_TUPLES_OK )
+    QString returning;
+    if ( !( flags & QgsFeatureSink::FastInsert ) )
+    {
+      if ( mPrimaryKeyType == PktFidMap || mPrimaryKeyType == PktInt || mPrimaryKeyType == PktInt64 || mPrimaryKeyType == PktUint64 )
       {
-        for ( int i = 0; i < mPrimaryKeyAttrs.size(); ++i )
+        returning = QStringLiteral( " RETURNING " );
+
+        QString delim;
+        const auto constMPrimaryKeyAttrs = mPrimaryKeyAttrs;
+        for ( int idx : constMPrimaryKeyAttrs )
         {
-          const int idx = mPrimaryKeyAttrs.at( i );
-          const QgsField fld = mAttributeFields.at( idx );
-          features->setAttribute( idx, convertValue( fld.type(), fld.subType(), result.PQgetvalue( 0, i ), fld.typeName() ) );
+          returning += delim + quotedIdentifier( mAttributeFields.at( idx ).name() );
+          delim = ',';
         }
       }
-      else if ( result.PQresultStatus() != PGRES_COMMAND_OK )
-        throw PGException( result );
+    }
+
+    // prepares a statement inserting rowCount rows
+    auto prepareInsert = [&]( const QString & name, int rowCount )
+    {
+      QStringList rows;
+      rows.reserve( rowCount );
+      for ( int row = 0; row < rowCount; ++row )
+      {
+        rows << QStringLiteral( "(%1)" ).arg( rowValues( [row, paramCount]( int param ) { return QStringLiteral( "$%1" ).arg( row * paramCount + param ); } ) );
+      }
+      const QString sql = insert + QStringLiteral( "VALUES %1%2" ).arg( rows.join( ',' ), returning );
+
+      QgsDebugMsgLevel( QStringLiteral( "prepare %1: %2" ).arg( name, sql ), 2 );
+      QgsPostgresResult stmt( conn->PQprepare( name, sql, rowCount * paramCount, nullptr ) );
+
+      if ( stmt.PQresultStatus() != PGRES_COMMAND_OK )
+        throw PGException( stmt );
+
+      preparedStatements << name;
+    };
+
+    bool copied = false;
+    if ( ( flags & QgsFeatureSink::FastInsert ) && paramCount > 0 && flist.size() > 1 )
+    {
+      // No key needs to be returned: stream the parameters with COPY to a temporary
+      // table typed like the parameters of the INSERT statement, then insert all the
+      // rows at once with the same value expressions.
+      prepareInsert( QStringLiteral( "addfeatures_copy" ), 1 );
+
+      QgsPostgresResult types( conn->PQexec( QStringLiteral( "SELECT t::text FROM pg_prepared_statements, unnest(parameter_types) WITH ORDINALITY u(t,n) WHERE name='addfeatures_copy' ORDER BY n" ) ) );
+      if ( types.PQresultStatus() != PGRES_TUPLES_OK )
+        throw PGException( types );
+      if ( types.PQntuples() != paramCount )
+        throw PGException( tr( "Unexpected number of parameter types: %1 instead of %2" ).arg( types.PQntuples() ).arg( paramCount ) );
+
+      QStringList columns;
+      for ( int i = 0; i < paramCount; ++i )
+      {
+        columns << QStringLiteral( "p%1 %2" ).arg( i + 1 ).arg( types.PQgetvalue( i, 0 ) );
+      }
+
+      const QString stagingTable = QStringLiteral( "pg_temp.qgis_addfeatures" );
+
+      // sends the rows of the buffer with a COPY command
+      auto copyRows = [conn, &stagingTable]( const QByteArray & rows )
+      {
+        QgsPostgresResult copy( conn->PQexec( QStringLiteral( "COPY %1 FROM STDIN" ).arg( stagingTable ), false ) );
+        if ( copy.PQresultStatus() != PGRES_COPY_IN )
+          throw PGException( copy );
+
+        if ( conn->PQputCopyData( rows ) != 1 || conn->PQputCopyEnd() != 1 )
+          throw PGException( conn->PQerrorMessage() );
+
+        QgsPostgresResult copied( conn->PQgetResult() );
+        // consume the remaining results, the connection is ready for the next command afterwards
+        while ( QgsPostgresResult( conn->PQgetResult() ).result() )
+          ;
+        if ( copied.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( copied );
+      };
+
+      auto execSavepointCommand = [conn]( const QString & sql )
+      {
+        QgsPostgresResult result( conn->PQexec( sql ) );
+        if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( result );
+      };
+
+      // The staging table cannot be created by roles without the TEMPORARY privilege,
+      // so the rows are inserted with INSERT statements if staging them fails
+      execSavepointCommand( QStringLiteral( "SAVEPOINT qgis_addfeatures_copy" ) );
+
+      try
+      {
+        QgsPostgresResult create( conn->PQexec( QStringLiteral( "CREATE TEMPORARY TABLE qgis_addfeatures (%1) ON COMMIT DROP" ).arg( columns.join( ',' ) ), false ) );
+        if ( create.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( create );
+
+        // The default values may be queried while computing the parameters (on the
+        // same connection in transactions), so the rows are buffered and sent by chunks
+        const int copyBufferSize = 1 << 20;
+        QByteArray buffer;
+        buffer.reserve( copyBufferSize + copyBufferSize / 4 );
+        QStringList params;
+        for ( QgsFeatureList::iterator features = flist.begin(); features != flist.end(); ++features )
+        {
+          params.clear();
+          featureParams( *features, params );
+          for ( int i = 0; i < params.size(); ++i )
+          {
+            if ( i > 0 )
+              buffer.append( '\t' );
+            appendCopyValue( params.at( i ), buffer );
+          }
+          buffer.append( '\n' );
+
+          if ( buffer.size() >= copyBufferSize )
+          {
+            copyRows( buffer );
+            buffer.clear();
+          }
+        }
+
+        if ( !buffer.isEmpty() )
+          copyRows( buffer );
 
-      if ( !( flags & QgsFeatureSink::FastInsert ) && mPrimaryKeyType == PktOid )
+        copied = true;
+      }
+      catch ( PGException &e )
       {
-        features->setId( result.PQoidValue() );
-        QgsDebugMsgLevel( QStringLiteral( "new fid=%1" ).arg( features->id() ), 4 );
+        QgsMessageLog::logMessage( tr( "Could not stage the new features with COPY, inserting them with INSERT statements: %1" ).arg( e.errorMessage() ), tr( "PostGIS" ) );
+        execSavepointCommand( QStringLiteral( "ROLLBACK TO SAVEPOINT qgis_addfeatures_copy" ) );
+      }
+
+      if ( copied )
+      {
+        const QString sql = insert + QStringLiteral( "SELECT %1 FROM %2" )
+                            .arg( rowValues( []( int param ) { return QStringLiteral( "p%1" ).arg( param ); } ), stagingTable );
+        QgsPostgresResult result( conn->PQexec( sql ) );
+        if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( result );
+
+        QgsPostgresResult drop( conn->PQexec( QStringLiteral( "DROP TABLE %1" ).arg( stagingTable ) ) );
+        if ( drop.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( drop );
+      }
+
+      execSavepointCommand( QStringLiteral( "RELEASE SAVEPOINT qgis_addfeatures_copy" ) );
+    }
+
+    if ( !copied )
+    {
+      // Insert the features by batches of multi-row INSERT statements when no key
+      // is returned. The order of the rows returned by a multi-row statement is not
+      // guaranteed to match the order of its VALUES, so the features whose keys are
+      // needed are inserted by single row statements.
+      const bool returnsOid = !( flags & QgsFeatureSink::FastInsert ) && mPrimaryKeyType == PktOid;
+      const int maxParams = std::numeric_limits<quint16>::max();
+      const int batchSize = returnsOid || !returning.isEmpty() ? 1 : std::min( { ADD_FEATURES_BATCH_SIZE, maxParams / std::max( paramCount, 1 ), flist.size() } );
+      const int tailSize = flist.size() % batchSize;
+
+      prepareInsert( QStringLiteral( "addfeatures" ), batchSize );
+      if ( tailSize > 0 )
+        prepareInsert( QStringLiteral( "addfeatures_tail" ), tailSize );
+
+      QStringList params;
+      for ( int batchStart = 0; batchStart < flist.size(); batchStart += batchSize )
+      {
+        const int rowCount = std::min( batchSize, flist.size() - batchStart );
+
+        params.clear();
+        params.reserve( rowCount * paramCount );
+        for ( int row = 0; row < rowCount; ++row )
+        {
+          featureParams( flist[ batchStart + row ], params );
+        }
+
+        QgsPostgresResult result( conn->PQexecPrepared( rowCount == batchSize ? QStringLiteral( "addfeatures" ) : QStringLiteral( "addfeatures_tail" ), params ) );
+
+        if ( !( flags & QgsFeatureSink::FastInsert ) && result.PQresultStatus() == PGRES_TUPLES_OK )
+        {
+          QgsFeature &feature = flist[ batchStart ];
+          for ( int i = 0; i < mPrimaryKeyAttrs.size(); ++i )
+          {
+            const int idx = mPrimaryKeyAttrs.at( i );
+            const QgsField fld = mAttributeFields.at( idx );
+            feature.setAttribute( idx, convertValue( fld.type(), fld.subType(), result.PQgetvalue( 0, i ), fld.typeName() ) );
+          }
+        }
+        else if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( result );
+
+        if ( returnsOid )
+        {
+          flist[ batchStart ].setId( result.PQoidValue() );
+          QgsDebugMsgLevel( QStringLiteral( "new fid=%1" ).arg( flist[ batchStart ].id() ), 4 );
+        }
       }
     }
 
@@ -2612,7 +2828,9 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
       }
     }
 
-    conn->PQexecNR( QStringLiteral( "DEALLOCATE addfeatures" ) );
+    for ( const QString &name : qgis::as_const( preparedStatements ) )
+      conn->PQexecNR( QStringLiteral( "DEALLOCATE %1" ).arg( name ) );
+    preparedStatements.clear();
 
     returnvalue &= conn->commit();
     if ( mTransaction )
@@ -2624,7 +2842,8 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   {
     pushError( tr( "PostGIS error while adding features: %1" ).arg( e.errorMessage() ) );
     conn->rollback();
-    conn->PQexecNR( QStringLiteral( "DEALLOCATE addfeatures" ) );
+    for ( const QString &name : qgis::as_const( preparedStatements ) )
+      conn->PQexecNR( QStringLiteral( "DEALLOCATE %1" ).arg( name ) );
     returnvalue = false;
   }
 
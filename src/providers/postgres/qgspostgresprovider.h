@@ -450,6 +450,10 @@ class QgsPostgresProvider final: public QgsVectorDataProvider
           : mWhat( r.PQresultErrorMessage() )
         {}
 
+        explicit PGException( const QString &errorMessage )
+          : mWhat( errorMessage )
+        {}
+
         QString errorMessage() const
         {
           return mWhat;
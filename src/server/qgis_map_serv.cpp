@@ -74,6 +74,9 @@ int main( int argc, char *argv[] )
 #endif
 
   // Starts FCGI loop
+  // Requests are handled one at a time: QgsServer relies on QgsProject::instance(), on the
+  // server interface and on the Python plugins, none of which are thread safe. Run several
+  // processes (e.g. with the process manager of the web server) to use all the cores.
   while ( fcgi_accept() >= 0 )
   {
     QgsFcgiServerRequest  request;
@@ -20,6 +20,7 @@
 #include "qgsserverexception.h"
 #include "qgsstorebadlayerinfo.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverimagecache.h"
 
 #include <QFile>
 
@@ -167,6 +168,9 @@ void QgsConfigCache::removeChangedEntry( const QString &path )
   mXmlDocumentCache.remove( path );
 
   mFileSystemWatcher.removePath( path );
+
+  // cached images rendered from the previous project are now stale
+  QgsServerImageCache::instance()->removeProject( path );
 }
 
 
@@ -39,6 +39,7 @@
 #include "qgsserverparameters.h"
 #include "qgsapplication.h"
 #include "qgsruntimeprofiler.h"
+#include "qgsserverimagecache.h"
 
 #include <QDomDocument>
 #include <QNetworkDiskCache>
@@ -223,6 +224,13 @@ bool QgsServer::init()
   sSettings()->logSummary();
 
   setupNetworkAccessManager();
+
+  // Configure native image cache
+  QgsServerImageCache::instance()->setMaximumMemorySize( sSettings()->imageCacheSize() );
+  QgsServerImageCache::instance()->setMaximumDirectorySize( sSettings()->imageCacheDirectorySize() );
+  QgsServerImageCache::instance()->setMaximumAge( sSettings()->imageCacheMaximumAge() );
+  QgsServerImageCache::instance()->setDirectory( sSettings()->imageCacheDirectory() );
+
   QDomImplementation::setInvalidDataPolicy( QDomImplementation::DropInvalidChars );
 
   // Instantiate the plugin directory so that providers are loaded
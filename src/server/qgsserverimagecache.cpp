@@ -0,0 +1,376 @@
+/***************************************************************************
+                          qgsserverimagecache.cpp
+                          -----------------------
+  Native cache for images rendered by the server (tiles, maps)
+
+  begin                : 2020-10-17
+  copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsconfig.h"
+#include "qgsserverimagecache.h"
+#include "qgsserverrequest.h"
+#include "qgsserverinterface.h"
+#include "qgsproject.h"
+#include "qgsmessagelog.h"
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsaccesscontrol.h"
+#endif
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <limits>
+
+//! Name of the file marking the project directories created by the cache
+static const QString PROJECT_DIRECTORY_MARKER = QStringLiteral( ".qgis_server_image_cache" );
+
+//! Percentage of its maximum size the file store is reduced to when it is full
+static const int EVICTION_TARGET_PERCENT = 90;
+
+QgsServerImageCache *QgsServerImageCache::instance()
+{
+  static QgsServerImageCache *sInstance = nullptr;
+
+  if ( !sInstance )
+    sInstance = new QgsServerImageCache();
+
+  return sInstance;
+}
+
+QgsServerImageCache::QgsServerImageCache()
+{
+  mMemoryCache.setMaxCost( 0 );
+}
+
+void QgsServerImageCache::setMaximumMemorySize( qint64 size )
+{
+  QMutexLocker locker( &mMutex );
+  // QCache costs are int, store them in KiB
+  mMemoryCache.setMaxCost( static_cast< int >( qBound( static_cast< qint64 >( 0 ), size / 1024, static_cast< qint64 >( std::numeric_limits<int>::max() ) ) ) );
+}
+
+qint64 QgsServerImageCache::maximumMemorySize() const
+{
+  QMutexLocker locker( &mMutex );
+  return static_cast< qint64 >( mMemoryCache.maxCost() ) * 1024;
+}
+
+void QgsServerImageCache::setDirectory( const QString &directory )
+{
+  QMutexLocker locker( &mMutex );
+  mDirectory = directory;
+  if ( !mDirectory.isEmpty() && !QDir().mkpath( mDirectory ) )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Unable to create image cache directory '%1', file store is disabled" ).arg( mDirectory ), QStringLiteral( "Server" ), Qgis::Warning );
+    mDirectory.clear();
+  }
+
+  if ( !mDirectory.isEmpty() )
+    evictFiles();
+  else
+    mDirectorySize = 0;
+}
+
+QString QgsServerImageCache::directory() const
+{
+  QMutexLocker locker( &mMutex );
+  return mDirectory;
+}
+
+void QgsServerImageCache::setMaximumDirectorySize( qint64 size )
+{
+  QMutexLocker locker( &mMutex );
+  mMaximumDirectorySize = std::max( static_cast< qint64 >( 0 ), size );
+  if ( !mDirectory.isEmpty() && mMaximumDirectorySize > 0 && mDirectorySize > mMaximumDirectorySize )
+    evictFiles();
+}
+
+qint64 QgsServerImageCache::maximumDirectorySize() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMaximumDirectorySize;
+}
+
+void QgsServerImageCache::setMaximumAge( int age )
+{
+  QMutexLocker locker( &mMutex );
+  mMaximumAge = std::max( 0, age );
+}
+
+int QgsServerImageCache::maximumAge() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMaximumAge;
+}
+
+bool QgsServerImageCache::isEnabled() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMemoryCache.maxCost() > 0 || !mDirectory.isEmpty();
+}
+
+QByteArray QgsServerImageCache::image( const QgsProject *project, const QgsServerRequest &request, const QString &accessKey )
+{
+  if ( !project || !isEnabled() )
+    return QByteArray();
+
+  const QString key = imageKey( project, request, accessKey );
+
+  QMutexLocker locker( &mMutex );
+  if ( const MemoryImage *memoryImage = mMemoryCache.object( key ) )
+  {
+    if ( !isExpired( memoryImage->time ) )
+      return memoryImage->content;
+
+    mMemoryCache.remove( key );
+  }
+
+  if ( mDirectory.isEmpty() )
+    return QByteArray();
+
+  QFile file( imageFilePath( key ) );
+  const QFileInfo fileInfo( file );
+  if ( fileInfo.exists() && isExpired( fileInfo.lastModified() ) )
+  {
+    mDirectorySize -= fileInfo.size();
+    file.remove();
+    return QByteArray();
+  }
+
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return QByteArray();
+
+  const QByteArray content = file.readAll();
+  if ( !content.isEmpty() && mMemoryCache.maxCost() > 0 )
+  {
+    // promote to the memory cache, keeping the age of the file
+    mMemoryCache.insert( key, new MemoryImage{ content, fileInfo.lastModified() }, std::max( 1, content.size() / 1024 ) );
+  }
+  return content;
+}
+
+bool QgsServerImageCache::setImage( const QByteArray &image, const QgsProject *project, const QgsServerRequest &request, const QString &accessKey )
+{
+  if ( !project || image.isEmpty() || !isEnabled() )
+    return false;
+
+  const QString key = imageKey( project, request, accessKey );
+
+  QMutexLocker locker( &mMutex );
+  bool cached = false;
+  if ( mMemoryCache.maxCost() > 0 )
+  {
+    cached = mMemoryCache.insert( key, new MemoryImage{ image, QDateTime::currentDateTime() }, std::max( 1, image.size() / 1024 ) );
+  }
+
+  if ( !mDirectory.isEmpty() )
+  {
+    const QString projectDirectory = mDirectory + '/' + key.section( '/', 0, 0 );
+    if ( !isProjectDirectory( projectDirectory ) )
+    {
+      // mark the directory, so that clearing the cache never removes other directories
+      QDir().mkpath( projectDirectory );
+      QFile marker( projectDirectory + '/' + PROJECT_DIRECTORY_MARKER );
+      marker.open( QIODevice::WriteOnly );
+    }
+
+    const QString filePath = imageFilePath( key );
+    const QFileInfo previousFile( filePath );
+    const qint64 previousSize = previousFile.exists() ? previousFile.size() : 0;
+    QDir().mkpath( previousFile.absolutePath() );
+
+    // write to a temporary file first, so that concurrent readers never
+    // see a partial image
+    QSaveFile file( filePath );
+    if ( file.open( QIODevice::WriteOnly ) && file.write( image ) == image.size() && file.commit() )
+    {
+      cached = true;
+      mDirectorySize += image.size() - previousSize;
+
+      // other server processes may share the store, the eviction rescans it
+      if ( ( mMaximumDirectorySize > 0 && mDirectorySize > mMaximumDirectorySize )
+           || ( mMaximumAge > 0 && mLastEviction.secsTo( QDateTime::currentDateTime() ) > mMaximumAge ) )
+      {
+        evictFiles();
+      }
+    }
+    else
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Unable to write cached image '%1'" ).arg( filePath ), QStringLiteral( "Server" ), Qgis::Warning );
+    }
+  }
+  return cached;
+}
+
+void QgsServerImageCache::removeProject( const QString &path )
+{
+  const QString prefix = projectHash( path ) + '/';
+
+  QMutexLocker locker( &mMutex );
+  const QList<QString> keys = mMemoryCache.keys();
+  for ( const QString &key : keys )
+  {
+    if ( key.startsWith( prefix ) )
+      mMemoryCache.remove( key );
+  }
+
+  if ( !mDirectory.isEmpty() )
+  {
+    const QString projectDirectory = mDirectory + '/' + projectHash( path );
+    if ( isProjectDirectory( projectDirectory ) )
+    {
+      QDir( projectDirectory ).removeRecursively();
+      evictFiles();
+    }
+  }
+}
+
+void QgsServerImageCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mMemoryCache.clear();
+
+  if ( !mDirectory.isEmpty() )
+  {
+    // the directory may be shared with other content, only remove the directories of the cache
+    const QStringList projectDirs = QDir( mDirectory ).entryList( QDir::Dirs | QDir::NoDotAndDotDot );
+    for ( const QString &projectDir : projectDirs )
+    {
+      const QString projectDirectory = mDirectory + '/' + projectDir;
+      if ( isProjectDirectory( projectDirectory ) )
+        QDir( projectDirectory ).removeRecursively();
+    }
+    mDirectorySize = 0;
+  }
+}
+
+bool QgsServerImageCache::accessControlKey( QgsServerInterface *serverIface, QString &accessKey )
+{
+  accessKey.clear();
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  if ( serverIface && serverIface->accessControls() )
+  {
+    QStringList keys;
+    if ( !serverIface->accessControls()->fillCacheKey( keys ) )
+      return false;
+    accessKey = keys.join( '-' );
+  }
+#else
+  Q_UNUSED( serverIface )
+#endif
+  return true;
+}
+
+QString QgsServerImageCache::projectHash( const QString &path )
+{
+  return QString::fromLatin1( QCryptographicHash::hash( path.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+}
+
+QString QgsServerImageCache::imageKey( const QgsProject *project, const QgsServerRequest &request, const QString &accessKey )
+{
+  // parameters map is sorted by (upper case) names, which
+  // normalizes the parameters order
+  QByteArray normalized;
+  normalized.append( QByteArray::number( project->lastModified().toMSecsSinceEpoch() ) );
+  const QMap<QString, QString> parameters = request.parameters();
+  for ( auto it = parameters.constBegin(); it != parameters.constEnd(); ++it )
+  {
+    normalized.append( '&' );
+    normalized.append( it.key().toUtf8() );
+    normalized.append( '=' );
+    normalized.append( it.value().toUtf8() );
+  }
+  normalized.append( '#' );
+  normalized.append( accessKey.toUtf8() );
+
+  const QString hash = QString::fromLatin1( QCryptographicHash::hash( normalized, QCryptographicHash::Sha1 ).toHex() );
+  return projectHash( project->fileName() ) + '/' + hash;
+}
+
+QString QgsServerImageCache::imageFilePath( const QString &key ) const
+{
+  // key is <project hash>/<request hash>, shard the request hashes
+  // in two levels of sub directories to keep directories small
+  const QString requestHash = key.section( '/', 1 );
+  return QStringLiteral( "%1/%2/%3/%4/%5" ).arg( mDirectory,
+         key.section( '/', 0, 0 ),
+         requestHash.left( 2 ),
+         requestHash.mid( 2, 2 ),
+         requestHash );
+}
+
+bool QgsServerImageCache::isProjectDirectory( const QString &path )
+{
+  return QFileInfo::exists( path + '/' + PROJECT_DIRECTORY_MARKER );
+}
+
+bool QgsServerImageCache::isExpired( const QDateTime &time ) const
+{
+  return mMaximumAge > 0 && time.secsTo( QDateTime::currentDateTime() ) > mMaximumAge;
+}
+
+void QgsServerImageCache::evictFiles()
+{
+  mLastEviction = QDateTime::currentDateTime();
+
+  QList< QFileInfo > files;
+  qint64 size = 0;
+  const QStringList projectDirs = QDir( mDirectory ).entryList( QDir::Dirs | QDir::NoDotAndDotDot );
+  for ( const QString &projectDir : projectDirs )
+  {
+    const QString projectDirectory = mDirectory + '/' + projectDir;
+    if ( !isProjectDirectory( projectDirectory ) )
+      continue;
+
+    // the marker is a hidden file, which is not listed
+    QDirIterator it( projectDirectory, QDir::Files, QDirIterator::Subdirectories );
+    while ( it.hasNext() )
+    {
+      it.next();
+      const QFileInfo fileInfo = it.fileInfo();
+      if ( isExpired( fileInfo.lastModified() ) )
+      {
+        QFile::remove( fileInfo.absoluteFilePath() );
+        continue;
+      }
+      files << fileInfo;
+      size += fileInfo.size();
+    }
+  }
+
+  if ( mMaximumDirectorySize > 0 && size > mMaximumDirectorySize )
+  {
+    std::sort( files.begin(), files.end(), []( const QFileInfo & a, const QFileInfo & b )
+    {
+      return a.lastModified() < b.lastModified();
+    } );
+
+    const qint64 targetSize = mMaximumDirectorySize * EVICTION_TARGET_PERCENT / 100;
+    for ( const QFileInfo &fileInfo : qgis::as_const( files ) )
+    {
+      if ( size <= targetSize )
+        break;
+
+      if ( QFile::remove( fileInfo.absoluteFilePath() ) )
+        size -= fileInfo.size();
+    }
+  }
+
+  mDirectorySize = size;
+}
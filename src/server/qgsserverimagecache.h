@@ -0,0 +1,202 @@
+/***************************************************************************
+                          qgsserverimagecache.h
+                          ---------------------
+  Native cache for images rendered by the server (tiles, maps)
+
+  begin                : 2020-10-17
+  copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERIMAGECACHE_H
+#define QGSSERVERIMAGECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QMutex>
+#include <QString>
+
+#include "qgis_server.h"
+#include "qgis_sip.h"
+
+class QgsProject;
+class QgsServerInterface;
+class QgsServerRequest;
+
+/**
+ * \ingroup server
+ * \class QgsServerImageCache
+ * \brief Native cache for encoded images rendered by the server, like WMTS
+ * tiles or tiled WMS GetMap responses.
+ *
+ * Images are stored in a size-bounded least recently used memory cache and,
+ * if a directory is set, in a file store sharded by key. The file store can be
+ * bounded by size, evicting the oldest images first, and images older than a
+ * maximum age are never served. Keys are built from
+ * the project path and last modification time, the normalized request
+ * parameters and the access control cache key, so that a reloaded project
+ * never serves stale images.
+ *
+ * Entries of a project are removed when the project is removed from the
+ * QgsConfigCache.
+ *
+ * The cache is disabled until a memory size or a directory is set.
+ *
+ * \since QGIS 3.18
+ */
+class SERVER_EXPORT QgsServerImageCache
+{
+  public:
+
+    /**
+     * Returns the current instance.
+     */
+    static QgsServerImageCache *instance();
+
+    /**
+     * Sets the maximum \a size in bytes of the memory cache. A size
+     * of 0 disables the memory cache.
+     * \see maximumMemorySize()
+     */
+    void setMaximumMemorySize( qint64 size );
+
+    /**
+     * Returns the maximum size in bytes of the memory cache.
+     * \see setMaximumMemorySize()
+     */
+    qint64 maximumMemorySize() const;
+
+    /**
+     * Sets the \a directory of the file store. An empty directory
+     * disables the file store.
+     * \see directory()
+     */
+    void setDirectory( const QString &directory );
+
+    /**
+     * Returns the directory of the file store.
+     * \see setDirectory()
+     */
+    QString directory() const;
+
+    /**
+     * Sets the maximum \a size in bytes of the file store. When the store grows
+     * beyond this size, the oldest images are removed. A size of 0 leaves the
+     * file store unbounded.
+     * \see maximumDirectorySize()
+     */
+    void setMaximumDirectorySize( qint64 size );
+
+    /**
+     * Returns the maximum size in bytes of the file store.
+     * \see setMaximumDirectorySize()
+     */
+    qint64 maximumDirectorySize() const;
+
+    /**
+     * Sets the maximum \a age in seconds of the cached images. Older images are
+     * removed instead of being served. An age of 0 keeps images until they are
+     * evicted or their project is reloaded.
+     * \see maximumAge()
+     */
+    void setMaximumAge( int age );
+
+    /**
+     * Returns the maximum age in seconds of the cached images.
+     * \see setMaximumAge()
+     */
+    int maximumAge() const;
+
+    /**
+     * Returns TRUE if either the memory cache or the file store is enabled.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Returns the cached image for a \a request on a \a project, or an
+     * empty array if the image is not in the cache.
+     * \param project the project used to render the image
+     * \param request the request used to render the image
+     * \param accessKey the access control key identifying different images for the same request
+     */
+    QByteArray image( const QgsProject *project, const QgsServerRequest &request, const QString &accessKey = QString() );
+
+    /**
+     * Inserts an encoded \a image in the cache for a \a request on a \a project.
+     * \param image the encoded image
+     * \param project the project used to render the image
+     * \param request the request used to render the image
+     * \param accessKey the access control key identifying different images for the same request
+     * \returns TRUE if the image has been cached
+     */
+    bool setImage( const QByteArray &image, const QgsProject *project, const QgsServerRequest &request, const QString &accessKey = QString() );
+
+    /**
+     * Removes all the cached images of the project stored at \a path.
+     */
+    void removeProject( const QString &path );
+
+    /**
+     * Removes all the cached images. Only the directories created by the cache
+     * are removed from the file store.
+     */
+    void clear();
+
+    /**
+     * Returns the access control cache key of the server interface
+     * in \a accessKey.
+     * \returns FALSE if the access control plugins forbid caching
+     */
+    static bool accessControlKey( QgsServerInterface *serverIface, QString &accessKey ) SIP_SKIP;
+
+  private:
+    QgsServerImageCache() SIP_FORCE;
+
+    //! Returns the directory name used for a project path
+    static QString projectHash( const QString &path );
+
+    //! Returns the key of an image
+    static QString imageKey( const QgsProject *project, const QgsServerRequest &request, const QString &accessKey );
+
+    //! Returns the file path of an image in the file store
+    QString imageFilePath( const QString &key ) const;
+
+    //! Returns TRUE if \a path is a project directory created by the cache
+    static bool isProjectDirectory( const QString &path );
+
+    //! Returns TRUE if an image written at \a time is older than the maximum age
+    bool isExpired( const QDateTime &time ) const;
+
+    /**
+     * Removes the expired images from the file store, then the oldest images
+     * while the store is larger than its maximum size, and updates its size.
+     */
+    void evictFiles();
+
+    struct MemoryImage
+    {
+      QByteArray content;
+      QDateTime time;
+    };
+
+    mutable QMutex mMutex;
+    //! Memory cache, costs are in KiB
+    QCache<QString, MemoryImage> mMemoryCache;
+    QString mDirectory;
+    qint64 mMaximumDirectorySize = 0;
+    int mMaximumAge = 0;
+    //! Size of the file store, as of the last eviction and the writes since
+    qint64 mDirectorySize = 0;
+    QDateTime mLastEviction;
+};
+
+#endif // QGSSERVERIMAGECACHE_H
@@ -64,6 +64,61 @@ void QgsServerSettings::initSettings()
                               };
   mSettings[ sMaxThreads.envVar ] = sMaxThreads;
 
+  // image cache size
+  const Setting sImageCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_SIZE,
+                                    QgsServerSettingsEnv::DEFAULT_VALUE,
+                                    QStringLiteral( "Maximum size in bytes of the memory cache for WMTS tiles and tiled WMS maps" ),
+                                    QStringLiteral( "/cache/image_cache_size" ),
+                                    QVariant::LongLong,
+                                    QVariant( 0 ),
+                                    QVariant()
+                                  };
+  mSettings[ sImageCacheSize.envVar ] = sImageCacheSize;
+
+  // image cache directory
+  const Setting sImageCacheDirectory = { QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_DIRECTORY,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         QStringLiteral( "Directory of the file store for WMTS tiles and tiled WMS maps" ),
+                                         QStringLiteral( "/cache/image_cache_directory" ),
+                                         QVariant::String,
+                                         QVariant( "" ),
+                                         QVariant()
+                                       };
+  mSettings[ sImageCacheDirectory.envVar ] = sImageCacheDirectory;
+
+  // image cache directory size
+  const Setting sImageCacheDirectorySize = { QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_DIRECTORY_SIZE,
+                                             QgsServerSettingsEnv::DEFAULT_VALUE,
+                                             QStringLiteral( "Maximum size in bytes of the file store for WMTS tiles and tiled WMS maps" ),
+                                             QStringLiteral( "/cache/image_cache_directory_size" ),
+                                             QVariant::LongLong,
+                                             QVariant( 0 ),
+                                             QVariant()
+                                           };
+  mSettings[ sImageCacheDirectorySize.envVar ] = sImageCacheDirectorySize;
+
+  // image cache maximum age
+  const Setting sImageCacheMaxAge = { QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_MAX_AGE,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Maximum age in seconds of the cached WMTS tiles and tiled WMS maps" ),
+                                      QStringLiteral( "/cache/image_cache_max_age" ),
+                                      QVariant::Int,
+                                      QVariant( 0 ),
+                                      QVariant()
+                                    };
+  mSettings[ sImageCacheMaxAge.envVar ] = sImageCacheMaxAge;
+
+  // wmts metatile size
+  const Setting sWmtsMetatileSize = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_SIZE,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Number of tiles per side of the metatiles rendered for WMTS GetTile requests" ),
+                                      QStringLiteral( "/qgis/wmts_metatile_size" ),
+                                      QVariant::Int,
+                                      QVariant( 1 ),
+                                      QVariant()
+                                    };
+  mSettings[ sWmtsMetatileSize.envVar ] = sWmtsMetatileSize;
+
   // log level
   const Setting sLogLevel = { QgsServerSettingsEnv::QGIS_SERVER_LOG_LEVEL,
                               QgsServerSettingsEnv::DEFAULT_VALUE,
@@ -457,6 +512,31 @@ QString QgsServerSettings::cacheDirectory() const
   return value( QgsServerSettingsEnv::QGIS_SERVER_CACHE_DIRECTORY ).toString();
 }
 
+qint64 QgsServerSettings::imageCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_SIZE ).toLongLong();
+}
+
+QString QgsServerSettings::imageCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_DIRECTORY ).toString();
+}
+
+qint64 QgsServerSettings::imageCacheDirectorySize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_DIRECTORY_SIZE ).toLongLong();
+}
+
+int QgsServerSettings::imageCacheMaximumAge() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_MAX_AGE ).toInt();
+}
+
+int QgsServerSettings::wmtsMetatileSize() const
+{
+  return qMax( 1, value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_SIZE ).toInt() );
+}
+
 QString QgsServerSettings::overrideSystemLocale() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_OVERRIDE_SYSTEM_LOCALE ).toString();
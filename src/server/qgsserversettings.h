@@ -71,6 +71,11 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_SERVER_LANDING_PAGE_PROJECTS_DIRECTORIES, //!< Directories used by the landing page service to find .qgs and .qgz projects (since QGIS 3.16)
       QGIS_SERVER_LANDING_PAGE_PROJECTS_PG_CONNECTIONS, //!< PostgreSQL connection strings used by the landing page service to find projects (since QGIS 3.16)
       QGIS_SERVER_LOG_PROFILE, //!< When QGIS_SERVER_LOG_LEVEL is 0 this flag adds to the logs detailed information about the time taken by the different processing steps inside the QGIS Server request (since QGIS 3.16)
+      QGIS_SERVER_IMAGE_CACHE_SIZE, //!< Maximum size in bytes of the native memory cache for WMTS tiles and tiled WMS maps, defaults to 0 (disabled) (since QGIS 3.18)
+      QGIS_SERVER_IMAGE_CACHE_DIRECTORY, //!< Directory of the native file store for WMTS tiles and tiled WMS maps, defaults to empty (disabled) (since QGIS 3.18)
+      QGIS_SERVER_WMTS_METATILE_SIZE, //!< Number of tiles per side of the metatiles rendered for WMTS GetTile requests, defaults to 1 (disabled) (since QGIS 3.18)
+      QGIS_SERVER_IMAGE_CACHE_DIRECTORY_SIZE, //!< Maximum size in bytes of the native file store for WMTS tiles and tiled WMS maps, defaults to 0 (unbounded) (since QGIS 3.18)
+      QGIS_SERVER_IMAGE_CACHE_MAX_AGE, //!< Maximum age in seconds of the images of the native cache for WMTS tiles and tiled WMS maps, defaults to 0 (no expiry) (since QGIS 3.18)
     };
     Q_ENUM( EnvVar )
 };
@@ -180,6 +185,55 @@ class SERVER_EXPORT QgsServerSettings
      */
     QString cacheDirectory() const;
 
+    /**
+     * Returns the maximum size in bytes of the native memory cache for
+     * WMTS tiles and tiled WMS maps.
+     * \returns the cache size, 0 if the memory cache is disabled.
+     * \since QGIS 3.18
+     */
+    qint64 imageCacheSize() const;
+
+    /**
+     * Returns the directory of the native file store for WMTS tiles
+     * and tiled WMS maps.
+     * \returns the directory, or an empty string if the file store is disabled.
+     * \since QGIS 3.18
+     */
+    QString imageCacheDirectory() const;
+
+    /**
+     * Returns the maximum size in bytes of the native file store for
+     * WMTS tiles and tiled WMS maps. The oldest images are removed when
+     * the store grows beyond this size.
+     * \returns the store size, 0 if the file store is unbounded.
+     * \see imageCacheDirectory()
+     * \since QGIS 3.18
+     */
+    qint64 imageCacheDirectorySize() const;
+
+    /**
+     * Returns the maximum age in seconds of the images of the native
+     * cache for WMTS tiles and tiled WMS maps.
+     * \returns the maximum age, 0 if images do not expire.
+     * \since QGIS 3.18
+     */
+    int imageCacheMaximumAge() const;
+
+    /**
+     * Returns the number of tiles per side of the metatiles rendered for
+     * WMTS GetTile requests.
+     *
+     * With a size greater than 1, a GetTile request renders the whole block
+     * of size x size neighbouring tiles in a single map job and stores the
+     * sliced tiles in the native image cache. Metatiling requires the image
+     * cache to be enabled.
+     *
+     * \returns the metatile size, 1 if metatiling is disabled.
+     * \see imageCacheSize()
+     * \since QGIS 3.18
+     */
+    int wmtsMetatileSize() const;
+
     /**
      * Overrides system locale
      * \returns the optional override for system locale.
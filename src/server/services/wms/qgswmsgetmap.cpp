@@ -22,18 +22,36 @@
 #include "qgswmsgetmap.h"
 #include "qgswmsrenderer.h"
 #include "qgswmsserviceexception.h"
+#include "qgsserverimagecache.h"
 
 #include <QImage>
 
 namespace QgsWms
 {
-
   void writeGetMap( QgsServerInterface *serverIface, const QgsProject *project,
                     const QString &, const QgsServerRequest &request,
                     QgsServerResponse &response )
   {
     // get wms parameters from query
     const QgsWmsParameters parameters( QUrlQuery( request.url() ) );
+    const QString format = request.parameters().value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
+
+    // tiled requests (including WMTS GetTile) are served from the native image cache
+    QgsServerImageCache *imageCache = QgsServerImageCache::instance();
+    QString accessKey;
+    const bool useImageCache = parameters.tiledAsBool()
+                               && imageCache->isEnabled()
+                               && QgsServerImageCache::accessControlKey( serverIface, accessKey );
+    if ( useImageCache )
+    {
+      const QByteArray content = imageCache->image( project, request, accessKey );
+      if ( !content.isEmpty() )
+      {
+        response.setHeader( QStringLiteral( "Content-Type" ), imageContentType( parseImageFormat( format ) ) );
+        response.write( content );
+        return;
+      }
+    }
 
     // prepare render context
     QgsWmsRenderContext context( project, serverIface );
@@ -53,8 +71,12 @@ namespace QgsWms
 
     if ( result )
     {
-      const QString format = request.parameters().value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
       writeImage( response, *result, format, context.imageQuality() );
+
+      if ( useImageCache )
+      {
+        imageCache->setImage( response.data(), project, request, accessKey );
+      }
     }
     else
     {
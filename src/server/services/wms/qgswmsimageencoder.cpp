@@ -0,0 +1,130 @@
+/***************************************************************************
+                              qgswmsimageencoder.cpp
+                              -------------------------
+  begin                : 2020-10-17
+  copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QImage>
+#include <QIODevice>
+#include <QRegularExpression>
+
+#include "qgswmsimageencoder.h"
+#include "qgsmediancut.h"
+
+namespace QgsWms
+{
+  ImageOutputFormat parseImageFormat( const QString &format )
+  {
+    if ( format.compare( QLatin1String( "png" ), Qt::CaseInsensitive ) == 0 ||
+         format.compare( QLatin1String( "image/png" ), Qt::CaseInsensitive ) == 0 )
+    {
+      return PNG;
+    }
+    else if ( format.compare( QLatin1String( "jpg " ), Qt::CaseInsensitive ) == 0  ||
+              format.compare( QLatin1String( "image/jpeg" ), Qt::CaseInsensitive ) == 0 )
+    {
+      return JPEG;
+    }
+    else if ( format.compare( QLatin1String( "webp" ), Qt::CaseInsensitive ) == 0  ||
+              format.compare( QLatin1String( "image/webp" ), Qt::CaseInsensitive ) == 0 )
+    {
+      return WEBP;
+    }
+    else
+    {
+      // lookup for png with mode
+      QRegularExpression modeExpr = QRegularExpression( QStringLiteral( "image/png\\s*;\\s*mode=([^;]+)" ),
+                                    QRegularExpression::CaseInsensitiveOption );
+
+      QRegularExpressionMatch match = modeExpr.match( format );
+      QString mode = match.captured( 1 );
+      if ( mode.compare( QLatin1String( "16bit" ), Qt::CaseInsensitive ) == 0 )
+        return PNG16;
+      if ( mode.compare( QLatin1String( "8bit" ), Qt::CaseInsensitive ) == 0 )
+        return PNG8;
+      if ( mode.compare( QLatin1String( "1bit" ), Qt::CaseInsensitive ) == 0 )
+        return PNG1;
+    }
+
+    return UNKN;
+  }
+
+  QString imageContentType( ImageOutputFormat format )
+  {
+    switch ( format )
+    {
+      case JPEG:
+        return QStringLiteral( "image/jpeg" );
+      case WEBP:
+        return QStringLiteral( "image/webp" );
+      case UNKN:
+        return QString();
+      default:
+        return QStringLiteral( "image/png" );
+    }
+  }
+
+  bool encodeImage( const QImage &img, ImageOutputFormat format, int imageQuality, QIODevice *device )
+  {
+    QImage  result;
+    const char *saveFormat = "PNG";
+    switch ( format )
+    {
+      case PNG:
+        result = img;
+        break;
+      case PNG8:
+      {
+        QVector<QRgb> colorTable;
+
+        // Rendering is made with the format QImage::Format_ARGB32_Premultiplied
+        // So we need to convert it in QImage::Format_ARGB32 in order to properly build
+        // the color table.
+        QImage img256 = img.convertToFormat( QImage::Format_ARGB32 );
+        medianCut( colorTable, 256, img256 );
+        result = img256.convertToFormat( QImage::Format_Indexed8, colorTable,
+                                         Qt::ColorOnly | Qt::ThresholdDither |
+                                         Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+      }
+      break;
+      case PNG16:
+        result = img.convertToFormat( QImage::Format_ARGB4444_Premultiplied );
+        break;
+      case PNG1:
+        result = img.convertToFormat( QImage::Format_Mono,
+                                      Qt::MonoOnly | Qt::ThresholdDither |
+                                      Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+        break;
+      case JPEG:
+        result = img;
+        saveFormat = "JPEG";
+        break;
+      case WEBP:
+        result = img;
+        saveFormat = "WEBP";
+        break;
+      case UNKN:
+        return false;
+    }
+
+    // Preserve DPI, some conversions, in particular the one for 8bit will drop this information
+    result.setDotsPerMeterX( img.dotsPerMeterX() );
+    result.setDotsPerMeterY( img.dotsPerMeterY() );
+
+    if ( format == JPEG || format == WEBP )
+    {
+      return result.save( device, saveFormat, imageQuality );
+    }
+    return result.save( device, saveFormat );
+  }
+} // namespace QgsWms
@@ -0,0 +1,65 @@
+/***************************************************************************
+                              qgswmsimageencoder.h
+
+  Encoding of rendered images in the WMS output formats
+  -----------------------------------------------------
+  begin                : 2020-10-17
+  copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWMSIMAGEENCODER_H
+#define QGSWMSIMAGEENCODER_H
+
+#include <QString>
+
+class QImage;
+class QIODevice;
+
+/**
+ * \ingroup server
+ * Image encoding shared by the WMS and WMTS services. It only depends on
+ * QtGui so it can be built in every service module that needs it.
+ */
+
+namespace QgsWms
+{
+  //! Supported image output format
+  enum ImageOutputFormat
+  {
+    UNKN,
+    PNG,
+    PNG8,
+    PNG16,
+    PNG1,
+    JPEG,
+    WEBP
+  };
+
+  /**
+   * Parse image format parameter
+   *  \returns OutputFormat
+   */
+  ImageOutputFormat parseImageFormat( const QString &format );
+
+  /**
+   * Returns the MIME type of the images encoded in \a format
+   */
+  QString imageContentType( ImageOutputFormat format );
+
+  /**
+   * Encodes \a img in \a format to \a device. The \a imageQuality is only
+   * used by the JPEG and WEBP formats.
+   * \returns FALSE if the format is unknown or the image cannot be written
+   */
+  bool encodeImage( const QImage &img, ImageOutputFormat format, int imageQuality, QIODevice *device );
+} // namespace QgsWms
+
+#endif
@@ -24,6 +24,7 @@
 #define QGSWMSUTILS_H
 
 #include "qgsmodule.h"
+#include "qgswmsimageencoder.h"
 
 class QgsRectangle;
 
@@ -35,29 +36,11 @@ class QgsRectangle;
 //! WMS implementation
 namespace QgsWms
 {
-  //! Supported image output format
-  enum ImageOutputFormat
-  {
-    UNKN,
-    PNG,
-    PNG8,
-    PNG16,
-    PNG1,
-    JPEG,
-    WEBP
-  };
-
   /**
    * Returns WMS service URL
    */
   QUrl serviceUrl( const QgsServerRequest &request, const QgsProject *project );
 
-  /**
-   * Parse image format parameter
-   *  \returns OutputFormat
-   */
-  ImageOutputFormat parseImageFormat( const QString &format );
-
   /**
    * Write image response
    */
@@ -17,11 +17,110 @@
 #include "qgswmtsutils.h"
 #include "qgswmtsparameters.h"
 #include "qgswmtsgettile.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsserverimagecache.h"
+#include "qgsserverprojectutils.h"
+#include "qgsserversettings.h"
+#include "qgswmsimageencoder.h"
 
+#include <QBuffer>
 #include <QImage>
 
 namespace QgsWmts
 {
+  namespace
+  {
+    // Returns the WMTS query of the tile at row and col
+    QUrlQuery tileQuery( const QUrlQuery &query, int row, int col )
+    {
+      QUrlQuery result;
+      const QList<QPair<QString, QString> > items = query.queryItems( QUrl::FullyDecoded );
+      for ( const QPair<QString, QString> &item : items )
+      {
+        if ( item.first.compare( QLatin1String( "TILEROW" ), Qt::CaseInsensitive ) == 0 )
+          result.addQueryItem( item.first, QString::number( row ) );
+        else if ( item.first.compare( QLatin1String( "TILECOL" ), Qt::CaseInsensitive ) == 0 )
+          result.addQueryItem( item.first, QString::number( col ) );
+        else
+          result.addQueryItem( item.first, item.second );
+      }
+      return result;
+    }
+
+    /**
+     * Renders the metatile containing the requested tile, stores all its
+     * tiles in the image cache and writes the requested one to the response.
+     * Returns FALSE if the metatile could not be rendered.
+     */
+    bool writeMetatile( QgsServerInterface *serverIface, const QgsProject *project,
+                        const QgsWmtsParameters &params, const QgsServerRequest &request,
+                        QgsServerResponse &response, int metatileSize, const QString &accessKey )
+    {
+      metatileDef metatile;
+      QUrlQuery query = translateWmtsParamToWmsQueryItem( QStringLiteral( "GetMap" ), params, project, serverIface, metatileSize, &metatile );
+      if ( metatile.rows * metatile.cols <= 1 )
+        return false;
+
+      // Slices are encoded in the requested format, the metatile itself is
+      // rendered losslessly so that JPEG tiles are compressed once and
+      // 8bit tiles get their own palette
+      const QString formatName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT );
+      const QgsWms::ImageOutputFormat outputFormat = QgsWms::parseImageFormat( query.queryItemValue( formatName, QUrl::FullyDecoded ) );
+      if ( outputFormat == QgsWms::UNKN )
+        return false;
+      query.removeAllQueryItems( formatName );
+      query.addQueryItem( formatName, QStringLiteral( "image/png" ) );
+
+      // Render the whole block with a single map job: features are fetched,
+      // symbols prepared and labels placed once for all the tiles.
+      // The metatile itself is also kept by the image cache, so evicted
+      // tiles are sliced again without rendering.
+      QgsServerParameters wmsParams( query );
+      QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
+      QgsBufferServerResponse wmsResponse;
+      QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
+      service->executeRequest( wmsRequest, wmsResponse, project );
+
+      QImage image;
+      if ( !wmsResponse.header( QStringLiteral( "Content-Type" ) ).startsWith( QLatin1String( "image/" ) )
+           || !image.loadFromData( wmsResponse.data() ) )
+      {
+        return false;
+      }
+
+      const int quality = QgsServerProjectUtils::wmsImageQuality( *project );
+      const int tileSize = image.width() / metatile.cols;
+      const QUrlQuery wmtsQuery( request.url() );
+      const int requestedRow = params.tileRowAsInt();
+      const int requestedCol = params.tileColAsInt();
+
+      QgsServerImageCache *imageCache = QgsServerImageCache::instance();
+      for ( int row = metatile.minRow; row < metatile.minRow + metatile.rows; ++row )
+      {
+        for ( int col = metatile.minCol; col < metatile.minCol + metatile.cols; ++col )
+        {
+          const QImage tile = image.copy( ( col - metatile.minCol ) * tileSize, ( row - metatile.minRow ) * tileSize, tileSize, tileSize );
+          QByteArray content;
+          QBuffer buffer( &content );
+          buffer.open( QIODevice::WriteOnly );
+          if ( !QgsWms::encodeImage( tile, outputFormat, quality, &buffer ) )
+            return false;
+
+          // Store the tile under the key of the GetMap request it is translated to
+          const QgsWmtsParameters tileParams( QgsServerParameters( tileQuery( wmtsQuery, row, col ) ) );
+          const QUrlQuery tileWmsQuery = translateWmtsParamToWmsQueryItem( QStringLiteral( "GetMap" ), tileParams, project, serverIface );
+          imageCache->setImage( content, project, QgsServerRequest( "?" + tileWmsQuery.query( QUrl::FullyDecoded ) ), accessKey );
+
+          if ( row == requestedRow && col == requestedCol )
+          {
+            response.setHeader( QStringLiteral( "Content-Type" ), QgsWms::imageContentType( outputFormat ) );
+            response.write( content );
+          }
+        }
+      }
+      return true;
+    }
+  }
 
   void writeGetTile( QgsServerInterface *serverIface, const QgsProject *project,
                      const QString &version, const QgsServerRequest &request,
@@ -68,6 +167,28 @@ namespace QgsWmts
 
     QgsServerParameters wmsParams( query );
     QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
+
+    // Metatiling: render the neighbouring tiles at once unless this
+    // tile is already in the image cache
+    const int metatileSize = serverIface->serverSettings() ? serverIface->serverSettings()->wmtsMetatileSize() : 1;
+    QgsServerImageCache *imageCache = QgsServerImageCache::instance();
+    QString accessKey;
+    if ( metatileSize > 1 && imageCache->isEnabled()
+         && QgsServerImageCache::accessControlKey( serverIface, accessKey )
+         && imageCache->image( project, wmsRequest, accessKey ).isEmpty()
+         && writeMetatile( serverIface, project, params, request, response, metatileSize, accessKey ) )
+    {
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+      if ( cacheManager )
+      {
+        QByteArray content = response.data();
+        if ( !content.isEmpty() )
+          cacheManager->setCachedImage( &content, project, request, accessControl );
+      }
+#endif
+      return;
+    }
+
     QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
     service->executeRequest( wmsRequest, response, project );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
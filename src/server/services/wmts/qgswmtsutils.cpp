@@ -26,6 +26,8 @@
 #include "qgssettings.h"
 #include "qgsprojectviewsettings.h"
 
+#include <algorithm>
+
 namespace QgsWmts
 {
   namespace
@@ -627,7 +629,8 @@ namespace QgsWmts
   }
 
   QUrlQuery translateWmtsParamToWmsQueryItem( const QString &request, const QgsWmtsParameters &params,
-      const QgsProject *project, QgsServerInterface *serverIface )
+      const QgsProject *project, QgsServerInterface *serverIface,
+      int metatileSize, metatileDef *metatile )
   {
 #ifndef HAVE_SERVER_PYTHON_PLUGINS
     ( void )serverIface;
@@ -761,11 +764,27 @@ namespace QgsWmts
       throw QgsRequestNotWellFormedException( QStringLiteral( "TileCol is unknown" ) );
     }
 
+    // Block of tiles to render, aligned on the metatile grid
+    metatileDef block;
+    block.minRow = tr;
+    block.minCol = tc;
+    if ( metatileSize > 1 )
+    {
+      block.minRow = ( tr / metatileSize ) * metatileSize;
+      block.minCol = ( tc / metatileSize ) * metatileSize;
+      block.rows = std::min( metatileSize, tm.row - block.minRow );
+      block.cols = std::min( metatileSize, tm.col - block.minCol );
+    }
+    if ( metatile )
+    {
+      *metatile = block;
+    }
+
     double res = tm.resolution;
-    double minx = tm.left + tc * ( tileSize * res );
-    double miny = tm.top - ( tr + 1 ) * ( tileSize * res );
-    double maxx = tm.left + ( tc + 1 ) * ( tileSize * res );
-    double maxy = tm.top - tr * ( tileSize * res );
+    double minx = tm.left + block.minCol * ( tileSize * res );
+    double miny = tm.top - ( block.minRow + block.rows ) * ( tileSize * res );
+    double maxx = tm.left + ( block.minCol + block.cols ) * ( tileSize * res );
+    double maxy = tm.top - block.minRow * ( tileSize * res );
     QString bbox;
     if ( tms.hasAxisInverted )
     {
@@ -794,8 +813,8 @@ namespace QgsWmts
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::STYLES ), QString() );
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::CRS ), tms.ref );
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::BBOX ), bbox );
-    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::WIDTH ), QStringLiteral( "256" ) );
-    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::HEIGHT ), QStringLiteral( "256" ) );
+    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::WIDTH ), QString::number( block.cols * tileSize ) );
+    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::HEIGHT ), QString::number( block.rows * tileSize ) );
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT ), format );
     if ( params.format() == QgsWmtsParameters::Format::PNG )
     {
@@ -98,6 +98,22 @@ namespace QgsWmts
     QMap< int, tileMatrixLimitDef > tileMatrixLimits;
   };
 
+  /**
+   * Block of neighbouring tiles of a tile matrix, rendered at once
+   * with a single WMS GetMap request.
+   * \since QGIS 3.18
+   */
+  struct metatileDef
+  {
+    int minRow = 0;
+
+    int minCol = 0;
+
+    int rows = 1;
+
+    int cols = 1;
+  };
+
   struct layerDef
   {
     QString id;
@@ -142,9 +158,14 @@ namespace QgsWmts
 
   /**
    * Translate WMTS parameters to WMS query item
+   *
+   * If \a metatileSize is greater than 1, the query covers the block of
+   * \a metatileSize x \a metatileSize tiles containing the requested tile
+   * (clipped to the tile matrix), and the block is returned in \a metatile.
    */
   QUrlQuery translateWmtsParamToWmsQueryItem( const QString &request, const QgsWmtsParameters &params,
-      const QgsProject *project, QgsServerInterface *serverIface );
+      const QgsProject *project, QgsServerInterface *serverIface,
+      int metatileSize = 1, metatileDef *metatile = nullptr );
 
 } // namespace QgsWmts
 
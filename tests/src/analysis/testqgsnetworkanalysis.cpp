@@ -25,6 +25,12 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgsgraphbuilder.h"
 #include "qgsgraph.h"
 #include "qgsgraphanalyzer.h"
+#include "qgscompactgraph.h"
+#include "qgscontractionhierarchy.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
 
 class TestQgsNetworkAnalysis : public QObject
 {
@@ -40,9 +46,13 @@ class TestQgsNetworkAnalysis : public QObject
     void testGraph();
     void testBuild();
     void testBuildTolerance();
+    void testBuildManyPoints();
     void dijkkjkjkskkjsktra();
     void testRouteFail();
     void testRouteFail2();
+    void testCompactGraph();
+    void testShortestPath();
+    void testContractionHierarchy();
 
   private:
     std::unique_ptr< QgsVectorLayer > buildNetwork();
@@ -281,6 +291,64 @@ void TestQgsNetworkAnalysis::testBuildTolerance()
   QCOMPARE( graph->edge( 4 ).toVertex(), 3 );
 }
 
+void TestQgsNetworkAnalysis::testBuildManyPoints()
+{
+  // a grid of streets, each split in several features
+  std::unique_ptr< QgsVectorLayer > network = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "LineString?crs=epsg:3857&field=cost:int" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+  QgsFeatureList flist;
+  QgsMultiPolylineXY lines;
+  for ( int i = 0; i <= 20; ++i )
+  {
+    for ( int j = 0; j < 20; j += 5 )
+    {
+      const QgsPolylineXY horizontal = QgsPolylineXY() << QgsPointXY( j * 10, i * 10 ) << QgsPointXY( j * 10 + 27, i * 10 + 1 ) << QgsPointXY( j * 10 + 50, i * 10 );
+      const QgsPolylineXY vertical = QgsPolylineXY() << QgsPointXY( i * 10, j * 10 ) << QgsPointXY( i * 10 - 1, j * 10 + 23 ) << QgsPointXY( i * 10, j * 10 + 50 );
+      for ( const QgsPolylineXY &line : { horizontal, vertical } )
+      {
+        QgsFeature ff( 0 );
+        ff.setGeometry( QgsGeometry::fromPolylineXY( line ) );
+        ff.setAttributes( QgsAttributes() << 1 );
+        flist << ff;
+        lines << line;
+      }
+    }
+  }
+  network->dataProvider()->addFeatures( flist );
+  const QgsGeometry networkGeometry = QgsGeometry::fromMultiPolylineXY( lines );
+
+  QVector< QgsPointXY > points;
+  for ( int i = 0; i < 500; ++i )
+    points << QgsPointXY( -20 + ( i * 37 ) % 250, -20 + ( i * 53 ) % 245 );
+  // far away from the network
+  points << QgsPointXY( 100000, -50000 );
+
+  std::unique_ptr< QgsVectorLayerDirector > director = qgis::make_unique< QgsVectorLayerDirector > ( network.get(),
+      -1, QString(), QString(), QString(), QgsVectorLayerDirector::DirectionBoth );
+  director->addStrategy( new QgsNetworkDistanceStrategy() );
+  std::unique_ptr< QgsGraphBuilder > builder = qgis::make_unique< QgsGraphBuilder > ( network->sourceCrs(), false, 0, QStringLiteral( "NONE" ) );
+
+  QVector< QgsPointXY > snapped;
+  director->makeGraph( builder.get(), points, snapped );
+  std::unique_ptr< QgsGraph > graph( builder->graph() );
+  QCOMPARE( snapped.size(), points.size() );
+
+  for ( int i = 0; i < points.size(); ++i )
+  {
+    // snapped to the closest point of the network, which is a vertex of the graph
+    const double distance = networkGeometry.distance( QgsGeometry::fromPointXY( points.at( i ) ) );
+    QGSCOMPARENEAR( points.at( i ).distance( snapped.at( i ) ), distance, 0.000001 );
+    QVERIFY( graph->findVertex( snapped.at( i ) ) != -1 );
+  }
+
+  // all the edges are as long as the distance between their vertices
+  for ( int i = 0; i < graph->edgeCount(); ++i )
+  {
+    const QgsGraphEdge &edge = graph->edge( i );
+    QVERIFY( edge.fromVertex() != edge.toVertex() );
+    QGSCOMPARENEAR( edge.cost( 0 ).toDouble(), graph->vertex( edge.fromVertex() ).point().distance( graph->vertex( edge.toVertex() ).point() ), 0.000001 );
+  }
+}
+
 void TestQgsNetworkAnalysis::dijkkjkjkskkjsktra()
 {
   std::unique_ptr<QgsVectorLayer> network = buildNetwork();
@@ -577,5 +645,256 @@ void TestQgsNetworkAnalysis::testRouteFail2()
 
 
 
+void TestQgsNetworkAnalysis::testCompactGraph()
+{
+  QgsGraph graph;
+  graph.addVertex( QgsPointXY( 0, 0 ) );
+  graph.addVertex( QgsPointXY( 10, 0 ) );
+  graph.addVertex( QgsPointXY( 10, 10 ) );
+  graph.addVertex( QgsPointXY( 0, 10 ) );
+  graph.addVertex( QgsPointXY( 20, 20 ) );
+  graph.addEdge( 0, 1, QVector< QVariant >() << 10 << 1 );
+  graph.addEdge( 1, 2, QVector< QVariant >() << 10 << 1 );
+  graph.addEdge( 0, 3, QVector< QVariant >() << 5 << 1 );
+  graph.addEdge( 3, 2, QVector< QVariant >() << 20 << 1 );
+  graph.addEdge( 2, 0, QVector< QVariant >() << 3 << 1 );
+
+  QgsCompactGraph compact( graph );
+  QCOMPARE( compact.vertexCount(), 5 );
+  QCOMPARE( compact.edgeCount(), 5 );
+  QCOMPARE( compact.strategyCount(), 2 );
+  QCOMPARE( compact.vertexPoint( 3 ), QgsPointXY( 0, 10 ) );
+  QCOMPARE( compact.outgoingEdgesBegin( 0 ), 0 );
+  QCOMPARE( compact.outgoingEdgesEnd( 0 ), 2 );
+  QCOMPARE( compact.edgeId( 1 ), 2 );
+  QCOMPARE( compact.edgeToVertex( 1 ), 3 );
+  QCOMPARE( compact.edgeCost( 0, 1 ), 5.0 );
+  QCOMPARE( compact.edgeCost( 1, 1 ), 1.0 );
+  QCOMPARE( compact.outgoingEdgesBegin( 4 ), compact.outgoingEdgesEnd( 4 ) );
+  QGSCOMPARENEAR( compact.minimumCostPerDistance( 0 ), 3 / std::sqrt( 200.0 ), 0.000001 );
+  QGSCOMPARENEAR( compact.minimumCostPerDistance( 1 ), 1 / std::sqrt( 200.0 ), 0.000001 );
+
+  // searches on the compact graph give the same results as on the source graph
+  for ( int criterion = 0; criterion < 2; ++criterion )
+  {
+    for ( int start = 0; start < graph.vertexCount(); ++start )
+    {
+      QVector<int> resultTree;
+      QVector<double> resultCost;
+      QgsGraphAnalyzer::dijkstra( &graph, start, criterion, &resultTree, &resultCost );
+      QVector<int> compactTree;
+      QVector<double> compactCost;
+      QgsGraphAnalyzer::dijkstra( &compact, start, criterion, &compactTree, &compactCost );
+      QCOMPARE( compactTree, resultTree );
+      QCOMPARE( compactCost, resultCost );
+    }
+  }
+
+  QVector<int> resultTree;
+  QVector<double> resultCost;
+  QgsGraphAnalyzer::dijkstra( &compact, 0, 0, &resultTree, &resultCost );
+  QCOMPARE( resultTree, QVector<int>() << -1 << 0 << 1 << 2 << -1 );
+  QCOMPARE( resultCost.at( 2 ), 20.0 );
+  QCOMPARE( resultCost.at( 3 ), 5.0 );
+  QVERIFY( std::isinf( resultCost.at( 4 ) ) );
+}
+
+void TestQgsNetworkAnalysis::testShortestPath()
+{
+  QgsGraph graph;
+  graph.addVertex( QgsPointXY( 0, 0 ) );
+  graph.addVertex( QgsPointXY( 10, 0 ) );
+  graph.addVertex( QgsPointXY( 10, 10 ) );
+  graph.addVertex( QgsPointXY( 0, 10 ) );
+  graph.addVertex( QgsPointXY( 20, 20 ) );
+  graph.addEdge( 0, 1, QVector< QVariant >() << 10 << 1 );
+  graph.addEdge( 1, 2, QVector< QVariant >() << 10 << 1 );
+  graph.addEdge( 0, 3, QVector< QVariant >() << 5 << 1 );
+  graph.addEdge( 3, 2, QVector< QVariant >() << 20 << 1 );
+  graph.addEdge( 2, 0, QVector< QVariant >() << 3 << 1 );
+  graph.addEdge( 3, 4, QVector< QVariant >() << 1 << 1 );
+  const QgsCompactGraph compact( graph );
+
+  double cost = 0;
+  QCOMPARE( QgsGraphAnalyzer::shortestPath( &compact, 0, 2, 0, &cost ), QVector<int>() << 0 << 1 << 2 );
+  QCOMPARE( cost, 20.0 );
+  QCOMPARE( QgsGraphAnalyzer::shortestPath( &compact, 2, 4, 0, &cost ), QVector<int>() << 2 << 0 << 3 << 4 );
+  QCOMPARE( cost, 9.0 );
+  QCOMPARE( QgsGraphAnalyzer::shortestPath( &compact, 1, 3, 1, &cost ), QVector<int>() << 1 << 2 << 0 << 3 );
+  QCOMPARE( cost, 3.0 );
+
+  // same vertex
+  QCOMPARE( QgsGraphAnalyzer::shortestPath( &compact, 1, 1, 0, &cost ), QVector<int>() << 1 );
+  QCOMPARE( cost, 0.0 );
+
+  // unreachable end vertex
+  QVERIFY( QgsGraphAnalyzer::shortestPath( &compact, 4, 0, 0, &cost ).isEmpty() );
+  QVERIFY( std::isinf( cost ) );
+
+  // invalid vertices
+  QVERIFY( QgsGraphAnalyzer::shortestPath( &compact, -1, 0, 0, &cost ).isEmpty() );
+  QVERIFY( QgsGraphAnalyzer::shortestPath( &compact, 0, 5, 0, &cost ).isEmpty() );
+
+  // costs match the ones from the full search
+  for ( int start = 0; start < graph.vertexCount(); ++start )
+  {
+    QVector<double> resultCost;
+    QgsGraphAnalyzer::dijkstra( &graph, start, 0, nullptr, &resultCost );
+    for ( int end = 0; end < graph.vertexCount(); ++end )
+    {
+      const QVector<int> path = QgsGraphAnalyzer::shortestPath( &compact, start, end, 0, &cost );
+      QCOMPARE( path.isEmpty(), std::isinf( resultCost.at( end ) ) );
+      if ( !path.isEmpty() )
+        QCOMPARE( cost, resultCost.at( end ) );
+    }
+  }
+}
+
+
+void TestQgsNetworkAnalysis::testContractionHierarchy()
+{
+  // a grid of one way and two way streets, with varying costs
+  const int size = 12;
+  QgsGraph graph;
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+      graph.addVertex( QgsPointXY( x * 10, y * 10 ) );
+  }
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+    {
+      const int vertex = y * size + x;
+      if ( x + 1 < size )
+      {
+        graph.addEdge( vertex, vertex + 1, QVector< QVariant >() << 1 + ( x * 7 + y * 3 ) % 5 );
+        if ( y % 3 != 0 )
+          graph.addEdge( vertex + 1, vertex, QVector< QVariant >() << 1 + ( x * 5 + y * 11 ) % 7 );
+      }
+      if ( y + 1 < size )
+      {
+        graph.addEdge( vertex, vertex + size, QVector< QVariant >() << 1 + ( x * 13 + y * 3 ) % 4 );
+        if ( x % 4 != 1 )
+          graph.addEdge( vertex + size, vertex, QVector< QVariant >() << 1 + ( x * 3 + y * 7 ) % 6 );
+      }
+    }
+  }
+  // an isolated vertex
+  graph.addVertex( QgsPointXY( -100, -100 ) );
+
+  QgsContractionHierarchy invalid;
+  QVERIFY( !invalid.isValid() );
+  QCOMPARE( invalid.vertexCount(), 0 );
+
+  const QgsContractionHierarchy hierarchy( graph );
+  QVERIFY( hierarchy.isValid() );
+  QCOMPARE( hierarchy.vertexCount(), graph.vertexCount() );
+  QCOMPARE( hierarchy.vertexPoint( 13 ), graph.vertex( 13 ).point() );
+
+  QVector< int > vertices;
+  for ( int vertex = 0; vertex < graph.vertexCount(); ++vertex )
+    vertices << vertex;
+  const QVector< double > matrix = hierarchy.costMatrix( vertices, vertices );
+  QCOMPARE( matrix.size(), vertices.size() * vertices.size() );
+
+  for ( int from = 0; from < graph.vertexCount(); ++from )
+  {
+    QVector< double > expectedCosts;
+    QgsGraphAnalyzer::dijkstra( &graph, from, 0, nullptr, &expectedCosts );
+    for ( int to = 0; to < graph.vertexCount(); ++to )
+    {
+      const double expected = expectedCosts.at( to );
+      double cost = 0;
+      const QVector< int > path = hierarchy.shortestPath( from, to, &cost );
+      if ( std::isinf( expected ) )
+      {
+        QVERIFY( std::isinf( hierarchy.cost( from, to ) ) );
+        QVERIFY( std::isinf( matrix.at( from * vertices.size() + to ) ) );
+        QVERIFY( std::isinf( cost ) );
+        QVERIFY( path.isEmpty() );
+        continue;
+      }
+
+      QCOMPARE( hierarchy.cost( from, to ), expected );
+      QCOMPARE( matrix.at( from * vertices.size() + to ), expected );
+      QCOMPARE( cost, expected );
+
+      // the unpacked path follows edges of the graph, and has the expected cost
+      QCOMPARE( path.first(), from );
+      QCOMPARE( path.last(), to );
+      double pathCost = 0;
+      for ( int i = 1; i < path.size(); ++i )
+      {
+        double edgeCost = std::numeric_limits< double >::infinity();
+        for ( int edgeId : graph.vertex( path.at( i - 1 ) ).outgoingEdges() )
+        {
+          const QgsGraphEdge &edge = graph.edge( edgeId );
+          if ( edge.toVertex() == path.at( i ) )
+            edgeCost = std::min( edgeCost, edge.cost( 0 ).toDouble() );
+        }
+        QVERIFY( !std::isinf( edgeCost ) );
+        pathCost += edgeCost;
+      }
+      QCOMPARE( pathCost, expected );
+    }
+  }
+
+  // invalid vertices
+  QVERIFY( std::isinf( hierarchy.cost( -1, 0 ) ) );
+  QVERIFY( hierarchy.shortestPath( 0, graph.vertexCount() ).isEmpty() );
+  const QVector< double > partial = hierarchy.costMatrix( QVector< int >() << 0 << -1, QVector< int >() << 5 );
+  QCOMPARE( partial.size(), 2 );
+  QCOMPARE( partial.at( 0 ), hierarchy.cost( 0, 5 ) );
+  QVERIFY( std::isinf( partial.at( 1 ) ) );
+
+  // matrices larger than the maximum size, whose size does not even fit in an int, are not computed
+  const QVector< int > manyVertices( 70000, 0 );
+  QVERIFY( hierarchy.costMatrix( manyVertices, manyVertices ).isEmpty() );
+  QVERIFY( hierarchy.costMatrix( manyVertices, QVector< int >() << 0 ).size() == manyVertices.size() );
+
+  // write and read back
+  QgsContractionHierarchy written( graph );
+  written.setFingerprint( QStringLiteral( "network" ) );
+  QTemporaryDir dir;
+  const QString path = dir.filePath( QStringLiteral( "hierarchy.qgsch" ) );
+  QVERIFY( written.writeToFile( path ) );
+  const QgsContractionHierarchy read = QgsContractionHierarchy::readFromFile( path );
+  QVERIFY( read.isValid() );
+  QCOMPARE( read.fingerprint(), QStringLiteral( "network" ) );
+  QCOMPARE( read.vertexCount(), hierarchy.vertexCount() );
+  QCOMPARE( read.shortcutCount(), hierarchy.shortcutCount() );
+  QCOMPARE( read.vertexPoint( 13 ), hierarchy.vertexPoint( 13 ) );
+  QCOMPARE( read.costMatrix( vertices, vertices ), matrix );
+  QCOMPARE( read.shortestPath( 0, size * size - 1 ), hierarchy.shortestPath( 0, size * size - 1 ) );
+
+  QVERIFY( !QgsContractionHierarchy::readFromFile( dir.filePath( QStringLiteral( "missing.qgsch" ) ) ).isValid() );
+  QVERIFY( !invalid.writeToFile( dir.filePath( QStringLiteral( "invalid.qgsch" ) ) ) );
+
+  // a hierarchy of 3 vertices with a single edge from vertex 0 to vertex 1
+  auto writeHierarchy = [&dir]( int middle )
+  {
+    const QString path = dir.filePath( QStringLiteral( "handmade.qgsch" ) );
+    QFile file( path );
+    file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << static_cast< quint32 >( 0x51474348 ) << static_cast< quint32 >( 2 ) << QString() << 1 << 3;
+    for ( int i = 0; i < 3; ++i )
+      stream << static_cast< double >( i ) << 0.0;
+    stream << ( QVector< int >() << 0 << 1 << 2 );
+    stream << ( QVector< int >() << 0 << 1 << 1 << 1 ) << ( QVector< int >() << 1 ) << ( QVector< double >() << 1.0 ) << ( QVector< int >() << middle );
+    stream << ( QVector< int >() << 0 << 0 << 0 << 0 ) << QVector< int >() << QVector< double >() << QVector< int >();
+    file.close();
+    return QgsContractionHierarchy::readFromFile( path );
+  };
+  QVERIFY( writeHierarchy( -1 ).isValid() );
+  QCOMPARE( writeHierarchy( -1 ).cost( 0, 1 ), 1.0 );
+  // a shortcut bypassing a vertex above its ends would make unpacking the path recurse forever
+  QVERIFY( !writeHierarchy( 2 ).isValid() );
+  QVERIFY( !writeHierarchy( 1 ).isValid() );
+}
+
+
 QGSTEST_MAIN( TestQgsNetworkAnalysis )
 #include "testqgsnetworkanalysis.moc"
@@ -533,6 +533,48 @@ class DummyParameterType : public QgsProcessingParameterType
     }
 };
 
+class DummyFeatureBasedAlgorithm : public QgsProcessingFeatureBasedAlgorithm
+{
+  public:
+
+    DummyFeatureBasedAlgorithm( bool parallel, int failAt = -1 )
+      : mParallel( parallel )
+      , mFailAt( failAt )
+    {}
+
+    QString name() const override { return QStringLiteral( "featurebased" ); }
+    QString displayName() const override { return name(); }
+    QString outputName() const override { return QStringLiteral( "output" ); }
+    Flags flags() const override
+    {
+      return mParallel ? QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatureProcessing : QgsProcessingFeatureBasedAlgorithm::flags();
+    }
+
+    QgsFeatureList processFeature( const QgsFeature &feature, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override
+    {
+      const int value = feature.attribute( 0 ).toInt();
+      if ( value == mFailAt )
+        throw QgsProcessingException( QStringLiteral( "failed at %1" ).arg( value ) );
+      if ( value % 1000 == 0 )
+        feedback->pushInfo( QStringLiteral( "feature %1" ).arg( value ) );
+
+      // drop some features and duplicate others
+      if ( value % 5 == 0 )
+        return QgsFeatureList();
+
+      QgsFeature f = feature;
+      f.setAttribute( 0, context.expressionContext().feature().attribute( 0 ).toInt() * 2 );
+      if ( value % 3 == 0 )
+        return QgsFeatureList() << f << f;
+      return QgsFeatureList() << f;
+    }
+
+    DummyFeatureBasedAlgorithm *createInstance() const override { return new DummyFeatureBasedAlgorithm( mParallel, mFailAt ); }
+
+    bool mParallel = false;
+    int mFailAt = -1;
+};
+
 class TestQgsProcessing: public QObject
 {
     Q_OBJECT
@@ -646,6 +688,7 @@ class TestQgsProcessing: public QObject
     void sourceTypeToString_data();
     void sourceTypeToString();
     void modelSource();
+    void featureBasedAlgorithmParallel();
 
   private:
 
@@ -11639,5 +11682,64 @@ void TestQgsProcessing::modelSource()
   QCOMPARE( res.source(), QgsProcessingModelChildParameterSource::ChildOutput );
 }
 
+void TestQgsProcessing::featureBasedAlgorithmParallel()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=value:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 10000; ++i )
+  {
+    QgsFeature f( layer.fields() );
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  auto run = [&layer]( bool parallel, int failAt, bool & ok, QString & log )
+  {
+    DummyFeatureBasedAlgorithm alg( parallel, failAt );
+    QgsProject p;
+    QgsProcessingContext context;
+    context.setProject( &p );
+    QgsProcessingFeedback feedback;
+    context.setFeedback( &feedback );
+
+    QVariantMap parameters;
+    parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue< QgsMapLayer * >( &layer ) );
+    parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+    const QVariantMap results = alg.run( parameters, context, &feedback, &ok );
+    log = feedback.textLog();
+
+    QList< int > values;
+    if ( QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) ) )
+    {
+      QgsFeature f;
+      QgsFeatureIterator it = output->getFeatures();
+      while ( it.nextFeature( f ) )
+        values << f.attribute( 0 ).toInt();
+    }
+    return values;
+  };
+
+  bool ok = false;
+  QString serialLog;
+  const QList< int > serial = run( false, -1, ok, serialLog );
+  QVERIFY( ok );
+  QCOMPARE( serial.size(), 10000 - 2000 + 2667 );
+
+  // same features, in the same order, with the same messages
+  QString parallelLog;
+  const QList< int > parallel = run( true, -1, ok, parallelLog );
+  QVERIFY( ok );
+  QCOMPARE( parallel, serial );
+  QCOMPARE( parallelLog, serialLog );
+
+  // exceptions are reported after the preceding features have been written
+  run( true, 5001, ok, parallelLog );
+  QVERIFY( !ok );
+  QVERIFY( parallelLog.contains( QStringLiteral( "failed at 5001" ) ) );
+}
+
 QGSTEST_MAIN( TestQgsProcessing )
 #include "testqgsprocessing.moc"
@@ -127,6 +127,8 @@ class TestQgsProcessingAlgs: public QObject
     void rasterLocalPosition();
     void roundRasterValues_data();
     void roundRasterValues();
+    void middlePointCells_data();
+    void middlePointCells();
 
     void layoutMapExtent();
 
@@ -178,6 +180,8 @@ class TestQgsProcessingAlgs: public QObject
 
     void fileDownloader();
 
+    void odCostMatrix();
+
   private:
 
     bool imageCheck( const QString &testName, const QString &renderedImage );
@@ -4074,6 +4078,50 @@ void TestQgsProcessingAlgs::roundRasterValues()
   }
 }
 
+void TestQgsProcessingAlgs::middlePointCells_data()
+{
+  QTest::addColumn<QString>( "wkt" );
+
+  // edges and vertices on the center lines and columns of the cells
+  QTest::newRow( "square on centers" ) << QStringLiteral( "Polygon((2.5 2.5, 7.5 2.5, 7.5 7.5, 2.5 7.5, 2.5 2.5))" );
+  QTest::newRow( "steps on centers" ) << QStringLiteral( "Polygon((1 1, 9 1, 9 5.5, 5 5.5, 5 8.5, 3.5 8.5, 3.5 3.5, 1 3.5, 1 1))" );
+  QTest::newRow( "hole on centers" ) << QStringLiteral( "Polygon((0 0, 10 0, 10 10, 0 10, 0 0),(3.5 3.5, 6.5 3.5, 6.5 6.5, 3.5 6.5, 3.5 3.5))" );
+  QTest::newRow( "triangle on centers" ) << QStringLiteral( "Polygon((1.5 1.5, 8.5 1.5, 5.5 8.5, 1.5 1.5))" );
+  QTest::newRow( "diamond on centers" ) << QStringLiteral( "Polygon((5.5 0.5, 9.5 5.5, 5.5 9.5, 0.5 5.5, 5.5 0.5))" );
+  QTest::newRow( "multipolygon" ) << QStringLiteral( "MultiPolygon(((0.5 0.5, 4.5 0.5, 4.5 4.5, 0.5 0.5)),((5.5 5.5, 9.5 5.5, 9.5 9.5, 5.5 9.5, 5.5 5.5)))" );
+  QTest::newRow( "off centers" ) << QStringLiteral( "Polygon((1.2 1.3, 8.7 2.1, 7.9 8.8, 2.2 7.6, 1.2 1.3))" );
+}
+
+void TestQgsProcessingAlgs::middlePointCells()
+{
+  QFETCH( QString, wkt );
+  const QgsGeometry polygon = QgsGeometry::fromWkt( wkt );
+  QVERIFY( !polygon.isNull() );
+
+  const QgsRectangle gridExtent( 0, 0, 10, 10 );
+  QSet< QPair< int, int > > cells;
+  QVERIFY( QgsRasterAnalysisUtils::middlePointCells( polygon, gridExtent, 10, 10, 1, 1, [&cells]( int row, int firstColumn, int lastColumn )
+  {
+    for ( int column = firstColumn; column <= lastColumn; ++column )
+      cells.insert( qMakePair( row, column ) );
+  } ) );
+
+  // like the GEOS contains test, centers on the boundary are not within the polygon
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( polygon.constGet() ) );
+  engine->prepareGeometry();
+  QSet< QPair< int, int > > expected;
+  for ( int row = 0; row < 10; ++row )
+  {
+    for ( int column = 0; column < 10; ++column )
+    {
+      const QgsPoint center( column + 0.5, 10 - ( row + 0.5 ) );
+      if ( engine->contains( &center ) )
+        expected.insert( qMakePair( row, column ) );
+    }
+  }
+  QCOMPARE( cells, expected );
+}
+
 void TestQgsProcessingAlgs::layoutMapExtent()
 {
   std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:printlayoutmapextenttolayer" ) ) );
@@ -6619,6 +6667,112 @@ void TestQgsProcessingAlgs::exportMeshTimeSeries()
   outputFile.close();
 }
 
+void TestQgsProcessingAlgs::odCostMatrix()
+{
+  QgsProject project;
+  project.setCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+
+  std::unique_ptr< QgsVectorLayer > network = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "LineString?crs=EPSG:3857" ), QStringLiteral( "network" ), QStringLiteral( "memory" ) );
+  QgsFeatureList lines;
+  for ( const QString &wkt : { QStringLiteral( "LineString(0 0, 100 0)" ), QStringLiteral( "LineString(100 0, 100 100)" ), QStringLiteral( "LineString(0 0, 0 50)" ) } )
+  {
+    QgsFeature line;
+    line.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    lines << line;
+  }
+  QVERIFY( network->dataProvider()->addFeatures( lines ) );
+
+  auto pointLayer = []( const QList< QgsPointXY > &points )
+  {
+    std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+    QgsFeatureList features;
+    for ( const QgsPointXY &point : points )
+    {
+      QgsFeature feature;
+      feature.setGeometry( QgsGeometry::fromPointXY( point ) );
+      features << feature;
+    }
+    layer->dataProvider()->addFeatures( features );
+    return layer;
+  };
+  std::unique_ptr< QgsVectorLayer > startPoints = pointLayer( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 1, 51 ) );
+  std::unique_ptr< QgsVectorLayer > endPoints = pointLayer( QList< QgsPointXY >() << QgsPointXY( 99, 101 ) << QgsPointXY( 100, 0 ) );
+
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:odcostmatrix" ) ) );
+  QVERIFY( alg != nullptr );
+
+  QTemporaryDir dir;
+  const QString hierarchyPath = dir.filePath( QStringLiteral( "network.qgsch" ) );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( network.get() ) );
+  parameters.insert( QStringLiteral( "STRATEGY" ), 0 );
+  parameters.insert( QStringLiteral( "DEFAULT_DIRECTION" ), 2 );
+  parameters.insert( QStringLiteral( "DEFAULT_SPEED" ), 50.0 );
+  parameters.insert( QStringLiteral( "TOLERANCE" ), 0.0 );
+  parameters.insert( QStringLiteral( "START_POINTS" ), QVariant::fromValue( startPoints.get() ) );
+  parameters.insert( QStringLiteral( "END_POINTS" ), QVariant::fromValue( endPoints.get() ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+  parameters.insert( QStringLiteral( "OUTPUT_HIERARCHY" ), hierarchyPath );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  context->setProject( &project );
+  QgsProcessingFeedback feedback;
+
+  auto runMatrix = [&]( const QVariantMap & parameters, bool & ok )
+  {
+    const QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+    QStringList costs;
+    if ( !ok )
+      return costs;
+
+    QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+    QgsFeatureIterator it = output->getFeatures();
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+      costs << QStringLiteral( "%1-%2:%3" ).arg( feature.attribute( 0 ).toString(), feature.attribute( 1 ).toString(), feature.attribute( 2 ).toString() );
+    return costs;
+  };
+
+  // points are snapped to the nearest vertex of the network
+  const QStringList expected = QStringList() << QStringLiteral( "1-1:200" ) << QStringLiteral( "1-2:100" ) << QStringLiteral( "2-1:250" ) << QStringLiteral( "2-2:150" );
+  bool ok = false;
+  QCOMPARE( runMatrix( parameters, ok ), expected );
+  QVERIFY( ok );
+  QVERIFY( QFile::exists( hierarchyPath ) );
+
+  // the saved hierarchy gives the same costs
+  parameters.remove( QStringLiteral( "OUTPUT_HIERARCHY" ) );
+  parameters.insert( QStringLiteral( "HIERARCHY" ), hierarchyPath );
+  QCOMPARE( runMatrix( parameters, ok ), expected );
+  QVERIFY( ok );
+
+  // but it is rejected for other settings
+  QVariantMap fastest = parameters;
+  fastest.insert( QStringLiteral( "STRATEGY" ), 1 );
+  runMatrix( fastest, ok );
+  QVERIFY( !ok );
+
+  QVariantMap oneWay = parameters;
+  oneWay.insert( QStringLiteral( "DEFAULT_DIRECTION" ), 0 );
+  runMatrix( oneWay, ok );
+  QVERIFY( !ok );
+
+  // and for another network
+  QgsFeature line;
+  line.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString(0 50, 100 100)" ) ) );
+  QVERIFY( network->dataProvider()->addFeature( line ) );
+  runMatrix( parameters, ok );
+  QVERIFY( !ok );
+
+  // or a corrupted file
+  QFile file( hierarchyPath );
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  file.write( "not a hierarchy" );
+  file.close();
+  runMatrix( parameters, ok );
+  QVERIFY( !ok );
+}
 
 bool TestQgsProcessingAlgs::imageCheck( const QString &testName, const QString &renderedImage )
 {
@@ -23,10 +23,14 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgsrastermatrix.h"
+#include "qgsrastermatrixkernels_p.h"
 #include "qgsapplication.h"
 #include "qgsproject.h"
 
+#include <random>
+
 Q_DECLARE_METATYPE( QgsRasterCalcNode::Operator )
+Q_DECLARE_METATYPE( QgsRasterMatrixKernels::InstructionSet )
 
 class TestQgsRasterCalculator : public QObject
 {
@@ -51,12 +55,17 @@ class TestQgsRasterCalculator : public QObject
     void dualOpNumberMatrix(); // test dual op run on number and matrix
     void dualOpMatrixNumber(); // test dual op run on matrix and number
     void dualOpMatrixMatrix(); // test dual op run on matrix and matrix
+    void dualOpKernels_data();
+    void dualOpKernels(); // test vectorized kernels give the same results as the scalar operators
+    void benchmarkDualOpKernels_data();
+    void benchmarkDualOpKernels();
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
+    void calcManyStrips();
 
     void errors();
     void toString();
@@ -67,6 +76,8 @@ class TestQgsRasterCalculator : public QObject
 
   private:
 
+    static bool applyDualOp( QgsRasterMatrix::TwoArgOperator op, QgsRasterMatrix &left, const QgsRasterMatrix &right );
+
     QgsRasterLayer *mpLandsatRasterLayer = nullptr;
     QgsRasterLayer *mpLandsatRasterLayer4326 = nullptr;
 };
@@ -363,6 +374,169 @@ void TestQgsRasterCalculator::dualOpMatrixMatrix()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+bool TestQgsRasterCalculator::applyDualOp( QgsRasterMatrix::TwoArgOperator op, QgsRasterMatrix &left, const QgsRasterMatrix &right )
+{
+  switch ( op )
+  {
+    case QgsRasterMatrix::opPLUS:
+      return left.add( right );
+    case QgsRasterMatrix::opMINUS:
+      return left.subtract( right );
+    case QgsRasterMatrix::opMUL:
+      return left.multiply( right );
+    case QgsRasterMatrix::opDIV:
+      return left.divide( right );
+    case QgsRasterMatrix::opPOW:
+      return left.power( right );
+    case QgsRasterMatrix::opEQ:
+      return left.equal( right );
+    case QgsRasterMatrix::opNE:
+      return left.notEqual( right );
+    case QgsRasterMatrix::opGT:
+      return left.greaterThan( right );
+    case QgsRasterMatrix::opLT:
+      return left.lesserThan( right );
+    case QgsRasterMatrix::opGE:
+      return left.greaterEqual( right );
+    case QgsRasterMatrix::opLE:
+      return left.lesserEqual( right );
+    case QgsRasterMatrix::opAND:
+      return left.logicalAnd( right );
+    case QgsRasterMatrix::opOR:
+      return left.logicalOr( right );
+    case QgsRasterMatrix::opMIN:
+      return left.min( right );
+    case QgsRasterMatrix::opMAX:
+      return left.max( right );
+  }
+  return false;
+}
+
+void TestQgsRasterCalculator::dualOpKernels_data()
+{
+  QTest::addColumn< QgsRasterMatrixKernels::InstructionSet >( "instructionSet" );
+
+  QTest::newRow( "sse2" ) << QgsRasterMatrixKernels::Sse2;
+  QTest::newRow( "avx" ) << QgsRasterMatrixKernels::Avx;
+}
+
+void TestQgsRasterCalculator::dualOpKernels()
+{
+  QFETCH( QgsRasterMatrixKernels::InstructionSet, instructionSet );
+
+  if ( QgsRasterMatrixKernels::supportedInstructionSet() < instructionSet )
+    QSKIP( "Instruction set not supported on this system" );
+
+  const double nan = std::numeric_limits< double >::quiet_NaN();
+  const double inf = std::numeric_limits< double >::infinity();
+  const double values[] = { 0.0, -0.0, 1.0, -1.0, 2.0, 3.5, -2.5, nan, inf, -inf, -9999.0, -1.0 };
+  const int valueCount = sizeof( values ) / sizeof( values[0] );
+
+  std::mt19937 generator( 17 );
+  // odd sizes, to have entries left over after the last vector
+  const int size = 43;
+
+  for ( int op = QgsRasterMatrix::opPLUS; op <= QgsRasterMatrix::opMAX; ++op )
+  {
+    // matrix and matrix, number and matrix, matrix and number
+    for ( int operands = 0; operands < 3; ++operands )
+    {
+      // NaN nodata never matches any value
+      for ( double leftNodata : { -9999.0, nan } )
+      {
+        const double rightNodata = -1.0;
+        const int leftSize = operands == 1 ? 1 : size;
+        const int rightSize = operands == 2 ? 1 : size;
+
+        std::vector< double > left( leftSize );
+        std::vector< double > right( rightSize );
+        for ( double &value : left )
+          value = values[ generator() % valueCount ];
+        for ( double &value : right )
+          value = values[ generator() % valueCount ];
+        // numbers which are nodata are handled before any kernel
+        if ( operands == 1 && left[0] == leftNodata )
+          left[0] = 2;
+        if ( operands == 2 && right[0] == rightNodata )
+          right[0] = 2;
+
+        std::vector< double > results[2];
+        const QgsRasterMatrixKernels::InstructionSet sets[2] = { QgsRasterMatrixKernels::Scalar, instructionSet };
+        for ( int i = 0; i < 2; ++i )
+        {
+          QgsRasterMatrixKernels::setInstructionSet( sets[i] );
+          double *leftData = new double[ leftSize ];
+          std::copy( left.begin(), left.end(), leftData );
+          double *rightData = new double[ rightSize ];
+          std::copy( right.begin(), right.end(), rightData );
+          QgsRasterMatrix leftMatrix( leftSize, 1, leftData, leftNodata );
+          QgsRasterMatrix rightMatrix( rightSize, 1, rightData, rightNodata );
+          QVERIFY( applyDualOp( static_cast< QgsRasterMatrix::TwoArgOperator >( op ), leftMatrix, rightMatrix ) );
+          results[i].assign( leftMatrix.data(), leftMatrix.data() + leftMatrix.nColumns() * leftMatrix.nRows() );
+        }
+        QgsRasterMatrixKernels::setInstructionSet( QgsRasterMatrixKernels::supportedInstructionSet() );
+
+        QCOMPARE( results[1].size(), results[0].size() );
+        for ( std::size_t i = 0; i < results[0].size(); ++i )
+        {
+          const double expected = results[0][i];
+          const double value = results[1][i];
+          if ( std::isnan( expected ) )
+          {
+            QVERIFY( std::isnan( value ) );
+          }
+          else
+          {
+            QCOMPARE( value, expected );
+            QCOMPARE( std::signbit( value ), std::signbit( expected ) );
+          }
+        }
+      }
+    }
+  }
+}
+
+void TestQgsRasterCalculator::benchmarkDualOpKernels_data()
+{
+  QTest::addColumn< QgsRasterMatrixKernels::InstructionSet >( "instructionSet" );
+
+  QTest::newRow( "scalar" ) << QgsRasterMatrixKernels::Scalar;
+  QTest::newRow( "sse2" ) << QgsRasterMatrixKernels::Sse2;
+  QTest::newRow( "avx" ) << QgsRasterMatrixKernels::Avx;
+}
+
+void TestQgsRasterCalculator::benchmarkDualOpKernels()
+{
+  QFETCH( QgsRasterMatrixKernels::InstructionSet, instructionSet );
+
+  if ( QgsRasterMatrixKernels::supportedInstructionSet() < instructionSet )
+    QSKIP( "Instruction set not supported on this system" );
+
+  // one strip of the raster calculator
+  const int columns = 1024;
+  const int rows = 256;
+  double *leftData = new double[ columns * rows ];
+  double *rightData = new double[ columns * rows ];
+  for ( int i = 0; i < columns * rows; ++i )
+  {
+    leftData[i] = i % 7 == 0 ? -9999 : i % 13;
+    rightData[i] = i % 11 == 0 ? -9999 : i % 17;
+  }
+  QgsRasterMatrix left( columns, rows, leftData, -9999 );
+  const QgsRasterMatrix right( columns, rows, rightData, -9999 );
+
+  QgsRasterMatrixKernels::setInstructionSet( instructionSet );
+  QBENCHMARK
+  {
+    QgsRasterMatrix result( left );
+    result.multiply( right );
+    result.add( right );
+    result.greaterThan( left );
+    result.max( right );
+  }
+  QgsRasterMatrixKernels::setInstructionSet( QgsRasterMatrixKernels::supportedInstructionSet() );
+}
+
 void TestQgsRasterCalculator::rasterRefOp()
 {
   // test single op run on raster ref
@@ -499,6 +673,57 @@ void TestQgsRasterCalculator::calcWithLayers()
   delete block;
 }
 
+void TestQgsRasterCalculator::calcManyStrips()
+{
+  QgsRasterCalculatorEntry entry1;
+  entry1.bandNumber = 1;
+  entry1.raster = mpLandsatRasterLayer;
+  entry1.ref = QStringLiteral( "landsat@1" );
+
+  QgsRasterCalculatorEntry entry2;
+  entry2.bandNumber = 2;
+  entry2.raster = mpLandsatRasterLayer;
+  entry2.ref = QStringLiteral( "landsat@2" );
+
+  QVector<QgsRasterCalculatorEntry> entries;
+  entries << entry1 << entry2;
+
+  // large enough to be calculated in many strips, in parallel
+  const int size = 2000;
+  const QgsRectangle extent = mpLandsatRasterLayer->extent();
+
+  QTemporaryFile tmpFile;
+  tmpFile.open(); // fileName is not available until open
+  QString tmpName = tmpFile.fileName();
+  tmpFile.close();
+
+  QgsRasterCalculator rc( QStringLiteral( "\"landsat@1\" * 2 - \"landsat@2\"" ),
+                          tmpName,
+                          QStringLiteral( "GTiff" ),
+                          extent, mpLandsatRasterLayer->crs(), size, size, entries,
+                          QgsProject::instance()->transformContext() );
+  QCOMPARE( static_cast< int >( rc.processCalculation() ), 0 );
+
+  std::unique_ptr< QgsRasterBlock > band1( mpLandsatRasterLayer->dataProvider()->block( 1, extent, size, size ) );
+  std::unique_ptr< QgsRasterBlock > band2( mpLandsatRasterLayer->dataProvider()->block( 2, extent, size, size ) );
+
+  //open output file and check results
+  std::unique_ptr< QgsRasterLayer > result = qgis::make_unique< QgsRasterLayer >( tmpName, QStringLiteral( "result" ) );
+  QCOMPARE( result->width(), size );
+  QCOMPARE( result->height(), size );
+  std::unique_ptr< QgsRasterBlock > block( result->dataProvider()->block( 1, extent, size, size ) );
+  int mismatches = 0;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int col = 0; col < size; ++col )
+    {
+      if ( block->value( row, col ) != band1->value( row, col ) * 2 - band2->value( row, col ) )
+        mismatches++;
+    }
+  }
+  QCOMPARE( mismatches, 0 );
+}
+
 void TestQgsRasterCalculator::calcWithReprojectedLayers()
 {
   QgsRasterCalculatorEntry entry1;
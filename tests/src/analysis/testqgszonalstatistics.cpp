@@ -19,10 +19,15 @@
 #include "qgsapplication.h"
 #include "qgsfeatureiterator.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgszonalstatistics.h"
 #include "qgsproject.h"
 #include "qgsvectorlayerutils.h"
+#include "qgsrasterfilewriter.h"
+#include "qgsrasterdataprovider.h"
+
+#include <QTemporaryFile>
 
 /**
  * \ingroup UnitTests
@@ -42,6 +47,8 @@ class TestQgsZonalStatistics : public QObject
     void testReprojection();
     void testNoData();
     void testSmallPolygons();
+    void testBatch();
+    void testFeatureBatches();
     void testShortName();
 
   private:
@@ -344,6 +351,149 @@ void TestQgsZonalStatistics::testSmallPolygons()
   QGSCOMPARENEAR( f.attribute( "nmean" ).toDouble(), 864.285638, 0.001 );
 }
 
+void TestQgsZonalStatistics::testBatch()
+{
+  // a raster of several tiles, so that polygons are split between tiles read on different threads
+  const int nCols = 2500;
+  const int nRows = 2200;
+  const QgsRectangle extent( 0, 0, nCols * 2.0, nRows * 2.0 );
+  QTemporaryFile tmpFile( QDir::tempPath() + QStringLiteral( "/zonal_batch_XXXXXX.tif" ) );
+  tmpFile.open();
+  tmpFile.close();
+
+  QgsRasterFileWriter writer( tmpFile.fileName() );
+  writer.setOutputProviderKey( QStringLiteral( "gdal" ) );
+  writer.setOutputFormat( QStringLiteral( "GTiff" ) );
+  std::unique_ptr< QgsRasterDataProvider > dp( writer.createOneBandRaster( Qgis::Float32, nCols, nRows, extent, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) ) );
+  QVERIFY( dp->isValid() );
+  dp->setNoDataValue( 1, -9999 );
+  if ( !dp->isEditable() )
+  {
+    QVERIFY( dp->setEditable( true ) );
+  }
+  QgsRasterBlock block( Qgis::Float32, nCols, nRows );
+  int validPixels = 0;
+  for ( int row = 0; row < nRows; row++ )
+  {
+    for ( int col = 0; col < nCols; col++ )
+    {
+      const int value = ( row * 7 + col * 13 ) % 101;
+      block.setValue( row, col, value == 0 ? -9999 : value );
+      validPixels += value == 0 ? 0 : 1;
+    }
+  }
+  QVERIFY( dp->writeBlock( &block, 1 ) );
+  QVERIFY( dp->setEditable( false ) );
+
+  QVector< QgsGeometry > geometries;
+  for ( int i = 0; i < 8; ++i )
+  {
+    for ( int j = 0; j < 8; ++j )
+    {
+      // octagons with a hole, crossing the boundaries of the tiles
+      const double centerX = 150 + i * 620.3;
+      const double centerY = 140 + j * 540.7;
+      QgsPolylineXY exterior;
+      QgsPolylineXY interior;
+      for ( int k = 0; k <= 8; ++k )
+      {
+        const double angle = M_PI / 4 * ( k % 8 ) + 0.1 * i;
+        exterior << QgsPointXY( centerX + 300.5 * std::cos( angle ), centerY + 300.5 * std::sin( angle ) );
+        interior << QgsPointXY( centerX + 50.5 * std::cos( angle ), centerY + 50.5 * std::sin( angle ) );
+      }
+      geometries << QgsGeometry::fromPolygonXY( QgsPolygonXY() << exterior << interior );
+    }
+  }
+  geometries << QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon(((2000 2000, 2100 2000, 2100 2100, 2000 2100, 2000 2000)),((4090 100, 4110 100, 4110 4300, 4090 4300, 4090 100)))" ) );
+  // smaller than a pixel
+  geometries << QgsGeometry::fromWkt( QStringLiteral( "Polygon((1001.1 1001.1, 1001.9 1001.1, 1001.9 1001.9, 1001.1 1001.1))" ) );
+  // outside of the raster
+  geometries << QgsGeometry::fromWkt( QStringLiteral( "Polygon((-100 -100, -50 -100, -50 -50, -100 -100))" ) );
+  geometries << QgsGeometry();
+  // a curve, and the whole raster
+  geometries << QgsGeometry::fromWkt( QStringLiteral( "CurvePolygon(CompoundCurve(CircularString(3000 3000, 3500 3500, 4000 3000),(4000 3000, 3000 3000)))" ) );
+  geometries << QgsGeometry::fromRect( extent );
+
+  const QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > results = QgsZonalStatistics::calculateStatistics( dp.get(), geometries, 2, 2, 1, QgsZonalStatistics::All );
+  QCOMPARE( results.size(), geometries.size() );
+
+  // same statistics as the ones of each geometry on its own
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const QMap<QgsZonalStatistics::Statistic, QVariant> expected = QgsZonalStatistics::calculateStatistics( dp.get(), geometries.at( i ), 2, 2, 1, QgsZonalStatistics::All );
+    const QMap<QgsZonalStatistics::Statistic, QVariant> &result = results.at( i );
+    QCOMPARE( result.keys(), expected.keys() );
+    for ( auto it = expected.constBegin(); it != expected.constEnd(); ++it )
+    {
+      const double value = it.value().toDouble();
+      QGSCOMPARENEAR( result.value( it.key() ).toDouble(), value, 1e-9 * std::max( 1.0, std::fabs( value ) ) );
+    }
+  }
+
+  QCOMPARE( results.at( 0 ).value( QgsZonalStatistics::Min ).toDouble(), 1.0 );
+  QCOMPARE( results.at( 0 ).value( QgsZonalStatistics::Max ).toDouble(), 100.0 );
+  QVERIFY( results.at( 64 ).value( QgsZonalStatistics::Count ).toDouble() > 2500 );
+  QVERIFY( results.at( 65 ).value( QgsZonalStatistics::Count ).toDouble() < 1 );
+  QVERIFY( results.at( 66 ).isEmpty() );
+  QVERIFY( results.at( 67 ).isEmpty() );
+  QVERIFY( results.at( 68 ).value( QgsZonalStatistics::Count ).toDouble() > 0 );
+  // all the pixels except the nodata ones
+  QCOMPARE( results.at( 69 ).value( QgsZonalStatistics::Count ).toDouble(), static_cast< double >( validPixels ) );
+
+  // small geometries scattered over the tiles read their own windows of the raster
+  QVector< QgsGeometry > scattered;
+  scattered << QgsGeometry::fromRect( QgsRectangle( 10.5, 10.5, 30.5, 30.5 ) )
+            << QgsGeometry::fromRect( QgsRectangle( 4500.5, 4000.5, 4520.5, 4020.5 ) )
+            << QgsGeometry::fromRect( QgsRectangle( 2040, 100, 2060, 120 ) )
+            << QgsGeometry();
+  const QVector< QMap<QgsZonalStatistics::Statistic, QVariant> > scatteredResults = QgsZonalStatistics::calculateStatistics( dp.get(), scattered, 2, 2, 1, QgsZonalStatistics::All );
+  QCOMPARE( scatteredResults.size(), scattered.size() );
+  for ( int i = 0; i < scattered.size(); ++i )
+  {
+    QCOMPARE( scatteredResults.at( i ), QgsZonalStatistics::calculateStatistics( dp.get(), scattered.at( i ), 2, 2, 1, QgsZonalStatistics::All ) );
+  }
+  QVERIFY( scatteredResults.at( 3 ).isEmpty() );
+}
+
+void TestQgsZonalStatistics::testFeatureBatches()
+{
+  QgsVectorLayer layer( QStringLiteral( "Polygon?crs=epsg:3857" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  // features alternating between the two ends of a raster of 4 x 2 tiles of 1024 cells
+  const QgsRectangle rasterExtent( 0, 0, 4 * 1024, 2 * 1024 );
+  QgsFeatureList features;
+  for ( int i = 0; i < 20; ++i )
+  {
+    QgsFeature feature;
+    const double x = i % 2 ? 10 + i : 4000 + i;
+    const double y = i % 2 ? 2000 - i : 10 + i;
+    feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( x, y, x + 5, y + 5 ) ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  const QList< QgsFeatureIds > batches = QgsZonalStatistics::featureBatches( layer.dataProvider(), QgsFeatureRequest(), rasterExtent, 1, 1, 10 );
+  QCOMPARE( batches.size(), 2 );
+
+  // each batch only holds the features of one tile
+  QgsFeatureIds seen;
+  for ( const QgsFeatureIds &batch : batches )
+  {
+    QCOMPARE( batch.size(), 10 );
+    QSet< int > columns;
+    QgsFeatureIterator it = layer.getFeatures( QgsFeatureRequest().setFilterFids( batch ) );
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+    {
+      columns << static_cast< int >( feature.geometry().boundingBox().xMinimum() / 1024 );
+      seen << feature.id();
+    }
+    QCOMPARE( columns.size(), 1 );
+  }
+  QCOMPARE( seen.size(), 20 );
+}
+
 void TestQgsZonalStatistics::testShortName()
 {
   QCOMPARE( QgsZonalStatistics::shortName( QgsZonalStatistics::Count ), QStringLiteral( "count" ) );
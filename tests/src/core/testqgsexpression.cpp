@@ -33,6 +33,7 @@
 #include "qgsrasterlayer.h"
 #include "qgsproject.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionprogram.h"
 #include "qgsvectorlayerutils.h"
 #include "qgsexpressioncontextutils.h"
 
@@ -4130,6 +4131,160 @@ class TestQgsExpression: public QObject
       }
     }
 
+    void compiledProgram_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<int>( "fallbacks" );
+
+      QTest::newRow( "int arithmetic" ) << "int_value * 2 + 1 - int_value % 3" << 0;
+      QTest::newRow( "double arithmetic" ) << "dbl_value / 2 + int_value ^ 2" << 0;
+      QTest::newRow( "integer division" ) << "int_value // 3 + dbl_value // 0" << 0;
+      QTest::newRow( "division by zero" ) << "int_value / 0" << 0;
+      QTest::newRow( "modulo by zero" ) << "int_value % 0" << 0;
+      QTest::newRow( "unary minus" ) << "-int_value + -dbl_value" << 0;
+      QTest::newRow( "null arithmetic" ) << "null_value + 1" << 0;
+      QTest::newRow( "null comparison" ) << "null_value > 1" << 0;
+      QTest::newRow( "is null" ) << "null_value IS NULL AND int_value IS NOT NULL" << 0;
+      QTest::newRow( "comparison" ) << "int_value > 3 AND dbl_value <= 2.5" << 0;
+      QTest::newRow( "logic" ) << "NOT (int_value = 5 OR dbl_value <> 1.5)" << 0;
+      QTest::newRow( "short circuit" ) << "int_value < 0 AND int_value / 0 > 1" << 0;
+      QTest::newRow( "unknown logic" ) << "null_value = 1 OR int_value = 5" << 0;
+      QTest::newRow( "string concatenation" ) << "str_value || int_value" << 0;
+      QTest::newRow( "string plus" ) << "str_value + 'b'" << 0;
+      QTest::newRow( "string comparison" ) << "str_value = 'a'" << 0;
+      QTest::newRow( "mixed types" ) << "str_value + int_value" << 0;
+      QTest::newRow( "case" ) << "CASE WHEN int_value > 10 THEN 'big' WHEN int_value > 3 THEN 'medium' ELSE 'small' END" << 0;
+      QTest::newRow( "case without else" ) << "CASE WHEN int_value > 10 THEN 1 END" << 0;
+      QTest::newRow( "static" ) << "1 + 2 * 3" << 0;
+      QTest::newRow( "function" ) << "round(dbl_value * 10) + int_value" << 1;
+      QTest::newRow( "in operator" ) << "int_value IN (1, 5) AND dbl_value > 1" << 1;
+      QTest::newRow( "bad unary minus" ) << "-str_value" << 0;
+      QTest::newRow( "bad logic" ) << "str_value AND int_value" << 0;
+    }
+
+    void compiledProgram()
+    {
+      QFETCH( QString, string );
+      QFETCH( int, fallbacks );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_value" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "dbl_value" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "str_value" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "null_value" ), QVariant::Int ) );
+
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << 5 << 1.5 << QStringLiteral( "a" ) << QVariant( QVariant::Int ) );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      QgsExpression exp( string );
+      QVERIFY( exp.prepare( &context ) );
+
+      std::unique_ptr< QgsExpressionProgram > program = QgsExpressionProgram::compile( const_cast< QgsExpressionNode * >( exp.rootNode() ) );
+      QVERIFY( program );
+      QCOMPARE( program->fallbackCount(), fallbacks );
+
+      // the compiled program must give the same results as the tree walking interpreter
+      QgsExpressionProgram::setEnabled( false );
+      const QVariant expected = exp.evaluate( &context );
+      const QString expectedError = exp.evalErrorString();
+      QgsExpressionProgram::setEnabled( true );
+      const QVariant result = exp.evaluate( &context );
+      QCOMPARE( exp.evalErrorString(), expectedError );
+      QCOMPARE( result.type(), expected.type() );
+      QCOMPARE( result.isNull(), expected.isNull() );
+      QCOMPARE( result, expected );
+    }
+
+    void evaluateBlock_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      QTest::newRow( "arithmetic" ) << "int_value * 2 + dbl_value";
+      QTest::newRow( "errors" ) << "-str_value";
+      QTest::newRow( "conditions" ) << "CASE WHEN int_value > 2 AND dbl_value < 3 THEN 'a' ELSE 'b' END";
+      QTest::newRow( "fallbacks" ) << "round(dbl_value) + @row_value";
+      QTest::newRow( "feature" ) << "$id * 2";
+    }
+
+    void evaluateBlock()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_value" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "dbl_value" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "str_value" ), QVariant::String ) );
+
+      QgsFeatureList features;
+      for ( int i = 0; i < 10; ++i )
+      {
+        QgsFeature f( fields, i );
+        f.setAttributes( QgsAttributes() << i << i / 4.0 << ( i % 3 ? QVariant( QString::number( i ) ) : QVariant( QStringLiteral( "x" ) ) ) );
+        features << f;
+      }
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature(), fields );
+      context.lastScope()->setVariable( QStringLiteral( "row_value" ), 3 );
+
+      QgsExpression exp( string );
+      QVERIFY( exp.prepare( &context ) );
+
+      QVariantList expected;
+      QString expectedError;
+      for ( const QgsFeature &f : qgis::as_const( features ) )
+      {
+        context.setFeature( f );
+        expected << exp.evaluate( &context );
+        if ( exp.hasEvalError() )
+          expectedError = exp.evalErrorString();
+      }
+
+      QCOMPARE( exp.evaluateBlock( features, &context ), expected );
+      QCOMPARE( exp.evalErrorString(), expectedError );
+      QCOMPARE( context.feature().id(), features.last().id() );
+
+      QgsExpressionProgram::setEnabled( false );
+      QCOMPARE( exp.evaluateBlock( features, &context ), expected );
+      QCOMPARE( exp.evalErrorString(), expectedError );
+      QgsExpressionProgram::setEnabled( true );
+    }
+
+    void compiledProgramBenchmark_data()
+    {
+      QTest::addColumn<bool>( "compiled" );
+
+      QTest::newRow( "tree walker" ) << false;
+      QTest::newRow( "compiled" ) << true;
+    }
+
+    void compiledProgramBenchmark()
+    {
+      QFETCH( bool, compiled );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "a" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "b" ), QVariant::Double ) );
+
+      QgsFeature f( fields );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      QgsExpression exp( QStringLiteral( "CASE WHEN a > 50 AND b < 0.5 THEN a * b + 1 WHEN a % 2 = 0 THEN a / 2 ELSE -b END" ) );
+      QVERIFY( exp.prepare( &context ) );
+
+      QgsExpressionProgram::setEnabled( compiled );
+      QBENCHMARK
+      {
+        for ( int i = 0; i < 1000; ++i )
+        {
+          f.setAttributes( QgsAttributes() << i % 100 << ( i % 10 ) / 10.0 );
+          context.setFeature( f );
+          exp.evaluate( &context );
+        }
+      }
+      QgsExpressionProgram::setEnabled( true );
+    }
+
 };
 
 QGSTEST_MAIN( TestQgsExpression )
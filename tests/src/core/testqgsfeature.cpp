@@ -21,6 +21,7 @@
 #include "qgsfeature.h"
 #include "qgsfield.h"
 #include "qgsgeometry.h"
+#include "qgswkbgeometryview.h"
 
 class TestQgsFeature: public QObject
 {
@@ -40,6 +41,7 @@ class TestQgsFeature: public QObject
     void gettersSetters(); //test getters and setters
     void attributes();
     void geometry();
+    void geometryView();
     void asVariant(); //test conversion to and from a QVariant
     void fields();
     void equality();
@@ -338,6 +340,81 @@ void TestQgsFeature::geometry()
   QVERIFY( geomFeature.geometry().isNull() );
 }
 
+void TestQgsFeature::geometryView()
+{
+  // views
+  QVERIFY( QgsWkbGeometryView().isNull() );
+  QCOMPARE( QgsWkbGeometryView().wkbType(), QgsWkbTypes::Unknown );
+  QVERIFY( QgsWkbGeometryView().boundingBox().isNull() );
+  QVERIFY( !QgsWkbGeometryView().boundingBoxIntersects( QgsRectangle( 0, 0, 10, 10 ) ) );
+
+  QgsWkbGeometryView pointView( QgsGeometry::fromWkt( QStringLiteral( "PointZ (5 6 7)" ) ).asWkb() );
+  QCOMPARE( pointView.wkbType(), QgsWkbTypes::PointZ );
+  QCOMPARE( pointView.boundingBox(), QgsRectangle( 5, 6, 5, 6 ) );
+  QVERIFY( pointView.boundingBoxIntersects( QgsRectangle( 0, 0, 10, 10 ) ) );
+  QVERIFY( !pointView.boundingBoxIntersects( QgsRectangle( 7, 0, 10, 10 ) ) );
+
+  const QgsGeometry multiPolygon = QgsGeometry::fromWkt( QStringLiteral( "MultiPolygonZM (((0 0 1 2, 10 0 1 2, 10 10 1 2, 0 10 1 2, 0 0 1 2),(2 2 1 2, 3 2 1 2, 3 3 1 2, 2 2 1 2)),((20 -5 1 2, 30 -5 1 2, 30 5 1 2, 20 -5 1 2)))" ) );
+  QgsWkbGeometryView multiPolygonView( multiPolygon.asWkb() );
+  QCOMPARE( multiPolygonView.wkbType(), QgsWkbTypes::MultiPolygonZM );
+  QCOMPARE( multiPolygonView.boundingBox(), multiPolygon.boundingBox() );
+  QCOMPARE( multiPolygonView.boundingBox(), QgsRectangle( 0, -5, 30, 10 ) );
+  QVERIFY( multiPolygonView.boundingBoxIntersects( QgsRectangle( 25, 7, 40, 20 ) ) );
+  QVERIFY( !multiPolygonView.boundingBoxIntersects( QgsRectangle( 31, 7, 40, 20 ) ) );
+  QVERIFY( multiPolygonView.geometry().equals( multiPolygon ) );
+
+  QgsWkbGeometryView emptyView( QgsGeometry::fromWkt( QStringLiteral( "GeometryCollection EMPTY" ) ).asWkb() );
+  QCOMPARE( emptyView.wkbType(), QgsWkbTypes::GeometryCollection );
+  QVERIFY( emptyView.boundingBox().isNull() );
+  QVERIFY( !emptyView.boundingBoxIntersects( QgsRectangle( -10, -10, 10, 10 ) ) );
+
+  // curves extend beyond their vertices, so the view falls back to the geometry
+  const QgsGeometry curve = QgsGeometry::fromWkt( QStringLiteral( "CurvePolygon (CircularString (0 0, 1 1, 2 0, 1 -1, 0 0))" ) );
+  QgsWkbGeometryView curveView( curve.asWkb() );
+  QCOMPARE( curveView.wkbType(), QgsWkbTypes::CurvePolygon );
+  QCOMPARE( curveView.boundingBox(), curve.boundingBox() );
+
+  // features
+  QgsFeature feature;
+  QVERIFY( feature.geometryView().isNull() );
+  QVERIFY( feature.geometryBoundingBox().isNull() );
+  feature.setGeometryView( multiPolygonView );
+  QVERIFY( feature.isValid() );
+  QVERIFY( feature.hasGeometry() );
+  QCOMPARE( feature.geometryView().wkb(), multiPolygon.asWkb() );
+  QCOMPARE( feature.geometryBoundingBox(), QgsRectangle( 0, -5, 30, 10 ) );
+  QVERIFY( feature.approximateMemoryUsage() > QgsFeature().approximateMemoryUsage() );
+
+  // the geometry is created on request, and shared by copies
+  QgsFeature copy( feature );
+  QVERIFY( copy.hasGeometry() );
+  QVERIFY( feature.geometry().equals( multiPolygon ) );
+  QVERIFY( copy.geometry().equals( multiPolygon ) );
+  QCOMPARE( copy.geometryBoundingBox(), QgsRectangle( 0, -5, 30, 10 ) );
+  QVERIFY( copy == feature );
+
+  // setting the geometry discards the view, without touching copies
+  copy.setGeometry( QgsGeometry( mGeometry ) );
+  QVERIFY( copy.geometryView().isNull() );
+  QCOMPARE( copy.geometry().asWkb(), mGeometry.asWkb() );
+  QCOMPARE( copy.geometryBoundingBox(), mGeometry.boundingBox() );
+  QVERIFY( feature.geometry().equals( multiPolygon ) );
+  QVERIFY( !feature.geometryView().isNull() );
+
+  copy = feature;
+  copy.clearGeometry();
+  QVERIFY( !copy.hasGeometry() );
+  QVERIFY( copy.geometryView().isNull() );
+  QVERIFY( copy.geometry().isNull() );
+  QVERIFY( feature.hasGeometry() );
+
+  // a null view clears the geometry
+  copy = feature;
+  copy.setGeometryView( QgsWkbGeometryView() );
+  QVERIFY( !copy.hasGeometry() );
+  QVERIFY( copy.geometry().isNull() );
+}
+
 void TestQgsFeature::asVariant()
 {
   QgsFeature original( mFields, 1001LL );
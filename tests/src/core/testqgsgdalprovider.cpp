@@ -22,12 +22,14 @@
 #include <QApplication>
 #include <QFileInfo>
 #include <QDir>
+#include <QTemporaryDir>
 
 //qgis includes...
 #include <qgis.h>
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsrasterdataprovider.h>
+#include <qgsrasterblockcache.h>
 #include <qgsrectangle.h>
 
 /**
@@ -59,6 +61,7 @@ class TestQgsGdalProvider : public QObject
     void interactionBetweenRasterChangeAndCache(); // test that updading a raster invalidates the GDAL dataset cache (#20104)
     void scale0(); //test when data has scale 0 (#20493)
     void transformCoordinates();
+    void blockCache();
 
   private:
     QString mTestDataDir;
@@ -399,5 +402,82 @@ void TestQgsGdalProvider::transformCoordinates()
 
 }
 
+void TestQgsGdalProvider::blockCache()
+{
+  const QString raster = QStringLiteral( TEST_DATA_DIR ) + "/landsat.tif";
+  std::unique_ptr< QgsRasterDataProvider > provider( dynamic_cast< QgsRasterDataProvider * >(
+        QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( provider );
+  std::unique_ptr< QgsRasterDataProvider > other( dynamic_cast< QgsRasterDataProvider * >(
+        QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( other );
+
+  // the cache is opt-in
+  if ( !qEnvironmentVariableIsSet( "QGIS_RASTER_BLOCK_CACHE_SIZE" ) )
+    QCOMPARE( QgsRasterBlockCache::maximumCost(), 0 );
+  QgsRasterBlockCache::setMaximumCost( 64 * 1024 );
+
+  QgsRasterBlockCache::clear();
+  QgsRasterBlockCache::resetStatistics();
+  const QgsRectangle extent = provider->extent();
+  std::unique_ptr< QgsRasterBlock > block( provider->block( 1, extent, 100, 100 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().misses, 1LL );
+  QCOMPARE( QgsRasterBlockCache::statistics().blockCount, 1 );
+
+  // providers opened on the same file share the blocks
+  std::unique_ptr< QgsRasterBlock > cached( other->block( 1, extent, 100, 100 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().hits, 1LL );
+  QCOMPARE( cached->data(), block->data() );
+
+  // other bands, resolutions and resampling settings are read again
+  cached.reset( other->block( 2, extent, 100, 100 ) );
+  cached.reset( other->block( 1, extent, 50, 50 ) );
+  other->enableProviderResampling( true );
+  other->setZoomedOutResamplingMethod( QgsRasterDataProvider::ResamplingMethod::Average );
+  cached.reset( other->block( 1, extent, 100, 100 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().hits, 1LL );
+  QCOMPARE( QgsRasterBlockCache::statistics().misses, 4LL );
+
+  // the cache is bounded
+  QgsRasterBlockCache::setMaximumCost( 0 );
+  QCOMPARE( QgsRasterBlockCache::statistics().blockCount, 0 );
+  cached.reset( provider->block( 1, extent, 100, 100 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().blockCount, 0 );
+  QCOMPARE( cached->data(), block->data() );
+  QgsRasterBlockCache::setMaximumCost( 64 * 1024 );
+
+  // the sources of VRT datasets may change without the VRT file being changed
+  std::unique_ptr< QgsRasterDataProvider > vrt( dynamic_cast< QgsRasterDataProvider * >(
+        QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), QStringLiteral( TEST_DATA_DIR ) + "/raster/hub13263.vrt", QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( vrt && vrt->isValid() );
+  cached.reset( vrt->block( 1, vrt->extent(), 10, 10 ) );
+  cached.reset( vrt->block( 1, vrt->extent(), 10, 10 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().blockCount, 0 );
+
+  // blocks are not shared with the providers of changed files
+  QTemporaryDir dir;
+  const QString copy = dir.filePath( QStringLiteral( "landsat.tif" ) );
+  QVERIFY( QFile::copy( raster, copy ) );
+  std::unique_ptr< QgsRasterDataProvider > copyProvider( dynamic_cast< QgsRasterDataProvider * >(
+        QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), copy, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( copyProvider );
+  cached.reset( copyProvider->block( 1, extent, 100, 100 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().blockCount, 1 );
+  copyProvider.reset();
+  QFile file( copy );
+  QVERIFY( file.open( QIODevice::Append ) );
+  file.write( "x" );
+  file.close();
+  copyProvider.reset( dynamic_cast< QgsRasterDataProvider * >(
+                        QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), copy, QgsDataProvider::ProviderOptions() ) ) );
+  QgsRasterBlockCache::resetStatistics();
+  cached.reset( copyProvider->block( 1, extent, 100, 100 ) );
+  QCOMPARE( QgsRasterBlockCache::statistics().hits, 0LL );
+  QCOMPARE( QgsRasterBlockCache::statistics().blockCount, 2 );
+
+  QgsRasterBlockCache::clear();
+  QgsRasterBlockCache::setMaximumCost( 0 );
+}
+
 QGSTEST_MAIN( TestQgsGdalProvider )
 #include "testqgsgdalprovider.moc"
@@ -15,6 +15,7 @@
 #include "qgstest.h"
 #include <cmath>
 #include <memory>
+#include <functional>
 #include <limits>
 #include <QObject>
 #include <QString>
@@ -27,6 +28,7 @@
 #include <QPointF>
 #include <QImage>
 #include <QPainter>
+#include <QtConcurrentMap>
 
 //qgis includes...
 #include <qgsapplication.h>
@@ -120,6 +122,7 @@ class TestQgsGeometry : public QObject
     void partIterator();
 
     void geos();
+    void geosConcurrency();
 
     // geometry types
     void point(); //test QgsPointV2
@@ -653,6 +656,26 @@ void TestQgsGeometry::geos()
   QVERIFY( !QgsGeos::fromGeos( asGeos.get() ) );
 }
 
+void TestQgsGeometry::geosConcurrency()
+{
+  // every thread uses its own GEOS context
+  QVector< QgsGeometry > polygons;
+  for ( int i = 0; i < 200; ++i )
+    polygons << QgsGeometry::fromWkt( QStringLiteral( "Polygon ((%1 0, %2 0, %2 10, %1 10, %1 0))" ).arg( i ).arg( i + 5 + i % 3 ) );
+
+  const auto process = []( const QgsGeometry & polygon )
+  {
+    return polygon.buffer( 1, 8 ).convexHull().makeValid().asWkt( 6 );
+  };
+
+  QStringList expected;
+  for ( const QgsGeometry &polygon : qgis::as_const( polygons ) )
+    expected << process( polygon );
+
+  const QStringList concurrent = QtConcurrent::blockingMapped< QStringList >( polygons, std::function< QString( const QgsGeometry & ) >( process ) );
+  QCOMPARE( concurrent, expected );
+}
+
 void TestQgsGeometry::point()
 {
   //test QgsPointV2
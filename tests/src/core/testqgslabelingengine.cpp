@@ -31,6 +31,9 @@
 #include "qgssinglesymbolrenderer.h"
 #include "qgssymbol.h"
 #include "pointset.h"
+#include "candidatecache.h"
+
+#include <QThreadPool>
 
 class TestQgsLabelingEngine : public QObject
 {
@@ -90,6 +93,9 @@ class TestQgsLabelingEngine : public QObject
     void testLineAnchorHorizontal();
     void testLineAnchorHorizontalConstraints();
     void testShowAllLabelsWhenALabelHasNoCandidates();
+    void testParallelPlacement();
+    void testParallelPlacementPolygons();
+    void testCandidateCache();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -186,6 +192,14 @@ void TestQgsLabelingEngine::testEngineSettings()
   QVERIFY( !settings2.testFlag( QgsLabelingEngineSettings::DrawUnplacedLabels ) );
   QCOMPARE( settings2.placementVersion(), QgsLabelingEngineSettings::PlacementEngineVersion1 );
 
+  // candidate cache is disabled by default
+  QVERIFY( !QgsLabelingEngineSettings().testFlag( QgsLabelingEngineSettings::CacheCandidates ) );
+  QVERIFY( !settings2.testFlag( QgsLabelingEngineSettings::CacheCandidates ) );
+  settings.setFlag( QgsLabelingEngineSettings::CacheCandidates, true );
+  settings.writeSettingsToProject( &p );
+  settings2.readSettingsFromProject( &p );
+  QVERIFY( settings2.testFlag( QgsLabelingEngineSettings::CacheCandidates ) );
+
   // test that older setting is still respected as a fallback
   QgsProject p2;
   QgsLabelingEngineSettings settings3;
@@ -3317,5 +3331,244 @@ void TestQgsLabelingEngine::testShowAllLabelsWhenALabelHasNoCandidates()
   QVERIFY( imageCheck( QStringLiteral( "show_all_labels_when_no_candidates" ), img, 20 ) );
 }
 
+void TestQgsLabelingEngine::testParallelPlacement()
+{
+  // test that candidates generated and problems solved in parallel give
+  // the same placements as the sequential placement
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+
+  QgsTextFormat format = settings.format();
+  format.setSize( 12 );
+  format.setColor( QColor( 0, 0, 0 ) );
+  settings.setFormat( format );
+
+  settings.fieldName = QStringLiteral( "\"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl2->setRenderer( new QgsNullSymbolRenderer() );
+
+  // pairs of close points, each pair is an independent component of the conflict graph
+  QgsFeatureList features;
+  int id = 0;
+  for ( int row = 0; row < 20; ++row )
+  {
+    for ( int column = 0; column < 20; ++column )
+    {
+      for ( int i = 0; i < 2; ++i )
+      {
+        QgsFeature f;
+        f.setAttributes( QgsAttributes() << id++ );
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( column * 1000 + i * 200, row * 1000 ) ) );
+        features << f;
+      }
+    }
+  }
+  QVERIFY( vl2->dataProvider()->addFeatures( features ) );
+  vl2->updateExtents();
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 2000, 2000 ) );
+  mapSettings.setExtent( QgsRectangle( -500, -500, 19500, 19500 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placedLabels = [&mapSettings]()
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QMap< QgsFeatureId, QgsRectangle > labels;
+    const QList<QgsLabelPosition> positions = results ? results->labelsWithinRect( mapSettings.extent() ) : QList<QgsLabelPosition>();
+    for ( const QgsLabelPosition &position : positions )
+      labels.insert( position.featureId, position.labelRect );
+    return labels;
+  };
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QMap< QgsFeatureId, QgsRectangle > sequentialLabels = placedLabels();
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( 4, maxThreadCount ) );
+  const QMap< QgsFeatureId, QgsRectangle > parallelLabels = placedLabels();
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QCOMPARE( sequentialLabels.count(), 800 );
+  QCOMPARE( parallelLabels.keys(), sequentialLabels.keys() );
+  for ( auto it = sequentialLabels.constBegin(); it != sequentialLabels.constEnd(); ++it )
+  {
+    QVERIFY( parallelLabels.value( it.key() ) == it.value() );
+  }
+}
+
+void TestQgsLabelingEngine::testParallelPlacementPolygons()
+{
+  // candidates for polygons are tested against the polygons with GEOS, from every thread
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+
+  QgsTextFormat format = settings.format();
+  format.setSize( 12 );
+  format.setColor( QColor( 0, 0, 0 ) );
+  settings.setFormat( format );
+
+  settings.fieldName = QStringLiteral( "'label ' || \"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::Horizontal;
+
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl2->setRenderer( new QgsNullSymbolRenderer() );
+
+  // concave polygons with holes
+  QgsFeatureList features;
+  int id = 0;
+  for ( int row = 0; row < 20; ++row )
+  {
+    for ( int column = 0; column < 20; ++column )
+    {
+      const double x = column * 1000;
+      const double y = row * 1000;
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << id++ );
+      f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((%1 %2, %3 %2, %3 %4, %5 %4, %5 %6, %1 %6, %1 %2), (%7 %8, %9 %8, %9 %10, %7 %10, %7 %8))" )
+                                           .arg( x ).arg( y ).arg( x + 900 ).arg( y + 400 ).arg( x + 300 ).arg( y + 900 )
+                                           .arg( x + 50 ).arg( y + 50 ).arg( x + 150 ).arg( y + 150 ) ) );
+      features << f;
+    }
+  }
+  QVERIFY( vl2->dataProvider()->addFeatures( features ) );
+  vl2->updateExtents();
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 2000, 2000 ) );
+  mapSettings.setExtent( QgsRectangle( -500, -500, 19500, 19500 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placedLabels = [&mapSettings]()
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QMap< QgsFeatureId, QgsRectangle > labels;
+    const QList<QgsLabelPosition> positions = results ? results->labelsWithinRect( mapSettings.extent() ) : QList<QgsLabelPosition>();
+    for ( const QgsLabelPosition &position : positions )
+      labels.insert( position.featureId, position.labelRect );
+    return labels;
+  };
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QMap< QgsFeatureId, QgsRectangle > sequentialLabels = placedLabels();
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( 4, maxThreadCount ) );
+  const QMap< QgsFeatureId, QgsRectangle > parallelLabels = placedLabels();
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QVERIFY( !sequentialLabels.isEmpty() );
+  QCOMPARE( parallelLabels.keys(), sequentialLabels.keys() );
+  for ( auto it = sequentialLabels.constBegin(); it != sequentialLabels.constEnd(); ++it )
+  {
+    QVERIFY( parallelLabels.value( it.key() ) == it.value() );
+  }
+}
+
+void TestQgsLabelingEngine::testCandidateCache()
+{
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl );
+  mapSettings.setOutputDpi( 96 );
+  QgsLabelingEngineSettings engineSettings = mapSettings.labelingEngineSettings();
+  engineSettings.setFlag( QgsLabelingEngineSettings::CacheCandidates, true );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "Class" );
+  setDefaultLabelParams( settings );
+
+  QgsLabelingEngine::clearCandidateCache();
+
+  QgsVectorLayer *layer = vl;
+  auto runEngine = [&mapSettings, &settings, layer]( int &hits, int &misses )
+  {
+    QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    QPainter p( &img );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &p );
+
+    QgsDefaultLabelingEngine engine;
+    engine.setMapSettings( mapSettings );
+    engine.addProvider( new QgsVectorLayerLabelProvider( layer, QString(), true, &settings ) );
+    engine.run( context );
+    p.end();
+
+    hits = engine.candidateCacheHits();
+    misses = engine.candidateCacheMisses();
+
+    std::unique_ptr< QgsLabelingResults > results( engine.takeResults() );
+    QList< QgsRectangle > labels;
+    const QList<QgsLabelPosition> positions = results->labelsWithinRect( mapSettings.extent() );
+    for ( const QgsLabelPosition &position : positions )
+      labels << position.labelRect;
+    std::sort( labels.begin(), labels.end(), []( const QgsRectangle & a, const QgsRectangle & b ) { return a.xMinimum() < b.xMinimum() || ( a.xMinimum() == b.xMinimum() && a.yMinimum() < b.yMinimum() ); } );
+    return labels;
+  };
+
+  int hits = 0;
+  int misses = 0;
+  const QList< QgsRectangle > labels = runEngine( hits, misses );
+  QCOMPARE( hits, 0 );
+  QVERIFY( misses > 0 );
+  QVERIFY( !labels.isEmpty() );
+
+  // same features at the same scale, all the candidates are reused
+  const int generated = misses;
+  QCOMPARE( runEngine( hits, misses ), labels );
+  QCOMPARE( hits, generated );
+  QCOMPARE( misses, 0 );
+
+  // the cache is bounded by the memory used by the candidates
+  const int maximumSize = pal::CandidateCache::instance()->maximumSize();
+  pal::CandidateCache::instance()->setMaximumSize( 1024 );
+  runEngine( hits, misses );
+  runEngine( hits, misses );
+  QVERIFY( hits < generated );
+  pal::CandidateCache::instance()->setMaximumSize( maximumSize );
+  QgsLabelingEngine::clearCandidateCache();
+  runEngine( hits, misses );
+
+  // different scale, nothing is reused
+  mapSettings.setOutputSize( QSize( 320, 240 ) );
+  runEngine( hits, misses );
+  QCOMPARE( hits, 0 );
+  QCOMPARE( misses, generated );
+
+  // disabled cache
+  engineSettings.setFlag( QgsLabelingEngineSettings::CacheCandidates, false );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+  runEngine( hits, misses );
+  QCOMPARE( hits, 0 );
+  QCOMPARE( misses, 0 );
+
+  QgsLabelingEngine::clearCandidateCache();
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
@@ -20,6 +20,8 @@
 #include <QTime>
 #include <QApplication>
 #include <QDesktopServices>
+#include <QThreadPool>
+#include <QTemporaryDir>
 
 #include "qgsvectorlayer.h"
 #include "qgsvectorfilewriter.h"
@@ -43,6 +45,8 @@
 #include "qgsfontutils.h"
 #include "qgsrasterlayer.h"
 #include "qgssinglesymbolrenderer.h"
+#include "qgscategorizedsymbolrenderer.h"
+#include "qgsfillsymbollayer.h"
 #include "qgsrasterlayertemporalproperties.h"
 
 //qgs unit test utility class
@@ -87,6 +91,10 @@ class TestQgsMapRendererJob : public QObject
     void stagedRendererWithStagedLabeling();
 
     void vectorLayerBoundsWithReprojection();
+    void pipelinedFeatureFetching();
+    void partitionedVectorRendering();
+    void partitionedVectorRenderingCrossingLines();
+    void partitionedVectorRenderingOverlappingFeatures();
 
     void temporalRender();
 
@@ -889,6 +897,289 @@ void TestQgsMapRendererJob::vectorLayerBoundsWithReprojection()
   QVERIFY( imageCheck( QStringLiteral( "vector_layer_bounds_with_reprojection" ), img ) );
 }
 
+void TestQgsMapRendererJob::pipelinedFeatureFetching()
+{
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  std::unique_ptr< QgsSingleSymbolRenderer > renderer = qgis::make_unique< QgsSingleSymbolRenderer >( symbol.release() );
+  gridLayer->setRenderer( renderer.release() );
+
+  QgsMapSettings mapSettings;
+
+  mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  mapSettings.setExtent( QgsRectangle( -37000835.1, -20182273.7, 37000835.1, 20182273.7 ) );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  QgsMapRendererSequentialJob renderJob( mapSettings );
+  renderJob.start();
+  renderJob.waitForFinished();
+  const QImage img = renderJob.renderedImage();
+
+  // fetching the features on a separate thread must give exactly the same result
+  mapSettings.setFlag( QgsMapSettings::PipelinedFeatureFetching, true );
+  QgsMapRendererSequentialJob pipelinedJob( mapSettings );
+  pipelinedJob.start();
+  pipelinedJob.waitForFinished();
+  const QImage pipelinedImg = pipelinedJob.renderedImage();
+  QCOMPARE( pipelinedImg, img );
+  QVERIFY( imageCheck( QStringLiteral( "vector_layer_bounds_with_reprojection" ), pipelinedImg ) );
+
+  // and so must rendering with symbol levels
+  mapSettings.setFlag( QgsMapSettings::PipelinedFeatureFetching, false );
+  gridLayer->renderer()->setUsingSymbolLevels( true );
+  QgsMapRendererSequentialJob levelsJob( mapSettings );
+  levelsJob.start();
+  levelsJob.waitForFinished();
+  const QImage levelsImg = levelsJob.renderedImage();
+
+  mapSettings.setFlag( QgsMapSettings::PipelinedFeatureFetching, true );
+  QgsMapRendererSequentialJob pipelinedLevelsJob( mapSettings );
+  pipelinedLevelsJob.start();
+  pipelinedLevelsJob.waitForFinished();
+  QCOMPARE( pipelinedLevelsJob.renderedImage(), levelsImg );
+}
+
+/**
+ * Restores the maximum thread count of the global thread pool when going out of scope.
+ */
+class ThreadCountRestorer
+{
+  public:
+    ThreadCountRestorer()
+      : mMaxThreadCount( QThreadPool::globalInstance()->maxThreadCount() )
+    {}
+
+    ~ThreadCountRestorer()
+    {
+      QThreadPool::globalInstance()->setMaxThreadCount( mMaxThreadCount );
+    }
+
+  private:
+    int mMaxThreadCount = 1;
+};
+
+void TestQgsMapRendererJob::partitionedVectorRendering()
+{
+  ThreadCountRestorer threadCountRestorer;
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  std::unique_ptr< QgsSingleSymbolRenderer > renderer = qgis::make_unique< QgsSingleSymbolRenderer >( symbol.release() );
+  gridLayer->setRenderer( renderer.release() );
+
+  QgsMapSettings mapSettings;
+
+  mapSettings.setDestinationCrs( gridLayer->crs() );
+  mapSettings.setExtent( gridLayer->extent() );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  const QImage expected = job.renderedImage();
+
+  // the strips are drawn exactly as the whole image
+  mapSettings.setFlag( QgsMapSettings::PartitionedVectorRendering, true );
+  QgsMapRendererSequentialJob renderJob( mapSettings );
+  renderJob.start();
+  renderJob.waitForFinished();
+  QCOMPARE( renderJob.renderedImage(), expected );
+
+  // merged level by level with symbol levels
+  gridLayer->renderer()->setUsingSymbolLevels( true );
+  QgsMapRendererSequentialJob levelsJob( mapSettings );
+  levelsJob.start();
+  levelsJob.waitForFinished();
+  QCOMPARE( levelsJob.renderedImage(), expected );
+
+  // reprojected layers are drawn in one go
+  mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  mapSettings.setExtent( QgsRectangle( -37000835.1, -20182273.7, 37000835.1, 20182273.7 ) );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing, true );
+  QgsMapRendererSequentialJob reprojectedJob( mapSettings );
+  reprojectedJob.start();
+  reprojectedJob.waitForFinished();
+  QVERIFY( imageCheck( QStringLiteral( "vector_layer_bounds_with_reprojection" ), reprojectedJob.renderedImage() ) );
+}
+
+void TestQgsMapRendererJob::partitionedVectorRenderingCrossingLines()
+{
+  ThreadCountRestorer threadCountRestorer;
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  // lines starting above or below the extent, and only entering it in the later parts of it:
+  // the bounding boxes of these lines span parts of the extent which the lines never cross,
+  // and which ogr does not return them to
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath( QStringLiteral( "crossing_lines.gpkg" ) );
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  QgsVectorFileWriter::SaveVectorOptions saveOptions;
+  std::unique_ptr< QgsVectorFileWriter > writer( QgsVectorFileWriter::create( fileName, fields, QgsWkbTypes::LineString, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateTransformContext(), saveOptions ) );
+  QCOMPARE( writer->hasError(), QgsVectorFileWriter::NoError );
+  const QStringList lines
+  {
+    QStringLiteral( "LineString (5 120, 95 50)" ),
+    QStringLiteral( "LineString (5 -20, 95 50)" ),
+    QStringLiteral( "LineString (-10 140, 70 60)" ),
+    QStringLiteral( "LineString (-10 -40, 70 40)" ),
+    QStringLiteral( "LineString (10 105, 90 90, 95 70)" ),
+  };
+  int id = 0;
+  for ( const QString &wkt : lines )
+  {
+    QgsFeature feature( fields );
+    feature.setAttribute( 0, ++id );
+    feature.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    QVERIFY( writer->addFeature( feature ) );
+  }
+  writer.reset();
+
+  QgsVectorLayer layer( fileName, QStringLiteral( "lines" ), QStringLiteral( "ogr" ) );
+  QVERIFY( layer.isValid() );
+  QCOMPARE( layer.featureCount(), static_cast< long >( lines.size() ) );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  layer.setRenderer( new QgsSingleSymbolRenderer( symbol.release() ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer.crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  mapSettings.setOutputSize( QSize( 256, 256 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setBackgroundColor( Qt::white );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << &layer );
+
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  const QImage expected = job.renderedImage();
+
+  // every line crossing the extent is drawn
+  for ( const QString &wkt : lines )
+  {
+    const QgsGeometry clipped = QgsGeometry::fromWkt( wkt ).clipped( mapSettings.extent() );
+    QVERIFY( !clipped.isEmpty() );
+    const QgsPointXY middle = clipped.interpolate( clipped.length() / 2 ).asPoint();
+    const QgsPointXY pixel = mapSettings.mapToPixel().transform( middle );
+    QCOMPARE( QColor( expected.pixel( static_cast< int >( pixel.x() ), static_cast< int >( pixel.y() ) ) ), QColor( 255, 0, 255 ) );
+  }
+
+  mapSettings.setFlag( QgsMapSettings::PartitionedVectorRendering, true );
+  QgsMapRendererSequentialJob partitionedJob( mapSettings );
+  partitionedJob.start();
+  partitionedJob.waitForFinished();
+  QCOMPARE( partitionedJob.renderedImage(), expected );
+
+  layer.renderer()->setUsingSymbolLevels( true );
+  QgsMapRendererSequentialJob levelsJob( mapSettings );
+  levelsJob.start();
+  levelsJob.waitForFinished();
+  QCOMPARE( levelsJob.renderedImage(), expected );
+}
+
+void TestQgsMapRendererJob::partitionedVectorRenderingOverlappingFeatures()
+{
+  ThreadCountRestorer threadCountRestorer;
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  // features overlapping each other across the boundaries of the four strips of the extent
+  // (at x = 25, 50 and 75), whose stacking order must be kept in every strip
+  QgsVectorLayer polygonLayer( QStringLiteral( "Polygon?crs=EPSG:4326&field=class:integer" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QVERIFY( polygonLayer.isValid() );
+  QgsVectorLayer pointLayer( QStringLiteral( "Point?crs=EPSG:4326&field=class:integer" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( pointLayer.isValid() );
+
+  auto addFeature = []( QgsVectorLayer & layer, int category, const QString & wkt )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttribute( 0, category );
+    feature.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    return layer.dataProvider()->addFeature( feature );
+  };
+  QVERIFY( addFeature( polygonLayer, 1, QStringLiteral( "Polygon ((10 10, 60 10, 60 60, 10 60, 10 10))" ) ) );
+  QVERIFY( addFeature( polygonLayer, 2, QStringLiteral( "Polygon ((20 30, 90 30, 90 70, 20 70, 20 30))" ) ) );
+  QVERIFY( addFeature( polygonLayer, 1, QStringLiteral( "Polygon ((24 20, 26 20, 26 90, 24 90, 24 20))" ) ) );
+  QVERIFY( addFeature( polygonLayer, 3, QStringLiteral( "Polygon ((5 50, 95 50, 95 55, 5 55, 5 50))" ) ) );
+  QVERIFY( addFeature( polygonLayer, 2, QStringLiteral( "Polygon ((49 5, 76 5, 76 95, 49 95, 49 5))" ) ) );
+  QVERIFY( addFeature( pointLayer, 1, QStringLiteral( "Point (24 80)" ) ) );
+  QVERIFY( addFeature( pointLayer, 2, QStringLiteral( "Point (26 80)" ) ) );
+  QVERIFY( addFeature( pointLayer, 3, QStringLiteral( "Point (50.5 80)" ) ) );
+  QVERIFY( addFeature( pointLayer, 1, QStringLiteral( "Point (49.5 82)" ) ) );
+  QVERIFY( addFeature( pointLayer, 2, QStringLiteral( "Point (74 20)" ) ) );
+  QVERIFY( addFeature( pointLayer, 3, QStringLiteral( "Point (77 20)" ) ) );
+
+  const QList< QColor > colors { QColor( 255, 0, 0 ), QColor( 0, 0, 255 ), QColor( 0, 160, 0 ) };
+  QgsCategoryList polygonCategories;
+  QgsCategoryList pointCategories;
+  for ( int i = 0; i < colors.size(); ++i )
+  {
+    QgsFillSymbol *fill = QgsFillSymbol::createSimple( QVariantMap() );
+    fill->setColor( colors.at( i ) );
+    fill->symbolLayer( 0 )->setStrokeColor( Qt::black );
+    static_cast< QgsSimpleFillSymbolLayer * >( fill->symbolLayer( 0 ) )->setStrokeWidth( 1.5 );
+    polygonCategories << QgsRendererCategory( i + 1, fill, QString::number( i + 1 ) );
+
+    QgsMarkerSymbol *marker = QgsMarkerSymbol::createSimple( QVariantMap( {{ QStringLiteral( "name" ), QStringLiteral( "square" ) }} ) );
+    marker->setColor( colors.at( i ) );
+    marker->setSize( 8 );
+    marker->setAngle( 30 );
+    pointCategories << QgsRendererCategory( i + 1, marker, QString::number( i + 1 ) );
+  }
+  polygonLayer.setRenderer( new QgsCategorizedSymbolRenderer( QStringLiteral( "class" ), polygonCategories ) );
+  pointLayer.setRenderer( new QgsCategorizedSymbolRenderer( QStringLiteral( "class" ), pointCategories ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( polygonLayer.crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  mapSettings.setOutputSize( QSize( 256, 256 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setBackgroundColor( Qt::white );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << &pointLayer << &polygonLayer );
+
+  for ( bool useSymbolLevels : { false, true } )
+  {
+    polygonLayer.renderer()->setUsingSymbolLevels( useSymbolLevels );
+    pointLayer.renderer()->setUsingSymbolLevels( useSymbolLevels );
+
+    mapSettings.setFlag( QgsMapSettings::PartitionedVectorRendering, false );
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    const QImage expected = job.renderedImage();
+
+    mapSettings.setFlag( QgsMapSettings::PartitionedVectorRendering, true );
+    QgsMapRendererSequentialJob partitionedJob( mapSettings );
+    partitionedJob.start();
+    partitionedJob.waitForFinished();
+    QCOMPARE( partitionedJob.renderedImage(), expected );
+  }
+}
+
 void TestQgsMapRendererJob::temporalRender()
 {
   std::unique_ptr< QgsRasterLayer > rasterLayer = qgis::make_unique< QgsRasterLayer >( TEST_DATA_DIR + QStringLiteral( "/raster_layer.tiff" ),
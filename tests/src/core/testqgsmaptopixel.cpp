@@ -30,6 +30,7 @@ class TestQgsMapToPixel: public QObject
     void fromScale();
     void equality();
     void toMapCoordinates();
+    void transformPolygon();
 };
 
 void TestQgsMapToPixel::rotation()
@@ -150,6 +151,35 @@ void TestQgsMapToPixel::toMapCoordinates()
   QCOMPARE( p, QgsPointXY( 20, 20 ) );
 }
 
+void TestQgsMapToPixel::transformPolygon()
+{
+  QPolygonF poly;
+  for ( int i = 0; i < 101; ++i )
+    poly << QPointF( 2.5 + i * 0.37, -7.1 + ( i % 13 ) * 1.9 );
+
+  // transforming the whole polygon must give exactly the same points as transforming them one by one
+  for ( double rotation : { 0.0, 90.0, -33.3 } )
+  {
+    QgsMapToPixel m2p( 0.13, 5, 5, 640, 480, rotation );
+
+    QPolygonF transformed = poly;
+    m2p.transformInPlace( transformed );
+    QCOMPARE( transformed.size(), poly.size() );
+    for ( int i = 0; i < poly.size(); ++i )
+    {
+      double x = poly.at( i ).x();
+      double y = poly.at( i ).y();
+      m2p.transformInPlace( x, y );
+      QCOMPARE( transformed.at( i ).x(), x );
+      QCOMPARE( transformed.at( i ).y(), y );
+    }
+  }
+
+  QPolygonF empty;
+  QgsMapToPixel().transformInPlace( empty );
+  QVERIFY( empty.isEmpty() );
+}
+
 QGSTEST_MAIN( TestQgsMapToPixel )
 #include "testqgsmaptopixel.moc"
 
@@ -23,6 +23,8 @@
 #include <QPainter>
 #include <QTime>
 #include <QDesktopServices>
+#include <QDomDocument>
+#include <QThreadPool>
 
 #include "cpl_conv.h"
 #include "gdal.h"
@@ -37,6 +39,7 @@
 #include <qgssinglebandgrayrenderer.h>
 #include <qgssinglebandpseudocolorrenderer.h>
 #include <qgsmultibandcolorrenderer.h>
+#include <qgshillshaderenderer.h>
 #include <qgscolorramp.h>
 #include <qgscptcityarchive.h>
 #include "qgscolorrampshader.h"
@@ -45,6 +48,11 @@
 #include "qgsrastertransparency.h"
 #include "qgspalettedrasterrenderer.h"
 #include "qgsrasterlayertemporalproperties.h"
+#include "qgsrasterdrawer.h"
+#include "qgsrasterprojector.h"
+#include "qgsrasteriterator.h"
+#include "qgsrasterviewport.h"
+#include "qgsmaptopixel.h"
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -72,6 +80,10 @@ class TestQgsRasterLayer : public QObject
     void isValid();
     void isSpatial();
     void pseudoColor();
+    void pseudoColorLookupTable();
+    void drawTiles();
+    void drawTilesHillshade();
+    void projectorGrid();
     void colorRamp1();
     void colorRamp2();
     void colorRamp3();
@@ -245,6 +257,72 @@ void TestQgsRasterLayer::pseudoColor()
   QVERIFY( render( "raster_pseudo" ) );
 }
 
+void TestQgsRasterLayer::pseudoColorLookupTable()
+{
+  const auto createShader = []( double minimum, double maximum )
+  {
+    QgsColorRampShader *colorRampShader = new QgsColorRampShader( minimum, maximum );
+    colorRampShader->setColorRampType( QgsColorRampShader::Interpolated );
+    colorRampShader->setColorRampItemList( QList<QgsColorRampShader::ColorRampItem>()
+                                           << QgsColorRampShader::ColorRampItem( minimum, QColor( 0, 0, 255 ) )
+                                           << QgsColorRampShader::ColorRampItem( ( minimum + maximum ) / 2, QColor( 0, 255, 0 ) )
+                                           << QgsColorRampShader::ColorRampItem( maximum, QColor( 255, 0, 0 ) ) );
+    QgsRasterShader *rasterShader = new QgsRasterShader( minimum, maximum );
+    rasterShader->setRasterShaderFunction( colorRampShader );
+    return rasterShader;
+  };
+
+  // compares rendered colors with the exact colors of the values, within a tolerance
+  const auto checkColors = []( QgsRasterLayer * layer, QgsSingleBandPseudoColorRenderer & renderer, int tolerance )
+  {
+    const int width = layer->width();
+    const int height = layer->height();
+    std::unique_ptr< QgsRasterBlock > values( layer->dataProvider()->block( 1, layer->extent(), width, height ) );
+    std::unique_ptr< QgsRasterBlock > colors( renderer.block( 1, layer->extent(), width, height ) );
+    const QgsRasterShaderFunction *function = renderer.shader()->rasterShaderFunction();
+    int mismatches = 0;
+    for ( int row = 0; row < height; ++row )
+    {
+      for ( int column = 0; column < width; ++column )
+      {
+        bool isNoData = false;
+        const double value = values->valueAndNoData( row, column, isNoData );
+        int red, green, blue, alpha;
+        if ( isNoData || !function->shade( value, &red, &green, &blue, &alpha ) )
+          continue;
+
+        const QRgb color = colors->color( row, column );
+        if ( std::abs( qRed( color ) - red ) > tolerance || std::abs( qGreen( color ) - green ) > tolerance
+             || std::abs( qBlue( color ) - blue ) > tolerance || qAlpha( color ) != alpha )
+          mismatches++;
+      }
+    }
+    return mismatches;
+  };
+
+  // integer values are always rendered through a table of their exact colors
+  QCOMPARE( mpLandsatRasterLayer->dataProvider()->dataType( 1 ), Qgis::Byte );
+  QgsSingleBandPseudoColorRenderer byteRenderer( mpLandsatRasterLayer->dataProvider(), 1, createShader( 100, 200 ) );
+  QCOMPARE( checkColors( mpLandsatRasterLayer, byteRenderer, 0 ), 0 );
+
+  // floating point values are shaded exactly by default, or quantized
+  const QgsRasterBandStats stats = mpFloat32RasterLayer->dataProvider()->bandStatistics( 1, QgsRasterBandStats::Min | QgsRasterBandStats::Max );
+  QgsSingleBandPseudoColorRenderer floatRenderer( mpFloat32RasterLayer->dataProvider(), 1, createShader( stats.minimumValue, stats.maximumValue ) );
+  QCOMPARE( floatRenderer.lookupTableResolution(), 0 );
+  QCOMPARE( checkColors( mpFloat32RasterLayer, floatRenderer, 0 ), 0 );
+  floatRenderer.setLookupTableResolution( 4096 );
+  QCOMPARE( checkColors( mpFloat32RasterLayer, floatRenderer, 1 ), 0 );
+
+  // the resolution is kept by clones and in projects
+  std::unique_ptr< QgsSingleBandPseudoColorRenderer > clone( floatRenderer.clone() );
+  QCOMPARE( clone->lookupTableResolution(), 4096 );
+  QDomDocument doc;
+  QDomElement elem = doc.createElement( QStringLiteral( "test" ) );
+  floatRenderer.writeXml( doc, elem );
+  std::unique_ptr< QgsRasterRenderer > readRenderer( QgsSingleBandPseudoColorRenderer::create( elem.firstChildElement(), mpFloat32RasterLayer->dataProvider() ) );
+  QCOMPARE( static_cast< QgsSingleBandPseudoColorRenderer * >( readRenderer.get() )->lookupTableResolution(), 4096 );
+}
+
 void TestQgsRasterLayer::populateColorRampShader( QgsColorRampShader *colorRampShader,
     QgsColorRamp *colorRamp,
     int numberOfEntries )
@@ -306,6 +384,147 @@ bool TestQgsRasterLayer::testColorRamp( const QString &name, QgsColorRamp *color
   return render( name );
 }
 
+void TestQgsRasterLayer::drawTiles()
+{
+  const int size = 1500;
+  const QgsRectangle extent = mpLandsatRasterLayer->extent();
+  QgsRasterViewPort viewPort;
+  viewPort.mTopLeftPoint = QgsPointXY( 0, 0 );
+  viewPort.mBottomRightPoint = QgsPointXY( size, size );
+  viewPort.mWidth = size;
+  viewPort.mHeight = size;
+  viewPort.mDrawnExtent = extent;
+  const QgsMapToPixel mapToPixel( extent.width() / size, extent.center().x(), extent.center().y(), size, size, 0 );
+
+  const auto draw = [&]() -> QImage
+  {
+    QImage image( size, size, QImage::Format_ARGB32_Premultiplied );
+    image.fill( 0 );
+    QPainter painter( &image );
+    QgsRasterIterator iterator( mpLandsatRasterLayer->pipe()->last() );
+    QgsRasterDrawer drawer( &iterator );
+    QgsRasterBlockFeedback feedback;
+    drawer.draw( &painter, &viewPort, &mapToPixel, &feedback );
+    painter.end();
+    return image;
+  };
+
+  // the provider can be read concurrently, so the viewport is drawn in tiles as soon as there are threads
+  QVERIFY( mpLandsatRasterLayer->dataProvider()->providerCapabilities() & QgsRasterDataProvider::ConcurrentReads );
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QImage sequential = draw();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  const QImage tiled = draw();
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  // tile edges may only sample the source pixels differently by rounding
+  int mismatches = 0;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int column = 0; column < size; ++column )
+    {
+      if ( sequential.pixel( column, row ) != tiled.pixel( column, row ) )
+        mismatches++;
+    }
+  }
+  QVERIFY( mismatches < size * size / 100 );
+  QVERIFY( tiled.pixel( size / 2, size / 2 ) != 0 );
+}
+
+void TestQgsRasterLayer::drawTilesHillshade()
+{
+  QgsRasterLayer demLayer( mTestDataDir + QStringLiteral( "raster/dem.tif" ), QStringLiteral( "dem" ), QStringLiteral( "gdal" ) );
+  QVERIFY( demLayer.isValid() );
+  demLayer.setRenderer( new QgsHillshadeRenderer( demLayer.dataProvider(), 1, 315, 45 ) );
+
+  // twice the resolution of the dem, so that the tile edges are the edges of dem pixels
+  const int width = demLayer.width() * 2;
+  const int height = demLayer.height() * 2;
+  const QgsRectangle extent = demLayer.extent();
+  QgsRasterViewPort viewPort;
+  viewPort.mTopLeftPoint = QgsPointXY( 0, 0 );
+  viewPort.mBottomRightPoint = QgsPointXY( width, height );
+  viewPort.mWidth = width;
+  viewPort.mHeight = height;
+  viewPort.mDrawnExtent = extent;
+  const QgsMapToPixel mapToPixel( extent.width() / width, extent.center().x(), extent.center().y(), width, height, 0 );
+
+  const auto draw = [&]() -> QImage
+  {
+    QImage image( width, height, QImage::Format_ARGB32_Premultiplied );
+    image.fill( 0 );
+    QPainter painter( &image );
+    QgsRasterIterator iterator( demLayer.pipe()->last() );
+    QgsRasterDrawer drawer( &iterator );
+    QgsRasterBlockFeedback feedback;
+    drawer.draw( &painter, &viewPort, &mapToPixel, &feedback );
+    painter.end();
+    return image;
+  };
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QImage sequential = draw();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  const QImage tiled = draw();
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  // the slopes at the tile edges are computed from the neighboring tiles, so there are no seams.
+  // Shades may only differ by the rounding of the cell sizes of the tiles.
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int column = 0; column < width; ++column )
+    {
+      const QRgb expected = sequential.pixel( column, row );
+      const QRgb actual = tiled.pixel( column, row );
+      if ( std::abs( qRed( expected ) - qRed( actual ) ) > 1 || std::abs( qGreen( expected ) - qGreen( actual ) ) > 1
+           || std::abs( qBlue( expected ) - qBlue( actual ) ) > 1 || std::abs( qAlpha( expected ) - qAlpha( actual ) ) > 1 )
+      {
+        QFAIL( QStringLiteral( "Pixel %1,%2 differs" ).arg( column ).arg( row ).toLocal8Bit().constData() );
+      }
+    }
+  }
+  QVERIFY( tiled.pixel( width / 2, height / 2 ) != 0 );
+}
+
+void TestQgsRasterLayer::projectorGrid()
+{
+  QgsRasterProjector projector;
+  projector.setInput( mpLandsatRasterLayer->dataProvider() );
+  projector.setCrs( mpLandsatRasterLayer->crs(), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsProject::instance()->transformContext() );
+  const QgsRectangle extent = QgsCoordinateTransform( mpLandsatRasterLayer->crs(), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ),
+                              QgsProject::instance()->transformContext() ).transformBoundingBox( mpLandsatRasterLayer->extent() );
+  const int size = 300;
+
+  // the grid of the first band is reused for the other bands, and again for the first one
+  std::unique_ptr< QgsRasterBlock > approximate( projector.block( 1, extent, size, size ) );
+  QVERIFY( approximate && approximate->isValid() );
+  std::unique_ptr< QgsRasterBlock > other( projector.block( 2, extent, size, size ) );
+  QVERIFY( other && other->isValid() );
+  std::unique_ptr< QgsRasterBlock > again( projector.block( 1, extent, size, size ) );
+  QCOMPARE( again->data(), approximate->data() );
+
+  // the approximation is within a pixel of the exact positions, so only few pixels may differ
+  projector.setPrecision( QgsRasterProjector::Exact );
+  std::unique_ptr< QgsRasterBlock > exact( projector.block( 1, extent, size, size ) );
+  QVERIFY( exact && exact->isValid() );
+  int mismatches = 0;
+  int data = 0;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int column = 0; column < size; ++column )
+    {
+      if ( !exact->isNoData( row, column ) )
+        data++;
+      if ( exact->isNoData( row, column ) != approximate->isNoData( row, column ) || exact->value( row, column ) != approximate->value( row, column ) )
+        mismatches++;
+    }
+  }
+  QVERIFY( data > size * size / 2 );
+  QVERIFY( mismatches < size * size / 10 );
+}
+
 void TestQgsRasterLayer::colorRamp1()
 {
   // gradient ramp
@@ -0,0 +1,225 @@
+/***************************************************************************
+     testqgsrenderobjectpool.cpp
+     ---------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS Project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+
+#include "qgsrenderobjectpool.h"
+#include "qgsrendercontext.h"
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgssymbol.h"
+
+class TestQgsRenderObjectPool: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void polygons();
+    void polygonLists();
+    void renderContext();
+    void renderFeatures();
+
+  private:
+    QImage renderWithPool( QgsRenderObjectPool *pool );
+};
+
+void TestQgsRenderObjectPool::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsRenderObjectPool::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsRenderObjectPool::polygons()
+{
+  QgsRenderObjectPool pool;
+  QCOMPARE( pool.allocationCount(), 0LL );
+  QCOMPARE( pool.reuseCount(), 0LL );
+
+  QPolygonF polygon = pool.takePolygon( 10 );
+  QVERIFY( polygon.isEmpty() );
+  QVERIFY( polygon.capacity() >= 10 );
+  QCOMPARE( pool.allocationCount(), 1LL );
+  polygon << QPointF( 1, 2 ) << QPointF( 3, 4 );
+  const QPointF *buffer = polygon.constData();
+
+  pool.releasePolygon( std::move( polygon ) );
+  QVERIFY( polygon.isEmpty() );
+
+  // the buffer is handed out again, emptied
+  QPolygonF reused = pool.takePolygon( 5 );
+  QVERIFY( reused.isEmpty() );
+  QVERIFY( reused.capacity() >= 10 );
+  reused << QPointF( 5, 6 );
+  QCOMPARE( reused.constData(), buffer );
+  QCOMPARE( pool.allocationCount(), 1LL );
+  QCOMPARE( pool.reuseCount(), 1LL );
+
+  // too small buffers are grown
+  pool.releasePolygon( std::move( reused ) );
+  QPolygonF grown = pool.takePolygon( 1000 );
+  QVERIFY( grown.capacity() >= 1000 );
+  QCOMPARE( pool.allocationCount(), 2LL );
+  QCOMPARE( pool.reuseCount(), 1LL );
+
+  // buffers shared with other polygons are left to them
+  grown << QPointF( 7, 8 );
+  QPolygonF copy = grown;
+  pool.releasePolygon( std::move( grown ) );
+  QCOMPARE( copy.size(), 1 );
+  QCOMPARE( copy.at( 0 ), QPointF( 7, 8 ) );
+  pool.takePolygon();
+  QCOMPARE( pool.allocationCount(), 3LL );
+
+  pool.resetCounters();
+  QCOMPARE( pool.allocationCount(), 0LL );
+  QCOMPARE( pool.reuseCount(), 0LL );
+
+  // cleared pools allocate again
+  QPolygonF released = pool.takePolygon( 10 );
+  pool.releasePolygon( std::move( released ) );
+  pool.clear();
+  pool.takePolygon( 10 );
+  QCOMPARE( pool.allocationCount(), 2LL );
+  QCOMPARE( pool.reuseCount(), 0LL );
+}
+
+void TestQgsRenderObjectPool::polygonLists()
+{
+  QgsRenderObjectPool pool;
+
+  QVector< QPolygonF > polygons = pool.takePolygonList( 2 );
+  QVERIFY( polygons.capacity() >= 2 );
+  QPolygonF first = pool.takePolygon( 4 );
+  first << QPointF( 1, 2 );
+  polygons << first;
+  first = QPolygonF();
+  polygons << ( QPolygonF() << QPointF( 3, 4 ) );
+  QCOMPARE( pool.allocationCount(), 2LL );
+
+  // the polygons of the list are released too
+  pool.releasePolygonList( std::move( polygons ) );
+  QVERIFY( polygons.isEmpty() );
+
+  QVector< QPolygonF > reused = pool.takePolygonList( 1 );
+  QVERIFY( reused.isEmpty() );
+  QPolygonF polygon1 = pool.takePolygon();
+  QPolygonF polygon2 = pool.takePolygon();
+  QVERIFY( polygon1.isEmpty() );
+  QVERIFY( polygon2.isEmpty() );
+  QCOMPARE( pool.allocationCount(), 2LL );
+  QCOMPARE( pool.reuseCount(), 3LL );
+
+  // lists shared with other lists are left to them
+  QVector< QPolygonF > shared;
+  shared << ( QPolygonF() << QPointF( 5, 6 ) );
+  QVector< QPolygonF > copy = shared;
+  pool.releasePolygonList( std::move( shared ) );
+  QCOMPARE( copy.size(), 1 );
+  QCOMPARE( copy.at( 0 ).size(), 1 );
+  QCOMPARE( copy.at( 0 ).at( 0 ), QPointF( 5, 6 ) );
+}
+
+void TestQgsRenderObjectPool::renderContext()
+{
+  QgsRenderContext context;
+  QVERIFY( !context.objectPool() );
+
+  QgsRenderObjectPool pool;
+  context.setObjectPool( &pool );
+  QCOMPARE( context.objectPool(), &pool );
+
+  // pools are not thread safe, so are not shared by copies of a context
+  QgsRenderContext copy( context );
+  QVERIFY( !copy.objectPool() );
+  QgsRenderContext assigned;
+  assigned = context;
+  QVERIFY( !assigned.objectPool() );
+
+  context.setObjectPool( nullptr );
+  QVERIFY( !context.objectPool() );
+}
+
+QImage TestQgsRenderObjectPool::renderWithPool( QgsRenderObjectPool *pool )
+{
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::white );
+  QPainter painter( &image );
+
+  QgsRenderContext context = QgsRenderContext::fromQPainter( &painter );
+  context.setMapToPixel( QgsMapToPixel( 1, 50, 50, 100, 100, 0 ) );
+  context.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  context.setObjectPool( pool );
+
+  std::unique_ptr< QgsFillSymbol > fill( QgsFillSymbol::createSimple( QVariantMap() ) );
+  std::unique_ptr< QgsLineSymbol > line( QgsLineSymbol::createSimple( QVariantMap() ) );
+  fill->startRender( context );
+  line->startRender( context );
+
+  const QStringList polygons
+  {
+    QStringLiteral( "Polygon ((10 10, 40 10, 40 40, 10 40, 10 10),(20 20, 30 20, 30 30, 20 20))" ),
+    QStringLiteral( "MultiPolygon (((60 10, 90 10, 90 40, 60 10)),((60 50, 90 50, 90 60, 60 50)))" ),
+    QStringLiteral( "Polygon ((10 60, 40 60, 40 90, 10 60),(15 70, 20 70, 20 75, 15 70),(25 80, 30 80, 30 85, 25 80))" ),
+  };
+  for ( const QString &wkt : polygons )
+  {
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    fill->renderFeature( feature, context );
+  }
+
+  const QStringList lines
+  {
+    QStringLiteral( "LineString (5 95, 95 95)" ),
+    QStringLiteral( "MultiLineString ((5 5, 95 5),(95 5, 95 95))" ),
+  };
+  for ( const QString &wkt : lines )
+  {
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    line->renderFeature( feature, context );
+  }
+
+  fill->stopRender( context );
+  line->stopRender( context );
+  painter.end();
+  return image;
+}
+
+void TestQgsRenderObjectPool::renderFeatures()
+{
+  const QImage expected = renderWithPool( nullptr );
+
+  QgsRenderObjectPool pool;
+  const QImage pooled = renderWithPool( &pool );
+  QCOMPARE( pooled, expected );
+
+  // the buffers of the first features are reused for the next ones
+  QVERIFY( pool.allocationCount() > 0 );
+  QVERIFY( pool.reuseCount() > 0 );
+  QVERIFY( pool.reuseCount() > pool.allocationCount() );
+}
+
+QGSTEST_MAIN( TestQgsRenderObjectPool )
+#include "testqgsrenderobjectpool.moc"
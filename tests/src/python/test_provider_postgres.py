@@ -33,6 +33,7 @@ from qgis.core import (
     QgsFeatureRequest,
     QgsFeatureSource,
     QgsFeature,
+    QgsFeatureSink,
     QgsFieldConstraints,
     QgsDataProvider,
     NULL,
@@ -628,6 +629,131 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         assert compareWkt(generated_geometry, expected_geometry), "Geometry mismatch! Expected:\n{}\nGot:\n{}\n".format(expected_geometry, generated_geometry)
         self.assertEqual(f4['poly_area'], expected_area)
 
+    def testBinaryFetch(self):
+        """Test values decoded from the binary cursor, over several fetched batches"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.binary_fetch CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.binary_fetch (pk serial PRIMARY KEY, i2 int2, i4 int4, f8 float8, b bool, d date, t time, ts timestamp)')
+        self.execSQLCommand("INSERT INTO qgis_test.binary_fetch (i2, i4, f8, b, d, t, ts) "
+                            "SELECT s % 100, s, s / 3.0, s % 2 = 0, '2020-01-01'::date + s, '10:00:00.123'::time, '2020-05-04 12:13:14.567'::timestamp "
+                            "FROM generate_series(1, 5000) s")
+        self.execSQLCommand("INSERT INTO qgis_test.binary_fetch (i2, i4, f8, b, d, t, ts) VALUES (NULL, NULL, NULL, NULL, 'infinity', NULL, '-infinity')")
+
+        vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' table="qgis_test"."binary_fetch" sql=', 'test', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        features = {f['pk']: f for f in vl.getFeatures()}
+        self.assertEqual(len(features), 5001)
+
+        f = features[4000]
+        self.assertEqual(f['i2'], 0)
+        self.assertEqual(f['i4'], 4000)
+        self.assertAlmostEqual(f['f8'], 4000 / 3.0)
+        self.assertEqual(f['b'], True)
+        self.assertEqual(f['d'], QDate(2020, 1, 1).addDays(4000))
+        self.assertEqual(f['t'], QTime(10, 0, 0, 123))
+        self.assertEqual(f['ts'], QDateTime(QDate(2020, 5, 4), QTime(12, 13, 14, 567)))
+
+        f = features[5001]
+        for field in ('i2', 'i4', 'f8', 'b', 'd', 't', 'ts'):
+            self.assertEqual(f[field], NULL)
+
+        # interrupt the iteration while the next batch is being fetched
+        it = vl.getFeatures()
+        for i in range(2500):
+            self.assertTrue(it.nextFeature(QgsFeature()))
+        self.assertTrue(it.rewind())
+        self.assertEqual(len([f for f in it]), 5001)
+        it = vl.getFeatures()
+        self.assertTrue(it.nextFeature(QgsFeature()))
+        self.assertTrue(it.close())
+
+        self.execSQLCommand('DROP TABLE qgis_test.binary_fetch CASCADE')
+
+    def testBulkInsert(self):
+        """Test adding many features with COPY (fast insert) and with multi-row INSERT statements"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.bulk_insert CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.bulk_insert (pk serial PRIMARY KEY, name text, value float8, category int4 DEFAULT 7, geom geometry(Point, 4326))')
+
+        vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."bulk_insert" (geom) sql=', 'test', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        count = 10000
+
+        def make_features():
+            features = []
+            for i in range(count):
+                f = QgsFeature(vl.fields())
+                f['name'] = 'name {}\t\\{}\n'.format(i, i) if i % 10 else NULL
+                f['value'] = i / 4.0
+                f['category'] = 3
+                f.setGeometry(QgsGeometry.fromWkt('Point ({} {})'.format(i % 180, i % 90)))
+                features.append(f)
+            return features
+
+        for flags in (QgsFeatureSink.FastInsert, QgsFeatureSink.Flags()):
+            self.execSQLCommand('TRUNCATE qgis_test.bulk_insert RESTART IDENTITY')
+            vl.dataProvider().reloadData()
+            features = make_features()
+
+            start = time.time()
+            res, features = vl.dataProvider().addFeatures(features, flags)
+            elapsed = time.time() - start
+            self.assertTrue(res)
+            print('{}: {} features added in {:.3f}s ({:.0f} features/s)'.format(
+                'COPY' if flags & QgsFeatureSink.FastInsert else 'INSERT', count, elapsed, count / max(elapsed, 1e-6)))
+
+            if not flags & QgsFeatureSink.FastInsert:
+                # the keys returned by the INSERT statements are assigned to their features
+                self.assertEqual([f['pk'] for f in features], list(range(1, count + 1)))
+
+            self.assertEqual(vl.dataProvider().featureCount(), count)
+            added = {f['value']: f for f in vl.getFeatures()}
+            self.assertEqual(len(added), count)
+            for i in (0, 1, 4321, count - 1):
+                f = added[i / 4.0]
+                self.assertEqual(f['name'], 'name {}\t\\{}\n'.format(i, i) if i % 10 else NULL)
+                self.assertEqual(f['category'], 3)
+                self.assertEqual(f.geometry().asWkt(), 'Point ({} {})'.format(i % 180, i % 90))
+
+        self.execSQLCommand('DROP TABLE qgis_test.bulk_insert CASCADE')
+
+    def testBulkInsertWithoutTemporaryPrivilege(self):
+        """Test adding features with the fast insert flag when the staging table for COPY cannot be created"""
+        md = QgsProviderRegistry.instance().providerMetadata("postgres")
+        conn = md.createConnection(self.dbconn, {})
+        database = conn.executeSql('SELECT current_database()')[0][0]
+        conn.executeSql('DROP TABLE IF EXISTS public.bulk_insert_no_temp')
+        conn.executeSql('DROP USER IF EXISTS no_temp_user')
+        conn.executeSql('CREATE USER no_temp_user WITH PASSWORD \'no_temp_user\'')
+        conn.executeSql('CREATE TABLE public.bulk_insert_no_temp (pk serial PRIMARY KEY, name text, geom geometry(Point, 4326))')
+        conn.executeSql('GRANT SELECT, INSERT ON public.bulk_insert_no_temp TO no_temp_user')
+        conn.executeSql('GRANT USAGE ON SEQUENCE public.bulk_insert_no_temp_pk_seq TO no_temp_user')
+        conn.executeSql('REVOKE TEMPORARY ON DATABASE "{}" FROM PUBLIC'.format(database))
+
+        try:
+            uri = QgsDataSourceUri(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="public"."bulk_insert_no_temp" (geom) sql=')
+            uri.setUsername('no_temp_user')
+            uri.setPassword('no_temp_user')
+            vl = QgsVectorLayer(uri.uri(), 'test', 'postgres')
+            self.assertTrue(vl.isValid())
+
+            features = []
+            for i in range(100):
+                f = QgsFeature(vl.fields())
+                f['name'] = 'name {}'.format(i)
+                f.setGeometry(QgsGeometry.fromWkt('Point ({} {})'.format(i % 180, i % 90)))
+                features.append(f)
+
+            # the features are inserted with INSERT statements instead
+            res, features = vl.dataProvider().addFeatures(features, QgsFeatureSink.FastInsert)
+            self.assertTrue(res)
+            self.assertEqual(vl.dataProvider().featureCount(), 100)
+            self.assertEqual(sorted(f['name'] for f in vl.getFeatures()), sorted('name {}'.format(i) for i in range(100)))
+        finally:
+            conn.executeSql('GRANT TEMPORARY ON DATABASE "{}" TO PUBLIC'.format(database))
+            conn.executeSql('DROP TABLE IF EXISTS public.bulk_insert_no_temp')
+            conn.executeSql('DROP USER IF EXISTS no_temp_user')
+
     def testNonPkBigintField(self):
         """Test if we can correctly insert, read and change attributes(fields) of type bigint and which are not PKs."""
         vl = QgsVectorLayer(
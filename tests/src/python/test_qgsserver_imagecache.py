@@ -0,0 +1,188 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServerImageCache.
+
+From build dir, run: ctest -R PyQgsServerImageCache -V
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS Project'
+__date__ = '17/10/2020'
+__copyright__ = 'Copyright 2020, The QGIS Project'
+
+import os
+import shutil
+import tempfile
+import time
+import urllib.parse
+
+from qgis.PyQt.QtGui import QImage
+from qgis.testing import unittest
+from qgis.server import QgsServerImageCache
+
+from test_qgsserver import QgsServerTestBase
+
+
+class TestQgsServerImageCache(QgsServerTestBase):
+
+    def setUp(self):
+        super().setUp()
+        self.cache_dir = tempfile.mkdtemp()
+        self.cache = QgsServerImageCache.instance()
+        self.cache.setMaximumMemorySize(1024 * 1024)
+        self.cache.setDirectory(self.cache_dir)
+
+    def tearDown(self):
+        self.cache.clear()
+        self.cache.setMaximumMemorySize(0)
+        self.cache.setMaximumDirectorySize(0)
+        self.cache.setMaximumAge(0)
+        self.cache.setDirectory('')
+        shutil.rmtree(self.cache_dir, True)
+
+    def _tile_query(self, row=0, col=0, format='image/png'):
+        return "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectGroupsPath),
+            "SERVICE": "WMTS",
+            "VERSION": "1.0.0",
+            "REQUEST": "GetTile",
+            "LAYER": "QGIS Server Hello World",
+            "STYLE": "",
+            "TILEMATRIXSET": "EPSG:3857",
+            "TILEMATRIX": "1",
+            "TILEROW": str(row),
+            "TILECOL": str(col),
+            "FORMAT": urllib.parse.quote(format)
+        }.items())])
+
+    def _cached_files(self):
+        files = []
+        for root, dirs, names in os.walk(self.cache_dir):
+            files.extend([os.path.join(root, name) for name in names if name != '.qgis_server_image_cache'])
+        return files
+
+    def test_settings(self):
+        self.assertTrue(self.cache.isEnabled())
+        self.assertEqual(self.cache.maximumMemorySize(), 1024 * 1024)
+        self.assertEqual(self.cache.directory(), self.cache_dir)
+
+        self.cache.setMaximumMemorySize(0)
+        self.cache.setDirectory('')
+        self.assertFalse(self.cache.isEnabled())
+
+    def test_gettile(self):
+        self.assertEqual(self._cached_files(), [])
+
+        header, body = self._execute_request(self._tile_query())
+        self.assertEqual(len(self._cached_files()), 1)
+
+        # identical request is served from the cache
+        cached_header, cached_body = self._execute_request(self._tile_query())
+        self.assertEqual(cached_body, body)
+        self.assertIn(b'Content-Type: image/png', cached_header)
+        self.assertEqual(len(self._cached_files()), 1)
+
+        # neighbouring tile is a new entry
+        self._execute_request(self._tile_query(0, 1))
+        self.assertEqual(len(self._cached_files()), 2)
+
+        # reloading the project invalidates its images
+        self.cache.removeProject(self.projectGroupsPath)
+        self.assertEqual(self._cached_files(), [])
+
+    def test_metatile(self):
+        self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '2')
+        try:
+            header, body = self._execute_request(self._tile_query(1, 0))
+            self.assertIn(b'Content-Type: image/png', header)
+            # the 2x2 tiles of the matrix and the metatile itself
+            self.assertEqual(len(self._cached_files()), 5)
+
+            # siblings are served from the cache
+            self._execute_request(self._tile_query(0, 1))
+            self.assertEqual(len(self._cached_files()), 5)
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '')
+
+    def test_metatile_formats(self):
+        self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '2')
+        try:
+            # slices are encoded like the WMS images of the same format
+            header, body = self._execute_request(self._tile_query(1, 0, 'image/jpeg'))
+            self.assertIn(b'Content-Type: image/jpeg', header)
+            self.assertTrue(body.startswith(b'\xff\xd8'))
+
+            header, body = self._execute_request(self._tile_query(1, 0, 'image/png; mode=8bit'))
+            self.assertIn(b'Content-Type: image/png', header)
+            image = QImage.fromData(body)
+            self.assertEqual(image.format(), QImage.Format_Indexed8)
+
+            # the siblings are cached in the requested format
+            cached_header, cached_body = self._execute_request(self._tile_query(0, 1, 'image/png; mode=8bit'))
+            self.assertEqual(QImage.fromData(cached_body).format(), QImage.Format_Indexed8)
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '')
+
+    def test_clear(self):
+        # directories which were not created by the cache are kept
+        foreign_dir = os.path.join(self.cache_dir, 'foreign')
+        os.mkdir(foreign_dir)
+        with open(os.path.join(foreign_dir, 'data.txt'), 'w') as f:
+            f.write('data')
+
+        self._execute_request(self._tile_query())
+        self.assertEqual(len(self._cached_files()), 2)
+
+        self.cache.clear()
+        self.assertEqual(self._cached_files(), [os.path.join(foreign_dir, 'data.txt')])
+
+        self.cache.removeProject(self.cache_dir + '/foreign')
+        self.assertTrue(os.path.exists(foreign_dir))
+
+    def test_directory_size(self):
+        self.cache.setMaximumMemorySize(0)
+
+        self._execute_request(self._tile_query())
+        files = self._cached_files()
+        self.assertEqual(len(files), 1)
+        tile_size = os.path.getsize(files[0])
+
+        # the oldest tiles are evicted when the store is full, an unknown
+        # parameter gives another entry of the same size
+        self.cache.setMaximumDirectorySize(tile_size * 3 // 2)
+        self.assertEqual(self._cached_files(), files)
+        time.sleep(1)
+        self._execute_request(self._tile_query() + '&CACHE_TEST=1')
+        self.assertEqual(len(self._cached_files()), 1)
+        self.assertNotEqual(self._cached_files(), files)
+
+    def test_maximum_age(self):
+        self.cache.setMaximumMemorySize(0)
+        self.cache.setMaximumAge(1)
+
+        header, body = self._execute_request(self._tile_query())
+        files = self._cached_files()
+        self.assertEqual(len(files), 1)
+
+        # expired tiles are removed and rendered again
+        written = os.path.getmtime(files[0])
+        time.sleep(2.5)
+        cached_header, cached_body = self._execute_request(self._tile_query())
+        self.assertEqual(cached_body, body)
+        self.assertEqual(self._cached_files(), files)
+        self.assertGreater(os.path.getmtime(files[0]), written)
+
+    def test_memory_only(self):
+        self.cache.setDirectory('')
+
+        header, body = self._execute_request(self._tile_query())
+        cached_header, cached_body = self._execute_request(self._tile_query())
+        self.assertEqual(cached_body, body)
+        self.assertEqual(self._cached_files(), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -111,6 +111,40 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.cacheSize(), 1024)
         os.environ.pop(env)
 
+    def test_env_image_cache(self):
+        self.assertEqual(self.settings.imageCacheSize(), 0)
+        self.assertEqual(self.settings.imageCacheDirectory(), "")
+
+        os.environ["QGIS_SERVER_IMAGE_CACHE_SIZE"] = "1048576"
+        os.environ["QGIS_SERVER_IMAGE_CACHE_DIRECTORY"] = "/tmp/fake"
+        self.settings.load()
+        self.assertEqual(self.settings.imageCacheSize(), 1048576)
+        self.assertEqual(self.settings.imageCacheDirectory(), "/tmp/fake")
+        os.environ.pop("QGIS_SERVER_IMAGE_CACHE_SIZE")
+        os.environ.pop("QGIS_SERVER_IMAGE_CACHE_DIRECTORY")
+
+    def test_env_image_cache_eviction(self):
+        self.assertEqual(self.settings.imageCacheDirectorySize(), 0)
+        self.assertEqual(self.settings.imageCacheMaximumAge(), 0)
+
+        os.environ["QGIS_SERVER_IMAGE_CACHE_DIRECTORY_SIZE"] = "10485760"
+        os.environ["QGIS_SERVER_IMAGE_CACHE_MAX_AGE"] = "3600"
+        self.settings.load()
+        self.assertEqual(self.settings.imageCacheDirectorySize(), 10485760)
+        self.assertEqual(self.settings.imageCacheMaximumAge(), 3600)
+        os.environ.pop("QGIS_SERVER_IMAGE_CACHE_DIRECTORY_SIZE")
+        os.environ.pop("QGIS_SERVER_IMAGE_CACHE_MAX_AGE")
+
+    def test_env_wmts_metatile_size(self):
+        env = "QGIS_SERVER_WMTS_METATILE_SIZE"
+
+        self.assertEqual(self.settings.wmtsMetatileSize(), 1)
+
+        os.environ[env] = "4"
+        self.settings.load()
+        self.assertEqual(self.settings.wmtsMetatileSize(), 4)
+        os.environ.pop(env)
+
     def test_env_cache_directory(self):
         env = "QGIS_SERVER_CACHE_DIRECTORY"
 